@@ -15,6 +15,7 @@
 
 IndexManager* IndexManager::_index_manager = 0;
 PagedFileManager *IndexManager::_pf_manager = NULL;
+BufferPoolManager *IndexManager::_bp_manager = NULL;
 
 
 IndexManager* IndexManager::instance()
@@ -27,8 +28,9 @@ IndexManager* IndexManager::instance()
 
 IndexManager::IndexManager()
 {
-    // Initialize the internal PagedFileManager instance
+    // Initialize the internal PagedFileManager and BufferPoolManager instances
     _pf_manager = PagedFileManager::instance();
+    _bp_manager = BufferPoolManager::instance();
 }
 
 IndexManager::~IndexManager()
@@ -95,7 +97,7 @@ RC IndexManager::insertEntry(IXFileHandle &ixfileHandle, const Attribute &attrib
 RC IndexManager::insertEntryRec(unsigned pageNum, IXFileHandle &ixfileHandle, const Attribute &attribute, const void *key, const RID &rid, void * copyKey)
 {
     void * pageData = calloc(PAGE_SIZE, 1);
-    ixfileHandle.fh.readPage(pageNum, pageData);
+    _bp_manager->readPage(ixfileHandle.fh, pageNum, pageData);
     indexDirectoryHeader indexHeader = getIndexDirectoryHeader(pageData);
 
     if(!indexHeader.isLeaf)
@@ -109,7 +111,7 @@ RC IndexManager::insertEntryRec(unsigned pageNum, IXFileHandle &ixfileHandle, co
               if (insertSize + (INT_SIZE) <= freeSpace )
               {
                    prepPage(pageData, copyKey, indexHeader, attribute, rid, -retVal);
-                   ixfileHandle.fh.writePage(pageNum, pageData);
+                   _bp_manager->writePage(ixfileHandle.fh, pageNum, pageData);
               }
               else
               {
@@ -126,7 +128,7 @@ RC IndexManager::insertEntryRec(unsigned pageNum, IXFileHandle &ixfileHandle, co
 	   if (insertSize + (INT_SIZE * 2) <= freeSpace )
 	   {
 	   	prepPage(pageData, key, indexHeader, attribute, rid, 0);
-           	ixfileHandle.fh.writePage(pageNum, pageData);
+           	_bp_manager->writePage(ixfileHandle.fh, pageNum, pageData);
 	   }
 	   else
 	   {
@@ -205,7 +207,7 @@ RC IndexManager::splitPageLeaf(void * page, const void *key, const Attribute &at
            }
 
    }
-   handle.fh.writePage(pageNum, smallPage);
+   _bp_manager->writePage(handle.fh, pageNum, smallPage);
    handle.fh.appendPage(bigPage);
    return pageCount;
 }
@@ -286,7 +288,7 @@ RC IndexManager::splitPageNonLeaf(void * page, const void *key, const Attribute
               insertPageOffset = insertPageOffset - INT_SIZE;
 	   }
    }
-   handle.fh.writePage(pageNum, smallPage);
+   _bp_manager->writePage(handle.fh, pageNum, smallPage);
    handle.fh.appendPage(bigPage);
    return pageCount;
 }
@@ -348,7 +350,7 @@ void IndexManager::printBtree(IXFileHandle &ixfileHandle, const Attribute &attri
 }
 */
   void *pageData = calloc(PAGE_SIZE, 1);  
-  ixfileHandle.fh.readPage(0 , pageData);
+  _bp_manager->readPage(ixfileHandle.fh, 0, pageData);
   indexDirectoryHeader indexHeader;
   memcpy (&indexHeader, pageData, sizeof(indexDirectoryHeader));
   free(pageData);
@@ -427,7 +429,7 @@ void IndexManager::recursePrint(IXFileHandle &ixfileHandle, const Attribute &att
 {
   //cout << "IN RECURSE";
   void *thisPage = malloc(PAGE_SIZE);  
-  ixfileHandle.fh.readPage(currPage, thisPage);
+  _bp_manager->readPage(ixfileHandle.fh, currPage, thisPage);
   indexDirectoryHeader indexHeader;
   memcpy (&indexHeader, thisPage, sizeof(indexDirectoryHeader));
 
@@ -855,7 +857,7 @@ RC IX_ScanIterator::close()
 RC IX_ScanIterator::getNextEntry(RID &rid, void *key)
 {
 	page = calloc(PAGE_SIZE, 1);
-	ixFH.fh.readPage(currPage, page);
+	BufferPoolManager::instance()->readPage(ixFH.fh, currPage, page);
 	indexDirectoryHeader indexHeader = getIndexDirectoryHeader(page);
 	
 	if(currSlot <= indexheader.nodeCount){
@@ -928,7 +930,7 @@ RC RBFM_ScanIterator::scanInit(IXFileHandle &ix,
 unsigned IX_ScanIterator::search(const void *key, bool lowKeyInclusive, IXFileHandle &ixfileHandle, unsigned pageNum)
 {
 	pageData = calloc(PAGE_SIZE, 1);
-	ixfileHandle.fh.readPage(pageNum, pageData);
+	BufferPoolManager::instance()->readPage(ixfileHandle.fh, pageNum, pageData);
 	indexDirectoryHeader indexHeader = getIndexDirectoryHeader(pageData);
 	
 	if(indexHeader.isLeaf){
@@ -6,6 +6,7 @@
 
 #include "../rbf/rbfm.h"
 #include "../rbf/pfm.h"
+#include "../rbf/bpm.h"
 
 
 # define IX_EOF (-1)  // end of the index scan
@@ -68,6 +69,7 @@ class IndexManager {
     private:
         static IndexManager *_index_manager;
 	static PagedFileManager *_pf_manager;
+	static BufferPoolManager *_bp_manager;
 	void newNonLeafPage(void * page, unsigned pageNum, unsigned pageZeroNum);
 	void setIndexDirectoryHeader(void * page, indexDirectoryHeader indexHeader);
         bool fileExists(const string &fileName);
@@ -0,0 +1,394 @@
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+
+#include <unistd.h>
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+
+#include "aio.h"
+
+AsyncIOManager* AsyncIOManager::_aio_manager = NULL;
+
+// There is no liburing here, so talk to the kernel directly
+static int ioUringSetup(unsigned entries, struct io_uring_params *params)
+{
+    return syscall(__NR_io_uring_setup, entries, params);
+}
+
+static int ioUringEnter(int ringFd, unsigned toSubmit, unsigned minComplete, unsigned flags)
+{
+    return syscall(__NR_io_uring_enter, ringFd, toSubmit, minComplete, flags, NULL, 0);
+}
+
+AsyncIOManager* AsyncIOManager::instance()
+{
+    if(!_aio_manager)
+        _aio_manager = new AsyncIOManager();
+
+    return _aio_manager;
+}
+
+
+AsyncIOManager::AsyncIOManager()
+: _engine(IoUring), _inFlight(0), _ringFd(-1), _sqRing(NULL), _cqRing(NULL), _sqes(NULL), _stopping(false)
+{
+    // Fall back to threads if the kernel is too old or io_uring is locked down
+    if (setupIoUring())
+    {
+        _engine = ThreadPool;
+        startThreads();
+    }
+}
+
+
+AsyncIOManager::~AsyncIOManager()
+{
+    waitForAll();
+    teardownIoUring();
+    stopThreads();
+}
+
+
+RC AsyncIOManager::setEngine(IOEngine engine)
+{
+    if (engine == _engine)
+        return SUCCESS;
+    if (_inFlight > 0)
+        return AIO_REQUESTS_IN_FLIGHT;
+
+    if (engine == IoUring)
+    {
+        RC rc = setupIoUring();
+        if (rc)
+            return rc;
+        stopThreads();
+    }
+    else
+    {
+        teardownIoUring();
+        startThreads();
+    }
+    _engine = engine;
+    return SUCCESS;
+}
+
+
+IOEngine AsyncIOManager::getEngine()
+{
+    return _engine;
+}
+
+
+RC AsyncIOManager::submit(FileHandle &fileHandle, IORequestType type, PageNum pageNum,
+                          void *data, IOCallback callback, void *context)
+{
+    IORequest *request = new IORequest;
+    request->type = type;
+    request->fileHandle = &fileHandle;
+    request->pageNum = pageNum;
+    request->data = data;
+    request->iov.iov_base = data;
+    request->iov.iov_len = PAGE_SIZE;
+    request->callback = callback;
+    request->context = context;
+    request->rc = SUCCESS;
+
+    if (_engine == IoUring)
+    {
+        RC rc = submitIoUring(request);
+        if (rc)
+        {
+            delete request;
+            return rc;
+        }
+    }
+    else
+    {
+        lock_guard<mutex> guard(_lock);
+        _pending.push_back(request);
+        _workReady.notify_one();
+    }
+    _inFlight++;
+    return SUCCESS;
+}
+
+
+RC AsyncIOManager::waitForCompletions(unsigned minCompletions)
+{
+    if (minCompletions > _inFlight)
+        minCompletions = _inFlight;
+
+    if (_engine == IoUring)
+        return reapIoUring(minCompletions);
+    return reapThreadPool(minCompletions);
+}
+
+
+RC AsyncIOManager::waitForAll()
+{
+    // Callbacks may submit more requests, so keep going until nothing is left
+    while (_inFlight > 0)
+    {
+        RC rc = waitForCompletions(_inFlight);
+        if (rc)
+            return rc;
+    }
+    return SUCCESS;
+}
+
+
+unsigned AsyncIOManager::getInFlight()
+{
+    return _inFlight;
+}
+
+// Private helper methods ///////////////////////////////////////////////////////////////////
+
+RC AsyncIOManager::setupIoUring()
+{
+    struct io_uring_params params;
+    memset(&params, 0, sizeof(params));
+    _ringFd = ioUringSetup(AIO_QUEUE_DEPTH, &params);
+    if (_ringFd < 0)
+        return AIO_ENGINE_UNAVAILABLE;
+
+    // Map the submission ring, the completion ring (often the same mapping) and the submission entries
+    _sqRingSize = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+    _cqRingSize = params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe);
+    bool singleMap = params.features & IORING_FEAT_SINGLE_MMAP;
+    if (singleMap)
+        _sqRingSize = _cqRingSize = max(_sqRingSize, _cqRingSize);
+
+    _sqRing = mmap(NULL, _sqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, _ringFd, IORING_OFF_SQ_RING);
+    if (_sqRing == MAP_FAILED)
+    {
+        _sqRing = NULL;
+        teardownIoUring();
+        return AIO_ENGINE_UNAVAILABLE;
+    }
+    _cqRing = _sqRing;
+    if (!singleMap)
+    {
+        _cqRing = mmap(NULL, _cqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, _ringFd, IORING_OFF_CQ_RING);
+        if (_cqRing == MAP_FAILED)
+        {
+            _cqRing = NULL;
+            teardownIoUring();
+            return AIO_ENGINE_UNAVAILABLE;
+        }
+    }
+    void *sqes = mmap(NULL, params.sq_entries * sizeof(struct io_uring_sqe), PROT_READ | PROT_WRITE,
+                      MAP_SHARED | MAP_POPULATE, _ringFd, IORING_OFF_SQES);
+    if (sqes == MAP_FAILED)
+    {
+        teardownIoUring();
+        return AIO_ENGINE_UNAVAILABLE;
+    }
+    _sqes = (struct io_uring_sqe*) sqes;
+    _sqEntries = params.sq_entries;
+
+    char *sq = (char*) _sqRing;
+    _sqTail = (unsigned*) (sq + params.sq_off.tail);
+    _sqMask = (unsigned*) (sq + params.sq_off.ring_mask);
+    _sqArray = (unsigned*) (sq + params.sq_off.array);
+
+    char *cq = (char*) _cqRing;
+    _cqHead = (unsigned*) (cq + params.cq_off.head);
+    _cqTail = (unsigned*) (cq + params.cq_off.tail);
+    _cqMask = (unsigned*) (cq + params.cq_off.ring_mask);
+    _cqes = (struct io_uring_cqe*) (cq + params.cq_off.cqes);
+    _cqEntries = params.cq_entries;
+    return SUCCESS;
+}
+
+
+void AsyncIOManager::teardownIoUring()
+{
+    if (_sqes != NULL && _sqRing != NULL)
+        munmap(_sqes, _sqEntries * sizeof(struct io_uring_sqe));
+    if (_cqRing != NULL && _cqRing != _sqRing)
+        munmap(_cqRing, _cqRingSize);
+    if (_sqRing != NULL)
+        munmap(_sqRing, _sqRingSize);
+    if (_ringFd >= 0)
+        close(_ringFd);
+    _ringFd = -1;
+    _sqRing = NULL;
+    _cqRing = NULL;
+    _sqes = NULL;
+}
+
+
+// Queue one request and hand it to the kernel straight away, so it is in flight while we carry on
+RC AsyncIOManager::submitIoUring(IORequest *request)
+{
+    // Never have more requests out than the completion ring can hold
+    while (_inFlight >= _cqEntries || _inFlight >= _sqEntries)
+    {
+        RC rc = reapIoUring(1);
+        if (rc)
+            return rc;
+    }
+
+    // We are the only producer, so the tail can be read plainly
+    unsigned tail = *_sqTail;
+    unsigned index = tail & *_sqMask;
+    struct io_uring_sqe *sqe = &_sqes[index];
+    memset(sqe, 0, sizeof(*sqe));
+    sqe->opcode = request->type == ReadRequest ? IORING_OP_READV : IORING_OP_WRITEV;
+    sqe->fd = request->fileHandle->getFile()->fd;
+    sqe->addr = (unsigned long) &request->iov;
+    sqe->len = 1;
+    sqe->off = (unsigned long long) request->pageNum * PAGE_SIZE;
+    sqe->user_data = (unsigned long long) request;
+    _sqArray[index] = index;
+    __atomic_store_n(_sqTail, tail + 1, __ATOMIC_RELEASE);
+
+    int submitted;
+    do
+        submitted = ioUringEnter(_ringFd, 1, 0, 0);
+    while (submitted < 0 && errno == EINTR);
+    if (submitted != 1)
+    {
+        // Take the entry back, the kernel never saw it
+        __atomic_store_n(_sqTail, tail, __ATOMIC_RELEASE);
+        return AIO_SUBMIT_FAILED;
+    }
+    return SUCCESS;
+}
+
+
+RC AsyncIOManager::reapIoUring(unsigned minCompletions)
+{
+    unsigned completed = 0;
+    while (true)
+    {
+        unsigned head = *_cqHead;
+        unsigned tail = __atomic_load_n(_cqTail, __ATOMIC_ACQUIRE);
+        while (head != tail)
+        {
+            struct io_uring_cqe *cqe = &_cqes[head & *_cqMask];
+            IORequest *request = (IORequest*) cqe->user_data;
+            int result = cqe->res;
+            head++;
+            __atomic_store_n(_cqHead, head, __ATOMIC_RELEASE);
+            _inFlight--;
+
+            // A failed or short transfer is finished (or failed for good) synchronously
+            if (result != PAGE_SIZE)
+                request->rc = transfer(request);
+            complete(request);
+            completed++;
+        }
+        if (completed >= minCompletions || _inFlight == 0)
+            return SUCCESS;
+
+        if (ioUringEnter(_ringFd, 0, 1, IORING_ENTER_GETEVENTS) < 0 && errno != EINTR)
+            return AIO_WAIT_FAILED;
+    }
+}
+
+
+void AsyncIOManager::startThreads()
+{
+    _stopping = false;
+    for (unsigned i = 0; i < AIO_THREADS; i++)
+        _workers.push_back(thread(&AsyncIOManager::workerLoop, this));
+}
+
+
+void AsyncIOManager::stopThreads()
+{
+    {
+        lock_guard<mutex> guard(_lock);
+        _stopping = true;
+        _workReady.notify_all();
+    }
+    for (unsigned i = 0; i < _workers.size(); i++)
+        _workers[i].join();
+    _workers.clear();
+}
+
+
+void AsyncIOManager::workerLoop()
+{
+    unique_lock<mutex> lock(_lock);
+    while (true)
+    {
+        _workReady.wait(lock, [&]{ return _stopping || !_pending.empty(); });
+        if (_pending.empty())
+            return;
+
+        IORequest *request = _pending.front();
+        _pending.pop_front();
+
+        lock.unlock();
+        request->rc = transfer(request);
+        lock.lock();
+
+        _completed.push_back(request);
+        _workDone.notify_one();
+    }
+}
+
+
+RC AsyncIOManager::reapThreadPool(unsigned minCompletions)
+{
+    unsigned completed = 0;
+    while (true)
+    {
+        deque<IORequest*> done;
+        {
+            unique_lock<mutex> lock(_lock);
+            if (completed < minCompletions)
+                _workDone.wait(lock, [&]{ return !_completed.empty(); });
+            done.swap(_completed);
+        }
+
+        for (unsigned i = 0; i < done.size(); i++)
+        {
+            _inFlight--;
+            complete(done[i]);
+            completed++;
+        }
+        if (completed >= minCompletions || _inFlight == 0)
+            return SUCCESS;
+    }
+}
+
+
+// Do the whole transfer with blocking calls
+RC AsyncIOManager::transfer(IORequest *request)
+{
+    off_t offset = (off_t) request->pageNum * PAGE_SIZE;
+    if (request->type == ReadRequest)
+        return request->fileHandle->preadFully(request->data, offset);
+    return request->fileHandle->pwriteFully(request->data, offset);
+}
+
+
+// Account for a finished request and run its callback, always on the reaping thread
+void AsyncIOManager::complete(IORequest *request)
+{
+    FileHandle *fileHandle = request->fileHandle;
+    RC rc = request->rc;
+    if (rc == SUCCESS)
+    {
+        if (request->type == ReadRequest)
+            fileHandle->readPageCounter++;
+        else
+        {
+            fileHandle->writePageCounter++;
+            if (fileHandle->getFile() != NULL && fileHandle->getFile()->durability == Strict)
+                rc = fileHandle->sync();
+        }
+    }
+
+    IOCallback callback = request->callback;
+    void *context = request->context;
+    delete request;
+    if (callback != NULL)
+        callback(rc, context);
+}
@@ -0,0 +1,115 @@
+#ifndef _aio_h_
+#define _aio_h_
+
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include <sys/uio.h>
+
+#include "../rbf/pfm.h"
+
+#define AIO_ENGINE_UNAVAILABLE 1
+#define AIO_REQUESTS_IN_FLIGHT 2
+#define AIO_SUBMIT_FAILED      3
+#define AIO_WAIT_FAILED        4
+
+// Most requests io_uring keeps queued at once, and threads used by the fallback engine
+#define AIO_QUEUE_DEPTH 64
+#define AIO_THREADS     4
+
+using namespace std;
+
+// How asynchronous page I/O is carried out
+typedef enum {
+    IoUring = 0,    // Linux io_uring, used whenever the kernel lets us set up a ring
+    ThreadPool      // Worker threads doing blocking pread/pwrite
+} IOEngine;
+
+typedef enum { ReadRequest = 0, WriteRequest } IORequestType;
+
+// One page read or write waiting to complete
+typedef struct IORequest
+{
+    IORequestType type;
+    FileHandle *fileHandle;
+    PageNum pageNum;
+    void *data;
+    // io_uring reads the buffer address from here, so it lives as long as the request
+    struct iovec iov;
+    IOCallback callback;
+    void *context;
+    RC rc;
+} IORequest;
+
+// Process-wide engine behind FileHandle::submitRead / submitWrite
+// Requests run in the background. Their callbacks run on the thread that reaps them with
+// waitForCompletions, so callbacks never race with the rest of the code.
+class AsyncIOManager
+{
+public:
+    static AsyncIOManager* instance();                                           // Access to the _aio_manager instance
+
+    RC setEngine(IOEngine engine);                                               // Switch engines, fails with requests in flight
+    IOEngine getEngine();
+
+    RC submit(FileHandle &fileHandle, IORequestType type, PageNum pageNum,      // Start a page read or write
+              void *data, IOCallback callback, void *context);
+    RC waitForCompletions(unsigned minCompletions);                              // Reap at least minCompletions requests, running their callbacks
+    RC waitForAll();                                                             // Reap every request in flight
+    unsigned getInFlight();                                                      // Number of requests submitted but not reaped
+
+protected:
+    AsyncIOManager();                                                            // Constructor
+    ~AsyncIOManager();                                                           // Destructor
+
+private:
+    static AsyncIOManager *_aio_manager;
+
+    IOEngine _engine;
+    unsigned _inFlight;
+
+    // io_uring state: the ring file descriptor and the shared submission / completion rings
+    int _ringFd;
+    void *_sqRing;
+    void *_cqRing;
+    size_t _sqRingSize;
+    size_t _cqRingSize;
+    struct io_uring_sqe *_sqes;
+    unsigned _sqEntries;
+    unsigned *_sqTail;
+    unsigned *_sqMask;
+    unsigned *_sqArray;
+    unsigned *_cqHead;
+    unsigned *_cqTail;
+    unsigned *_cqMask;
+    struct io_uring_cqe *_cqes;
+    unsigned _cqEntries;
+
+    // Thread pool state
+    vector<thread> _workers;
+    mutex _lock;
+    condition_variable _workReady;
+    condition_variable _workDone;
+    deque<IORequest*> _pending;
+    deque<IORequest*> _completed;
+    bool _stopping;
+
+    // Private helper methods
+    RC setupIoUring();
+    void teardownIoUring();
+    RC submitIoUring(IORequest *request);
+    RC reapIoUring(unsigned minCompletions);
+
+    void startThreads();
+    void stopThreads();
+    void workerLoop();
+    RC reapThreadPool(unsigned minCompletions);
+
+    RC transfer(IORequest *request);
+    void complete(IORequest *request);
+};
+
+#endif
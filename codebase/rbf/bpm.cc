@@ -0,0 +1,505 @@
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+
+#include "bpm.h"
+#include "aio.h"
+
+BufferPoolManager* BufferPoolManager::_bp_manager = NULL;
+
+static bool sameFile(const FileId &a, const FileId &b)
+{
+    return a.device == b.device && a.inode == b.inode;
+}
+
+BufferPoolManager* BufferPoolManager::instance()
+{
+    if(!_bp_manager)
+        _bp_manager = new BufferPoolManager();
+
+    return _bp_manager;
+}
+
+
+BufferPoolManager::BufferPoolManager()
+: _pool(NULL), _clockHand(0), _logicalReads(0), _logicalWrites(0)
+{
+    allocateFrames(BPM_DEFAULT_POOL_SIZE);
+}
+
+
+BufferPoolManager::~BufferPoolManager()
+{
+    free(_pool);
+}
+
+
+RC BufferPoolManager::setPoolSize(unsigned frameCount)
+{
+    if (frameCount == 0)
+        return BPM_NO_FREE_FRAME;
+
+    // Reads ahead hold pins only until they land
+    AsyncIOManager::instance()->waitForAll();
+
+    // We can't move pages out from under anyone holding a pointer into the pool
+    for (unsigned i = 0; i < _frames.size(); i++)
+    {
+        if (_frames[i].valid && _frames[i].pinCount > 0)
+            return BPM_FRAMES_PINNED;
+    }
+
+    // Write back everything before throwing the old frames away
+    FileHandle requester;
+    for (unsigned i = 0; i < _frames.size(); i++)
+    {
+        if (_frames[i].valid && _frames[i].dirty)
+        {
+            RC rc = writeBack(requester, _frames[i]);
+            if (rc)
+                return rc;
+        }
+    }
+
+    return allocateFrames(frameCount);
+}
+
+
+unsigned BufferPoolManager::getPoolSize()
+{
+    return _frames.size();
+}
+
+
+RC BufferPoolManager::pinPage(FileHandle &fileHandle, PageNum pageNum, void *&data)
+{
+    if (fileHandle.getFile() == NULL)
+        return PFM_FILE_NOT_OPEN;
+    if (pageNum >= fileHandle.getNumberOfPages())
+        return FH_PAGE_DN_EXIST;
+
+    unsigned frameNum;
+    RC rc = getFrame(fileHandle, pageNum, true, frameNum);
+    if (rc)
+        return rc;
+
+    Frame &frame = _frames[frameNum];
+    frame.pinCount++;
+    frame.referenced = true;
+    fileHandle.logicalReadCounter++;
+    _logicalReads++;
+
+    data = frame.data;
+    return SUCCESS;
+}
+
+
+RC BufferPoolManager::unpinPage(FileHandle &fileHandle, PageNum pageNum, bool dirty)
+{
+    PageKey key = {fileHandle._fileId, pageNum};
+    auto it = _pageTable.find(key);
+    if (it == _pageTable.end())
+        return BPM_PAGE_NOT_PINNED;
+
+    Frame &frame = _frames[it->second];
+    if (frame.pinCount == 0)
+        return BPM_PAGE_NOT_PINNED;
+
+    frame.pinCount--;
+    if (dirty)
+    {
+        // Remember which open file to write the page back through
+        frame.dirty = true;
+        frame.file = fileHandle.getFile();
+        fileHandle.logicalWriteCounter++;
+        _logicalWrites++;
+        return fileHandle.pageDirtied();
+    }
+    return SUCCESS;
+}
+
+
+RC BufferPoolManager::readPage(FileHandle &fileHandle, PageNum pageNum, void *data)
+{
+    void *page;
+    RC rc = pinPage(fileHandle, pageNum, page);
+    if (rc)
+        return rc;
+
+    memcpy(data, page, PAGE_SIZE);
+    return unpinPage(fileHandle, pageNum, false);
+}
+
+
+RC BufferPoolManager::writePage(FileHandle &fileHandle, PageNum pageNum, const void *data)
+{
+    if (fileHandle.getFile() == NULL)
+        return PFM_FILE_NOT_OPEN;
+    if (pageNum >= fileHandle.getNumberOfPages())
+        return FH_PAGE_DN_EXIST;
+
+    // The whole page is overwritten, so there is no need to read it in on a miss
+    unsigned frameNum;
+    RC rc = getFrame(fileHandle, pageNum, false, frameNum);
+    if (rc)
+        return rc;
+
+    Frame &frame = _frames[frameNum];
+    memcpy(frame.data, data, PAGE_SIZE);
+    frame.referenced = true;
+    frame.dirty = true;
+    frame.file = fileHandle.getFile();
+    fileHandle.logicalWriteCounter++;
+    _logicalWrites++;
+    return fileHandle.pageDirtied();
+}
+
+
+// Pages already cached are left alone. Read ahead is only a hint, so it stops quietly
+// when there are no more frames to load into.
+RC BufferPoolManager::readAhead(FileHandle &fileHandle, PageNum pageNum, unsigned count)
+{
+    if (fileHandle.getFile() == NULL)
+        return PFM_FILE_NOT_OPEN;
+
+    unsigned numPages = fileHandle.getNumberOfPages();
+    for (PageNum p = pageNum; p < pageNum + count && p < numPages; p++)
+    {
+        PageKey key = {fileHandle._fileId, p};
+        if (_pageTable.find(key) != _pageTable.end())
+            continue;
+
+        unsigned frameNum;
+        if (findVictim(fileHandle, frameNum))
+            return SUCCESS;
+        Frame &frame = _frames[frameNum];
+        RC rc;
+        if (frame.valid)
+        {
+            if (frame.dirty && (rc = writeBackAround(fileHandle, frameNum)))
+                return rc;
+            PageKey oldKey = {frame.fileId, frame.pageNum};
+            _pageTable.erase(oldKey);
+            frame.valid = false;
+        }
+
+        // Keep the frame pinned while the read is in flight so it isn't picked as a victim again
+        frame.fileId = fileHandle._fileId;
+        frame.pageNum = p;
+        frame.file = NULL;
+        frame.pinCount = 1;
+        frame.dirty = false;
+        frame.referenced = true;
+        frame.valid = true;
+        frame.loading = true;
+        _pageTable[key] = frameNum;
+
+        if ((rc = fileHandle.submitRead(p, frame.data, readAheadDone, &frame)))
+        {
+            _pageTable.erase(key);
+            frame.valid = false;
+            frame.loading = false;
+            frame.pinCount = 0;
+            return rc;
+        }
+    }
+    return SUCCESS;
+}
+
+
+RC BufferPoolManager::prefetchPages(FileHandle &fileHandle, PageNum pageNum, unsigned count)
+{
+    RC rc = readAhead(fileHandle, pageNum, count);
+    RC waitRc = AsyncIOManager::instance()->waitForAll();
+    return rc ? rc : waitRc;
+}
+
+
+bool BufferPoolManager::isPageDirty(FileHandle &fileHandle, PageNum pageNum)
+{
+    PageKey key = {fileHandle._fileId, pageNum};
+    auto it = _pageTable.find(key);
+    return it != _pageTable.end() && _frames[it->second].dirty;
+}
+
+
+// Dirty pages are written in page order, each run of consecutive pages with a single write
+RC BufferPoolManager::flushFile(FileHandle &fileHandle)
+{
+    vector<pair<PageNum, unsigned> > dirty;
+    for (unsigned i = 0; i < _frames.size(); i++)
+    {
+        Frame &frame = _frames[i];
+        if (frame.valid && frame.dirty && sameFile(frame.fileId, fileHandle._fileId))
+            dirty.push_back(make_pair(frame.pageNum, i));
+    }
+    sort(dirty.begin(), dirty.end());
+
+    vector<unsigned> run;
+    for (unsigned i = 0; i < dirty.size(); i++)
+    {
+        if (!run.empty() && _frames[run.back()].pageNum + 1 != dirty[i].first)
+        {
+            RC rc = writeBackRun(fileHandle, run);
+            if (rc)
+                return rc;
+            run.clear();
+        }
+        run.push_back(dirty[i].second);
+    }
+    return writeBackRun(fileHandle, run);
+}
+
+
+void BufferPoolManager::discardFile(const FileId &fileId, PageNum firstPage)
+{
+    // A frame can't be reused while a read into it is still in flight
+    AsyncIOManager::instance()->waitForAll();
+
+    for (unsigned i = 0; i < _frames.size(); i++)
+    {
+        Frame &frame = _frames[i];
+        if (!frame.valid || !sameFile(frame.fileId, fileId) || frame.pageNum < firstPage)
+            continue;
+        PageKey key = {frame.fileId, frame.pageNum};
+        _pageTable.erase(key);
+        frame.valid = false;
+        frame.dirty = false;
+        frame.file = NULL;
+        frame.pinCount = 0;
+    }
+}
+
+
+RC BufferPoolManager::collectLogicalCounterValues(unsigned &logicalReadCount, unsigned &logicalWriteCount)
+{
+    logicalReadCount  = _logicalReads;
+    logicalWriteCount = _logicalWrites;
+    return SUCCESS;
+}
+
+// Private helper methods ///////////////////////////////////////////////////////////////////
+
+RC BufferPoolManager::allocateFrames(unsigned frameCount)
+{
+    char *pool = (char*) malloc((size_t) frameCount * PAGE_SIZE);
+    if (pool == NULL)
+        return BPM_MALLOC_FAILED;
+
+    free(_pool);
+    _pool = pool;
+    _pageTable.clear();
+    _frames.assign(frameCount, Frame());
+    for (unsigned i = 0; i < frameCount; i++)
+    {
+        _frames[i].pageNum = 0;
+        _frames[i].file = NULL;
+        _frames[i].pinCount = 0;
+        _frames[i].dirty = false;
+        _frames[i].referenced = false;
+        _frames[i].valid = false;
+        _frames[i].loading = false;
+        _frames[i].data = _pool + (size_t) i * PAGE_SIZE;
+    }
+    _clockHand = 0;
+    return SUCCESS;
+}
+
+// Find the frame holding pageNum, loading it (or just claiming a frame for it) on a miss
+RC BufferPoolManager::getFrame(FileHandle &fileHandle, PageNum pageNum, bool readFromDisk, unsigned &frameNum)
+{
+    PageKey key = {fileHandle._fileId, pageNum};
+    auto it = _pageTable.find(key);
+    if (it != _pageTable.end())
+    {
+        frameNum = it->second;
+        waitForLoad(_frames[frameNum]);
+        // The read may have failed, and taken the frame out of the table
+        if (_frames[frameNum].valid)
+            return SUCCESS;
+    }
+
+    RC rc = findVictim(fileHandle, frameNum);
+    if (rc)
+        return rc;
+
+    Frame &frame = _frames[frameNum];
+    if (frame.valid)
+    {
+        if (frame.dirty && (rc = writeBackAround(fileHandle, frameNum)))
+            return rc;
+        PageKey oldKey = {frame.fileId, frame.pageNum};
+        _pageTable.erase(oldKey);
+        frame.valid = false;
+    }
+
+    if (readFromDisk && (rc = fileHandle.readPageFromDisk(pageNum, frame.data)))
+        return rc;
+
+    frame.fileId = fileHandle._fileId;
+    frame.pageNum = pageNum;
+    frame.file = NULL;
+    frame.pinCount = 0;
+    frame.dirty = false;
+    frame.referenced = true;
+    frame.valid = true;
+    frame.loading = false;
+    _pageTable[key] = frameNum;
+    return SUCCESS;
+}
+
+// CLOCK: sweep the frames, giving every recently referenced page a second chance
+RC BufferPoolManager::findVictim(FileHandle &fileHandle, unsigned &frameNum)
+{
+    unsigned frameCount = _frames.size();
+    for (unsigned i = 0; i < 2 * frameCount; i++)
+    {
+        unsigned current = _clockHand;
+        _clockHand = (_clockHand + 1) % frameCount;
+
+        Frame &frame = _frames[current];
+        if (!frame.valid)
+        {
+            frameNum = current;
+            return SUCCESS;
+        }
+        if (frame.pinCount > 0)
+            continue;
+        if (frame.referenced)
+        {
+            frame.referenced = false;
+            continue;
+        }
+        frameNum = current;
+        return SUCCESS;
+    }
+    // Every frame is pinned
+    return BPM_NO_FREE_FRAME;
+}
+
+// Write a dirty frame to its file, charging the I/O to the handle that caused it
+RC BufferPoolManager::writeBack(FileHandle &fileHandle, Frame &frame)
+{
+    FileHandle owner;
+    owner.setFile(frame.file);
+    RC rc = owner.writePageToDisk(frame.pageNum, frame.data);
+    fileHandle.writePageCounter += owner.writePageCounter;
+    owner.setFile(NULL);
+    if (rc)
+        return rc;
+
+    frame.dirty = false;
+    frame.file = NULL;
+    return SUCCESS;
+}
+
+// Write back frames holding consecutive pages of one file, in page order
+RC BufferPoolManager::writeBackRun(FileHandle &fileHandle, const vector<unsigned> &frameNums)
+{
+    if (frameNums.empty())
+        return SUCCESS;
+
+    vector<const void*> pages;
+    for (unsigned i = 0; i < frameNums.size(); i++)
+        pages.push_back(_frames[frameNums[i]].data);
+
+    FileHandle owner;
+    owner.setFile(_frames[frameNums[0]].file);
+    RC rc = owner.writePagesToDisk(_frames[frameNums[0]].pageNum, pages);
+    fileHandle.writePageCounter += owner.writePageCounter;
+    owner.setFile(NULL);
+    if (rc)
+        return rc;
+
+    for (unsigned i = 0; i < frameNums.size(); i++)
+    {
+        _frames[frameNums[i]].dirty = false;
+        _frames[frameNums[i]].file = NULL;
+    }
+    return SUCCESS;
+}
+
+// Write back a dirty frame that is about to be evicted, along with the dirty pages next to it,
+// so a bulk load doesn't trickle out one page per eviction
+RC BufferPoolManager::writeBackAround(FileHandle &fileHandle, unsigned frameNum)
+{
+    Frame &victim = _frames[frameNum];
+    PageKey key = {victim.fileId, victim.pageNum};
+
+    // Walk down, then up, from the victim while the neighbouring pages are cached and dirty
+    vector<unsigned> before, after;
+    while (key.pageNum > 0 && before.size() + after.size() + 1 < BPM_MAX_WRITE_RUN)
+    {
+        key.pageNum--;
+        auto it = _pageTable.find(key);
+        if (it == _pageTable.end() || !_frames[it->second].dirty)
+            break;
+        before.push_back(it->second);
+    }
+    key.pageNum = victim.pageNum;
+    while (before.size() + after.size() + 1 < BPM_MAX_WRITE_RUN)
+    {
+        key.pageNum++;
+        auto it = _pageTable.find(key);
+        if (it == _pageTable.end() || !_frames[it->second].dirty)
+            break;
+        after.push_back(it->second);
+    }
+
+    vector<unsigned> run(before.rbegin(), before.rend());
+    run.push_back(frameNum);
+    run.insert(run.end(), after.begin(), after.end());
+    return writeBackRun(fileHandle, run);
+}
+
+// Called before a direct FileHandle::readPage so it doesn't see stale bytes on disk
+RC BufferPoolManager::flushPage(FileHandle &fileHandle, PageNum pageNum)
+{
+    PageKey key = {fileHandle._fileId, pageNum};
+    auto it = _pageTable.find(key);
+    if (it == _pageTable.end() || !_frames[it->second].dirty)
+        return SUCCESS;
+    return writeBack(fileHandle, _frames[it->second]);
+}
+
+// Called after a direct FileHandle::writePage so a cached copy doesn't go stale
+void BufferPoolManager::pageWritten(const FileId &fileId, PageNum pageNum, const void *data)
+{
+    PageKey key = {fileId, pageNum};
+    auto it = _pageTable.find(key);
+    if (it == _pageTable.end())
+        return;
+
+    Frame &frame = _frames[it->second];
+    waitForLoad(frame);
+    if (!frame.valid)
+        return;
+    memcpy(frame.data, data, PAGE_SIZE);
+    frame.dirty = false;
+    frame.file = NULL;
+}
+
+// Reap asynchronous completions until the read into this frame has landed
+void BufferPoolManager::waitForLoad(Frame &frame)
+{
+    AsyncIOManager *aio = AsyncIOManager::instance();
+    while (frame.loading && aio->getInFlight() > 0)
+    {
+        if (aio->waitForCompletions(1))
+            break;
+    }
+}
+
+// Completion of a read ahead: the frame becomes an ordinary cached page, or is dropped if the read failed
+void BufferPoolManager::readAheadDone(RC rc, void *context)
+{
+    Frame *frame = (Frame*) context;
+    frame->loading = false;
+    frame->pinCount--;
+    if (rc)
+    {
+        PageKey key = {frame->fileId, frame->pageNum};
+        instance()->_pageTable.erase(key);
+        frame->valid = false;
+    }
+}
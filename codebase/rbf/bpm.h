@@ -0,0 +1,120 @@
+#ifndef _bpm_h_
+#define _bpm_h_
+
+#include <unordered_map>
+#include <vector>
+
+#include "../rbf/pfm.h"
+
+#define BPM_NO_FREE_FRAME     1
+#define BPM_PAGE_NOT_PINNED   2
+#define BPM_FRAMES_PINNED     3
+#define BPM_MALLOC_FAILED     4
+
+#define BPM_DEFAULT_POOL_SIZE 256
+// Most neighbouring dirty pages written back together with an evicted page
+#define BPM_MAX_WRITE_RUN     64
+
+using namespace std;
+
+// A single page-sized slot of the buffer pool
+typedef struct Frame
+{
+    FileId fileId;
+    PageNum pageNum;
+    // Set while the frame is dirty so the page can be written back, NULL otherwise
+    OpenFile *file;
+    unsigned pinCount;
+    bool dirty;
+    // Second chance bit for the CLOCK replacement policy
+    bool referenced;
+    bool valid;
+    // Set while an asynchronous read into the frame is in flight, the frame stays pinned until it lands
+    bool loading;
+    char *data;
+} Frame;
+
+// Key of the page table: a page of a particular file
+typedef struct PageKey
+{
+    FileId fileId;
+    PageNum pageNum;
+
+    bool operator==(const PageKey &other) const
+    {
+        return fileId.device == other.fileId.device
+            && fileId.inode == other.fileId.inode
+            && pageNum == other.pageNum;
+    }
+} PageKey;
+
+struct PageKeyHash
+{
+    size_t operator()(const PageKey &key) const
+    {
+        size_t h = (size_t) key.fileId.inode * 1000003u;
+        h ^= (size_t) key.fileId.device + 0x9e3779b9 + (h << 6) + (h >> 2);
+        h ^= (size_t) key.pageNum + 0x9e3779b9 + (h << 6) + (h >> 2);
+        return h;
+    }
+};
+
+// Process-wide page cache shared by every FileHandle
+// Pages are cached by file identity, so they survive closing and reopening a file.
+// Dirty pages are written back when evicted, flushed, or when the last handle on the file closes,
+// or sooner if the durability mode of the file asks for it (see FileHandle::pageDirtied).
+class BufferPoolManager
+{
+public:
+    static BufferPoolManager* instance();                                          // Access to the _bp_manager instance
+
+    RC setPoolSize(unsigned frameCount);                                           // Resize the pool, fails if any page is pinned
+    unsigned getPoolSize();                                                        // Number of frames in the pool
+
+    RC pinPage(FileHandle &fileHandle, PageNum pageNum, void *&data);              // Pin a page in the pool and point data at it
+    RC unpinPage(FileHandle &fileHandle, PageNum pageNum, bool dirty);             // Release a pin, marking the page dirty if modified
+
+    RC readPage(FileHandle &fileHandle, PageNum pageNum, void *data);              // Copy a page out of the pool
+    RC writePage(FileHandle &fileHandle, PageNum pageNum, const void *data);       // Copy a page into the pool and mark it dirty
+    RC readAhead(FileHandle &fileHandle, PageNum pageNum, unsigned count);         // Start loading pages not yet cached in the background
+    RC prefetchPages(FileHandle &fileHandle, PageNum pageNum, unsigned count);     // Same, but wait for the pages to be loaded
+
+    bool isPageDirty(FileHandle &fileHandle, PageNum pageNum);                     // Does the pool hold changes to the page not yet on disk
+    RC flushFile(FileHandle &fileHandle);                                          // Write back every dirty page of the file
+    void discardFile(const FileId &fileId, PageNum firstPage = 0);                 // Forget pages of the file from firstPage on, without writing them
+    RC collectLogicalCounterValues(unsigned &logicalReadCount, unsigned &logicalWriteCount);  // Same as FileHandle's, for every handle together
+
+    friend class FileHandle;
+
+protected:
+    BufferPoolManager();                                                           // Constructor
+    ~BufferPoolManager();                                                          // Destructor
+
+private:
+    static BufferPoolManager *_bp_manager;
+
+    vector<Frame> _frames;
+    char *_pool;
+    unsigned _clockHand;
+    unordered_map<PageKey, unsigned, PageKeyHash> _pageTable;
+
+    // Logical page accesses through any handle, including those closed since
+    unsigned _logicalReads;
+    unsigned _logicalWrites;
+
+    // Private helper methods
+    RC allocateFrames(unsigned frameCount);
+    RC getFrame(FileHandle &fileHandle, PageNum pageNum, bool readFromDisk, unsigned &frameNum);
+    RC findVictim(FileHandle &fileHandle, unsigned &frameNum);
+    RC writeBack(FileHandle &fileHandle, Frame &frame);
+    RC writeBackRun(FileHandle &fileHandle, const vector<unsigned> &frameNums);
+    RC writeBackAround(FileHandle &fileHandle, unsigned frameNum);
+    void waitForLoad(Frame &frame);
+    static void readAheadDone(RC rc, void *context);
+
+    // Keep cached copies coherent with direct FileHandle I/O
+    RC flushPage(FileHandle &fileHandle, PageNum pageNum);
+    void pageWritten(const FileId &fileId, PageNum pageNum, const void *data);
+};
+
+#endif
@@ -0,0 +1,204 @@
+#include <cstring>
+
+#if defined(__x86_64__) || defined(__i386__)
+#define FILTER_X86
+#include <immintrin.h>
+#endif
+
+#include "filter.h"
+
+static bool _kernelChosen = false;
+static FilterKernel _kernel = ScalarKernel;
+
+bool filterKernelSupported(FilterKernel kernel)
+{
+    switch (kernel)
+    {
+        case ScalarKernel: return true;
+#ifdef FILTER_X86
+        case SSEKernel: return __builtin_cpu_supports("sse2");
+        case AVX2Kernel: return __builtin_cpu_supports("avx2");
+#endif
+        default: return false;
+    }
+}
+
+FilterKernel getFilterKernel()
+{
+    if (!_kernelChosen)
+    {
+        _kernel = ScalarKernel;
+        if (filterKernelSupported(AVX2Kernel))
+            _kernel = AVX2Kernel;
+        else if (filterKernelSupported(SSEKernel))
+            _kernel = SSEKernel;
+        _kernelChosen = true;
+    }
+    return _kernel;
+}
+
+RC setFilterKernel(FilterKernel kernel)
+{
+    if (!filterKernelSupported(kernel))
+        return FILTER_KERNEL_UNSUPPORTED;
+    _kernel = kernel;
+    _kernelChosen = true;
+    return SUCCESS;
+}
+
+// Scalar kernels, also used for what is left over after the vector loops. start is a multiple of 8.
+template <typename T>
+static void filterScalar(const T *values, unsigned start, unsigned count, CompOp compOp, T constant, uint8_t *selection)
+{
+    for (unsigned i = start; i < count; i += 8)
+    {
+        uint8_t bits = 0;
+        for (unsigned j = 0; j < 8 && i + j < count; j++)
+        {
+            T value = values[i + j];
+            bool match;
+            switch (compOp)
+            {
+                case EQ_OP: match = value == constant; break;
+                case LT_OP: match = value < constant; break;
+                case GT_OP: match = value > constant; break;
+                case LE_OP: match = value <= constant; break;
+                case GE_OP: match = value >= constant; break;
+                case NE_OP: match = value != constant; break;
+                case NO_OP: match = true; break;
+                default: match = false; break;
+            }
+            bits |= match << j;
+        }
+        selection[i / 8] = bits;
+    }
+}
+
+#ifdef FILTER_X86
+
+// Ints only have == and > compares: < swaps the operands, and !=, <=, >= invert the result.
+// These return how far they got, the scalar kernel does the rest.
+
+__attribute__((target("avx2")))
+static unsigned filterIntsAVX2(const int32_t *values, unsigned count, CompOp compOp, int32_t constant, uint8_t *selection)
+{
+    bool equal = compOp == EQ_OP || compOp == NE_OP;
+    bool swap = compOp == LT_OP || compOp == GE_OP;
+    uint8_t invert = (compOp == NE_OP || compOp == LE_OP || compOp == GE_OP) ? 0xff : 0;
+
+    __m256i c = _mm256_set1_epi32(constant);
+    unsigned i = 0;
+    for (; i + 8 <= count; i += 8)
+    {
+        __m256i v = _mm256_loadu_si256((const __m256i*) (values + i));
+        __m256i mask = equal ? _mm256_cmpeq_epi32(v, c) : swap ? _mm256_cmpgt_epi32(c, v) : _mm256_cmpgt_epi32(v, c);
+        selection[i / 8] = _mm256_movemask_ps(_mm256_castsi256_ps(mask)) ^ invert;
+    }
+    return i;
+}
+
+__attribute__((target("avx2")))
+static unsigned filterRealsAVX2(const float *values, unsigned count, CompOp compOp, float constant, uint8_t *selection)
+{
+    // Ordered compares are false for NaN like the scalar ones, != is unordered and true for NaN
+    __m256 c = _mm256_set1_ps(constant);
+    unsigned i = 0;
+    for (; i + 8 <= count; i += 8)
+    {
+        __m256 v = _mm256_loadu_ps(values + i);
+        __m256 mask;
+        switch (compOp)
+        {
+            case EQ_OP: mask = _mm256_cmp_ps(v, c, _CMP_EQ_OQ); break;
+            case LT_OP: mask = _mm256_cmp_ps(v, c, _CMP_LT_OQ); break;
+            case GT_OP: mask = _mm256_cmp_ps(v, c, _CMP_GT_OQ); break;
+            case LE_OP: mask = _mm256_cmp_ps(v, c, _CMP_LE_OQ); break;
+            case GE_OP: mask = _mm256_cmp_ps(v, c, _CMP_GE_OQ); break;
+            case NE_OP: mask = _mm256_cmp_ps(v, c, _CMP_NEQ_UQ); break;
+            default: return i;
+        }
+        selection[i / 8] = _mm256_movemask_ps(mask);
+    }
+    return i;
+}
+
+// Two 4 wide compares make up each byte of the bitmap
+__attribute__((target("sse2")))
+static unsigned filterIntsSSE(const int32_t *values, unsigned count, CompOp compOp, int32_t constant, uint8_t *selection)
+{
+    bool equal = compOp == EQ_OP || compOp == NE_OP;
+    bool swap = compOp == LT_OP || compOp == GE_OP;
+    uint8_t invert = (compOp == NE_OP || compOp == LE_OP || compOp == GE_OP) ? 0xff : 0;
+
+    __m128i c = _mm_set1_epi32(constant);
+    unsigned i = 0;
+    for (; i + 8 <= count; i += 8)
+    {
+        __m128i low = _mm_loadu_si128((const __m128i*) (values + i));
+        __m128i high = _mm_loadu_si128((const __m128i*) (values + i + 4));
+        __m128i lowMask = equal ? _mm_cmpeq_epi32(low, c) : swap ? _mm_cmpgt_epi32(c, low) : _mm_cmpgt_epi32(low, c);
+        __m128i highMask = equal ? _mm_cmpeq_epi32(high, c) : swap ? _mm_cmpgt_epi32(c, high) : _mm_cmpgt_epi32(high, c);
+        int bits = _mm_movemask_ps(_mm_castsi128_ps(lowMask)) | _mm_movemask_ps(_mm_castsi128_ps(highMask)) << 4;
+        selection[i / 8] = bits ^ invert;
+    }
+    return i;
+}
+
+__attribute__((target("sse2")))
+static unsigned filterRealsSSE(const float *values, unsigned count, CompOp compOp, float constant, uint8_t *selection)
+{
+    __m128 c = _mm_set1_ps(constant);
+    unsigned i = 0;
+    for (; i + 8 <= count; i += 8)
+    {
+        __m128 low = _mm_loadu_ps(values + i);
+        __m128 high = _mm_loadu_ps(values + i + 4);
+        __m128 lowMask, highMask;
+        switch (compOp)
+        {
+            case EQ_OP: lowMask = _mm_cmpeq_ps(low, c); highMask = _mm_cmpeq_ps(high, c); break;
+            case LT_OP: lowMask = _mm_cmplt_ps(low, c); highMask = _mm_cmplt_ps(high, c); break;
+            case GT_OP: lowMask = _mm_cmpgt_ps(low, c); highMask = _mm_cmpgt_ps(high, c); break;
+            case LE_OP: lowMask = _mm_cmple_ps(low, c); highMask = _mm_cmple_ps(high, c); break;
+            case GE_OP: lowMask = _mm_cmpge_ps(low, c); highMask = _mm_cmpge_ps(high, c); break;
+            case NE_OP: lowMask = _mm_cmpneq_ps(low, c); highMask = _mm_cmpneq_ps(high, c); break;
+            default: return i;
+        }
+        selection[i / 8] = _mm_movemask_ps(lowMask) | _mm_movemask_ps(highMask) << 4;
+    }
+    return i;
+}
+
+#endif
+
+void filterInts(const int32_t *values, unsigned count, CompOp compOp, int32_t constant, uint8_t *selection)
+{
+    unsigned done = 0;
+#ifdef FILTER_X86
+    if (compOp != NO_OP)
+    {
+        FilterKernel kernel = getFilterKernel();
+        if (kernel == AVX2Kernel)
+            done = filterIntsAVX2(values, count, compOp, constant, selection);
+        else if (kernel == SSEKernel)
+            done = filterIntsSSE(values, count, compOp, constant, selection);
+    }
+#endif
+    filterScalar(values, done, count, compOp, constant, selection);
+}
+
+void filterReals(const float *values, unsigned count, CompOp compOp, float constant, uint8_t *selection)
+{
+    unsigned done = 0;
+#ifdef FILTER_X86
+    if (compOp != NO_OP)
+    {
+        FilterKernel kernel = getFilterKernel();
+        if (kernel == AVX2Kernel)
+            done = filterRealsAVX2(values, count, compOp, constant, selection);
+        else if (kernel == SSEKernel)
+            done = filterRealsSSE(values, count, compOp, constant, selection);
+    }
+#endif
+    filterScalar(values, done, count, compOp, constant, selection);
+}
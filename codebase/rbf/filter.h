@@ -0,0 +1,29 @@
+#ifndef _filter_h_
+#define _filter_h_
+
+#include <cstdint>
+
+#include "../rbf/rbfm.h"
+
+#define FILTER_KERNEL_UNSUPPORTED 1
+
+// Predicate kernels compare a run of 4 byte column values against a constant and set one bit per
+// value in a selection bitmap: bit i % 8 of byte i / 8 is set when value i satisfies the CompOp.
+// They give the same answers as the one value at a time comparisons in RBFM_ScanIterator.
+
+// Instruction set used by the kernels, picked from what the CPU supports the first time they run
+typedef enum {
+    ScalarKernel = 0,   // One value at a time, works everywhere
+    SSEKernel,          // 4 values per instruction (SSE2)
+    AVX2Kernel          // 8 values per instruction
+} FilterKernel;
+
+FilterKernel getFilterKernel();
+RC setFilterKernel(FilterKernel kernel);                // Fails if the CPU doesn't support the kernel
+bool filterKernelSupported(FilterKernel kernel);
+
+// selection needs room for (count + 7) / 8 bytes
+void filterInts(const int32_t *values, unsigned count, CompOp compOp, int32_t constant, uint8_t *selection);
+void filterReals(const float *values, unsigned count, CompOp compOp, float constant, uint8_t *selection);
+
+#endif
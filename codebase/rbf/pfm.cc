@@ -1,12 +1,31 @@
+#include <algorithm>
+#include <cerrno>
 #include <cstdio>
 #include <string>
 
+#include <fcntl.h>
+#include <limits.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/mman.h>
 #include <sys/stat.h>
 #include <sys/types.h>
+#include <sys/uio.h>
 
 #include "pfm.h"
+#include "bpm.h"
+#include "aio.h"
+
+// Milliseconds on a clock that never goes backwards, for GroupFlush
+static unsigned long long currentMillis()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (unsigned long long) ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
 
 PagedFileManager* PagedFileManager::_pf_manager = NULL;
+BufferPoolManager* PagedFileManager::_bp_manager = NULL;
 
 PagedFileManager* PagedFileManager::instance()
 {
@@ -18,7 +37,10 @@ PagedFileManager* PagedFileManager::instance()
 
 
 PagedFileManager::PagedFileManager()
+: _durability(WriteThrough), _groupPages(PFM_GROUP_FLUSH_PAGES), _groupMillis(PFM_GROUP_FLUSH_MILLIS)
 {
+    // Initialize the shared BufferPoolManager instance
+    _bp_manager = BufferPoolManager::instance();
 }
 
 
@@ -32,20 +54,29 @@ RC PagedFileManager::createFile(const string &fileName)
     // If the file already exists, error
     if (fileExists(fileName))
         return PFM_FILE_EXISTS;
-    // Attempt to open the file for writing
-    FILE *pFile = fopen(fileName.c_str(), "wb");
+    // Attempt to create the file
+    int fd = open(fileName.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
     // Return an error if we fail
-
-    if (pFile == NULL)
+    if (fd < 0)
         return PFM_OPEN_FAILED;
 
-    fclose (pFile);
+    close(fd);
+
+    // A new file may reuse the identity of one removed behind our back, drop anything cached for it
+    FileId fileId;
+    if (getFileId(fileName, fileId))
+        _bp_manager->discardFile(fileId);
     return SUCCESS;
 }
 
 
 RC PagedFileManager::destroyFile(const string &fileName)
 {
+    // Cached pages of the file must not outlive it
+    FileId fileId;
+    if (getFileId(fileName, fileId))
+        _bp_manager->discardFile(fileId);
+
     // If file cannot be successfully removed, error
     if (remove(fileName.c_str()) != 0)
         return PFM_REMOVE_FAILED;
@@ -57,21 +88,49 @@ RC PagedFileManager::destroyFile(const string &fileName)
 RC PagedFileManager::openFile(const string &fileName, FileHandle &fileHandle)
 {
     // If this handle already has an open file, error
-    if (fileHandle.getfd() != NULL)
+    if (fileHandle.getFile() != NULL)
         return PFM_HANDLE_IN_USE;
 
     // If the file doesn't exist, error
-    if (!fileExists(fileName.c_str()))
+    FileId fileId;
+    if (!getFileId(fileName, fileId))
         return PFM_FILE_DN_EXIST;
 
-    // Open the file for reading/writing in binary mode
-    FILE *pFile;
-    pFile = fopen(fileName.c_str(), "rb+");
+    // If another handle already has this file open, share it so both see the same cached pages
+    // (its page count is already known, and may be ahead of the file while appends wait in the pool)
+    OpenFile *file = findOpenFile(fileId);
+    if (file != NULL)
+    {
+        file->refCount++;
+        fileHandle.setFile(file);
+        return SUCCESS;
+    }
+
+    // Open the file for reading/writing
+    int fd = open(fileName.c_str(), O_RDWR);
     // If we fail, error
-    if (pFile == NULL)
+    if (fd < 0)
         return PFM_OPEN_FAILED;
 
-    fileHandle.setfd(pFile);
+    file = new OpenFile;
+    file->id = fileId;
+    file->fd = fd;
+    file->refCount = 1;
+    file->durability = _durability;
+    file->groupPages = _groupPages;
+    file->groupMillis = _groupMillis;
+    file->pendingPages = 0;
+    file->lastFlushMillis = currentMillis();
+    RC rc = refreshNumberOfPages(file);
+    if (rc)
+    {
+        close(fd);
+        delete file;
+        return rc;
+    }
+    _openFiles.push_back(file);
+
+    fileHandle.setFile(file);
 
     return SUCCESS;
 }
@@ -79,18 +138,46 @@ RC PagedFileManager::openFile(const string &fileName, FileHandle &fileHandle)
 
 RC PagedFileManager::closeFile(FileHandle &fileHandle)
 {
-    FILE *pFile = fileHandle.getfd();
+    OpenFile *file = fileHandle.getFile();
 
     // If not an open file, error
-    if (pFile == NULL)
+    if (file == NULL)
         return 1;
 
-    // Flush and close the file
-    fclose(pFile);
+    // Other handles still use this file
+    if (--file->refCount > 0)
+    {
+        fileHandle.setFile(NULL);
+        return SUCCESS;
+    }
 
-    fileHandle.setfd(NULL);
+    // Last handle: nothing may still be reading or writing the file when it goes
+    AsyncIOManager::instance()->waitForAll();
 
-    return SUCCESS;
+    // Write back any dirty pages while we can still reach the file,
+    // and unless writes are plain write through, make sure they are on disk
+    RC rc;
+    if (file->durability == WriteThrough)
+        rc = _bp_manager->flushFile(fileHandle);
+    else
+        rc = fileHandle.flush();
+
+    // Close the file
+    close(file->fd);
+
+    _openFiles.erase(find(_openFiles.begin(), _openFiles.end(), file));
+    delete file;
+
+    fileHandle.setFile(NULL);
+
+    return rc;
+}
+
+void PagedFileManager::setDurability(Durability durability, unsigned groupPages, unsigned groupMillis)
+{
+    _durability = durability;
+    _groupPages = groupPages;
+    _groupMillis = groupMillis;
 }
 
 // Check if a file already exists
@@ -101,14 +188,56 @@ bool PagedFileManager::fileExists(const string &fileName)
     return stat(fileName.c_str(), &sb) == 0;
 }
 
+// Get the device/inode pair identifying a file, false if it doesn't exist
+bool PagedFileManager::getFileId(const string &fileName, FileId &fileId)
+{
+    struct stat sb;
+    if (stat(fileName.c_str(), &sb) != 0)
+        return false;
+    fileId.device = sb.st_dev;
+    fileId.inode = sb.st_ino;
+    return true;
+}
+
+OpenFile *PagedFileManager::findOpenFile(const FileId &fileId)
+{
+    for (unsigned i = 0; i < _openFiles.size(); i++)
+    {
+        if (_openFiles[i]->id.device == fileId.device && _openFiles[i]->id.inode == fileId.inode)
+            return _openFiles[i];
+    }
+    return NULL;
+}
+
+// Take the page count from the file size. This is the only place we stat an open file, so it is where
+// we notice the file was truncated behind our back: cached pages past the new end are dropped.
+RC PagedFileManager::refreshNumberOfPages(OpenFile *file)
+{
+    struct stat sb;
+    if (fstat(file->fd, &sb) != 0)
+        return PFM_OPEN_FAILED;
+
+    // A paged file is always a whole number of pages
+    if (sb.st_size % PAGE_SIZE != 0)
+        return PFM_FILE_TRUNCATED;
+
+    file->numPages = sb.st_size / PAGE_SIZE;
+    _bp_manager->discardFile(file->id, file->numPages);
+    return SUCCESS;
+}
+
 
 FileHandle::FileHandle()
 {
     readPageCounter = 0;
     writePageCounter = 0;
     appendPageCounter = 0;
+    logicalReadCounter = 0;
+    logicalWriteCounter = 0;
 
-    _fd = NULL;
+    _file = NULL;
+    _fileId.device = 0;
+    _fileId.inode = 0;
 }
 
 
@@ -117,74 +246,127 @@ FileHandle::~FileHandle()
 }
 
 
+// Direct page reads always go to disk, so write back any newer copy held by the buffer pool first
 RC FileHandle::readPage(PageNum pageNum, void *data)
 {
-    // If pageNum doesn't exist, error
-    if (getNumberOfPages() < pageNum)
-        return FH_PAGE_DN_EXIST;
-
-    // Try to seek to the specified page
-    if (fseek(_fd, PAGE_SIZE * pageNum, SEEK_SET))
-        return FH_SEEK_FAILED;
-
-    // Try to read the specified page
-    if (fread(data, 1, PAGE_SIZE, _fd) != PAGE_SIZE)
-        return FH_READ_FAILED;
+    RC rc = BufferPoolManager::instance()->flushPage(*this, pageNum);
+    if (rc)
+        return rc;
 
-    readPageCounter++;
-    return SUCCESS;
+    return readPageFromDisk(pageNum, data);
 }
 
 
+// Direct page writes go straight to disk and refresh any copy held by the buffer pool,
+// unless the file is in a write back mode, in which case they wait in the pool
 RC FileHandle::writePage(PageNum pageNum, const void *data)
 {
-    // Check if the page exists
-    if (getNumberOfPages() < pageNum)
-        return FH_PAGE_DN_EXIST;
+    if (_file->durability == WriteBack || _file->durability == GroupFlush)
+        return BufferPoolManager::instance()->writePage(*this, pageNum, data);
 
-    // Seek to the start of the page
-    if (fseek(_fd, PAGE_SIZE * pageNum, SEEK_SET))
-        return FH_SEEK_FAILED;
+    RC rc = writePageToDisk(pageNum, data);
+    if (rc)
+        return rc;
+
+    BufferPoolManager::instance()->pageWritten(_fileId, pageNum, data);
+    if (_file->durability == Strict)
+        return sync();
+    return SUCCESS;
+}
 
-    // Write the page
-    if (fwrite(data, 1, PAGE_SIZE, _fd) == PAGE_SIZE)
+
+RC FileHandle::appendPage(const void *data)
+{
+    // In a write back mode the new page only exists in the pool until it is written back
+    if (_file->durability == WriteBack || _file->durability == GroupFlush)
     {
-        // Immediately commit changes to disk
-        fflush(_fd);
-        writePageCounter++;
+        _file->numPages++;
+        RC rc = BufferPoolManager::instance()->writePage(*this, _file->numPages - 1, data);
+        if (rc)
+        {
+            _file->numPages--;
+            return rc;
+        }
+        appendPageCounter++;
         return SUCCESS;
     }
-    
-    return FH_WRITE_FAILED;
+
+    // Write the new page just past the current end of the file
+    off_t offset = (off_t) _file->numPages * PAGE_SIZE;
+    if (pwriteFully(data, offset))
+        return FH_WRITE_FAILED;
+
+    _file->numPages++;
+    appendPageCounter++;
+    if (_file->durability == Strict)
+        return sync();
+    return SUCCESS;
 }
 
 
-RC FileHandle::appendPage(const void *data)
+RC FileHandle::appendPages(const void *data, unsigned count)
 {
-    // Seek to the end of the file
-    if (fseek(_fd, 0, SEEK_END))
-        return FH_SEEK_FAILED;
-
-    // Write the new page
-    if (fwrite(data, 1, PAGE_SIZE, _fd) == PAGE_SIZE)
+    // Write back modes stage every page in the pool
+    if (_file->durability == WriteBack || _file->durability == GroupFlush)
     {
-        fflush(_fd);
-        appendPageCounter++;
+        for (unsigned i = 0; i < count; i++)
+        {
+            RC rc = appendPage((const char*) data + (size_t) i * PAGE_SIZE);
+            if (rc)
+                return rc;
+        }
         return SUCCESS;
     }
-    return FH_WRITE_FAILED;
+
+    // Write every page just past the current end of the file, retrying short writes
+    size_t length = (size_t) count * PAGE_SIZE;
+    off_t offset = (off_t) _file->numPages * PAGE_SIZE;
+    size_t done = 0;
+    while (done < length)
+    {
+        ssize_t n = pwrite(_file->fd, (const char*) data + done, length - done, offset + done);
+        if (n < 0 && errno == EINTR)
+            continue;
+        if (n <= 0)
+            return FH_WRITE_FAILED;
+        done += n;
+    }
+
+    _file->numPages += count;
+    appendPageCounter += count;
+    if (_file->durability == Strict)
+        return sync();
+    return SUCCESS;
 }
 
 
 unsigned FileHandle::getNumberOfPages()
 {
-    // Use stat to get the file size
-    struct stat sb;
-    if (fstat(fileno(_fd), &sb) != 0)
-        // On error, return 0
-        return 0;
-    // Filesize is always PAGE_SIZE * number of pages
-    return sb.st_size / PAGE_SIZE;
+    return _file->numPages;
+}
+
+
+// Pages past the new end still in the pool are thrown away, not written back, so they can't grow the file again
+RC FileHandle::truncate(unsigned numPages)
+{
+    if (_file == NULL)
+        return PFM_FILE_NOT_OPEN;
+    if (numPages >= _file->numPages)
+        return SUCCESS;
+
+    BufferPoolManager::instance()->discardFile(_fileId, numPages);
+    if (ftruncate(_file->fd, (off_t) numPages * PAGE_SIZE) != 0)
+        return FH_WRITE_FAILED;
+    _file->numPages = numPages;
+    if (_file->durability == Strict)
+        return sync();
+    return SUCCESS;
+}
+
+
+FileId FileHandle::getFileId()
+{
+    return _fileId;
 }
 
 
@@ -196,12 +378,277 @@ RC FileHandle::collectCounterValues(unsigned &readPageCount, unsigned &writePage
     return SUCCESS;
 }
 
-void FileHandle::setfd(FILE *fd)
+
+RC FileHandle::collectLogicalCounterValues(unsigned &logicalReadCount, unsigned &logicalWriteCount)
+{
+    logicalReadCount  = logicalReadCounter;
+    logicalWriteCount = logicalWriteCounter;
+    return SUCCESS;
+}
+
+
+// Change how this file's writes reach the disk from now on, see Durability
+RC FileHandle::setDurability(Durability durability, unsigned groupPages, unsigned groupMillis)
 {
-    _fd = fd;
+    if (_file == NULL)
+        return PFM_FILE_NOT_OPEN;
+
+    // Writes made from now on go to disk right away, so don't leave older ones behind in the pool
+    if (durability == WriteThrough || durability == Strict)
+    {
+        RC rc = flush();
+        if (rc)
+            return rc;
+    }
+
+    _file->durability = durability;
+    _file->groupPages = groupPages;
+    _file->groupMillis = groupMillis;
+    return SUCCESS;
 }
 
-FILE *FileHandle::getfd()
+
+RC FileHandle::flush()
 {
-    return _fd;
+    if (_file == NULL)
+        return PFM_FILE_NOT_OPEN;
+
+    RC rc = BufferPoolManager::instance()->flushFile(*this);
+    if (rc)
+        return rc;
+
+    _file->pendingPages = 0;
+    _file->lastFlushMillis = currentMillis();
+    return sync();
+}
+
+
+// The mapping sees the file as it is on disk (and any later pwrite, through the page cache),
+// so pages still waiting in the buffer pool are written back first
+RC FileHandle::mapPages(void *&region, unsigned &numPages)
+{
+    region = NULL;
+    numPages = 0;
+    if (_file == NULL)
+        return PFM_FILE_NOT_OPEN;
+
+    RC rc = BufferPoolManager::instance()->flushFile(*this);
+    if (rc)
+        return rc;
+
+    numPages = _file->numPages;
+    if (numPages == 0)
+        return SUCCESS;
+
+    size_t length = (size_t) numPages * PAGE_SIZE;
+    void *mapped = mmap(NULL, length, PROT_READ, MAP_SHARED, _file->fd, 0);
+    if (mapped == MAP_FAILED)
+    {
+        numPages = 0;
+        return FH_MAP_FAILED;
+    }
+
+    // Scans go front to back: ask for aggressive readahead and early reclaim
+    madvise(mapped, length, MADV_SEQUENTIAL);
+    region = mapped;
+    return SUCCESS;
+}
+
+
+// Doesn't need the file to still be open
+RC FileHandle::unmapPages(void *region, unsigned numPages)
+{
+    if (region == NULL)
+        return SUCCESS;
+    if (munmap(region, (size_t) numPages * PAGE_SIZE) != 0)
+        return FH_MAP_FAILED;
+    return SUCCESS;
+}
+
+
+// Like readPage, write back any newer copy in the buffer pool before going to disk
+RC FileHandle::submitRead(PageNum pageNum, void *data, IOCallback callback, void *context)
+{
+    if (_file == NULL)
+        return PFM_FILE_NOT_OPEN;
+    if (pageNum >= getNumberOfPages())
+        return FH_PAGE_DN_EXIST;
+
+    RC rc = BufferPoolManager::instance()->flushPage(*this, pageNum);
+    if (rc)
+        return rc;
+
+    return AsyncIOManager::instance()->submit(*this, ReadRequest, pageNum, data, callback, context);
+}
+
+
+// Like a write through writePage, whatever the durability mode: the pool copy is refreshed right away
+// and the page goes to disk in the background (synced on completion in Strict mode)
+RC FileHandle::submitWrite(PageNum pageNum, const void *data, IOCallback callback, void *context)
+{
+    if (_file == NULL)
+        return PFM_FILE_NOT_OPEN;
+    if (pageNum > getNumberOfPages())
+        return FH_PAGE_DN_EXIST;
+
+    RC rc = AsyncIOManager::instance()->submit(*this, WriteRequest, pageNum, (void*) data, callback, context);
+    if (rc)
+        return rc;
+
+    // Writing the page just past the end grows the file
+    if (pageNum == _file->numPages)
+        _file->numPages++;
+    BufferPoolManager::instance()->pageWritten(_fileId, pageNum, data);
+    return SUCCESS;
+}
+
+
+RC FileHandle::waitForIO()
+{
+    return AsyncIOManager::instance()->waitForAll();
+}
+
+
+RC FileHandle::readPageFromDisk(PageNum pageNum, void *data)
+{
+    // If pageNum doesn't exist, error
+    if (getNumberOfPages() < pageNum)
+        return FH_PAGE_DN_EXIST;
+
+    // Try to read the specified page
+    if (preadFully(data, (off_t) pageNum * PAGE_SIZE))
+        return FH_READ_FAILED;
+
+    readPageCounter++;
+    return SUCCESS;
+}
+
+
+RC FileHandle::writePageToDisk(PageNum pageNum, const void *data)
+{
+    // Check if the page exists
+    if (getNumberOfPages() < pageNum)
+        return FH_PAGE_DN_EXIST;
+
+    // Write the page, there is no user space buffer to flush afterwards
+    if (pwriteFully(data, (off_t) pageNum * PAGE_SIZE))
+        return FH_WRITE_FAILED;
+
+    // Writing the page just past the end grows the file
+    if (pageNum == _file->numPages)
+        _file->numPages++;
+
+    writePageCounter++;
+    return SUCCESS;
+}
+
+// Write consecutive pages starting at pageNum with as few system calls as possible
+RC FileHandle::writePagesToDisk(PageNum pageNum, const vector<const void*> &pages)
+{
+    if (pages.empty())
+        return SUCCESS;
+    if (getNumberOfPages() < pageNum + pages.size() - 1)
+        return FH_PAGE_DN_EXIST;
+
+    struct iovec iov[IOV_MAX];
+    for (unsigned first = 0; first < pages.size(); first += IOV_MAX)
+    {
+        unsigned count = min((unsigned) IOV_MAX, (unsigned) (pages.size() - first));
+        for (unsigned i = 0; i < count; i++)
+        {
+            iov[i].iov_base = (void*) pages[first + i];
+            iov[i].iov_len = PAGE_SIZE;
+        }
+
+        ssize_t n;
+        do
+            n = pwritev(_file->fd, iov, count, (off_t) (pageNum + first) * PAGE_SIZE);
+        while (n < 0 && errno == EINTR);
+
+        // On a short write, finish the pages that didn't fully make it one at a time
+        unsigned written = n < 0 ? 0 : n / PAGE_SIZE;
+        for (unsigned i = written; i < count; i++)
+        {
+            if (pwriteFully(pages[first + i], (off_t) (pageNum + first + i) * PAGE_SIZE))
+                return FH_WRITE_FAILED;
+        }
+    }
+
+    if (pageNum + pages.size() > _file->numPages)
+        _file->numPages = pageNum + pages.size();
+    writePageCounter += pages.size();
+    return SUCCESS;
+}
+
+// Page I/O is positional (pread/pwrite), so a handle has no seek position and
+// any number of readers can share the same descriptor.
+// Read a whole page at offset, retrying short reads and interrupted calls
+RC FileHandle::preadFully(void *data, off_t offset)
+{
+    size_t done = 0;
+    while (done < PAGE_SIZE)
+    {
+        ssize_t n = pread(_file->fd, (char*) data + done, PAGE_SIZE - done, offset + done);
+        if (n < 0 && errno == EINTR)
+            continue;
+        // Reading past the end of the file is an error too
+        if (n <= 0)
+            return FH_READ_FAILED;
+        done += n;
+    }
+    return SUCCESS;
+}
+
+// Write a whole page at offset, retrying short writes and interrupted calls
+RC FileHandle::pwriteFully(const void *data, off_t offset)
+{
+    size_t done = 0;
+    while (done < PAGE_SIZE)
+    {
+        ssize_t n = pwrite(_file->fd, (const char*) data + done, PAGE_SIZE - done, offset + done);
+        if (n < 0 && errno == EINTR)
+            continue;
+        if (n <= 0)
+            return FH_WRITE_FAILED;
+        done += n;
+    }
+    return SUCCESS;
+}
+
+void FileHandle::setFile(OpenFile *file)
+{
+    _file = file;
+    if (file != NULL)
+        _fileId = file->id;
+}
+
+OpenFile *FileHandle::getFile()
+{
+    return _file;
+}
+
+RC FileHandle::sync()
+{
+    if (fdatasync(_file->fd) != 0)
+        return FH_SYNC_FAILED;
+    return SUCCESS;
+}
+
+// Called by the buffer pool whenever one of our pages becomes dirty
+RC FileHandle::pageDirtied()
+{
+    switch (_file->durability)
+    {
+        case Strict:
+            return flush();
+        case GroupFlush:
+            // Checked as pages are written, there is no background flusher
+            _file->pendingPages++;
+            if (_file->pendingPages >= _file->groupPages
+                || currentMillis() - _file->lastFlushMillis >= _file->groupMillis)
+                return flush();
+            return SUCCESS;
+        default:
+            return SUCCESS;
+    }
 }
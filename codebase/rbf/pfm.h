@@ -9,22 +9,70 @@
 #define PFM_HANDLE_IN_USE 4
 #define PFM_FILE_DN_EXIST 5
 #define PFM_FILE_NOT_OPEN 6
+#define PFM_FILE_TRUNCATED 7
 
 #define FH_PAGE_DN_EXIST  1
 #define FH_SEEK_FAILED    2
 #define FH_READ_FAILED    3
 #define FH_WRITE_FAILED   4
+#define FH_SYNC_FAILED    5
+#define FH_MAP_FAILED     6
 
 typedef unsigned PageNum;
 typedef int RC;
 typedef char byte;
 
 #define PAGE_SIZE 4096
+#include <cstdio>
 #include <string>
 #include <climits>
+#include <vector>
+
+#include <sys/types.h>
 using namespace std;
 
 class FileHandle;
+class BufferPoolManager;
+class AsyncIOManager;
+
+// Called when an asynchronous page read or write finishes, with its result and the caller's context
+typedef void (*IOCallback)(RC rc, void *context);
+
+// When page writes made through a FileHandle reach the disk
+typedef enum {
+    WriteThrough = 0,   // Each write goes straight to the OS (the default)
+    WriteBack,          // Writes stay in the buffer pool until evicted, flushed or the file is closed
+    GroupFlush,         // Like WriteBack, but the file is flushed every few pages or milliseconds
+    Strict              // Each write is written and synced to disk before returning
+} Durability;
+
+// Default GroupFlush thresholds
+#define PFM_GROUP_FLUSH_PAGES  64
+#define PFM_GROUP_FLUSH_MILLIS 100
+
+// Identifies a paged file independently of the path or handle used to open it
+typedef struct FileId
+{
+    dev_t device;
+    ino_t inode;
+} FileId;
+
+// State shared by every FileHandle that has the same file open
+// The buffer pool writes dirty pages back through this, so it lives until the last handle closes
+typedef struct OpenFile
+{
+    FileId id;
+    int fd;
+    unsigned refCount;
+    // Read from the file size on open and maintained by appends, so bounds checks cost no syscall
+    unsigned numPages;
+    // Durability mode and GroupFlush state
+    Durability durability;
+    unsigned groupPages;
+    unsigned groupMillis;
+    unsigned pendingPages;
+    unsigned long long lastFlushMillis;
+} OpenFile;
 
 class PagedFileManager
 {
@@ -35,6 +83,9 @@ public:
     RC destroyFile   (const string &fileName);                          // Destroy a file
     RC openFile      (const string &fileName, FileHandle &fileHandle);  // Open a file
     RC closeFile     (FileHandle &fileHandle);                          // Close a file
+    void setDurability(Durability durability,                           // Durability of files opened from now on
+                       unsigned groupPages = PFM_GROUP_FLUSH_PAGES,
+                       unsigned groupMillis = PFM_GROUP_FLUSH_MILLIS);
 
 protected:
     PagedFileManager();                                                 // Constructor
@@ -42,9 +93,21 @@ protected:
 
 private:
     static PagedFileManager *_pf_manager;
+    static BufferPoolManager *_bp_manager;
+
+    // Every file currently open through some FileHandle
+    vector<OpenFile*> _openFiles;
+
+    // Durability given to newly opened files
+    Durability _durability;
+    unsigned _groupPages;
+    unsigned _groupMillis;
 
     // Private helper methods
     bool fileExists(const string &fileName);
+    bool getFileId(const string &fileName, FileId &fileId);
+    OpenFile *findOpenFile(const FileId &fileId);
+    RC refreshNumberOfPages(OpenFile *file);
 };
 
 
@@ -52,9 +115,13 @@ class FileHandle
 {
 public:
     // variables to keep the counter for each operation
+    // These count physical page I/O, whether issued directly or by the buffer pool
     unsigned readPageCounter;
     unsigned writePageCounter;
     unsigned appendPageCounter;
+    // Logical page accesses served through the buffer pool (hits and misses alike)
+    unsigned logicalReadCounter;
+    unsigned logicalWriteCounter;
     
     FileHandle();                                                       // Default constructor
     ~FileHandle();                                                      // Destructor
@@ -62,18 +129,50 @@ public:
     RC readPage(PageNum pageNum, void *data);                           // Get a specific page
     RC writePage(PageNum pageNum, const void *data);                    // Write a specific page
     RC appendPage(const void *data);                                    // Append a specific page
+    RC appendPages(const void *data, unsigned count);                   // Append count consecutive pages with a single write
     unsigned getNumberOfPages();                                        // Get the number of pages in the file
+    RC truncate(unsigned numPages);                                     // Drop every page from numPages on, cached copies included
+    FileId getFileId();                                                 // Identity of the open file, shared by all its handles
     RC collectCounterValues(unsigned &readPageCount, unsigned &writePageCount, unsigned &appendPageCount);  // Put the current counter values into variables
+    RC collectLogicalCounterValues(unsigned &logicalReadCount, unsigned &logicalWriteCount);                // Same for buffer pool accesses
+
+    RC setDurability(Durability durability,                             // Change the durability of the open file
+                     unsigned groupPages = PFM_GROUP_FLUSH_PAGES,
+                     unsigned groupMillis = PFM_GROUP_FLUSH_MILLIS);
+    RC flush();                                                         // Write back every cached change and sync it to disk
+
+    RC mapPages(void *&region, unsigned &numPages);                     // Map every page of the file read only, for sequential scans
+    RC unmapPages(void *region, unsigned numPages);                     // Release a mapping made by mapPages
+
+    // Asynchronous page I/O, see AsyncIOManager. The buffer must stay untouched until the callback runs,
+    // and callbacks only run from waitForIO (or another wait on the AsyncIOManager).
+    RC submitRead(PageNum pageNum, void *data, IOCallback callback, void *context);
+    RC submitWrite(PageNum pageNum, const void *data, IOCallback callback, void *context);
+    RC waitForIO();                                                     // Wait for every asynchronous request to finish
 
-    // Let PagedFileManager access our private helper methods
+    // Let PagedFileManager and BufferPoolManager access our private helper methods
     friend class PagedFileManager;
+    friend class BufferPoolManager;
+    friend class AsyncIOManager;
 
 private:
-    FILE *_fd;
+    OpenFile *_file;
+    FileId _fileId;
 
     // Private helper methods
-    void setfd(FILE *fd);
-    FILE *getfd();
+    void setFile(OpenFile *file);
+    OpenFile *getFile();
+
+    // Physical page I/O, bypassing the buffer pool
+    RC readPageFromDisk(PageNum pageNum, void *data);
+    RC writePageToDisk(PageNum pageNum, const void *data);
+    RC writePagesToDisk(PageNum pageNum, const vector<const void*> &pages);
+    RC preadFully(void *data, off_t offset);
+    RC pwriteFully(const void *data, off_t offset);
+
+    // Durability helpers
+    RC sync();
+    RC pageDirtied();
 }; 
 
 #endif
@@ -0,0 +1,197 @@
+#include <iostream>
+#include <string>
+#include <cassert>
+#include <chrono>
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+
+#include "pfm.h"
+#include "test_util.h"
+
+using namespace std;
+
+// Compares FileHandle's pread/pwrite page I/O against the old stdio path
+// (one FILE*, fseek + fread/fwrite + fflush per page) on the same file.
+// The file stays in the OS page cache, so this measures per-call overhead rather than the disk.
+// It then times a bulk load (appending every page, then closing) under each durability mode.
+
+#define BENCH_PAGES   2048
+#define BENCH_PASSES  8
+
+static double elapsedMicros(chrono::steady_clock::time_point start)
+{
+    return chrono::duration<double, micro>(chrono::steady_clock::now() - start).count();
+}
+
+// Page order for the random access runs
+static void shufflePages(vector<PageNum> &order)
+{
+    srand(181);
+    for (unsigned i = 0; i < order.size(); i++)
+        order[i] = i;
+    for (unsigned i = order.size() - 1; i > 0; i--)
+        swap(order[i], order[rand() % (i + 1)]);
+}
+
+static double stdioRead(FILE *file, const vector<PageNum> &order, void *data)
+{
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
+    for (unsigned pass = 0; pass < BENCH_PASSES; pass++)
+    {
+        for (unsigned i = 0; i < order.size(); i++)
+        {
+            int rc = fseek(file, (long) PAGE_SIZE * order[i], SEEK_SET);
+            assert(rc == 0 && "Seeking should not fail.");
+            size_t n = fread(data, 1, PAGE_SIZE, file);
+            assert(n == PAGE_SIZE && "Reading a page should not fail.");
+        }
+    }
+    return elapsedMicros(start);
+}
+
+static double stdioWrite(FILE *file, const vector<PageNum> &order, void *data)
+{
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
+    for (unsigned pass = 0; pass < BENCH_PASSES; pass++)
+    {
+        for (unsigned i = 0; i < order.size(); i++)
+        {
+            int rc = fseek(file, (long) PAGE_SIZE * order[i], SEEK_SET);
+            assert(rc == 0 && "Seeking should not fail.");
+            size_t n = fwrite(data, 1, PAGE_SIZE, file);
+            assert(n == PAGE_SIZE && "Writing a page should not fail.");
+            fflush(file);
+        }
+    }
+    return elapsedMicros(start);
+}
+
+static double handleRead(FileHandle &fileHandle, const vector<PageNum> &order, void *data)
+{
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
+    for (unsigned pass = 0; pass < BENCH_PASSES; pass++)
+    {
+        for (unsigned i = 0; i < order.size(); i++)
+        {
+            RC rc = fileHandle.readPage(order[i], data);
+            assert(rc == success && "Reading a page should not fail.");
+        }
+    }
+    return elapsedMicros(start);
+}
+
+static double handleWrite(FileHandle &fileHandle, const vector<PageNum> &order, void *data)
+{
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
+    for (unsigned pass = 0; pass < BENCH_PASSES; pass++)
+    {
+        for (unsigned i = 0; i < order.size(); i++)
+        {
+            RC rc = fileHandle.writePage(order[i], data);
+            assert(rc == success && "Writing a page should not fail.");
+        }
+    }
+    return elapsedMicros(start);
+}
+
+// Append BENCH_PAGES pages to a new file, then flush and close it, so every mode ends with the data on disk
+static double bulkLoad(PagedFileManager *pfm, const string &fileName, Durability durability, void *data)
+{
+    RC rc = pfm->createFile(fileName);
+    assert(rc == success && "Creating the file should not fail.");
+
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
+    pfm->setDurability(durability);
+    FileHandle fileHandle;
+    rc = pfm->openFile(fileName, fileHandle);
+    assert(rc == success && "Opening the file should not fail.");
+    for (unsigned i = 0; i < BENCH_PAGES; i++)
+    {
+        rc = fileHandle.appendPage(data);
+        assert(rc == success && "Appending a page should not fail.");
+    }
+    rc = fileHandle.flush();
+    assert(rc == success && "Flushing the file should not fail.");
+    rc = pfm->closeFile(fileHandle);
+    assert(rc == success && "Closing the file should not fail.");
+    double micros = elapsedMicros(start);
+
+    pfm->setDurability(WriteThrough);
+    rc = pfm->destroyFile(fileName);
+    assert(rc == success && "Destroying the file should not fail.");
+    return micros;
+}
+
+static void report(const string &name, double stdioMicros, double handleMicros)
+{
+    double accesses = (double) BENCH_PAGES * BENCH_PASSES;
+    cout << name << ": stdio " << stdioMicros / accesses << " us/page, pread/pwrite "
+         << handleMicros / accesses << " us/page, speedup " << stdioMicros / handleMicros << "x" << endl;
+}
+
+int PFMBench(PagedFileManager *pfm)
+{
+    cout << endl << "***** In PFM Benchmark *****" << endl;
+
+    RC rc;
+    string fileName = "pfmbench_file";
+
+    rc = pfm->createFile(fileName);
+    assert(rc == success && "Creating the file should not fail.");
+
+    FileHandle fileHandle;
+    rc = pfm->openFile(fileName, fileHandle);
+    assert(rc == success && "Opening the file should not fail.");
+
+    void *data = malloc(PAGE_SIZE);
+    for (unsigned i = 0; i < BENCH_PAGES; i++)
+    {
+        memset(data, 'a' + i % 26, PAGE_SIZE);
+        rc = fileHandle.appendPage(data);
+        assert(rc == success && "Appending a page should not fail.");
+    }
+
+    FILE *file = fopen(fileName.c_str(), "rb+");
+    assert(file != NULL && "Opening the file through stdio should not fail.");
+
+    vector<PageNum> sequential(BENCH_PAGES);
+    vector<PageNum> random(BENCH_PAGES);
+    for (unsigned i = 0; i < BENCH_PAGES; i++)
+        sequential[i] = i;
+    shufflePages(random);
+
+    cout << BENCH_PAGES << " pages, " << BENCH_PASSES << " passes each" << endl;
+    report("sequential read ", stdioRead(file, sequential, data), handleRead(fileHandle, sequential, data));
+    report("random read     ", stdioRead(file, random, data), handleRead(fileHandle, random, data));
+    report("sequential write", stdioWrite(file, sequential, data), handleWrite(fileHandle, sequential, data));
+    report("random write    ", stdioWrite(file, random, data), handleWrite(fileHandle, random, data));
+
+    fclose(file);
+
+    rc = pfm->closeFile(fileHandle);
+    assert(rc == success && "Closing the file should not fail.");
+
+    rc = pfm->destroyFile(fileName);
+    assert(rc == success && "Destroying the file should not fail.");
+
+    const char *modes[] = { "write through", "write back", "group flush", "strict" };
+    Durability durabilities[] = { WriteThrough, WriteBack, GroupFlush, Strict };
+    for (unsigned i = 0; i < 4; i++)
+        cout << "bulk load, " << modes[i] << ": " << bulkLoad(pfm, fileName, durabilities[i], data) / BENCH_PAGES << " us/page" << endl;
+
+    free(data);
+
+    cout << "PFM Benchmark Finished!" << endl << endl;
+    return 0;
+}
+
+int main()
+{
+    PagedFileManager *pfm = PagedFileManager::instance();
+
+    remove("pfmbench_file");
+
+    RC rcmain = PFMBench(pfm);
+    return rcmain;
+}
@@ -0,0 +1,264 @@
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+
+#include "pscan.h"
+#include "filter.h"
+
+ParallelScan::ParallelScan()
+: _scan(NULL), _morsels(0), _nextMorsel(0), _maxChunks(0), _running(0), _stopping(false), _rc(SUCCESS),
+  _current(NULL), _currentRow(0)
+{
+}
+
+
+ParallelScan::~ParallelScan()
+{
+    stop();
+}
+
+
+RC ParallelScan::start(RBFM_ScanIterator &scan, unsigned threads)
+{
+    _scan = &scan;
+    RecordBasedFileManager *rbfm = scan.rbfm;
+
+    // Pick out the data pages up front, leaving out those the zone map rules out,
+    // so that only this thread ever goes through the buffer pool
+    for (PageNum p = 1; p < scan.mappedPages; p++)
+    {
+        if (!rbfm->isFreeSpaceMapPage(p) && (!scan.zoneFiltered || scan.pageMayMatch(p)))
+            _pages.push_back(p);
+    }
+    _morsels = (_pages.size() + PSCAN_MORSEL_PAGES - 1) / PSCAN_MORSEL_PAGES;
+    _nextMorsel = 0;
+
+    // The predicate kernel is picked on first use, which must not happen in several workers at once
+    getFilterKernel();
+
+    threads = max(1u, min(threads, _morsels));
+    for (unsigned i = 0; i < threads; i++)
+    {
+        RBFM_ScanIterator *worker = new RBFM_ScanIterator();
+        RC rc = worker->initWorker(scan);
+        _workers.push_back(worker);
+        if (rc)
+        {
+            stop();
+            return rc;
+        }
+    }
+
+    _maxChunks = threads * PSCAN_CHUNKS_PER_THREAD;
+    _running = threads;
+    for (unsigned i = 0; i < threads; i++)
+        _threads.push_back(thread(&ParallelScan::workerLoop, this, _workers[i]));
+    return SUCCESS;
+}
+
+
+RC ParallelScan::getNextRecord(RID &rid, void *data)
+{
+    while (_current == NULL || _currentRow >= _current->rids.size())
+    {
+        RC rc = nextChunk();
+        if (rc)
+            return rc;
+    }
+
+    unsigned begin = _current->rowOffsets[_currentRow];
+    unsigned end = rowEnd(_currentRow);
+    if (end > begin)
+        memcpy(data, _current->rows + begin, end - begin);
+    rid = _current->rids[_currentRow++];
+    return SUCCESS;
+}
+
+
+RC ParallelScan::getNextBatch(vector<RID> &rids, void *data, unsigned maxRows)
+{
+    rids.clear();
+    char *out = (char*) data;
+    while (rids.size() < maxRows)
+    {
+        if (_current == NULL || _currentRow >= _current->rids.size())
+        {
+            RC rc = nextChunk();
+            if (rc == RBFM_EOF)
+                break;
+            if (rc)
+                return rc;
+            continue;
+        }
+
+        // Rows of a chunk are already packed back to back, so take as many as fit in one copy
+        unsigned rows = min(maxRows - (unsigned) rids.size(), (unsigned) _current->rids.size() - _currentRow);
+        unsigned begin = _current->rowOffsets[_currentRow];
+        unsigned end = rowEnd(_currentRow + rows - 1);
+        if (end > begin)
+            memcpy(out, _current->rows + begin, end - begin);
+        out += end - begin;
+        rids.insert(rids.end(), _current->rids.begin() + _currentRow, _current->rids.begin() + _currentRow + rows);
+        _currentRow += rows;
+    }
+    return rids.empty() ? RBFM_EOF : SUCCESS;
+}
+
+
+void ParallelScan::stop()
+{
+    {
+        lock_guard<mutex> guard(_lock);
+        _stopping = true;
+        _spaceReady.notify_all();
+    }
+    for (unsigned i = 0; i < _threads.size(); i++)
+        _threads[i].join();
+    _threads.clear();
+
+    for (unsigned i = 0; i < _workers.size(); i++)
+    {
+        _workers[i]->close();
+        delete _workers[i];
+    }
+    _workers.clear();
+
+    for (unsigned i = 0; i < _chunks.size(); i++)
+        freeChunk(_chunks[i]);
+    _chunks.clear();
+    freeChunk(_current);
+    _current = NULL;
+}
+
+// Private helper methods ///////////////////////////////////////////////////////////////////
+
+void ParallelScan::workerLoop(RBFM_ScanIterator *worker)
+{
+    unique_lock<mutex> lock(_lock);
+    while (!_stopping && _rc == SUCCESS && _nextMorsel < _morsels)
+    {
+        unsigned morsel = _nextMorsel++;
+        lock.unlock();
+
+        ScanChunk *chunk = new ScanChunk;
+        chunk->rows = NULL;
+        chunk->used = chunk->capacity = 0;
+        RC rc = scanMorsel(*worker, morsel, chunk);
+
+        lock.lock();
+        if (rc || chunk->rids.empty())
+        {
+            if (rc && _rc == SUCCESS)
+                _rc = rc;
+            freeChunk(chunk);
+            continue;
+        }
+
+        // Don't run too far ahead of the reader
+        _spaceReady.wait(lock, [&]{ return _stopping || _chunks.size() < _maxChunks; });
+        if (_stopping)
+        {
+            freeChunk(chunk);
+            break;
+        }
+        _chunks.push_back(chunk);
+        _chunkReady.notify_one();
+    }
+
+    _running--;
+    _chunkReady.notify_one();
+}
+
+
+// Go through every page of the morsel with the worker's copy of the iterator
+RC ParallelScan::scanMorsel(RBFM_ScanIterator &worker, unsigned morsel, ScanChunk *chunk)
+{
+    RecordBasedFileManager *rbfm = worker.rbfm;
+    bool project = !worker.projection.empty();
+    bool filter = worker.compOp != NO_OP || !worker.clauses.empty();
+    // Most a projected row can take beyond the bytes of its record: a null indicator and a varchar length per field
+    unsigned rowOverhead = worker.projectionNullSize + worker.projection.size() * VARCHAR_LENGTH_SIZE;
+
+    unsigned end = min((morsel + 1) * PSCAN_MORSEL_PAGES, (unsigned) _pages.size());
+    for (unsigned i = morsel * PSCAN_MORSEL_PAGES; i < end; i++)
+    {
+        worker.currPage = _pages[i];
+        worker.pageData = (char*) _scan->mappedData + (size_t) worker.currPage * PAGE_SIZE;
+        SlotDirectoryHeader header = rbfm->getSlotDirectoryHeader(worker.pageData);
+        worker.totalSlot = header.recordEntriesNumber;
+        worker.paxPage = header.paxColumns != 0;
+        worker.codeConditions();
+        if (worker.vectorFiltered)
+            worker.filterPage();
+        // Coded fields project to values from the page's dictionary, none longer than the dictionary
+        unsigned dictionaryOverhead = header.dictionaryOffset != 0 ? worker.projection.size() * (PAGE_SIZE - header.dictionaryOffset) : 0;
+
+        const SlotDirectoryRecordEntry *slots = (const SlotDirectoryRecordEntry*) ((char*) worker.pageData + sizeof(SlotDirectoryHeader));
+        for (worker.currSlot = 0; worker.currSlot < worker.totalSlot; worker.currSlot++)
+        {
+            SlotDirectoryRecordEntry slot = slots[worker.currSlot];
+            if (slot.offset <= 0 || (filter && !worker.checkScanCondition()))
+                continue;
+
+            RID rid;
+            rid.pageNum = worker.currPage;
+            rid.slotNum = worker.currSlot;
+            chunk->rids.push_back(rid);
+            chunk->rowOffsets.push_back(chunk->used);
+            if (!project)
+                continue;
+
+            unsigned needed = chunk->used + rowOverhead + dictionaryOverhead + slot.length;
+            if (needed > chunk->capacity)
+            {
+                unsigned capacity = max(max(needed, 2 * chunk->capacity), (unsigned) PAGE_SIZE);
+                char *rows = (char*) realloc(chunk->rows, capacity);
+                if (rows == NULL)
+                    return RBFM_MALLOC_FAILED;
+                chunk->rows = rows;
+                chunk->capacity = capacity;
+            }
+            chunk->used += worker.projectRecord((char*) worker.pageData + slot.offset, chunk->rows + chunk->used);
+        }
+    }
+    return SUCCESS;
+}
+
+
+// Swap the chunk we're done with for the next one, waiting for a worker if need be
+RC ParallelScan::nextChunk()
+{
+    freeChunk(_current);
+    _current = NULL;
+
+    unique_lock<mutex> lock(_lock);
+    _chunkReady.wait(lock, [&]{ return _rc != SUCCESS || !_chunks.empty() || _running == 0; });
+    if (_rc)
+        return _rc;
+    if (_chunks.empty())
+        return RBFM_EOF;
+
+    _current = _chunks.front();
+    _chunks.pop_front();
+    _currentRow = 0;
+    _spaceReady.notify_one();
+    return SUCCESS;
+}
+
+
+// Where the current chunk's row ends
+unsigned ParallelScan::rowEnd(unsigned row)
+{
+    if (row + 1 < _current->rowOffsets.size())
+        return _current->rowOffsets[row + 1];
+    return _current->used;
+}
+
+
+void ParallelScan::freeChunk(ScanChunk *chunk)
+{
+    if (chunk == NULL)
+        return;
+    free(chunk->rows);
+    delete chunk;
+}
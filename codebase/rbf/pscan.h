@@ -0,0 +1,75 @@
+#ifndef _pscan_h_
+#define _pscan_h_
+
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "../rbf/rbfm.h"
+
+// Data pages handed to a worker at a time, and finished chunks each worker may have waiting
+#define PSCAN_MORSEL_PAGES      16
+#define PSCAN_CHUNKS_PER_THREAD 4
+
+using namespace std;
+
+// The matches a worker found in one morsel: their RIDs, and their projected rows packed back to back
+typedef struct ScanChunk
+{
+    vector<RID> rids;
+    vector<unsigned> rowOffsets;
+    char *rows;
+    unsigned used;
+    unsigned capacity;
+} ScanChunk;
+
+// The workers behind a PARALLEL_SCAN. The data pages of the file are split into morsels of
+// PSCAN_MORSEL_PAGES pages, which the workers take in turn. Each worker has its own copy of the
+// scan iterator and evaluates the conditions and projection straight off the file's read-only mapping,
+// so workers never touch the buffer pool. Their matches come back through a single queue, a morsel
+// at a time and in no particular order. The file can't change under them: RecordBasedFileManager
+// refuses to modify or vacuum it with RBFM_FILE_SCANNED until the scan is closed.
+class ParallelScan
+{
+public:
+    ParallelScan();                                                    // Constructor
+    ~ParallelScan();                                                   // Destructor, stops the workers
+
+    RC start(RBFM_ScanIterator &scan, unsigned threads);               // Start scanning the pages scan has mapped
+    RC getNextRecord(RID &rid, void *data);                            // Same as RBFM_ScanIterator
+    RC getNextBatch(vector<RID> &rids, void *data, unsigned maxRows);
+    void stop();                                                       // Stop the workers, dropping matches not yet returned
+
+private:
+    RBFM_ScanIterator *_scan;
+    vector<RBFM_ScanIterator*> _workers;
+    vector<thread> _threads;
+
+    // Data pages left after the zone map had its say, split into morsels
+    vector<PageNum> _pages;
+    unsigned _morsels;
+    unsigned _nextMorsel;
+
+    // Finished chunks, and the one being returned
+    mutex _lock;
+    condition_variable _chunkReady;
+    condition_variable _spaceReady;
+    deque<ScanChunk*> _chunks;
+    unsigned _maxChunks;
+    unsigned _running;
+    bool _stopping;
+    RC _rc;
+    ScanChunk *_current;
+    unsigned _currentRow;
+
+    // Private helper methods
+    void workerLoop(RBFM_ScanIterator *worker);
+    RC scanMorsel(RBFM_ScanIterator &worker, unsigned morsel, ScanChunk *chunk);
+    RC nextChunk();
+    unsigned rowEnd(unsigned row);
+    static void freeChunk(ScanChunk *chunk);
+};
+
+#endif
@@ -6,11 +6,17 @@
 #include <iomanip>
 #include <iostream>
 #include <string>
+#include <unordered_map>
+#include <sys/stat.h>
 
 #include "rbfm.h"
+#include "aio.h"
+#include "filter.h"
+#include "pscan.h"
 
 RecordBasedFileManager* RecordBasedFileManager::_rbf_manager = NULL;
 PagedFileManager *RecordBasedFileManager::_pf_manager = NULL;
+BufferPoolManager *RecordBasedFileManager::_bp_manager = NULL;
 
 RecordBasedFileManager* RecordBasedFileManager::instance()
 {
@@ -21,35 +27,68 @@ RecordBasedFileManager* RecordBasedFileManager::instance()
 }
 
 RecordBasedFileManager::RecordBasedFileManager()
+: _scanReadAhead(RBFM_SCAN_READAHEAD), _scanThreads(0)
 {
-    // Initialize the internal PagedFileManager instance
+    setScanThreads(0);
+    // Initialize the internal PagedFileManager and BufferPoolManager instances
     _pf_manager = PagedFileManager::instance();
+    _bp_manager = BufferPoolManager::instance();
 }
 
 RecordBasedFileManager::~RecordBasedFileManager()
 {
+    for (unsigned i = 0; i < _closedHomes.size(); i++)
+        delete _closedHomes[i];
 }
 
 RC RecordBasedFileManager::createFile(const string &fileName) 
 {
+    return createFile(fileName, vector<Attribute>(), SLOTTED_LAYOUT);
+}
+
+RC RecordBasedFileManager::createFile(const string &fileName, const vector<Attribute> &recordDescriptor, PageLayout layout)
+{
+    // PAX minipages only hold 4 byte values
+    if (layout == PAX_LAYOUT)
+    {
+        if (recordDescriptor.empty())
+            return RBFM_LAYOUT_TYPE;
+        for (unsigned i = 0; i < recordDescriptor.size(); i++)
+        {
+            if (recordDescriptor[i].type == TypeVarChar)
+                return RBFM_LAYOUT_TYPE;
+        }
+    }
+
     // Creating a new paged file.
     if (_pf_manager->createFile(fileName))
         return RBFM_CREATE_FAILED;
+    forgetClosedHomes(fileName);
 
-    // Setting up the first page.
+    // Setting up the free space map page and the first page.
+    void * mapPageData = calloc(PAGE_SIZE, 1);
+    if (mapPageData == NULL)
+        return RBFM_MALLOC_FAILED;
     void * firstPageData = calloc(PAGE_SIZE, 1);
     if (firstPageData == NULL)
         return RBFM_MALLOC_FAILED;
-    newRecordBasedPage(firstPageData);
+    if (layout == PAX_LAYOUT)
+        newPaxPage(firstPageData, recordDescriptor.size());
+    else
+        newRecordBasedPage(firstPageData);
+    ((uint8_t*) mapPageData)[0] = getFreeSpaceBucket(firstPageData);
 
-    // Adds the first record based page.
+    // Adds the map page followed by the first record based page.
     FileHandle handle;
     if (_pf_manager->openFile(fileName.c_str(), handle))
         return RBFM_OPEN_FAILED;
+    if (handle.appendPage(mapPageData))
+        return RBFM_APPEND_FAILED;
     if (handle.appendPage(firstPageData))
         return RBFM_APPEND_FAILED;
     _pf_manager->closeFile(handle);
 
+    free(mapPageData);
     free(firstPageData);
 
     return SUCCESS;
@@ -57,100 +96,308 @@ RC RecordBasedFileManager::createFile(const string &fileName)
 
 RC RecordBasedFileManager::destroyFile(const string &fileName) 
 {
-    return _pf_manager->destroyFile(fileName);
+    forgetClosedHomes(fileName);
+    RC rc = _pf_manager->destroyFile(fileName);
+    if (rc == SUCCESS)
+    {
+        _pf_manager->destroyFile(fileName + ZONE_FILE_SUFFIX);
+        _pf_manager->destroyFile(fileName + TOAST_FILE_SUFFIX);
+        _pf_manager->destroyFile(fileName + DICTIONARY_FILE_SUFFIX);
+    }
+    return rc;
 }
 
 RC RecordBasedFileManager::openFile(const string &fileName, FileHandle &fileHandle) 
 {
-    return _pf_manager->openFile(fileName.c_str(), fileHandle);
+    RC rc = _pf_manager->openFile(fileName.c_str(), fileHandle);
+    if (rc)
+        return rc;
+
+    RecordFile *file = findRecordFile(fileHandle);
+    if (file != NULL)
+    {
+        file->refCount++;
+        return SUCCESS;
+    }
+
+    // First handle on this file, open its zone map and toast file too if it has them, and find the
+    // columns it keeps dictionaries for
+    file = new RecordFile;
+    file->id = fileHandle.getFileId();
+    file->fileName = fileName;
+    file->refCount = 1;
+    file->hasToast = false;
+    file->hasHomes = false;
+    file->parallelScans = 0;
+    // Pick up the moved records closeFile kept, see ClosedHomes
+    for (unsigned i = 0; i < _closedHomes.size(); i++)
+    {
+        ClosedHomes *closed = _closedHomes[i];
+        if (closed->id.device != file->id.device || closed->id.inode != file->id.inode)
+            continue;
+        if (closed->numPages == fileHandle.getNumberOfPages())
+        {
+            file->homes.swap(closed->homes);
+            file->hasHomes = true;
+        }
+        _closedHomes.erase(_closedHomes.begin() + i);
+        delete closed;
+        break;
+    }
+    openToastFile(file, false);
+    FileHandle dictionaryHandle;
+    if (_pf_manager->openFile(fileName + DICTIONARY_FILE_SUFFIX, dictionaryHandle) == SUCCESS)
+    {
+        unsigned *header = (unsigned*) malloc(PAGE_SIZE);
+        if (header != NULL && dictionaryHandle.readPage(0, header) == SUCCESS)
+            file->dictionaryColumns.assign(header + 1, header + 1 + header[0]);
+        free(header);
+        _pf_manager->closeFile(dictionaryHandle);
+    }
+    file->hasZoneMap = false;
+    file->zoneColumns = 0;
+    if (_pf_manager->openFile(fileName + ZONE_FILE_SUFFIX, file->zoneHandle) == SUCCESS)
+    {
+        void *header;
+        if (_bp_manager->pinPage(file->zoneHandle, 0, header) == SUCCESS)
+        {
+            memcpy(&file->zoneColumns, header, sizeof(unsigned));
+            _bp_manager->unpinPage(file->zoneHandle, 0, false);
+            file->hasZoneMap = file->zoneColumns > 0;
+        }
+        if (!file->hasZoneMap)
+            _pf_manager->closeFile(file->zoneHandle);
+    }
+    _openFiles.push_back(file);
+    return SUCCESS;
 }
 
 RC RecordBasedFileManager::closeFile(FileHandle &fileHandle) 
 {
-    return _pf_manager->closeFile(fileHandle);
+    RecordFile *file = findRecordFile(fileHandle);
+    unsigned numPages = file != NULL ? fileHandle.getNumberOfPages() : 0;
+    RC rc = _pf_manager->closeFile(fileHandle);
+    if (rc || file == NULL || --file->refCount > 0)
+        return rc;
+
+    // Last handle on the file. Callers like RelationManager::vacuumTable open the file for every
+    // vacuum call, so what the vacuum found out about moved records is kept for the next one.
+    if (file->hasHomes)
+    {
+        ClosedHomes *closed = new ClosedHomes;
+        closed->id = file->id;
+        closed->numPages = numPages;
+        closed->homes.swap(file->homes);
+        _closedHomes.push_back(closed);
+    }
+    if (file->hasZoneMap)
+        rc = _pf_manager->closeFile(file->zoneHandle);
+    if (file->hasToast)
+    {
+        RC toastRc = _pf_manager->closeFile(file->toastHandle);
+        rc = rc ? rc : toastRc;
+    }
+    _openFiles.erase(find(_openFiles.begin(), _openFiles.end(), file));
+    delete file;
+    return rc;
 }
 
 RC RecordBasedFileManager::insertRecord(FileHandle &fileHandle, const vector<Attribute> &recordDescriptor, const void *data, RID &rid) 
 {
-    // Gets the size of the record.
+    if (isParallelScanned(fileHandle))
+        return RBFM_FILE_SCANNED;
+
+    // Gets the size of the record, moving its largest values out of line if it is too big
     unsigned recordSize = getRecordSize(recordDescriptor, data);
+    if (recordSize > RBFM_TOAST_RECORD_SIZE)
+    {
+        void *toasted;
+        RC rc = toastRecord(fileHandle, recordDescriptor, data, recordSize, toasted);
+        if (rc)
+            return rc;
+        if (toasted != NULL)
+        {
+            rc = insertRecord(fileHandle, recordDescriptor, toasted, rid);
+            if (rc)
+                freeRecordToast(fileHandle, recordDescriptor, data, toasted);
+            free(toasted);
+            return rc;
+        }
+    }
+    if (sizeof(SlotDirectoryHeader) + sizeof(SlotDirectoryRecordEntry) + recordSize > PAGE_SIZE)
+        return RBFM_RECORD_TOO_BIG;
 
-    // Cycles through pages looking for enough free space for the new entry.
-    void *pageData = malloc(PAGE_SIZE);
-    if (pageData == NULL)
-        return RBFM_MALLOC_FAILED;
+    // Asks the free space map for a page with enough space for the new entry (accounting also for
+    // the size that will be added to the slot directory). The page is pinned and modified in place.
+    void *pageData = NULL;
+    PageNum pageNum;
     bool pageFound = false;
-    unsigned i;
-    unsigned numPages = fileHandle.getNumberOfPages();
-    for (i = 0; i < numPages; i++)
+    RC rc;
+    while (true)
     {
-        if (fileHandle.readPage(i, pageData))
-            return RBFM_READ_FAILED;
+        if ((rc = findPageWithFreeSpace(fileHandle, sizeof(SlotDirectoryRecordEntry) + recordSize, pageNum, pageFound)))
+            return rc;
+        if (!pageFound)
+            break;
 
-        // When we find a page with enough space (accounting also for the size that will be added to the slot directory), we stop the loop.
+        if (_bp_manager->pinPage(fileHandle, pageNum, pageData))
+            return RBFM_READ_FAILED;
         if (getPageFreeSpaceSize(pageData) >= sizeof(SlotDirectoryRecordEntry) + recordSize)
-        {
-            pageFound = true;
             break;
-        }
+
+        // The map entry was out of date, fix it and look again
+        _bp_manager->unpinPage(fileHandle, pageNum, false);
+        if ((rc = updateFreeSpaceMap(fileHandle, pageNum, pageData)))
+            return rc;
     }
 
     // If we can't find a page with enough space, we create a new one
     if(!pageFound)
     {
-        newRecordBasedPage(pageData);
+        pageData = malloc(PAGE_SIZE);
+        if (pageData == NULL)
+            return RBFM_MALLOC_FAILED;
+        if ((rc = newDataPage(fileHandle, pageData)))
+        {
+            free(pageData);
+            return rc;
+        }
     }
 
-    SlotDirectoryHeader slotHeader = getSlotDirectoryHeader(pageData);
-
-    // Setting the return RID.
-    rid.pageNum = i;
-    rid.slotNum = getOpenSlot(pageData);
-
-    // Adding the new record reference in the slot directory.
-    SlotDirectoryRecordEntry newRecordEntry;
-    newRecordEntry.length = recordSize;
-    newRecordEntry.offset = slotHeader.freeSpaceOffset - recordSize;
-    setSlotDirectoryRecordEntry(pageData, rid.slotNum, newRecordEntry);
-
-    // Updating the slot directory header.
-    slotHeader.freeSpaceOffset = newRecordEntry.offset;
-    if (rid.slotNum == slotHeader.recordEntriesNumber)
-        slotHeader.recordEntriesNumber += 1;
-    setSlotDirectoryHeader(pageData, slotHeader);
-
-    // Adding the record data.
-    setRecordAtOffset (pageData, newRecordEntry.offset, recordDescriptor, data);
+    // Coding the record against the page's dictionary, then setting the return RID.
+    void *coded;
+    if ((rc = codeRecord(fileHandle, recordDescriptor, pageData, data, 0, coded, recordSize)))
+    {
+        if (pageFound)
+            _bp_manager->unpinPage(fileHandle, pageNum, false);
+        else
+            free(pageData);
+        return rc;
+    }
+    rid.pageNum = pageNum;
+    rid.slotNum = addRecordToPage(pageData, recordDescriptor, coded != NULL ? coded : data, recordSize);
+    free(coded);
 
-    // Writing the page to disk.
+    // Handing the page back to the pool, or adding it to the file.
     if (pageFound)
     {
-        if (fileHandle.writePage(i, pageData))
+        rc = updateFreeSpaceMap(fileHandle, pageNum, pageData);
+        if (rc == SUCCESS)
+            rc = widenZoneMap(fileHandle, recordDescriptor, pageNum, pageData, rid.slotNum);
+        if (_bp_manager->unpinPage(fileHandle, pageNum, true))
             return RBFM_WRITE_FAILED;
     }
     else
     {
-        if (fileHandle.appendPage(pageData))
-            return RBFM_APPEND_FAILED;
+        rc = appendRecordBasedPage(fileHandle, pageData, pageNum);
+        rid.pageNum = pageNum;
+        if (rc == SUCCESS)
+            rc = rebuildZoneMap(fileHandle, recordDescriptor, pageNum, pageData);
+        free(pageData);
     }
 
-    free(pageData);
-    return SUCCESS;
+    return rc;
+}
+
+RC RecordBasedFileManager::insertRecords(FileHandle &fileHandle, const vector<Attribute> &recordDescriptor, const vector<const void*> &data, vector<RID> &rids)
+{
+    rids.clear();
+    if (isParallelScanned(fileHandle))
+        return RBFM_FILE_SCANNED;
+    rids.reserve(data.size());
+
+    // Pages are filled here, then appended RBFM_BULK_BATCH_PAGES at a time
+    char *batch = (char*) malloc(RBFM_BULK_BATCH_PAGES * PAGE_SIZE);
+    if (batch == NULL)
+        return RBFM_MALLOC_FAILED;
+    PageNum firstPage = fileHandle.getNumberOfPages();
+    unsigned batchPages = 0;
+    void *pageData = NULL;
+
+    RC rc = SUCCESS;
+    void *toasted = NULL;
+    for (unsigned i = 0; i < data.size() && rc == SUCCESS; i++)
+    {
+        const void *record = data[i];
+        unsigned recordSize = getRecordSize(recordDescriptor, record);
+        if (recordSize > RBFM_TOAST_RECORD_SIZE)
+        {
+            free(toasted);
+            if ((rc = toastRecord(fileHandle, recordDescriptor, record, recordSize, toasted)))
+                break;
+            if (toasted != NULL)
+                record = toasted;
+        }
+        if (sizeof(SlotDirectoryHeader) + sizeof(SlotDirectoryRecordEntry) + recordSize > PAGE_SIZE)
+        {
+            rc = RBFM_RECORD_TOO_BIG;
+            break;
+        }
+
+        // Start a new page once the current one is full. The current page is done with by then,
+        // so that's when a full batch goes to the file.
+        if (pageData == NULL || getPageFreeSpaceSize(pageData) < sizeof(SlotDirectoryRecordEntry) + recordSize)
+        {
+            for (bool dataPage = false; !dataPage; )
+            {
+                if (batchPages == RBFM_BULK_BATCH_PAGES)
+                {
+                    if ((rc = appendRecordBasedPages(fileHandle, recordDescriptor, batch, batchPages)))
+                        break;
+                    firstPage += batchPages;
+                    batchPages = 0;
+                }
+                // Leave room for a free space map page where one is due
+                pageData = batch + batchPages * PAGE_SIZE;
+                dataPage = !isFreeSpaceMapPage(firstPage + batchPages);
+                if (dataPage)
+                    rc = newDataPage(fileHandle, pageData);
+                else
+                    memset(pageData, 0, PAGE_SIZE);
+                batchPages++;
+                if (rc)
+                    break;
+            }
+            if (rc)
+                break;
+        }
+
+        void *coded;
+        if ((rc = codeRecord(fileHandle, recordDescriptor, pageData, record, 0, coded, recordSize)))
+            break;
+        RID rid;
+        rid.pageNum = firstPage + batchPages - 1;
+        rid.slotNum = addRecordToPage(pageData, recordDescriptor, coded != NULL ? coded : record, recordSize);
+        rids.push_back(rid);
+        free(coded);
+    }
+
+    if (rc == SUCCESS && batchPages > 0)
+        rc = appendRecordBasedPages(fileHandle, recordDescriptor, batch, batchPages);
+
+    free(toasted);
+    free(batch);
+    return rc;
 }
 
 RC RecordBasedFileManager::readRecord(FileHandle &fileHandle, const vector<Attribute> &recordDescriptor, const RID &rid, void *data) 
 {
+    // Free space map pages hold no records
+    if (isFreeSpaceMapPage(rid.pageNum))
+        return RBFM_SLOT_DN_EXIST;
+
     // Retrieve the specific page
-    void *pageData = malloc(PAGE_SIZE);
-    if (pageData == NULL)
-        return RBFM_MALLOC_FAILED;
-    if (fileHandle.readPage(rid.pageNum, pageData))
+    void *pageData;
+    if (_bp_manager->pinPage(fileHandle, rid.pageNum, pageData))
         return RBFM_READ_FAILED;
 
     // Checks if the specific slot id exists in the page
     SlotDirectoryHeader slotHeader = getSlotDirectoryHeader(pageData);
     if(slotHeader.recordEntriesNumber <= rid.slotNum)
+    {
+        _bp_manager->unpinPage(fileHandle, rid.pageNum, false);
         return RBFM_SLOT_DN_EXIST;
+    }
 
     // Gets the slot directory record entry data
     SlotDirectoryRecordEntry recordEntry = getSlotDirectoryRecordEntry(pageData, rid.slotNum);
@@ -160,11 +407,11 @@ RC RecordBasedFileManager::readRecord(FileHandle &fileHandle, const vector<Attri
     {
         // Error to read a deleted record
         case DEAD:
-            free(pageData);
+            _bp_manager->unpinPage(fileHandle, rid.pageNum, false);
             return RBFM_READ_AFTER_DEL;
         // Get the forwarding address from the record entry and recurse
         case MOVED:
-            free(pageData);
+            _bp_manager->unpinPage(fileHandle, rid.pageNum, false);
             RID newRid;
             newRid.pageNum = recordEntry.length;
             newRid.slotNum = -recordEntry.offset;
@@ -172,25 +419,145 @@ RC RecordBasedFileManager::readRecord(FileHandle &fileHandle, const vector<Attri
         // Retrieve the actual entry data
         case VALID:
             int32_t offset = recordEntry.offset;
-            getRecordAtOffset(pageData, offset, recordDescriptor, data);
-            free(pageData);
-            return SUCCESS;
+            bool toasted = getRecordAtOffset(pageData, offset, recordDescriptor, data);
+            _bp_manager->unpinPage(fileHandle, rid.pageNum, false);
+            unsigned size;
+            return toasted ? detoastRecord(fileHandle, recordDescriptor, data, size) : SUCCESS;
     }
     // Not possible to reach this point, but compiler doesn't know that
     return -1;
 }
 
+RC RecordBasedFileManager::readRecords(FileHandle &fileHandle, const vector<Attribute> &recordDescriptor, const vector<RID> &rids, const vector<void*> &data)
+{
+    if (data.size() < rids.size())
+        return RBFM_READ_FAILED;
+
+    // Where each record is still to be looked for, starting with the RIDs we were given
+    RC rc;
+    vector<pair<RID, unsigned> > pending;
+    for (unsigned i = 0; i < rids.size(); i++)
+        pending.push_back(make_pair(rids[i], i));
+
+    // Each round reads every page it needs once, in page order. Records that moved are looked
+    // for at their new address in the next round.
+    while (!pending.empty())
+    {
+        sort(pending.begin(), pending.end(), [](const pair<RID, unsigned> &a, const pair<RID, unsigned> &b)
+             {return a.first.pageNum < b.first.pageNum || (a.first.pageNum == b.first.pageNum && a.first.slotNum < b.first.slotNum);});
+
+        vector<pair<RID, unsigned> > moved;
+        unsigned i = 0;
+        while (i < pending.size())
+        {
+            PageNum pageNum = pending[i].first.pageNum;
+            if (isFreeSpaceMapPage(pageNum))
+                return RBFM_SLOT_DN_EXIST;
+            void *pageData;
+            if (_bp_manager->pinPage(fileHandle, pageNum, pageData))
+                return RBFM_READ_FAILED;
+            SlotDirectoryHeader slotHeader = getSlotDirectoryHeader(pageData);
+
+            for (; i < pending.size() && pending[i].first.pageNum == pageNum; i++)
+            {
+                unsigned slotNum = pending[i].first.slotNum;
+                if (slotHeader.recordEntriesNumber <= slotNum)
+                {
+                    _bp_manager->unpinPage(fileHandle, pageNum, false);
+                    return RBFM_SLOT_DN_EXIST;
+                }
+
+                SlotDirectoryRecordEntry recordEntry = getSlotDirectoryRecordEntry(pageData, slotNum);
+                SlotStatus status = getSlotStatus(recordEntry);
+                if (status == DEAD)
+                {
+                    _bp_manager->unpinPage(fileHandle, pageNum, false);
+                    return RBFM_READ_AFTER_DEL;
+                }
+                if (status == MOVED)
+                {
+                    RID newRid;
+                    newRid.pageNum = recordEntry.length;
+                    newRid.slotNum = -recordEntry.offset;
+                    moved.push_back(make_pair(newRid, pending[i].second));
+                    continue;
+                }
+                void *record = data[pending[i].second];
+                unsigned size;
+                if (getRecordAtOffset(pageData, recordEntry.offset, recordDescriptor, record) &&
+                    (rc = detoastRecord(fileHandle, recordDescriptor, record, size)))
+                {
+                    _bp_manager->unpinPage(fileHandle, pageNum, false);
+                    return rc;
+                }
+            }
+            _bp_manager->unpinPage(fileHandle, pageNum, false);
+        }
+        pending.swap(moved);
+    }
+    return SUCCESS;
+}
+
+RC RecordBasedFileManager::readRecordView(FileHandle &fileHandle, const RID &rid, RecordView &view)
+{
+    view.release();
+
+    // Follow forwarding addresses until we reach the record, keeping only its page pinned
+    RID current = rid;
+    while (true)
+    {
+        if (isFreeSpaceMapPage(current.pageNum))
+            return RBFM_SLOT_DN_EXIST;
+        void *pageData;
+        if (_bp_manager->pinPage(fileHandle, current.pageNum, pageData))
+            return RBFM_READ_FAILED;
+
+        SlotDirectoryHeader slotHeader = getSlotDirectoryHeader(pageData);
+        if (slotHeader.recordEntriesNumber <= current.slotNum)
+        {
+            _bp_manager->unpinPage(fileHandle, current.pageNum, false);
+            return RBFM_SLOT_DN_EXIST;
+        }
+
+        SlotDirectoryRecordEntry recordEntry = getSlotDirectoryRecordEntry(pageData, current.slotNum);
+        SlotStatus status = getSlotStatus(recordEntry);
+        if (status == VALID)
+        {
+            view.fileHandle = &fileHandle;
+            view.pageNum = current.pageNum;
+            view.page = pageData;
+            view.record = (char*) pageData + recordEntry.offset;
+            return SUCCESS;
+        }
+
+        _bp_manager->unpinPage(fileHandle, current.pageNum, false);
+        if (status == DEAD)
+            return RBFM_READ_AFTER_DEL;
+        current.pageNum = recordEntry.length;
+        current.slotNum = -recordEntry.offset;
+    }
+}
+
 RC RecordBasedFileManager::deleteRecord(FileHandle &fileHandle, const vector<Attribute> &recordDescriptor, const RID &rid)
 {
+    // Free space map pages hold no records
+    if (isFreeSpaceMapPage(rid.pageNum))
+        return RBFM_SLOT_DN_EXIST;
+    if (isParallelScanned(fileHandle))
+        return RBFM_FILE_SCANNED;
+
     // Get page
-    void *pageData = malloc(PAGE_SIZE);
-    if (fileHandle.readPage(rid.pageNum, pageData) != SUCCESS)
+    void *pageData;
+    if (_bp_manager->pinPage(fileHandle, rid.pageNum, pageData) != SUCCESS)
         return RBFM_READ_FAILED;
 
     // Get page header
     SlotDirectoryHeader slotHeader = getSlotDirectoryHeader(pageData);
     if (slotHeader.recordEntriesNumber <= rid.slotNum)
+    {
+        _bp_manager->unpinPage(fileHandle, rid.pageNum, false);
         return RBFM_SLOT_DN_EXIST;
+    }
 
     // Get slot record entry data
     SlotDirectoryRecordEntry recordEntry = getSlotDirectoryRecordEntry(pageData, rid.slotNum);
@@ -198,7 +565,7 @@ RC RecordBasedFileManager::deleteRecord(FileHandle &fileHandle, const vector<Att
     // Cannot delete a deleted page
     if (status == DEAD)
     {
-        free(pageData);
+        _bp_manager->unpinPage(fileHandle, rid.pageNum, false);
         return RBFM_SLOT_DN_EXIST;
     }
     // Recursively delete moved pages
@@ -210,20 +577,28 @@ RC RecordBasedFileManager::deleteRecord(FileHandle &fileHandle, const vector<Att
         RC rc = deleteRecord(fileHandle, recordDescriptor, newRid);
         if (rc != SUCCESS)
         {
-            free(pageData);
+            _bp_manager->unpinPage(fileHandle, rid.pageNum, false);
             return rc;
         }
         markSlotDeleted(pageData, rid.slotNum);
     }
     else if (status == VALID)
     {
+        RC rc = freeRecordToast(fileHandle, (char*) pageData + recordEntry.offset);
+        if (rc != SUCCESS)
+        {
+            _bp_manager->unpinPage(fileHandle, rid.pageNum, false);
+            return rc;
+        }
         markSlotDeleted(pageData, rid.slotNum);
         reorganizePage(pageData);
+        dropEmptyDictionary(pageData);
+        clearForwardedHome(fileHandle, rid);
     }
     
-    // Once we've deleted the page(s), write changes to disk
-    RC rc = fileHandle.writePage(rid.pageNum, pageData);
-    free(pageData);
+    // Once we've deleted the page(s), hand the changes back to the pool
+    RC rc = updatePageSummaries(fileHandle, recordDescriptor, rid.pageNum, pageData);
+    _bp_manager->unpinPage(fileHandle, rid.pageNum, true);
     return rc;
 }
 
@@ -234,19 +609,59 @@ RC RecordBasedFileManager::deleteRecord(FileHandle &fileHandle, const vector<Att
 // same: do nothing
 RC RecordBasedFileManager::updateRecord(FileHandle &fileHandle, const vector<Attribute> &recordDescriptor, const void *data, const RID &rid)
 {
-    // Retrieve the specific page
-    void *pageData = malloc(PAGE_SIZE);
-    if (fileHandle.readPage(rid.pageNum, pageData))
+    if (isParallelScanned(fileHandle))
+        return RBFM_FILE_SCANNED;
+
+    // The new values that don't fit go out of line first
+    unsigned recordSize = getRecordSize(recordDescriptor, data);
+    void *toasted = NULL;
+    RC rc = SUCCESS;
+    if (recordSize > RBFM_TOAST_RECORD_SIZE && (rc = toastRecord(fileHandle, recordDescriptor, data, recordSize, toasted)))
+        return rc;
+    if (sizeof(SlotDirectoryHeader) + sizeof(SlotDirectoryRecordEntry) + recordSize > PAGE_SIZE)
+        rc = RBFM_RECORD_TOO_BIG;
+
+    // The old record's values out of line are only let go once nothing points at them any more
+    vector<ToastPointer> oldToast;
+    RecordFile *file = findRecordFile(fileHandle);
+    if (rc == SUCCESS && file != NULL && file->hasToast)
     {
-        free(pageData);
-        return RBFM_READ_FAILED;
+        RecordView view;
+        if ((rc = readRecordView(fileHandle, rid, view)) == SUCCESS)
+            getRecordToast(view.record, oldToast);
+        view.release();
     }
+    if (rc == SUCCESS)
+        rc = updateRecordAt(fileHandle, recordDescriptor, toasted != NULL ? toasted : data, rid);
+
+    if (rc == SUCCESS)
+    {
+        for (unsigned i = 0; i < oldToast.size() && rc == SUCCESS; i++)
+            rc = freeToastValue(file, oldToast[i]);
+    }
+    else if (toasted != NULL)
+        freeRecordToast(fileHandle, recordDescriptor, data, toasted);
+    free(toasted);
+    return rc;
+}
+
+// Update the record at rid with data whose values are already in or out of line as they will be stored
+RC RecordBasedFileManager::updateRecordAt(FileHandle &fileHandle, const vector<Attribute> &recordDescriptor, const void *data, const RID &rid)
+{
+    // Free space map pages hold no records
+    if (isFreeSpaceMapPage(rid.pageNum))
+        return RBFM_SLOT_DN_EXIST;
+
+    // Retrieve the specific page
+    void *pageData;
+    if (_bp_manager->pinPage(fileHandle, rid.pageNum, pageData))
+        return RBFM_READ_FAILED;
 
     // Checks if the specific slot id exists in the page
     SlotDirectoryHeader slotHeader = getSlotDirectoryHeader(pageData);
     if(slotHeader.recordEntriesNumber <= rid.slotNum)
     {
-        free(pageData);
+        _bp_manager->unpinPage(fileHandle, rid.pageNum, false);
         return RBFM_SLOT_DN_EXIST;
     }
 
@@ -258,36 +673,57 @@ RC RecordBasedFileManager::updateRecord(FileHandle &fileHandle, const vector<Att
     {
         // Error to update a deleted record
         case DEAD:
-            free(pageData);
+            _bp_manager->unpinPage(fileHandle, rid.pageNum, false);
             return RBFM_READ_AFTER_DEL;
-        // Get the forwarding address from the record entry and recurse
+        // Update the record where it was moved to, keeping this slot pointing straight at it
         case MOVED:
-            free(pageData);
-            RID newRid;
-            newRid.pageNum = recordEntry.length;
-            newRid.slotNum = -recordEntry.offset;
-            return updateRecord(fileHandle, recordDescriptor, data, newRid);
+        {
+            RC rc = updateForwardedRecord(fileHandle, recordDescriptor, data, rid, pageData, recordEntry);
+            _bp_manager->unpinPage(fileHandle, rid.pageNum, rc == SUCCESS);
+            return rc;
+        }
         default:
         break;
     }
     // Do actual work
-    // Gets the size of the updated record
+    // Gets the size of the updated record, coded against this page's dictionary. Adding to the
+    // dictionary moves the records on the page.
     unsigned recordSize = getRecordSize(recordDescriptor, data);
-    if (recordSize  == recordEntry.length)
+    void *coded;
+    RC rc = codeRecord(fileHandle, recordDescriptor, pageData, data, sizeof(SlotDirectoryRecordEntry) + recordEntry.length, coded, recordSize);
+    if (rc)
     {
-        setRecordAtOffset(pageData, recordEntry.offset, recordDescriptor, data);
-        RC rc = fileHandle.writePage(rid.pageNum, pageData);
-        free(pageData);
+        _bp_manager->unpinPage(fileHandle, rid.pageNum, false);
+        return rc;
+    }
+    rc = updateRecordOnPage(fileHandle, recordDescriptor, data, coded != NULL ? coded : data, recordSize, rid, pageData);
+    free(coded);
+    return rc;
+}
+
+// The rest of updateRecordAt, once record is what will be stored on the pinned page. data is the record
+// uncoded, for when it has to go elsewhere. Unpins the page.
+RC RecordBasedFileManager::updateRecordOnPage(FileHandle &fileHandle, const vector<Attribute> &recordDescriptor, const void *data,
+                                              const void *record, unsigned recordSize, const RID &rid, void *pageData)
+{
+    SlotDirectoryHeader slotHeader;
+    SlotDirectoryRecordEntry recordEntry = getSlotDirectoryRecordEntry(pageData, rid.slotNum);
+    if (recordSize  == recordEntry.length || isPaxPage(pageData))
+    {
+        // A row of a PAX page always fits where it is
+        setRecordAtOffset(pageData, recordEntry.offset, recordDescriptor, record);
+        RC rc = rebuildZoneMap(fileHandle, recordDescriptor, rid.pageNum, pageData);
+        _bp_manager->unpinPage(fileHandle, rid.pageNum, true);
         return rc;
     }
     else if (recordSize < recordEntry.length)
     {
-        setRecordAtOffset(pageData, recordEntry.offset, recordDescriptor, data);
+        setRecordAtOffset(pageData, recordEntry.offset, recordDescriptor, record);
         recordEntry.length = recordSize;
         setSlotDirectoryRecordEntry(pageData, rid.slotNum, recordEntry);
         reorganizePage(pageData);
-        RC rc = fileHandle.writePage(rid.pageNum, pageData);
-        free(pageData);
+        RC rc = updatePageSummaries(fileHandle, recordDescriptor, rid.pageNum, pageData);
+        _bp_manager->unpinPage(fileHandle, rid.pageNum, true);
         return rc;
     }
     else if (recordSize > recordEntry.length)
@@ -300,13 +736,14 @@ RC RecordBasedFileManager::updateRecord(FileHandle &fileHandle, const vector<Att
             RC rc = insertRecord(fileHandle, recordDescriptor, data, newRid);
             if (rc != SUCCESS)
             {
-                free(pageData);
+                _bp_manager->unpinPage(fileHandle, rid.pageNum, false);
                 return rc;
             }
             recordEntry.length = newRid.pageNum;
             recordEntry.offset = -newRid.slotNum;
             setSlotDirectoryRecordEntry(pageData, rid.slotNum, recordEntry);
             reorganizePage(pageData);
+            setForwardedHome(fileHandle, newRid, rid);
         }
         else
         {
@@ -328,63 +765,414 @@ RC RecordBasedFileManager::updateRecord(FileHandle &fileHandle, const vector<Att
             setSlotDirectoryHeader(pageData, slotHeader);
 
             // Add new record data
-            setRecordAtOffset (pageData, recordEntry.offset, recordDescriptor, data);
+            setRecordAtOffset (pageData, recordEntry.offset, recordDescriptor, record);
         }
     }
-    RC rc = fileHandle.writePage(rid.pageNum, pageData);
-    free(pageData);
+    RC rc = updatePageSummaries(fileHandle, recordDescriptor, rid.pageNum, pageData);
+    _bp_manager->unpinPage(fileHandle, rid.pageNum, true);
     return rc;
 }
 
-RC RecordBasedFileManager::printRecord(const vector<Attribute> &recordDescriptor, const void *data) 
+// Map every slot on pages [low, high) that some other slot forwards to, keyed by page and slot, to that other slot
+RC RecordBasedFileManager::findForwardedHomes(FileHandle &fileHandle, PageNum low, PageNum high, unordered_map<uint64_t, RID> &homes)
 {
-    // Parse the null indicator into an array
-    int nullIndicatorSize = getNullIndicatorSize(recordDescriptor.size());
-    char nullIndicator[nullIndicatorSize];
-    memset(nullIndicator, 0, nullIndicatorSize);
-    memcpy(nullIndicator, data, nullIndicatorSize);
-    
-    // We've read in the null indicator, so we can skip past it now
-    unsigned offset = nullIndicatorSize;
-
-    cout << "----" << endl;
-    for (unsigned i = 0; i < (unsigned) recordDescriptor.size(); i++)
+    unsigned numPages = fileHandle.getNumberOfPages();
+    for (PageNum i = 1; i < numPages; i++)
     {
-        cout << setw(10) << left << recordDescriptor[i].name << ": ";
-        // If the field is null, don't print it
-        bool isNull = fieldIsNull(nullIndicator, i);
-        if (isNull)
-        {
-            cout << "NULL" << endl;
+        if (isFreeSpaceMapPage(i))
             continue;
-        }
-        switch (recordDescriptor[i].type)
+        void *pageData;
+        if (_bp_manager->pinPage(fileHandle, i, pageData))
+            return RBFM_READ_FAILED;
+        SlotDirectoryHeader slotHeader = getSlotDirectoryHeader(pageData);
+        for (unsigned j = 0; j < slotHeader.recordEntriesNumber; j++)
         {
-            case TypeInt:
-                uint32_t data_integer;
-                memcpy(&data_integer, ((char*) data + offset), INT_SIZE);
-                offset += INT_SIZE;
+            SlotDirectoryRecordEntry recordEntry = getSlotDirectoryRecordEntry(pageData, j);
+            if (getSlotStatus(recordEntry) != MOVED || recordEntry.length < low || recordEntry.length >= high)
+                continue;
+            RID home;
+            home.pageNum = i;
+            home.slotNum = j;
+            homes[((uint64_t) recordEntry.length << 32) | (uint32_t) -recordEntry.offset] = home;
+        }
+        _bp_manager->unpinPage(fileHandle, i, false);
+    }
+    return SUCCESS;
+}
 
-                cout << "" << data_integer << endl;
-            break;
-            case TypeReal:
-                float data_real;
-                memcpy(&data_real, ((char*) data + offset), REAL_SIZE);
-                offset += REAL_SIZE;
+// Note that the record at rid was moved there from home, if the file keeps track of that
+void RecordBasedFileManager::setForwardedHome(FileHandle &fileHandle, const RID &rid, const RID &home)
+{
+    RecordFile *file = findRecordFile(fileHandle);
+    if (file != NULL && file->hasHomes)
+        file->homes[((uint64_t) rid.pageNum << 32) | rid.slotNum] = home;
+}
 
-                cout << "" << data_real << endl;
-            break;
-            case TypeVarChar:
-                // First VARCHAR_LENGTH_SIZE bytes describe the varchar length
-                uint32_t varcharSize;
-                memcpy(&varcharSize, ((char*) data + offset), VARCHAR_LENGTH_SIZE);
-                offset += VARCHAR_LENGTH_SIZE;
+// Note that nothing was moved to rid any more
+void RecordBasedFileManager::clearForwardedHome(FileHandle &fileHandle, const RID &rid)
+{
+    RecordFile *file = findRecordFile(fileHandle);
+    if (file != NULL && file->hasHomes)
+        file->homes.erase(((uint64_t) rid.pageNum << 32) | rid.slotNum);
+}
 
-                // Gets the actual string.
-                char *data_string = (char*) malloc(varcharSize + 1);
-                if (data_string == NULL)
-                    return RBFM_MALLOC_FAILED;
-                memcpy(data_string, ((char*) data + offset), varcharSize);
+// Drop what closeFile kept about the file's moved records, before it is destroyed or once a new
+// file may have taken its identity
+void RecordBasedFileManager::forgetClosedHomes(const string &fileName)
+{
+    struct stat sb;
+    if (stat(fileName.c_str(), &sb) != 0)
+        return;
+    for (unsigned i = 0; i < _closedHomes.size(); i++)
+    {
+        if (_closedHomes[i]->id.device == sb.st_dev && _closedHomes[i]->id.inode == sb.st_ino)
+        {
+            delete _closedHomes[i];
+            _closedHomes.erase(_closedHomes.begin() + i);
+            return;
+        }
+    }
+}
+
+// Move the records on the page that have homes elsewhere closer to the start of the file, then
+// drop dead slots from the end of its slot directory
+RC RecordBasedFileManager::vacuumPage(FileHandle &fileHandle, const vector<Attribute> &recordDescriptor, PageNum pageNum, const unordered_map<uint64_t, RID> &homes)
+{
+    RC rc = SUCCESS;
+    void *pageData;
+    if (_bp_manager->pinPage(fileHandle, pageNum, pageData))
+        return RBFM_READ_FAILED;
+
+    SlotDirectoryHeader slotHeader = getSlotDirectoryHeader(pageData);
+    for (unsigned i = 0; i < slotHeader.recordEntriesNumber && rc == SUCCESS; i++)
+    {
+        SlotDirectoryRecordEntry recordEntry = getSlotDirectoryRecordEntry(pageData, i);
+        unordered_map<uint64_t, RID>::const_iterator found = homes.find(((uint64_t) pageNum << 32) | i);
+        if (getSlotStatus(recordEntry) != VALID || found == homes.end() || found->second.pageNum == pageNum)
+            continue;
+        // Moving the record changes homes
+        RID home = found->second;
+        RID rid;
+        rid.pageNum = pageNum;
+        rid.slotNum = i;
+        rc = relocateRecord(fileHandle, recordDescriptor, home, rid, pageData);
+    }
+
+    // Slots in the middle of the directory have to stay, they are still someone's next RID
+    slotHeader = getSlotDirectoryHeader(pageData);
+    unsigned entries = slotHeader.recordEntriesNumber;
+    while (entries > 0 && getSlotStatus(getSlotDirectoryRecordEntry(pageData, entries - 1)) == DEAD)
+        entries--;
+    bool trimmed = entries != slotHeader.recordEntriesNumber;
+    if (rc == SUCCESS && trimmed)
+    {
+        slotHeader.recordEntriesNumber = entries;
+        setSlotDirectoryHeader(pageData, slotHeader);
+        reorganizePage(pageData);
+        rc = updatePageSummaries(fileHandle, recordDescriptor, pageNum, pageData);
+    }
+    _bp_manager->unpinPage(fileHandle, pageNum, trimmed);
+    return rc;
+}
+
+// Move a record that was forwarded from home to rid, whose page the caller has pinned. It goes back home if
+// there is room, else to an earlier page that has room, else nowhere. Its bytes are copied as they are,
+// unless it has codes into the dictionary of its page, in which case it is coded again for the new one.
+RC RecordBasedFileManager::relocateRecord(FileHandle &fileHandle, const vector<Attribute> &recordDescriptor, const RID &home, const RID &rid, void *pageData)
+{
+    RC rc;
+    SlotDirectoryRecordEntry recordEntry = getSlotDirectoryRecordEntry(pageData, rid.slotNum);
+    const char *record = (char*) pageData + recordEntry.offset;
+    unsigned length = recordEntry.length;
+    void *data = NULL;
+    RecordLength n;
+    memcpy(&n, record, sizeof(RecordLength));
+    n &= ~RBFM_FIXED_RECORD;
+    for (unsigned i = 0; i < n && data == NULL; i++)
+    {
+        if (!isCodedField(record, i))
+            continue;
+        if ((data = malloc(PAGE_SIZE)) == NULL)
+            return RBFM_MALLOC_FAILED;
+        getRecordAtOffset(pageData, recordEntry.offset, recordDescriptor, data);
+        length = getRecordSize(recordDescriptor, data);
+    }
+    rc = relocateRecordData(fileHandle, recordDescriptor, home, rid, pageData, data, length);
+    free(data);
+    return rc;
+}
+
+// The rest of relocateRecord, with data the record in the insertRecord() format if it has to be coded
+// again, NULL to copy it as it is. length is its size uncoded.
+RC RecordBasedFileManager::relocateRecordData(FileHandle &fileHandle, const vector<Attribute> &recordDescriptor, const RID &home, const RID &rid,
+                                              void *pageData, const void *data, unsigned length)
+{
+    RC rc;
+    SlotDirectoryRecordEntry recordEntry = getSlotDirectoryRecordEntry(pageData, rid.slotNum);
+
+    void *homeData;
+    if (_bp_manager->pinPage(fileHandle, home.pageNum, homeData))
+        return RBFM_READ_FAILED;
+
+    // The home slot has to still point here, or what we were told about it is out of date
+    bool stale = getSlotDirectoryHeader(homeData).recordEntriesNumber <= home.slotNum;
+    if (!stale)
+    {
+        SlotDirectoryRecordEntry homeEntry = getSlotDirectoryRecordEntry(homeData, home.slotNum);
+        stale = getSlotStatus(homeEntry) != MOVED || homeEntry.length != rid.pageNum || (unsigned) -homeEntry.offset != rid.slotNum;
+    }
+    if (stale)
+    {
+        clearForwardedHome(fileHandle, rid);
+        return _bp_manager->unpinPage(fileHandle, home.pageNum, false);
+    }
+
+    RID newRid;
+    void *newData;
+    if (getPageFreeSpaceSize(homeData) >= length)
+    {
+        newRid = home;
+        newData = homeData;
+    }
+    else
+    {
+        bool found;
+        if ((rc = findPageWithFreeSpace(fileHandle, sizeof(SlotDirectoryRecordEntry) + length, newRid.pageNum, found, rid.pageNum)))
+        {
+            _bp_manager->unpinPage(fileHandle, home.pageNum, false);
+            return rc;
+        }
+        // Nowhere better for it, or the map was out of date, in which case the next pass can try again
+        if (!found || newRid.pageNum == home.pageNum)
+            return _bp_manager->unpinPage(fileHandle, home.pageNum, false);
+        if (_bp_manager->pinPage(fileHandle, newRid.pageNum, newData))
+        {
+            _bp_manager->unpinPage(fileHandle, home.pageNum, false);
+            return RBFM_READ_FAILED;
+        }
+        if (getPageFreeSpaceSize(newData) < sizeof(SlotDirectoryRecordEntry) + length)
+        {
+            _bp_manager->unpinPage(fileHandle, home.pageNum, false);
+            rc = updateFreeSpaceMap(fileHandle, newRid.pageNum, newData);
+            _bp_manager->unpinPage(fileHandle, newRid.pageNum, false);
+            return rc;
+        }
+        newRid.slotNum = getOpenSlot(newData);
+    }
+
+    // Copy the record to the end of the free space on its new page
+    void *coded = NULL;
+    rc = SUCCESS;
+    if (data != NULL)
+        rc = codeRecord(fileHandle, recordDescriptor, newData, data, newData == homeData ? sizeof(SlotDirectoryRecordEntry) : 0, coded, length);
+    SlotDirectoryHeader slotHeader = getSlotDirectoryHeader(newData);
+    SlotDirectoryRecordEntry newEntry;
+    newEntry.length = length;
+    newEntry.offset = slotHeader.freeSpaceOffset - length;
+    if (data == NULL)
+        memcpy((char*) newData + newEntry.offset, (char*) pageData + recordEntry.offset, length);
+    else
+        setRecordAtOffset(newData, newEntry.offset, recordDescriptor, coded != NULL ? coded : data);
+    free(coded);
+    setSlotDirectoryRecordEntry(newData, newRid.slotNum, newEntry);
+    slotHeader.freeSpaceOffset = newEntry.offset;
+    if (newRid.slotNum == slotHeader.recordEntriesNumber)
+        slotHeader.recordEntriesNumber++;
+    setSlotDirectoryHeader(newData, slotHeader);
+
+    if (rc == SUCCESS)
+        rc = updateFreeSpaceMap(fileHandle, newRid.pageNum, newData);
+    if (rc == SUCCESS)
+        rc = widenZoneMap(fileHandle, recordDescriptor, newRid.pageNum, newData, newRid.slotNum);
+    if (newRid.pageNum != home.pageNum)
+    {
+        _bp_manager->unpinPage(fileHandle, newRid.pageNum, true);
+        SlotDirectoryRecordEntry forward;
+        forward.length = newRid.pageNum;
+        forward.offset = -newRid.slotNum;
+        setSlotDirectoryRecordEntry(homeData, home.slotNum, forward);
+        setForwardedHome(fileHandle, newRid, home);
+    }
+    _bp_manager->unpinPage(fileHandle, home.pageNum, true);
+    if (rc)
+        return rc;
+    return dropSlot(fileHandle, recordDescriptor, rid);
+}
+
+// Cut empty pages, and map pages with nothing after them, off the end of the file
+RC RecordBasedFileManager::truncateEmptyPages(FileHandle &fileHandle)
+{
+    unsigned numPages = fileHandle.getNumberOfPages();
+    unsigned keep = numPages;
+    // Files always keep their first map page and record page
+    while (keep > 2)
+    {
+        PageNum last = keep - 1;
+        if (!isFreeSpaceMapPage(last))
+        {
+            void *pageData;
+            if (_bp_manager->pinPage(fileHandle, last, pageData))
+                return RBFM_READ_FAILED;
+            unsigned entries = getSlotDirectoryHeader(pageData).recordEntriesNumber;
+            _bp_manager->unpinPage(fileHandle, last, false);
+            if (entries != 0)
+                break;
+        }
+        keep--;
+    }
+    if (keep < numPages && fileHandle.truncate(keep))
+        return RBFM_WRITE_FAILED;
+    return SUCCESS;
+}
+
+// Update a record that has been moved away from rid, whose page the caller has pinned. The record goes
+// back home if there is room, else stays where it is if it still fits, else moves to a new page. The home
+// slot always ends up pointing straight at it, and any slots left in between are reclaimed.
+RC RecordBasedFileManager::updateForwardedRecord(FileHandle &fileHandle, const vector<Attribute> &recordDescriptor, const void *data,
+                                                 const RID &rid, void *pageData, SlotDirectoryRecordEntry recordEntry)
+{
+    RC rc;
+    RID target;
+    target.pageNum = recordEntry.length;
+    target.slotNum = -recordEntry.offset;
+
+    // Follow the chain to the record, files written before updates collapsed it can have several hops
+    vector<RID> between;
+    void *targetData;
+    SlotDirectoryRecordEntry targetEntry;
+    while (true)
+    {
+        if (isFreeSpaceMapPage(target.pageNum))
+            return RBFM_SLOT_DN_EXIST;
+        if (_bp_manager->pinPage(fileHandle, target.pageNum, targetData))
+            return RBFM_READ_FAILED;
+        SlotDirectoryHeader targetHeader = getSlotDirectoryHeader(targetData);
+        if (targetHeader.recordEntriesNumber <= target.slotNum)
+        {
+            _bp_manager->unpinPage(fileHandle, target.pageNum, false);
+            return RBFM_SLOT_DN_EXIST;
+        }
+        targetEntry = getSlotDirectoryRecordEntry(targetData, target.slotNum);
+        SlotStatus status = getSlotStatus(targetEntry);
+        if (status == VALID)
+            break;
+        _bp_manager->unpinPage(fileHandle, target.pageNum, false);
+        if (status == DEAD)
+            return RBFM_READ_AFTER_DEL;
+        between.push_back(target);
+        target.pageNum = targetEntry.length;
+        target.slotNum = -targetEntry.offset;
+    }
+
+    unsigned recordSize = getRecordSize(recordDescriptor, data);
+    bool fits = recordSize <= getPageFreeSpaceSize(targetData) + targetEntry.length;
+    _bp_manager->unpinPage(fileHandle, target.pageNum, false);
+
+    if (target.pageNum != rid.pageNum && recordSize <= getPageFreeSpaceSize(pageData))
+    {
+        // Room for it back home, the slot is already there
+        if ((rc = dropSlot(fileHandle, recordDescriptor, target)))
+            return rc;
+        SlotDirectoryHeader slotHeader = getSlotDirectoryHeader(pageData);
+        recordEntry.length = recordSize;
+        recordEntry.offset = slotHeader.freeSpaceOffset - recordSize;
+        slotHeader.freeSpaceOffset = recordEntry.offset;
+        setSlotDirectoryHeader(pageData, slotHeader);
+        setRecordAtOffset(pageData, recordEntry.offset, recordDescriptor, data);
+    }
+    else if (fits)
+    {
+        // Still fits where it is, so this is an ordinary update of that record
+        if ((rc = updateRecordAt(fileHandle, recordDescriptor, data, target)))
+            return rc;
+        recordEntry.length = target.pageNum;
+        recordEntry.offset = -target.slotNum;
+        setForwardedHome(fileHandle, target, rid);
+    }
+    else
+    {
+        // Move it again, and free the slot it leaves
+        RID newRid;
+        if ((rc = insertRecord(fileHandle, recordDescriptor, data, newRid)))
+            return rc;
+        if ((rc = dropSlot(fileHandle, recordDescriptor, target)))
+            return rc;
+        recordEntry.length = newRid.pageNum;
+        recordEntry.offset = -newRid.slotNum;
+        setForwardedHome(fileHandle, newRid, rid);
+    }
+    setSlotDirectoryRecordEntry(pageData, rid.slotNum, recordEntry);
+
+    for (unsigned i = 0; i < between.size(); i++)
+        if ((rc = dropSlot(fileHandle, recordDescriptor, between[i])))
+            return rc;
+    return updatePageSummaries(fileHandle, recordDescriptor, rid.pageNum, pageData);
+}
+
+// Free a slot nothing refers to any more, along with any record it holds
+RC RecordBasedFileManager::dropSlot(FileHandle &fileHandle, const vector<Attribute> &recordDescriptor, const RID &rid)
+{
+    void *pageData;
+    if (_bp_manager->pinPage(fileHandle, rid.pageNum, pageData))
+        return RBFM_READ_FAILED;
+    markSlotDeleted(pageData, rid.slotNum);
+    reorganizePage(pageData);
+    dropEmptyDictionary(pageData);
+    clearForwardedHome(fileHandle, rid);
+    RC rc = updatePageSummaries(fileHandle, recordDescriptor, rid.pageNum, pageData);
+    _bp_manager->unpinPage(fileHandle, rid.pageNum, true);
+    return rc;
+}
+
+RC RecordBasedFileManager::printRecord(const vector<Attribute> &recordDescriptor, const void *data) 
+{
+    // Parse the null indicator into an array
+    int nullIndicatorSize = getNullIndicatorSize(recordDescriptor.size());
+    char nullIndicator[nullIndicatorSize];
+    memset(nullIndicator, 0, nullIndicatorSize);
+    memcpy(nullIndicator, data, nullIndicatorSize);
+    
+    // We've read in the null indicator, so we can skip past it now
+    unsigned offset = nullIndicatorSize;
+
+    cout << "----" << endl;
+    for (unsigned i = 0; i < (unsigned) recordDescriptor.size(); i++)
+    {
+        cout << setw(10) << left << recordDescriptor[i].name << ": ";
+        // If the field is null, don't print it
+        bool isNull = fieldIsNull(nullIndicator, i);
+        if (isNull)
+        {
+            cout << "NULL" << endl;
+            continue;
+        }
+        switch (recordDescriptor[i].type)
+        {
+            case TypeInt:
+                uint32_t data_integer;
+                memcpy(&data_integer, ((char*) data + offset), INT_SIZE);
+                offset += INT_SIZE;
+
+                cout << "" << data_integer << endl;
+            break;
+            case TypeReal:
+                float data_real;
+                memcpy(&data_real, ((char*) data + offset), REAL_SIZE);
+                offset += REAL_SIZE;
+
+                cout << "" << data_real << endl;
+            break;
+            case TypeVarChar:
+                // First VARCHAR_LENGTH_SIZE bytes describe the varchar length
+                uint32_t varcharSize;
+                memcpy(&varcharSize, ((char*) data + offset), VARCHAR_LENGTH_SIZE);
+                offset += VARCHAR_LENGTH_SIZE;
+
+                // Gets the actual string.
+                char *data_string = (char*) malloc(varcharSize + 1);
+                if (data_string == NULL)
+                    return RBFM_MALLOC_FAILED;
+                memcpy(data_string, ((char*) data + offset), varcharSize);
 
                 // Adds the string terminator.
                 data_string[varcharSize] = '\0';
@@ -402,19 +1190,22 @@ RC RecordBasedFileManager::printRecord(const vector<Attribute> &recordDescriptor
 
 RC RecordBasedFileManager::readAttribute(FileHandle &fileHandle, const vector<Attribute> &recordDescriptor, const RID &rid, const string &attributeName, void *data)
 {
-    char *pageData = (char*)malloc(PAGE_SIZE);
-    if (pageData == NULL)
-        return RBFM_MALLOC_FAILED;
-    if (fileHandle.readPage(rid.pageNum, pageData) != SUCCESS)
-    {
-        free(pageData);
+    // Free space map pages hold no records
+    if (isFreeSpaceMapPage(rid.pageNum))
+        return RBFM_SLOT_DN_EXIST;
+
+    void *pageData;
+    if (_bp_manager->pinPage(fileHandle, rid.pageNum, pageData) != SUCCESS)
         return RBFM_READ_FAILED;
-    }
+
     // Get record header, recurse if forwarded
     // Checks if the specific slot id exists in the page
     SlotDirectoryHeader slotHeader = getSlotDirectoryHeader(pageData);
     if(slotHeader.recordEntriesNumber < rid.slotNum)
+    {
+        _bp_manager->unpinPage(fileHandle, rid.pageNum, false);
         return RBFM_SLOT_DN_EXIST;
+    }
 
     // Gets the slot directory record entry data
     SlotDirectoryRecordEntry recordEntry = getSlotDirectoryRecordEntry(pageData, rid.slotNum);
@@ -424,11 +1215,11 @@ RC RecordBasedFileManager::readAttribute(FileHandle &fileHandle, const vector<At
     {
         // Error to get attribute of a deleted record
         case DEAD:
-            free(pageData);
+            _bp_manager->unpinPage(fileHandle, rid.pageNum, false);
             return RBFM_READ_AFTER_DEL;
         // Get the forwarding address from the record entry and recurse
         case MOVED:
-            free(pageData);
+            _bp_manager->unpinPage(fileHandle, rid.pageNum, false);
             RID newRid;
             newRid.pageNum = recordEntry.length;
             newRid.slotNum = -recordEntry.offset;
@@ -444,12 +1235,16 @@ RC RecordBasedFileManager::readAttribute(FileHandle &fileHandle, const vector<At
     auto iterPos = find_if(recordDescriptor.begin(), recordDescriptor.end(), pred);
     unsigned index = distance(recordDescriptor.begin(), iterPos);
     if (index == recordDescriptor.size())
+    {
+        _bp_manager->unpinPage(fileHandle, rid.pageNum, false);
         return RBFM_NO_SUCH_ATTR;
+    }
     AttrType type = recordDescriptor[index].type;
     // Write attribute to data
-    getAttributeFromRecord(pageData, offset, index, type, data);
-    free(pageData);
-    return SUCCESS;
+    bool toasted = getAttributeFromRecord(pageData, offset, index, type, data);
+    _bp_manager->unpinPage(fileHandle, rid.pageNum, false);
+    unsigned size;
+    return toasted ? detoastRecord(fileHandle, vector<Attribute>(1, recordDescriptor[index]), data, size) : SUCCESS;
 }
 
 // Scan returns an iterator to allow the caller to go through the results one by one. 
@@ -459,662 +1254,3018 @@ RC RecordBasedFileManager::readAttribute(FileHandle &fileHandle, const vector<At
       const CompOp compOp,                  // comparision type such as "<" and "="
       const void *value,                    // used in the comparison
       const vector<string> &attributeNames, // a list of projected attributes
-      RBFM_ScanIterator &rbfm_ScanIterator)
-{
-    return rbfm_ScanIterator.scanInit(fileHandle, recordDescriptor, conditionAttribute, compOp, value, attributeNames);
-}
-
-RBFM_ScanIterator::RBFM_ScanIterator()
-: currPage(0), currSlot(0), totalPage(0), totalSlot(0)
+      RBFM_ScanIterator &rbfm_ScanIterator,
+      ScanMode scanMode)
 {
-    rbfm = RecordBasedFileManager::instance();
+    RC rc = rbfm_ScanIterator.scanInit(fileHandle, recordDescriptor, conditionAttribute, compOp, value, attributeNames, scanMode);
+    if (rc == SUCCESS && scanMode == PARALLEL_SCAN)
+        rc = rbfm_ScanIterator.startParallelScan();
+    return rc;
 }
 
-RC RBFM_ScanIterator::close()
+RC RecordBasedFileManager::scan(FileHandle &fileHandle,
+      const vector<Attribute> &recordDescriptor,
+      const vector<ScanPredicate> &predicates,
+      const vector<string> &attributeNames,
+      RBFM_ScanIterator &rbfm_ScanIterator,
+      ScanMode scanMode)
 {
-    free(pageData);
-    return SUCCESS;
+    RC rc = rbfm_ScanIterator.scanInit(fileHandle, recordDescriptor, predicates, attributeNames, scanMode);
+    if (rc == SUCCESS && scanMode == PARALLEL_SCAN)
+        rc = rbfm_ScanIterator.startParallelScan();
+    return rc;
 }
 
-// Initialize the scanIterator with all necessary state
-RC RBFM_ScanIterator::scanInit(FileHandle &fh,
-        const vector<Attribute> rd,
-        const string &ca, 
-        const CompOp co, 
-        const void *v, 
-        const vector<string> &an)
+RC RecordBasedFileManager::aggregate(FileHandle &fileHandle,
+      const vector<Attribute> &recordDescriptor,
+      const string &aggregateAttribute,
+      const AggregateOp op,
+      const vector<ScanPredicate> &predicates,
+      const string &groupAttribute,
+      vector<AggregateGroup> &groups)
 {
-    // Start at page 0 slot 0
-    currPage = 0;
-    currSlot = 0;
-    totalPage = 0;
-    totalSlot = 0;
-    // Keep a buffer to hold the current page
-    pageData = malloc(PAGE_SIZE);
+    groups.clear();
 
-    // Store the variables passed in to
-    fileHandle = fh;
-    conditionAttribute = ca;
-    recordDescriptor = rd;
-    compOp = co;
-    value = v;
-    attributeNames = an;
+    // Only COUNT makes sense for varchars, or for whole records
+    unsigned aggIndex = recordDescriptor.size();
+    AttrType aggType = TypeInt;
+    if (!aggregateAttribute.empty())
+    {
+        auto pred = [&](Attribute a) {return a.name == aggregateAttribute;};
+        aggIndex = distance(recordDescriptor.begin(), find_if(recordDescriptor.begin(), recordDescriptor.end(), pred));
+        if (aggIndex == recordDescriptor.size())
+            return RBFM_NO_SUCH_ATTR;
+        aggType = recordDescriptor[aggIndex].type;
+    }
+    if (op != COUNT_AGG && (aggregateAttribute.empty() || aggType == TypeVarChar))
+        return RBFM_AGGREGATE_TYPE;
 
-    skipList.clear();
+    unsigned groupIndex = recordDescriptor.size();
+    if (!groupAttribute.empty())
+    {
+        auto pred = [&](Attribute a) {return a.name == groupAttribute;};
+        groupIndex = distance(recordDescriptor.begin(), find_if(recordDescriptor.begin(), recordDescriptor.end(), pred));
+        if (groupIndex == recordDescriptor.size())
+            return RBFM_NO_SUCH_ATTR;
+        if (recordDescriptor[groupIndex].type == TypeReal)
+            return RBFM_AGGREGATE_TYPE;
+    }
+    bool grouped = groupIndex < recordDescriptor.size();
 
-    // Get total number of pages
-    totalPage = fh.getNumberOfPages();
-    if (totalPage > 0)
+    // Nothing is projected: each match is read where it sits in the page
+    RBFM_ScanIterator iter;
+    vector<string> attributeNames;
+    RC rc = scan(fileHandle, recordDescriptor, predicates, attributeNames, iter);
+    if (rc)
     {
-        if (fh.readPage(0, pageData))
-            return RBFM_READ_FAILED;
+        iter.close();
+        return rc;
     }
-    else
-        return SUCCESS;
 
-    // Get number of slots on first page
-    SlotDirectoryHeader header = rbfm->getSlotDirectoryHeader(pageData);
-    totalSlot = header.recordEntriesNumber;
+    // Groups in the order they were first seen, found again through their value
+    unordered_map<string, unsigned> groupPositions;
+    unsigned nullGroup = UINT_MAX;
+    if (!grouped)
+        groups.push_back(AggregateGroup());
 
-    // If we don't need to do any comparisons, we can ignore the condition attribute
-    if (co == NO_OP)
-        return SUCCESS;
+    RID rid;
+    const char *record;
+    while ((rc = iter.getNextRecordInPlace(rid, record)) == SUCCESS)
+    {
+        const char *field;
+        uint32_t len;
+        unsigned position = 0;
+        if (grouped)
+        {
+            bool isNull = !getRecordValue(iter.pageData, record, groupIndex, field, len);
+            string key = isNull ? string() : string(field, len);
+            if (!isNull && isToastedField(record, groupIndex) && (rc = readToastValue(fileHandle, field, key)))
+                break;
+            unsigned &slot = isNull ? nullGroup : groupPositions.emplace(key, UINT_MAX).first->second;
+            if (slot == UINT_MAX)
+            {
+                slot = groups.size();
+                AggregateGroup group = AggregateGroup();
+                group.groupValue = key;
+                group.groupIsNull = isNull;
+                groups.push_back(group);
+            }
+            position = slot;
+        }
+        AggregateGroup &group = groups[position];
 
-    // Else, we need to find the condition attribute's index in the record descriptor
-    auto pred = [&](Attribute a) {return a.name == conditionAttribute;};
-    auto iterPos = find_if(recordDescriptor.begin(), recordDescriptor.end(), pred);
-    attrIndex = distance(recordDescriptor.begin(), iterPos);
-    if (attrIndex == recordDescriptor.size())
-        return RBFM_NO_SUCH_ATTR;
+        // COUNT(*) takes every record, everything else only those with a value
+        if (aggregateAttribute.empty())
+        {
+            group.count++;
+            continue;
+        }
+        if (!getRecordValue(iter.pageData, record, aggIndex, field, len))
+            continue;
+        if (op == COUNT_AGG)
+        {
+            group.count++;
+            continue;
+        }
+
+        double value;
+        if (aggType == TypeInt)
+        {
+            int32_t intValue;
+            memcpy(&intValue, field, INT_SIZE);
+            value = intValue;
+        }
+        else
+        {
+            float realValue;
+            memcpy(&realValue, field, REAL_SIZE);
+            value = realValue;
+        }
+        if (group.count == 0 || op == SUM_AGG || op == AVG_AGG)
+            group.value = group.count == 0 ? value : group.value + value;
+        else if (op == MIN_AGG)
+            group.value = min(group.value, value);
+        else
+            group.value = max(group.value, value);
+        group.count++;
+    }
+    iter.close();
+    if (rc != RBFM_EOF)
+        return rc;
 
+    for (unsigned i = 0; i < groups.size(); i++)
+    {
+        if (op == COUNT_AGG)
+            groups[i].value = groups[i].count;
+        else if (op == AVG_AGG && groups[i].count > 0)
+            groups[i].value /= groups[i].count;
+    }
     return SUCCESS;
 }
 
-RC RBFM_ScanIterator::getNextRecord(RID &rid, void *data)
+void RecordBasedFileManager::setScanReadAhead(unsigned pages)
 {
-    RC rc = getNextSlot();
-    if (rc)
-        return rc;
-
-    // If we are not returning any results, we can just set the RID and return
-    if (attributeNames.size() == 0)
-    {
-        rid.pageNum = currPage;
-        rid.slotNum = currSlot++;
-        return SUCCESS;
-    }
-
-    // Prepare null indicator
-    unsigned nullIndicatorSize = rbfm->getNullIndicatorSize(attributeNames.size());
-    char nullIndicator[nullIndicatorSize];
-    memset(nullIndicator, 0, nullIndicatorSize);
-
-    SlotDirectoryRecordEntry recordEntry = rbfm->getSlotDirectoryRecordEntry(pageData, currSlot);
+    _scanReadAhead = pages;
+}
 
-    // Unsure how large each attribute will be, set to size of page to be safe
-    void *buffer = malloc(PAGE_SIZE);
-    if (buffer == NULL)
-        return RBFM_MALLOC_FAILED;
+void RecordBasedFileManager::setScanThreads(unsigned threads)
+{
+    if (threads == 0)
+        threads = max(1u, thread::hardware_concurrency());
+    _scanThreads = threads;
+}
 
-    // Keep track of offset into data
-    unsigned dataOffset = nullIndicatorSize;
+RC RecordBasedFileManager::createZoneMap(const string &fileName, const vector<Attribute> &recordDescriptor)
+{
+    if (recordDescriptor.empty())
+        return RBFM_NO_SUCH_ATTR;
 
-    for (unsigned i = 0; i < attributeNames.size(); i++)
+    // Opening the file through us registers it, the zone map hangs off that
+    FileHandle fileHandle;
+    if (openFile(fileName, fileHandle))
+        return RBFM_OPEN_FAILED;
+    RecordFile *file = findRecordFile(fileHandle);
+    if (file->hasZoneMap)
     {
-        // Get index and type of attribute in record
-        auto pred = [&](Attribute a) {return a.name == attributeNames[i];};
-        auto iterPos = find_if(recordDescriptor.begin(), recordDescriptor.end(), pred);
-        unsigned index = distance(recordDescriptor.begin(), iterPos);
-        if (index == recordDescriptor.size())
-            return RBFM_NO_SUCH_ATTR;
-        AttrType type = recordDescriptor[index].type;
-
-        // Read attribute into buffer
-        rbfm->getAttributeFromRecord(pageData, recordEntry.offset, index, type, buffer);
-        // Determine if null
-        char null;
-        memcpy (&null, buffer, 1);
-        if (null)
-        {
-            int indicatorIndex = i / CHAR_BIT;
-            char indicatorMask  = 1 << (CHAR_BIT - 1 - (i % CHAR_BIT));
-            nullIndicator[indicatorIndex] |= indicatorMask;
-        }
-        // Read from buffer into data
-        else if (type == TypeInt)
-        {
-            memcpy ((char*)data + dataOffset, (char*)buffer + 1, INT_SIZE);
-            dataOffset += INT_SIZE;
-        }
-        else if (type == TypeReal)
-        {
-            memcpy ((char*)data + dataOffset, (char*)buffer + 1, REAL_SIZE);
-            dataOffset += REAL_SIZE;
-        }
-        else if (type == TypeVarChar)
-        {
-            uint32_t varcharSize;
-            memcpy(&varcharSize, (char*)buffer + 1, VARCHAR_LENGTH_SIZE);
-            memcpy((char*)data + dataOffset, &varcharSize, VARCHAR_LENGTH_SIZE);
-            dataOffset += VARCHAR_LENGTH_SIZE;
-            memcpy((char*)data + dataOffset, (char*)buffer + 1 + VARCHAR_LENGTH_SIZE, varcharSize);
-            dataOffset += varcharSize;
-        }
+        closeFile(fileHandle);
+        return RBFM_ZONE_MAP_EXISTS;
     }
-    // Finally set null indicator of data, clean up and return
-    memcpy((char*)data, nullIndicator, nullIndicatorSize);
-
-    free (buffer);
-    rid.pageNum = currPage;
-    rid.slotNum = currSlot++;
-    return SUCCESS;
-}
-
-// Private helper methods ///////////////////////////////////////////////////////////////////
 
-RC RBFM_ScanIterator::getNextSlot()
-{
-    // If we're done with the current page, or we've read the last page
-    if (currSlot >= totalSlot || currPage >= totalPage)
+    string zoneName = fileName + ZONE_FILE_SUFFIX;
+    if (_pf_manager->createFile(zoneName))
     {
-        // Reinitialize the current slot and increment page number
-        currSlot = 0;
-        currPage++;
-        // If we're done with last page, return EOF
-        if (currPage >= totalPage)
-            return RBFM_EOF;
-        // Otherwise get next page ready
-        RC rc = getNextPage();
-        if (rc)
-            return rc;
+        closeFile(fileHandle);
+        return RBFM_CREATE_FAILED;
+    }
+    if (_pf_manager->openFile(zoneName, file->zoneHandle))
+    {
+        closeFile(fileHandle);
+        return RBFM_OPEN_FAILED;
     }
 
-    // Get slot header, check to see if valid and meets scan condition
-    SlotDirectoryRecordEntry recordEntry = rbfm->getSlotDirectoryRecordEntry(pageData, currSlot);
-
-    if (rbfm->getSlotStatus(recordEntry) != VALID || !checkScanCondition())
+    // Summarize as many columns as fit an entry in a page
+    void *pageData = calloc(PAGE_SIZE, 1);
+    if (pageData == NULL)
     {
-        // If not, try next slot
-        currSlot++;
-        return getNextSlot();
+        closeFile(fileHandle);
+        return RBFM_MALLOC_FAILED;
     }
-    return SUCCESS;
+    unsigned columns = min((unsigned) recordDescriptor.size(), (unsigned) (PAGE_SIZE / sizeof(ColumnZone)));
+    memcpy(pageData, &columns, sizeof(unsigned));
+    RC rc = SUCCESS;
+    if (file->zoneHandle.appendPage(pageData))
+        rc = RBFM_APPEND_FAILED;
+    file->hasZoneMap = true;
+    file->zoneColumns = columns;
+
+    // Then every data page already in the file
+    for (PageNum i = 1; i < fileHandle.getNumberOfPages() && rc == SUCCESS; i++)
+    {
+        if (isFreeSpaceMapPage(i))
+            continue;
+        if (_bp_manager->readPage(fileHandle, i, pageData))
+            rc = RBFM_READ_FAILED;
+        else
+            rc = rebuildZoneMap(fileHandle, recordDescriptor, i, pageData);
+    }
+    free(pageData);
+
+    RC closeRc = closeFile(fileHandle);
+    return rc ? rc : closeRc;
 }
 
-RC RBFM_ScanIterator::getNextPage()
+RC RecordBasedFileManager::destroyZoneMap(const string &fileName)
 {
-    // Read in page
-    if (fileHandle.readPage(currPage, pageData))
-        return RBFM_READ_FAILED;
+    // Stop maintaining it in case the file is open
+    FileHandle fileHandle;
+    if (openFile(fileName, fileHandle))
+        return RBFM_OPEN_FAILED;
+    RecordFile *file = findRecordFile(fileHandle);
+    if (file->hasZoneMap)
+    {
+        _pf_manager->closeFile(file->zoneHandle);
+        file->hasZoneMap = false;
+        file->zoneColumns = 0;
+    }
+    closeFile(fileHandle);
 
-    // Update slot total
-    SlotDirectoryHeader header = rbfm->getSlotDirectoryHeader(pageData);
-    totalSlot = header.recordEntriesNumber;
-    return SUCCESS;
+    return _pf_manager->destroyFile(fileName + ZONE_FILE_SUFFIX);
 }
 
-bool RBFM_ScanIterator::checkScanCondition()
+RC RecordBasedFileManager::createDictionary(const string &fileName, const vector<Attribute> &recordDescriptor, const vector<string> &attributeNames)
 {
-    if (compOp == NO_OP) return true;
-    if (value == NULL) return false;
-    Attribute attr = recordDescriptor[attrIndex];
-    // Allocate enough memory to hold attribute and 1 byte null indicator
-    void *data = malloc(1 + attr.length);
-    // Get record entry to get offset
-    SlotDirectoryRecordEntry recordEntry = rbfm->getSlotDirectoryRecordEntry(pageData, currSlot);
-    // Grab the given attribute and store it in data
-    rbfm->getAttributeFromRecord(pageData, recordEntry.offset, attrIndex, attr.type, data);
-
-    char null;
-    memcpy(&null, data, 1);
-
-    bool result = false;
-    if (null)
+    vector<unsigned> columns;
+    for (unsigned i = 0; i < attributeNames.size(); i++)
     {
-        result = false;
+        auto pred = [&](Attribute a) {return a.name == attributeNames[i];};
+        unsigned index = distance(recordDescriptor.begin(), find_if(recordDescriptor.begin(), recordDescriptor.end(), pred));
+        if (index == recordDescriptor.size())
+            return RBFM_NO_SUCH_ATTR;
+        if (recordDescriptor[index].type != TypeVarChar)
+            return RBFM_DICTIONARY_TYPE;
+        columns.push_back(index);
     }
-    // Checkscan condition on record data and scan value
-    else if (attr.type == TypeInt)
+    if (columns.empty() || columns.size() >= PAGE_SIZE / sizeof(unsigned))
+        return RBFM_NO_SUCH_ATTR;
+
+    // Opening the file through us registers it, the columns are kept with that
+    FileHandle fileHandle;
+    if (openFile(fileName, fileHandle))
+        return RBFM_OPEN_FAILED;
+    RecordFile *file = findRecordFile(fileHandle);
+    if (!file->dictionaryColumns.empty())
     {
-        int32_t recordInt;
-        memcpy(&recordInt, (char*)data + 1, INT_SIZE);
-        result = checkScanCondition(recordInt, compOp, value);
+        closeFile(fileHandle);
+        return RBFM_DICTIONARY_EXISTS;
     }
-    else if (attr.type == TypeReal)
+
+    // Page 0 of the side file holds the number of columns, then their indexes
+    string dictionaryName = fileName + DICTIONARY_FILE_SUFFIX;
+    FileHandle dictionaryHandle;
+    if (_pf_manager->createFile(dictionaryName) || _pf_manager->openFile(dictionaryName, dictionaryHandle))
     {
-        float recordReal;
-        memcpy(&recordReal, (char*)data + 1, REAL_SIZE);
-        result = checkScanCondition(recordReal, compOp, value);
+        closeFile(fileHandle);
+        return RBFM_CREATE_FAILED;
     }
-    else if (attr.type == TypeVarChar)
+    unsigned *header = (unsigned*) calloc(PAGE_SIZE, 1);
+    if (header == NULL)
     {
-        uint32_t varcharSize;
-        memcpy(&varcharSize, (char*)data + 1, VARCHAR_LENGTH_SIZE);
-        char recordString[varcharSize + 1];
-        memcpy(recordString, (char*)data + 1 + VARCHAR_LENGTH_SIZE, varcharSize);
-        recordString[varcharSize] = '\0';
-
-        result = checkScanCondition(recordString, compOp, value);
+        _pf_manager->closeFile(dictionaryHandle);
+        closeFile(fileHandle);
+        return RBFM_MALLOC_FAILED;
     }
-    free (data);
-    return result;
+    header[0] = columns.size();
+    copy(columns.begin(), columns.end(), header + 1);
+    RC rc = dictionaryHandle.appendPage(header) ? RBFM_APPEND_FAILED : SUCCESS;
+    free(header);
+    _pf_manager->closeFile(dictionaryHandle);
+    if (rc == SUCCESS)
+        file->dictionaryColumns = columns;
+
+    RC closeRc = closeFile(fileHandle);
+    return rc ? rc : closeRc;
 }
 
-bool RBFM_ScanIterator::checkScanCondition(int recordInt, CompOp compOp, const void *value)
+RC RecordBasedFileManager::destroyDictionary(const string &fileName)
 {
-    int32_t intValue;
-    memcpy (&intValue, value, INT_SIZE);
+    // Stop coding new records in case the file is open, the ones already coded keep their dictionaries
+    FileHandle fileHandle;
+    if (openFile(fileName, fileHandle))
+        return RBFM_OPEN_FAILED;
+    findRecordFile(fileHandle)->dictionaryColumns.clear();
+    closeFile(fileHandle);
 
-    switch (compOp)
-    {
-        case EQ_OP: return recordInt == intValue;
-        case LT_OP: return recordInt < intValue;
-        case GT_OP: return recordInt > intValue;
-        case LE_OP: return recordInt <= intValue;
-        case GE_OP: return recordInt >= intValue;
-        case NE_OP: return recordInt != intValue;
-        case NO_OP: return true;
-        // Should never happen
-        default: return false;
-    }
+    return _pf_manager->destroyFile(fileName + DICTIONARY_FILE_SUFFIX);
 }
 
-bool RBFM_ScanIterator::checkScanCondition(float recordReal, CompOp compOp, const void *value)
+RC RecordBasedFileManager::getForwardingChainLengths(FileHandle &fileHandle, vector<unsigned> &chainLengths)
 {
-    float realValue;
-    memcpy (&realValue, value, REAL_SIZE);
+    chainLengths.clear();
+    unsigned numPages = fileHandle.getNumberOfPages();
 
-    switch (compOp)
+    // First find every slot some other slot forwards to, those aren't where records start
+    unordered_map<uint64_t, RID> targets;
+    RC rc = findForwardedHomes(fileHandle, 1, numPages, targets);
+    if (rc)
+        return rc;
+
+    // Then follow the chain from every other live slot
+    for (PageNum i = 1; i < numPages; i++)
     {
-        case EQ_OP: return recordReal == realValue;
-        case LT_OP: return recordReal < realValue;
-        case GT_OP: return recordReal > realValue;
-        case LE_OP: return recordReal <= realValue;
-        case GE_OP: return recordReal >= realValue;
-        case NE_OP: return recordReal != realValue;
-        case NO_OP: return true;
-        // Should never happen
-        default: return false;
+        if (isFreeSpaceMapPage(i))
+            continue;
+        void *pageData;
+        if (_bp_manager->pinPage(fileHandle, i, pageData))
+            return RBFM_READ_FAILED;
+        SlotDirectoryHeader slotHeader = getSlotDirectoryHeader(pageData);
+        for (unsigned j = 0; j < slotHeader.recordEntriesNumber; j++)
+        {
+            SlotDirectoryRecordEntry recordEntry = getSlotDirectoryRecordEntry(pageData, j);
+            SlotStatus status = getSlotStatus(recordEntry);
+            if (status == DEAD || targets.count(((uint64_t) i << 32) | j))
+                continue;
+
+            unsigned hops = 0;
+            while (status == MOVED)
+            {
+                RID next;
+                next.pageNum = recordEntry.length;
+                next.slotNum = -recordEntry.offset;
+                if (isFreeSpaceMapPage(next.pageNum))
+                {
+                    _bp_manager->unpinPage(fileHandle, i, false);
+                    return RBFM_SLOT_DN_EXIST;
+                }
+                void *nextData;
+                if (_bp_manager->pinPage(fileHandle, next.pageNum, nextData))
+                {
+                    _bp_manager->unpinPage(fileHandle, i, false);
+                    return RBFM_READ_FAILED;
+                }
+                recordEntry = getSlotDirectoryRecordEntry(nextData, next.slotNum);
+                _bp_manager->unpinPage(fileHandle, next.pageNum, false);
+                status = getSlotStatus(recordEntry);
+                hops++;
+            }
+            if (chainLengths.size() <= hops)
+                chainLengths.resize(hops + 1, 0);
+            chainLengths[hops]++;
+        }
+        _bp_manager->unpinPage(fileHandle, i, false);
     }
+    return SUCCESS;
 }
 
-bool RBFM_ScanIterator::checkScanCondition(char *recordString, CompOp compOp, const void *value)
+RC RecordBasedFileManager::vacuum(FileHandle &fileHandle, const vector<Attribute> &recordDescriptor, PageNum &cursor, unsigned pages)
 {
-    if (compOp == NO_OP)
-        return true;
+    // Truncating the file would pull pages out from under the workers of a parallel scan
+    if (isParallelScanned(fileHandle))
+        return RBFM_FILE_SCANNED;
 
-    int32_t valueSize;
-    memcpy(&valueSize, value, VARCHAR_LENGTH_SIZE);
-    char valueStr[valueSize + 1];
-    valueStr[valueSize] = '\0';
-    memcpy(valueStr, (char*) value + VARCHAR_LENGTH_SIZE, valueSize);
+    RC rc;
+    unsigned numPages = fileHandle.getNumberOfPages();
+    if (cursor == 0 || cursor >= numPages)
+        cursor = numPages - 1;
+    PageNum low = (pages == 0 || pages > cursor) ? 1 : cursor - pages + 1;
+
+    // Records moved onto these pages can only be moved again once we know which slots point at them.
+    // The first vacuum of the file looks at every page for that, later ones keep what it found.
+    RecordFile *file = findRecordFile(fileHandle);
+    unordered_map<uint64_t, RID> found;
+    unordered_map<uint64_t, RID> *homes = &found;
+    if (file == NULL)
+        rc = findForwardedHomes(fileHandle, low, cursor + 1, found);
+    else
+    {
+        rc = SUCCESS;
+        if (!file->hasHomes)
+        {
+            file->homes.clear();
+            if ((rc = findForwardedHomes(fileHandle, 1, numPages, file->homes)) == SUCCESS)
+                file->hasHomes = true;
+        }
+        homes = &file->homes;
+    }
+    if (rc)
+        return rc;
 
-    int cmp = strcmp(recordString, valueStr);
-    switch (compOp)
+    for (PageNum i = cursor; i >= low; i--)
     {
-        case EQ_OP: return cmp == 0;
-        case LT_OP: return cmp <  0;
-        case GT_OP: return cmp >  0;
-        case LE_OP: return cmp <= 0;
-        case GE_OP: return cmp >= 0;
-        case NE_OP: return cmp != 0;
-        // Should never happen
-        default: return false;
+        if (isFreeSpaceMapPage(i))
+            continue;
+        if ((rc = vacuumPage(fileHandle, recordDescriptor, i, *homes)))
+            return rc;
     }
+    if ((rc = truncateEmptyPages(fileHandle)))
+        return rc;
+
+    // Page 0 is a map page, so a cursor of 0 means we went all the way
+    cursor = low - 1;
+    return cursor == 0 ? RBFM_EOF : SUCCESS;
 }
 
-// Configures a new record based page, and puts it in "page".
-void RecordBasedFileManager::newRecordBasedPage(void * page)
+RecordView::RecordView()
+: fileHandle(NULL), pageNum(0), page(NULL), record(NULL)
 {
-    memset(page, 0, PAGE_SIZE);
-    // Writes the slot directory header.
-    SlotDirectoryHeader slotHeader;
-    slotHeader.freeSpaceOffset = PAGE_SIZE;
-    slotHeader.recordEntriesNumber = 0;
-    setSlotDirectoryHeader(page, slotHeader);
+    rbfm = RecordBasedFileManager::instance();
 }
 
-SlotDirectoryHeader RecordBasedFileManager::getSlotDirectoryHeader(void * page)
+RecordView::~RecordView()
 {
-    // Getting the slot directory header.
-    SlotDirectoryHeader slotHeader;
-    memcpy (&slotHeader, page, sizeof(SlotDirectoryHeader));
-    return slotHeader;
+    release();
 }
 
-void RecordBasedFileManager::setSlotDirectoryHeader(void * page, SlotDirectoryHeader slotHeader)
+bool RecordView::isValid()
 {
-    // Setting the slot directory header.
-    memcpy (page, &slotHeader, sizeof(SlotDirectoryHeader));
+    return record != NULL;
 }
 
-SlotDirectoryRecordEntry RecordBasedFileManager::getSlotDirectoryRecordEntry(void * page, unsigned recordEntryNumber)
+unsigned RecordView::getNumberOfFields()
 {
-    // Getting the slot directory entry data.
-    SlotDirectoryRecordEntry recordEntry;
-    memcpy  (
-            &recordEntry,
-            ((char*) page + sizeof(SlotDirectoryHeader) + recordEntryNumber * sizeof(SlotDirectoryRecordEntry)),
-            sizeof(SlotDirectoryRecordEntry)
-            );
-
-    return recordEntry;
+    if (record == NULL)
+        return 0;
+    if (rbfm->isPaxPage(page))
+        return rbfm->getSlotDirectoryHeader(page).paxColumns;
+    RecordLength n;
+    memcpy(&n, record, sizeof(RecordLength));
+    return n & ~RBFM_FIXED_RECORD;
 }
 
-void RecordBasedFileManager::setSlotDirectoryRecordEntry(void * page, unsigned recordEntryNumber, SlotDirectoryRecordEntry recordEntry)
+bool RecordView::isNull(unsigned i)
 {
-    // Setting the slot directory entry data.
-    memcpy  (
-            ((char*) page + sizeof(SlotDirectoryHeader) + recordEntryNumber * sizeof(SlotDirectoryRecordEntry)),
-            &recordEntry,
-            sizeof(SlotDirectoryRecordEntry)
-            );
+    const char *field;
+    uint32_t len;
+    return !getField(i, field, len);
 }
 
-// Computes the free space of a page (function of the free space pointer and the slot directory size).
-unsigned RecordBasedFileManager::getPageFreeSpaceSize(void * page) 
+int32_t RecordView::getInt(unsigned i)
 {
-    SlotDirectoryHeader slotHeader = getSlotDirectoryHeader(page);
-    return slotHeader.freeSpaceOffset - slotHeader.recordEntriesNumber * sizeof(SlotDirectoryRecordEntry) - sizeof(SlotDirectoryHeader);
+    const char *field;
+    uint32_t len;
+    int32_t value = 0;
+    if (getField(i, field, len))
+        memcpy(&value, field, INT_SIZE);
+    return value;
 }
 
-unsigned RecordBasedFileManager::getRecordSize(const vector<Attribute> &recordDescriptor, const void *data) 
+float RecordView::getReal(unsigned i)
 {
-    // Read in the null indicator
-    int nullIndicatorSize = getNullIndicatorSize(recordDescriptor.size());
-    char nullIndicator[nullIndicatorSize];
-    memset(nullIndicator, 0, nullIndicatorSize);
-    memcpy(nullIndicator, (char*) data, nullIndicatorSize);
-
-    // Offset into *data. Start just after null indicator
-    unsigned offset = nullIndicatorSize;
-    // Running count of size. Initialize to size of header
-    unsigned size = sizeof (RecordLength) + (recordDescriptor.size()) * sizeof(ColumnOffset) + nullIndicatorSize;
+    const char *field;
+    uint32_t len;
+    float value = 0;
+    if (getField(i, field, len))
+        memcpy(&value, field, REAL_SIZE);
+    return value;
+}
 
-    for (unsigned i = 0; i < (unsigned) recordDescriptor.size(); i++)
+const char *RecordView::getVarChar(unsigned i, uint32_t &length)
+{
+    const char *field;
+    if (!getField(i, field, length))
     {
-        // Skip null fields
-        if (fieldIsNull(nullIndicator, i))
-            continue;
-        switch (recordDescriptor[i].type)
-        {
-            case TypeInt:
-                size += INT_SIZE;
-                offset += INT_SIZE;
-            break;
-            case TypeReal:
-                size += REAL_SIZE;
-                offset += REAL_SIZE;
-            break;
-            case TypeVarChar:
-                uint32_t varcharSize;
-                // We have to get the size of the VarChar field by reading the integer that precedes the string value itself
-                memcpy(&varcharSize, (char*) data + offset, VARCHAR_LENGTH_SIZE);
-                size += varcharSize;
-                offset += varcharSize + VARCHAR_LENGTH_SIZE;
-            break;
-        }
+        length = 0;
+        return "";
     }
+    // Values stored out of line are fetched into the view, they stay good until the next one
+    if (rbfm->isToastedField(record, i))
+    {
+        if (rbfm->readToastValue(*fileHandle, field, toastValue))
+            toastValue.clear();
+        length = toastValue.size();
+        return toastValue.data();
+    }
+    return field;
+}
 
-    return size;
+string RecordView::getVarCharString(unsigned i)
+{
+    uint32_t length;
+    const char *field = getVarChar(i, length);
+    return string(field, length);
 }
 
-// Calculate actual bytes for nulls-indicator for the given field counts
-int RecordBasedFileManager::getNullIndicatorSize(int fieldCount) 
+RC RecordView::release()
 {
-    return int(ceil((double) fieldCount / CHAR_BIT));
+    if (record == NULL)
+        return SUCCESS;
+    record = NULL;
+    return rbfm->_bp_manager->unpinPage(*fileHandle, pageNum, false);
 }
 
-bool RecordBasedFileManager::fieldIsNull(char *nullIndicator, int i)
+// Where field i sits in the page, false if it is NULL or there is no such field
+bool RecordView::getField(unsigned i, const char *&field, uint32_t &len)
 {
-    int indicatorIndex = i / CHAR_BIT;
-    int indicatorMask  = 1 << (CHAR_BIT - 1 - (i % CHAR_BIT));
-    return (nullIndicator[indicatorIndex] & indicatorMask) != 0;
+    if (record == NULL)
+        return false;
+    return rbfm->getRecordValue(page, record, i, field, len);
 }
 
-void RecordBasedFileManager::setRecordAtOffset(void *page, unsigned offset, const vector<Attribute> &recordDescriptor, const void *data)
+RBFM_ScanIterator::RBFM_ScanIterator()
+: parallel(NULL), currPage(0), currSlot(0), totalPage(0), totalSlot(0), pageData(NULL), pageBuffer(NULL), mappedData(NULL), mappedPages(0),
+  readAheadWindow(0), nextReadAhead(0), zoneFiltered(false), vectorFiltered(false), pageFiltered(false),
+  conditionValues(NULL), selection(NULL), type(TypeInt), attrIndex(0), conditionCode(-1), paxPage(false), callerHandle(NULL), projectionNullSize(0), fixedProjection(false), projectedToast(false)
 {
-    // Read in the null indicator
+    rbfm = RecordBasedFileManager::instance();
+}
+
+// Reads ahead still in flight point at our file handle
+RBFM_ScanIterator::~RBFM_ScanIterator()
+{
+    stopParallelScan();
+    if (nextReadAhead > 0)
+        AsyncIOManager::instance()->waitForAll();
+}
+
+RC RBFM_ScanIterator::close()
+{
+    // The workers read the mapping, so they stop before anything else goes
+    stopParallelScan();
+    if (nextReadAhead > 0)
+        AsyncIOManager::instance()->waitForAll();
+    nextReadAhead = 0;
+    returnCounters();
+    free(pageBuffer);
+    pageBuffer = NULL;
+    pageData = NULL;
+    free(conditionValues);
+    conditionValues = NULL;
+    free(selection);
+    selection = NULL;
+    vectorFiltered = pageFiltered = false;
+    fileHandle.unmapPages(mappedData, mappedPages);
+    mappedData = NULL;
+    return SUCCESS;
+}
+
+// Initialize the scanIterator with all necessary state
+RC RBFM_ScanIterator::scanInit(FileHandle &fh,
+        const vector<Attribute> rd,
+        const string &ca, 
+        const CompOp co, 
+        const void *v, 
+        const vector<string> &an,
+        ScanMode scanMode)
+{
+    // Start at page 0 slot 0
+    currPage = 0;
+    currSlot = 0;
+    totalPage = 0;
+    totalSlot = 0;
+    // Keep a buffer to hold the current page
+    pageBuffer = malloc(PAGE_SIZE);
+    if (pageBuffer == NULL)
+        return RBFM_MALLOC_FAILED;
+    pageData = pageBuffer;
+
+    // Store the variables passed in to
+    fileHandle = fh;
+    callerHandle = &fh;
+    fileHandle.readPageCounter = fileHandle.writePageCounter = fileHandle.appendPageCounter = 0;
+    fileHandle.logicalReadCounter = fileHandle.logicalWriteCounter = 0;
+    conditionAttribute = ca;
+    recordDescriptor = rd;
+    compOp = co;
+    value = v;
+    attributeNames = an;
+
+    skipList.clear();
+    clauses.clear();
+    zoneClauses.clear();
+
+    // Get total number of pages
+    // Page 0 is a free space map page, so there are no slots to go through there:
+    // the first call to getNextSlot moves straight on to the first data page.
+    totalPage = fh.getNumberOfPages();
+
+    // If the file can't be mapped we simply copy pages as usual
+    mappedData = NULL;
+    mappedPages = 0;
+    if (scanMode != COPY_SCAN)
+        fileHandle.mapPages(mappedData, mappedPages);
+
+    // Work out where each projected attribute lives in the record once, rather than for every record
+    projection.clear();
+    for (unsigned i = 0; i < attributeNames.size(); i++)
+    {
+        auto pred = [&](Attribute a) {return a.name == attributeNames[i];};
+        auto iterPos = find_if(recordDescriptor.begin(), recordDescriptor.end(), pred);
+        unsigned index = distance(recordDescriptor.begin(), iterPos);
+        if (index == recordDescriptor.size())
+            return RBFM_NO_SUCH_ATTR;
+        projection.push_back(index);
+    }
+    projectionNullSize = rbfm->getNullIndicatorSize(projection.size());
+    fixedProjection = projection.size() == recordDescriptor.size() && rbfm->isFixedWidth(recordDescriptor);
+    for (unsigned i = 0; i < projection.size() && fixedProjection; i++)
+        fixedProjection = projection[i] == i;
+
+    // Don't let read ahead push the rest of the buffer pool out
+    readAheadWindow = min(rbfm->_scanReadAhead, rbfm->_bp_manager->getPoolSize() / 2);
+    nextReadAhead = 0;
+
+    // If we don't need to do any comparisons, we can ignore the condition attribute
+    zoneFiltered = false;
+    vectorFiltered = pageFiltered = false;
+    if (co == NO_OP)
+        return SUCCESS;
+
+    // Else, we need to find the condition attribute's index in the record descriptor
+    auto pred = [&](Attribute a) {return a.name == conditionAttribute;};
+    auto iterPos = find_if(recordDescriptor.begin(), recordDescriptor.end(), pred);
+    attrIndex = distance(recordDescriptor.begin(), iterPos);
+    if (attrIndex == recordDescriptor.size())
+        return RBFM_NO_SUCH_ATTR;
+    type = recordDescriptor[attrIndex].type;
+
+    // Pages the zone map rules out are never read
+    RecordFile *file = rbfm->findRecordFile(fileHandle);
+    if (value != NULL && file != NULL && file->hasZoneMap && attrIndex < file->zoneColumns)
+    {
+        ScanCondition condition = {attrIndex, type, compOp, value, 0, -1};
+        zoneClauses.push_back(ScanClause(1, condition));
+        zoneFiltered = true;
+    }
+
+    // Ints and reals go through the predicate kernels a page at a time
+    if (value != NULL && type != TypeVarChar)
+    {
+        conditionValues = malloc(RBFM_MAX_SLOTS * sizeof(int32_t));
+        selection = (uint8_t*) malloc((RBFM_MAX_SLOTS + CHAR_BIT - 1) / CHAR_BIT);
+        if (conditionValues == NULL || selection == NULL)
+            return RBFM_MALLOC_FAILED;
+        vectorFiltered = true;
+    }
+
+    return SUCCESS;
+}
+
+// Initialize the scanIterator for a multi-predicate scan
+RC RBFM_ScanIterator::scanInit(FileHandle &fh,
+        const vector<Attribute> rd,
+        const vector<ScanPredicate> &predicates,
+        const vector<string> &an,
+        ScanMode scanMode)
+{
+    // Gather the predicates into clauses: one for every OR group, and one for each predicate outside a group
+    vector<ScanClause> allClauses;
+    vector<unsigned> clauseGroups;
+    for (unsigned i = 0; i < predicates.size(); i++)
+    {
+        auto pred = [&](Attribute a) {return a.name == predicates[i].attribute;};
+        auto iterPos = find_if(rd.begin(), rd.end(), pred);
+        unsigned index = distance(rd.begin(), iterPos);
+        if (index == rd.size())
+            return RBFM_NO_SUCH_ATTR;
+
+        ScanCondition condition = {index, rd[index].type, predicates[i].compOp, predicates[i].value, 0, -1};
+        condition.selectivity = rbfm->estimateSelectivity(fh, condition);
+
+        unsigned group = predicates[i].orGroup;
+        unsigned c = 0;
+        while (group != 0 && c < clauseGroups.size() && clauseGroups[c] != group)
+            c++;
+        if (group == 0 || c == clauseGroups.size())
+        {
+            c = allClauses.size();
+            allClauses.push_back(ScanClause());
+            clauseGroups.push_back(group);
+        }
+        allClauses[c].push_back(condition);
+    }
+
+    // Order the predicates of a clause most likely to hold first, and the clauses least likely to hold first.
+    // A clause holds unless all of its predicates fail. Clauses that always hold are dropped.
+    vector<ScanClause> ordered;
+    vector<double> clauseSelectivity;
+    for (unsigned c = 0; c < allClauses.size(); c++)
+    {
+        ScanClause &clause = allClauses[c];
+        stable_sort(clause.begin(), clause.end(),
+                    [](const ScanCondition &a, const ScanCondition &b) {return a.selectivity > b.selectivity;});
+        if (clause[0].compOp == NO_OP)
+            continue;
+        double fails = 1;
+        for (unsigned i = 0; i < clause.size(); i++)
+            fails *= 1 - clause[i].selectivity;
+
+        unsigned pos = ordered.size();
+        while (pos > 0 && clauseSelectivity[pos - 1] > 1 - fails)
+            pos--;
+        ordered.insert(ordered.begin() + pos, clause);
+        clauseSelectivity.insert(clauseSelectivity.begin() + pos, 1 - fails);
+    }
+
+    // The most selective lone predicate becomes the scan condition, so it gets the page at a time kernels
+    // and the zone map like any single condition scan
+    unsigned lead = 0;
+    while (lead < ordered.size() && ordered[lead].size() != 1)
+        lead++;
+    RC rc;
+    if (lead < ordered.size())
+    {
+        ScanCondition condition = ordered[lead][0];
+        ordered.erase(ordered.begin() + lead);
+        rc = scanInit(fh, rd, rd[condition.attrIndex].name, condition.compOp, condition.value, an, scanMode);
+    }
+    else
+        rc = scanInit(fh, rd, "", NO_OP, NULL, an, scanMode);
+    if (rc)
+        return rc;
+    clauses = ordered;
+
+    // The other clauses can rule pages out too, as long as the zone map covers all of their predicates
+    RecordFile *file = rbfm->findRecordFile(fileHandle);
+    for (unsigned c = 0; file != NULL && file->hasZoneMap && c < clauses.size(); c++)
+    {
+        bool covered = true;
+        for (unsigned i = 0; i < clauses[c].size(); i++)
+            covered = covered && clauses[c][i].value != NULL && clauses[c][i].attrIndex < file->zoneColumns;
+        if (covered)
+            zoneClauses.push_back(clauses[c]);
+    }
+    zoneFiltered = !zoneClauses.empty();
+
+    return SUCCESS;
+}
+
+RC RBFM_ScanIterator::getNextRecord(RID &rid, void *data)
+{
+    if (parallel != NULL)
+        return parallel->getNextRecord(rid, data);
+
+    RC rc = getNextSlot();
+    if (rc)
+        return rc;
+
+    // If we are not returning any results, we can just set the RID and return
+    if (attributeNames.size() == 0)
+    {
+        rid.pageNum = currPage;
+        rid.slotNum = currSlot++;
+        return SUCCESS;
+    }
+
+    SlotDirectoryRecordEntry recordEntry = rbfm->getSlotDirectoryRecordEntry(pageData, currSlot);
+    projectRecord((char*) pageData + recordEntry.offset, data);
+
+    rid.pageNum = currPage;
+    rid.slotNum = currSlot++;
+    unsigned size;
+    return projectedToast ? detoastProjection(data, size) : SUCCESS;
+}
+
+RC RBFM_ScanIterator::getNextBatch(vector<RID> &rids, void *data, unsigned maxRows)
+{
+    if (parallel != NULL)
+        return parallel->getNextBatch(rids, data, maxRows);
+
+    // Fill the RIDs in place, trimming the vector once we're done
+    rids.resize(maxRows);
+    RID *rid = rids.data();
+    unsigned rows = 0;
+    char *out = (char*) data;
+    RC rc = SUCCESS;
+    while (rows < maxRows)
+    {
+        // Find the next match, moving on to later pages as needed
+        rc = getNextSlot();
+        if (rc)
+            break;
+
+        // Then take every match left on the page in one go, reading the slot directory in place.
+        // Only live records have a positive offset.
+        const SlotDirectoryRecordEntry *slots = (const SlotDirectoryRecordEntry*) ((char*) pageData + sizeof(SlotDirectoryHeader));
+        bool project = !projection.empty();
+        bool filter = compOp != NO_OP || !clauses.empty();
+        for (; currSlot < totalSlot && rows < maxRows; currSlot++)
+        {
+            int32_t offset = slots[currSlot].offset;
+            if (offset <= 0 || (filter && !checkScanCondition()))
+                continue;
+            if (project)
+            {
+                unsigned size = projectRecord((char*) pageData + offset, out);
+                if (projectedToast && (rc = detoastProjection(out, size)))
+                    return rc;
+                out += size;
+            }
+            rid[rows].pageNum = currPage;
+            rid[rows].slotNum = currSlot;
+            rows++;
+        }
+    }
+    rids.resize(rows);
+
+    if (rc && rc != RBFM_EOF)
+        return rc;
+    return rows == 0 ? RBFM_EOF : SUCCESS;
+}
+
+// Private helper methods ///////////////////////////////////////////////////////////////////
+
+// Move on to the next match and point record at it in the page, rather than projecting it
+RC RBFM_ScanIterator::getNextRecordInPlace(RID &rid, const char *&record)
+{
+    RC rc = getNextSlot();
+    if (rc)
+        return rc;
+
+    SlotDirectoryRecordEntry recordEntry = rbfm->getSlotDirectoryRecordEntry(pageData, currSlot);
+    record = (char*) pageData + recordEntry.offset;
+    rid.pageNum = currPage;
+    rid.slotNum = currSlot++;
+    return SUCCESS;
+}
+
+// Hand the scan over to worker threads. If the file couldn't be mapped it goes on here, like a COPY_SCAN.
+RC RBFM_ScanIterator::startParallelScan()
+{
+    // Workers can't go through the buffer pool for values stored out of line, so such files are
+    // scanned like a MAPPED_SCAN
+    RecordFile *file = rbfm->findRecordFile(fileHandle);
+    if (mappedData == NULL || (file != NULL && file->hasToast))
+        return SUCCESS;
+
+    parallel = new ParallelScan();
+    RC rc = parallel->start(*this, rbfm->_scanThreads);
+    if (rc)
+    {
+        delete parallel;
+        parallel = NULL;
+        return rc;
+    }
+    if (file != NULL)
+        file->parallelScans++;
+    return SUCCESS;
+}
+
+// Stop the workers, and let the file be modified again once no other parallel scan is reading it
+void RBFM_ScanIterator::stopParallelScan()
+{
+    if (parallel == NULL)
+        return;
+    delete parallel;
+    parallel = NULL;
+    RecordFile *file = rbfm->findRecordFile(fileHandle);
+    if (file != NULL && file->parallelScans > 0)
+        file->parallelScans--;
+}
+
+// Set up a parallel scan worker: the conditions and projection of scan, with buffers of its own
+RC RBFM_ScanIterator::initWorker(const RBFM_ScanIterator &scan)
+{
+    *this = scan;
+    parallel = NULL;
+    callerHandle = NULL;
+    pageData = pageBuffer = NULL;
+    mappedData = NULL;
+    mappedPages = 0;
+    nextReadAhead = 0;
+    conditionValues = NULL;
+    selection = NULL;
+    if (!vectorFiltered)
+        return SUCCESS;
+
+    conditionValues = malloc(RBFM_MAX_SLOTS * sizeof(int32_t));
+    selection = (uint8_t*) malloc((RBFM_MAX_SLOTS + CHAR_BIT - 1) / CHAR_BIT);
+    if (conditionValues == NULL || selection == NULL)
+        return RBFM_MALLOC_FAILED;
+    return SUCCESS;
+}
+
+// Count the pages the scan went through against the handle it was given
+void RBFM_ScanIterator::returnCounters()
+{
+    if (callerHandle == NULL)
+        return;
+    callerHandle->readPageCounter += fileHandle.readPageCounter;
+    callerHandle->writePageCounter += fileHandle.writePageCounter;
+    callerHandle->appendPageCounter += fileHandle.appendPageCounter;
+    callerHandle->logicalReadCounter += fileHandle.logicalReadCounter;
+    callerHandle->logicalWriteCounter += fileHandle.logicalWriteCounter;
+    fileHandle.readPageCounter = fileHandle.writePageCounter = fileHandle.appendPageCounter = 0;
+    fileHandle.logicalReadCounter = fileHandle.logicalWriteCounter = 0;
+    callerHandle = NULL;
+}
+
+// Evaluate the scan condition for every slot of the current page in one go
+void RBFM_ScanIterator::filterPage()
+{
+    pageFiltered = totalSlot <= RBFM_MAX_SLOTS;
+    if (!pageFiltered)
+        return;
+
+    // Gather the condition attribute of every live record, remembering which slots have one
+    int32_t *values = (int32_t*) conditionValues;
+    unsigned bitmapSize = (totalSlot + CHAR_BIT - 1) / CHAR_BIT;
+    uint8_t present[bitmapSize];
+    memset(present, 0, bitmapSize);
+    const SlotDirectoryRecordEntry *slots = (const SlotDirectoryRecordEntry*) ((char*) pageData + sizeof(SlotDirectoryHeader));
+    SlotDirectoryHeader header = rbfm->getSlotDirectoryHeader(pageData);
+    if (paxPage && attrIndex < header.paxColumns)
+    {
+        // On a PAX page the attribute's minipage already is the array, only the live rows with a value are picked out
+        values = (int32_t*) ((char*) pageData + rbfm->getPaxColumnOffset(header, attrIndex));
+        const char *nullIndicators = (char*) pageData + rbfm->getPaxNullOffset(header);
+        unsigned nullIndicatorSize = rbfm->getNullIndicatorSize(header.paxColumns);
+        for (unsigned i = 0; i < totalSlot; i++)
+        {
+            if (slots[i].offset > 0 && !rbfm->fieldIsNull((char*) nullIndicators + i * nullIndicatorSize, attrIndex))
+                present[i / CHAR_BIT] |= 1 << (i % CHAR_BIT);
+        }
+    }
+    else if (paxPage)
+        memset(values, 0, totalSlot * sizeof(int32_t));
+    else
+    {
+        for (unsigned i = 0; i < totalSlot; i++)
+        {
+            values[i] = 0;
+            const char *field;
+            uint32_t len;
+            if (slots[i].offset > 0 && rbfm->getRecordField((char*) pageData + slots[i].offset, attrIndex, field, len) && len == INT_SIZE)
+            {
+                memcpy(&values[i], field, INT_SIZE);
+                present[i / CHAR_BIT] |= 1 << (i % CHAR_BIT);
+            }
+        }
+    }
+
+    if (type == TypeInt)
+    {
+        int32_t intValue;
+        memcpy(&intValue, value, INT_SIZE);
+        filterInts(values, totalSlot, compOp, intValue, selection);
+    }
+    else
+    {
+        float realValue;
+        memcpy(&realValue, value, REAL_SIZE);
+        filterReals((float*) values, totalSlot, compOp, realValue, selection);
+    }
+    for (unsigned i = 0; i < bitmapSize; i++)
+        selection[i] &= present[i];
+}
+
+// Copy the projected attributes of the record at "record" straight into data, returning their size
+unsigned RBFM_ScanIterator::projectRecord(const char *record, void *data)
+{
+    projectedToast = false;
+
+    // A whole fixed width record with no NULLs already is its projection
+    if (fixedProjection && !paxPage)
+    {
+        RecordLength n;
+        memcpy(&n, record, sizeof(RecordLength));
+        const char *recordNullIndicator = record + sizeof(RecordLength);
+        if (n == (recordDescriptor.size() | RBFM_FIXED_RECORD) && !rbfm->hasNullFields(recordNullIndicator, projectionNullSize))
+        {
+            unsigned size = projectionNullSize + projection.size() * INT_SIZE;
+            memcpy(data, recordNullIndicator, size);
+            return size;
+        }
+    }
+
+    char *nullIndicator = (char*) data;
+    memset(nullIndicator, 0, projectionNullSize);
+    char *out = (char*) data + projectionNullSize;
+
+    for (unsigned i = 0; i < projection.size(); i++)
+    {
+        const char *field;
+        uint32_t len;
+        if (!rbfm->getRecordValue(pageData, record, projection[i], field, len))
+        {
+            nullIndicator[i / CHAR_BIT] |= 1 << (CHAR_BIT - 1 - (i % CHAR_BIT));
+            continue;
+        }
+
+        if (recordDescriptor[projection[i]].type == TypeVarChar)
+        {
+            // Values stored out of line are fetched once the whole record is projected
+            uint32_t varcharSize = len;
+            if (rbfm->isToastedField(record, projection[i]))
+            {
+                varcharSize |= RBFM_TOASTED_LENGTH;
+                projectedToast = true;
+            }
+            memcpy(out, &varcharSize, VARCHAR_LENGTH_SIZE);
+            out += VARCHAR_LENGTH_SIZE;
+        }
+        memcpy(out, field, len);
+        out += len;
+    }
+    return out - (char*) data;
+}
+
+// Fetch the values projectRecord left out of line, size gets the size of the projected record
+RC RBFM_ScanIterator::detoastProjection(void *data, unsigned &size)
+{
+    vector<Attribute> projected;
+    for (unsigned i = 0; i < projection.size(); i++)
+        projected.push_back(recordDescriptor[projection[i]]);
+    return rbfm->detoastRecord(fileHandle, projected, data, size);
+}
+
+// Move on to the next live record that meets the scan condition, one page at a time
+RC RBFM_ScanIterator::getNextSlot()
+{
+    // A vacuum may have cut pages off the file since the last call, and touching a mapped page past
+    // the new end is fatal. The current page is read again through the buffer pool if it is still there.
+    if (mappedData != NULL && pageData != pageBuffer && fileHandle.getNumberOfPages() != mappedPages)
+    {
+        if (currPage >= fileHandle.getNumberOfPages())
+            return RBFM_EOF;
+        RC rc = getNextPage();
+        if (rc)
+            return rc;
+        if (vectorFiltered)
+            filterPage();
+    }
+
+    while (true)
+    {
+        // Go through the rest of the current page
+        for (; currSlot < totalSlot && currPage < totalPage; currSlot++)
+        {
+            SlotDirectoryRecordEntry recordEntry = rbfm->getSlotDirectoryRecordEntry(pageData, currSlot);
+            if (rbfm->getSlotStatus(recordEntry) == VALID && checkScanCondition())
+                return SUCCESS;
+        }
+
+        // Reinitialize the current slot and increment page number, skipping map pages
+        // and pages the zone map says have nothing for us
+        currSlot = 0;
+        currPage++;
+        while (currPage < totalPage && (rbfm->isFreeSpaceMapPage(currPage) ||
+               (zoneFiltered && !pageMayMatch(currPage))))
+            currPage++;
+        // If we're done with last page, return EOF. A vacuum may have cut pages off the file since we started.
+        if (currPage >= totalPage || currPage >= fileHandle.getNumberOfPages())
+            return RBFM_EOF;
+        // Otherwise get next page ready
+        RC rc = getNextPage();
+        if (rc)
+            return rc;
+        if (vectorFiltered)
+            filterPage();
+    }
+}
+
+RC RBFM_ScanIterator::getNextPage()
+{
+    // In MAPPED_SCAN mode walk the page in place. If the file has changed size since it was mapped
+    // we give up on the mapping for the rest of the scan, and a page with changes still in the pool
+    // is copied from there, like in the default mode.
+    if (mappedData != NULL && fileHandle.getNumberOfPages() != mappedPages)
+    {
+        fileHandle.unmapPages(mappedData, mappedPages);
+        mappedData = NULL;
+    }
+    if (mappedData != NULL && !rbfm->_bp_manager->isPageDirty(fileHandle, currPage))
+    {
+        pageData = (char*) mappedData + (size_t) currPage * PAGE_SIZE;
+        SlotDirectoryHeader header = rbfm->getSlotDirectoryHeader(pageData);
+        totalSlot = header.recordEntriesNumber;
+        paxPage = header.paxColumns != 0;
+        codeConditions();
+        return SUCCESS;
+    }
+    pageData = pageBuffer;
+
+    // Keep the next readAheadWindow pages on their way while this one is processed,
+    // topping the window up each time half of it has been used
+    if (readAheadWindow > 0)
+    {
+        if (nextReadAhead <= currPage)
+            nextReadAhead = currPage + 1;
+        if (nextReadAhead - currPage - 1 < readAheadWindow / 2 && nextReadAhead < totalPage)
+        {
+            PageNum end = min(currPage + 1 + readAheadWindow, totalPage);
+            // Stop short of the next page the scan is going to skip
+            for (PageNum p = nextReadAhead; zoneFiltered && p < end; p++)
+            {
+                if (!rbfm->isFreeSpaceMapPage(p) && !pageMayMatch(p))
+                    end = p;
+            }
+            if (end > nextReadAhead)
+            {
+                rbfm->_bp_manager->readAhead(fileHandle, nextReadAhead, end - nextReadAhead);
+                nextReadAhead = end;
+            }
+        }
+    }
+
+    // Read in page through the buffer pool, keeping a private copy so that
+    // updates made while the scan is open don't move records under us
+    if (rbfm->_bp_manager->readPage(fileHandle, currPage, pageData))
+        return RBFM_READ_FAILED;
+
+    // Update slot total
+    SlotDirectoryHeader header = rbfm->getSlotDirectoryHeader(pageData);
+    totalSlot = header.recordEntriesNumber;
+    paxPage = header.paxColumns != 0;
+    codeConditions();
+    return SUCCESS;
+}
+
+// Look up the values of the varchar conditions in the dictionary of the page just read
+void RBFM_ScanIterator::codeConditions()
+{
+    conditionCode = -1;
+    if (rbfm->getSlotDirectoryHeader(pageData).dictionaryEntries == 0)
+        return;
+    if (type == TypeVarChar && value != NULL)
+    {
+        uint32_t len;
+        memcpy(&len, value, VARCHAR_LENGTH_SIZE);
+        conditionCode = rbfm->findDictionaryCode(pageData, (const char*) value + VARCHAR_LENGTH_SIZE, len);
+    }
+    for (unsigned c = 0; c < clauses.size(); c++)
+    {
+        for (unsigned i = 0; i < clauses[c].size(); i++)
+        {
+            ScanCondition &condition = clauses[c][i];
+            if (condition.type != TypeVarChar || condition.value == NULL)
+                continue;
+            uint32_t len;
+            memcpy(&len, condition.value, VARCHAR_LENGTH_SIZE);
+            condition.code = rbfm->findDictionaryCode(pageData, (const char*) condition.value + VARCHAR_LENGTH_SIZE, len);
+        }
+    }
+}
+
+// Whether the zone map leaves a chance of a match on the page: every clause needs a predicate that may hold there
+bool RBFM_ScanIterator::pageMayMatch(PageNum pageNum)
+{
+    for (unsigned c = 0; c < zoneClauses.size(); c++)
+    {
+        bool mayMatch = false;
+        for (unsigned i = 0; i < zoneClauses[c].size() && !mayMatch; i++)
+        {
+            const ScanCondition &condition = zoneClauses[c][i];
+            mayMatch = rbfm->pageMayMatch(fileHandle, pageNum, condition.attrIndex, condition.type, condition.compOp, condition.value);
+        }
+        if (!mayMatch)
+            return false;
+    }
+    return true;
+}
+
+bool RBFM_ScanIterator::checkScanCondition()
+{
+    if (compOp == NO_OP && clauses.empty()) return true;
+    SlotDirectoryRecordEntry recordEntry = rbfm->getSlotDirectoryRecordEntry(pageData, currSlot);
+    const char *record = (char*) pageData + recordEntry.offset;
+
+    if (compOp != NO_OP)
+    {
+        if (value == NULL)
+            return false;
+        if (pageFiltered)
+        {
+            if (!((selection[currSlot / CHAR_BIT] >> (currSlot % CHAR_BIT)) & 1))
+                return false;
+        }
+        else
+        {
+            ScanCondition condition = {attrIndex, type, compOp, value, 0, conditionCode};
+            if (!checkScanCondition(record, condition))
+                return false;
+        }
+    }
+    return clauses.empty() || checkClauses(record);
+}
+
+// Whether the record meets every clause of a multi-predicate scan
+bool RBFM_ScanIterator::checkClauses(const char *record)
+{
+    for (unsigned c = 0; c < clauses.size(); c++)
+    {
+        bool holds = false;
+        for (unsigned i = 0; i < clauses[c].size() && !holds; i++)
+            holds = checkScanCondition(record, clauses[c][i]);
+        if (!holds)
+            return false;
+    }
+    return true;
+}
+
+bool RBFM_ScanIterator::checkScanCondition(const char *record, const ScanCondition &condition)
+{
+    if (condition.compOp == NO_OP) return true;
+    if (condition.value == NULL) return false;
+
+    // Look at the field where it sits in the page
+    const char *field;
+    uint32_t len;
+    bool found = paxPage ? rbfm->getPaxField(pageData, record, condition.attrIndex, field, len)
+                         : rbfm->getRecordField(record, condition.attrIndex, field, len);
+    if (!found)
+        return false;
+
+    // Checkscan condition on record data and scan value
+    if (condition.type == TypeInt)
+    {
+        int32_t recordInt;
+        memcpy(&recordInt, field, INT_SIZE);
+        return checkScanCondition(recordInt, condition.compOp, condition.value);
+    }
+    if (condition.type == TypeReal)
+    {
+        float recordReal;
+        memcpy(&recordReal, field, REAL_SIZE);
+        return checkScanCondition(recordReal, condition.compOp, condition.value);
+    }
+    // A code stands for one value on its page, so equality needs nothing else
+    if (rbfm->isCodedField(record, condition.attrIndex))
+    {
+        uint8_t code = field[0];
+        if (condition.compOp == EQ_OP)
+            return code == condition.code;
+        if (condition.compOp == NE_OP)
+            return code != condition.code;
+        rbfm->getDictionaryValue(pageData, code, field, len);
+    }
+    string value;
+    if (rbfm->isToastedField(record, condition.attrIndex))
+    {
+        if (rbfm->readToastValue(fileHandle, field, value))
+            return false;
+        field = value.data();
+        len = value.size();
+    }
+    char recordString[len + 1];
+    memcpy(recordString, field, len);
+    recordString[len] = '\0';
+    return checkScanCondition(recordString, condition.compOp, condition.value);
+}
+
+bool RBFM_ScanIterator::checkScanCondition(int recordInt, CompOp compOp, const void *value)
+{
+    int32_t intValue;
+    memcpy (&intValue, value, INT_SIZE);
+
+    switch (compOp)
+    {
+        case EQ_OP: return recordInt == intValue;
+        case LT_OP: return recordInt < intValue;
+        case GT_OP: return recordInt > intValue;
+        case LE_OP: return recordInt <= intValue;
+        case GE_OP: return recordInt >= intValue;
+        case NE_OP: return recordInt != intValue;
+        case NO_OP: return true;
+        // Should never happen
+        default: return false;
+    }
+}
+
+bool RBFM_ScanIterator::checkScanCondition(float recordReal, CompOp compOp, const void *value)
+{
+    float realValue;
+    memcpy (&realValue, value, REAL_SIZE);
+
+    switch (compOp)
+    {
+        case EQ_OP: return recordReal == realValue;
+        case LT_OP: return recordReal < realValue;
+        case GT_OP: return recordReal > realValue;
+        case LE_OP: return recordReal <= realValue;
+        case GE_OP: return recordReal >= realValue;
+        case NE_OP: return recordReal != realValue;
+        case NO_OP: return true;
+        // Should never happen
+        default: return false;
+    }
+}
+
+bool RBFM_ScanIterator::checkScanCondition(char *recordString, CompOp compOp, const void *value)
+{
+    if (compOp == NO_OP)
+        return true;
+
+    int32_t valueSize;
+    memcpy(&valueSize, value, VARCHAR_LENGTH_SIZE);
+    char valueStr[valueSize + 1];
+    valueStr[valueSize] = '\0';
+    memcpy(valueStr, (char*) value + VARCHAR_LENGTH_SIZE, valueSize);
+
+    int cmp = strcmp(recordString, valueStr);
+    switch (compOp)
+    {
+        case EQ_OP: return cmp == 0;
+        case LT_OP: return cmp <  0;
+        case GT_OP: return cmp >  0;
+        case LE_OP: return cmp <= 0;
+        case GE_OP: return cmp >= 0;
+        case NE_OP: return cmp != 0;
+        // Should never happen
+        default: return false;
+    }
+}
+
+// Configures a new record based page, and puts it in "page".
+void RecordBasedFileManager::newRecordBasedPage(void * page)
+{
+    memset(page, 0, PAGE_SIZE);
+    // Writes the slot directory header.
+    SlotDirectoryHeader slotHeader;
+    slotHeader.freeSpaceOffset = PAGE_SIZE;
+    slotHeader.recordEntriesNumber = 0;
+    slotHeader.dictionaryOffset = 0;
+    slotHeader.dictionaryEntries = 0;
+    slotHeader.paxColumns = 0;
+    slotHeader.paxRows = 0;
+    setSlotDirectoryHeader(page, slotHeader);
+}
+
+// Configures a new PAX page for records of columns ints and reals, with as many rows as fit
+void RecordBasedFileManager::newPaxPage(void *page, unsigned columns)
+{
+    newRecordBasedPage(page);
+    SlotDirectoryHeader slotHeader = getSlotDirectoryHeader(page);
+    unsigned rowSize = sizeof(SlotDirectoryRecordEntry) + getNullIndicatorSize(columns) + columns * INT_SIZE;
+    slotHeader.paxColumns = columns;
+    // Leaving room to align the first minipage
+    slotHeader.paxRows = (PAGE_SIZE - sizeof(SlotDirectoryHeader) - (INT_SIZE - 1)) / rowSize;
+    setSlotDirectoryHeader(page, slotHeader);
+}
+
+// Configures a new data page laid out like the first one of the file
+RC RecordBasedFileManager::newDataPage(FileHandle &fileHandle, void *page)
+{
+    void *firstPage;
+    if (_bp_manager->pinPage(fileHandle, 1, firstPage))
+        return RBFM_READ_FAILED;
+    unsigned columns = getSlotDirectoryHeader(firstPage).paxColumns;
+    _bp_manager->unpinPage(fileHandle, 1, false);
+
+    if (columns != 0)
+        newPaxPage(page, columns);
+    else
+        newRecordBasedPage(page);
+    return SUCCESS;
+}
+
+SlotDirectoryHeader RecordBasedFileManager::getSlotDirectoryHeader(void * page)
+{
+    // Getting the slot directory header.
+    SlotDirectoryHeader slotHeader;
+    memcpy (&slotHeader, page, sizeof(SlotDirectoryHeader));
+    return slotHeader;
+}
+
+void RecordBasedFileManager::setSlotDirectoryHeader(void * page, SlotDirectoryHeader slotHeader)
+{
+    // Setting the slot directory header.
+    memcpy (page, &slotHeader, sizeof(SlotDirectoryHeader));
+}
+
+SlotDirectoryRecordEntry RecordBasedFileManager::getSlotDirectoryRecordEntry(void * page, unsigned recordEntryNumber)
+{
+    // Getting the slot directory entry data.
+    SlotDirectoryRecordEntry recordEntry;
+    memcpy  (
+            &recordEntry,
+            ((char*) page + sizeof(SlotDirectoryHeader) + recordEntryNumber * sizeof(SlotDirectoryRecordEntry)),
+            sizeof(SlotDirectoryRecordEntry)
+            );
+
+    return recordEntry;
+}
+
+void RecordBasedFileManager::setSlotDirectoryRecordEntry(void * page, unsigned recordEntryNumber, SlotDirectoryRecordEntry recordEntry)
+{
+    // Setting the slot directory entry data.
+    memcpy  (
+            ((char*) page + sizeof(SlotDirectoryHeader) + recordEntryNumber * sizeof(SlotDirectoryRecordEntry)),
+            &recordEntry,
+            sizeof(SlotDirectoryRecordEntry)
+            );
+}
+
+// Computes the free space of a page (function of the free space pointer and the slot directory size).
+unsigned RecordBasedFileManager::getPageFreeSpaceSize(void * page) 
+{
+    SlotDirectoryHeader slotHeader = getSlotDirectoryHeader(page);
+    if (slotHeader.paxColumns != 0)
+    {
+        // A free row of a PAX page takes any record, so a PAX page counts the space its free rows
+        // would have on a slotted page: that way records ask every page for room the same way.
+        // Rows are counted in whole free space map buckets, so a page with one free row is still found.
+        unsigned freeRows = slotHeader.paxRows - slotHeader.recordEntriesNumber;
+        for (unsigned i = 0; i < slotHeader.recordEntriesNumber; i++)
+        {
+            if (getSlotStatus(getSlotDirectoryRecordEntry(page, i)) == DEAD)
+                freeRows++;
+        }
+        unsigned rowSize = sizeof(SlotDirectoryRecordEntry) + sizeof(RecordLength) + getNullIndicatorSize(slotHeader.paxColumns) +
+                           slotHeader.paxColumns * INT_SIZE;
+        rowSize = (rowSize + FSM_BUCKET_SIZE - 1) / FSM_BUCKET_SIZE * FSM_BUCKET_SIZE;
+        return min(freeRows * rowSize, (unsigned) (PAGE_SIZE - sizeof(SlotDirectoryHeader)));
+    }
+    return slotHeader.freeSpaceOffset - slotHeader.recordEntriesNumber * sizeof(SlotDirectoryRecordEntry) - sizeof(SlotDirectoryHeader);
+}
+
+unsigned RecordBasedFileManager::getRecordSize(const vector<Attribute> &recordDescriptor, const void *data) 
+{
+    // Fixed width records are the same size whatever they hold
+    if (isFixedWidth(recordDescriptor))
+        return sizeof(RecordLength) + getNullIndicatorSize(recordDescriptor.size()) + recordDescriptor.size() * INT_SIZE;
+
+    // Read in the null indicator
+    int nullIndicatorSize = getNullIndicatorSize(recordDescriptor.size());
+    char nullIndicator[nullIndicatorSize];
+    memset(nullIndicator, 0, nullIndicatorSize);
+    memcpy(nullIndicator, (char*) data, nullIndicatorSize);
+
+    // Offset into *data. Start just after null indicator
+    unsigned offset = nullIndicatorSize;
+    // Running count of size. Initialize to size of header
+    unsigned size = sizeof (RecordLength) + (recordDescriptor.size()) * sizeof(ColumnOffset) + nullIndicatorSize;
+
+    for (unsigned i = 0; i < (unsigned) recordDescriptor.size(); i++)
+    {
+        // Skip null fields
+        if (fieldIsNull(nullIndicator, i))
+            continue;
+        switch (recordDescriptor[i].type)
+        {
+            case TypeInt:
+                size += INT_SIZE;
+                offset += INT_SIZE;
+            break;
+            case TypeReal:
+                size += REAL_SIZE;
+                offset += REAL_SIZE;
+            break;
+            case TypeVarChar:
+                uint32_t varcharSize;
+                // We have to get the size of the VarChar field by reading the integer that precedes the string value itself
+                memcpy(&varcharSize, (char*) data + offset, VARCHAR_LENGTH_SIZE);
+                varcharSize &= ~RBFM_LENGTH_FLAGS;
+                size += varcharSize;
+                offset += varcharSize + VARCHAR_LENGTH_SIZE;
+            break;
+        }
+    }
+
+    return size;
+}
+
+// Whether the records of recordDescriptor are fixed width, see RBFM_FIXED_RECORD
+bool RecordBasedFileManager::isFixedWidth(const vector<Attribute> &recordDescriptor)
+{
+    for (unsigned i = 0; i < recordDescriptor.size(); i++)
+    {
+        if (recordDescriptor[i].type == TypeVarChar)
+            return false;
+    }
+    return !recordDescriptor.empty();
+}
+
+// Whether any bit of the null indicator is set
+bool RecordBasedFileManager::hasNullFields(const char *nullIndicator, unsigned nullIndicatorSize)
+{
+    for (unsigned i = 0; i < nullIndicatorSize; i++)
+    {
+        if (nullIndicator[i])
+            return true;
+    }
+    return false;
+}
+
+// Calculate actual bytes for nulls-indicator for the given field counts
+int RecordBasedFileManager::getNullIndicatorSize(int fieldCount) 
+{
+    return int(ceil((double) fieldCount / CHAR_BIT));
+}
+
+bool RecordBasedFileManager::fieldIsNull(char *nullIndicator, int i)
+{
+    int indicatorIndex = i / CHAR_BIT;
+    int indicatorMask  = 1 << (CHAR_BIT - 1 - (i % CHAR_BIT));
+    return (nullIndicator[indicatorIndex] & indicatorMask) != 0;
+}
+
+// Find field index of the record at "record". Returns false if the field is null, which includes
+// fields added to the table after the record was written.
+bool RecordBasedFileManager::getRecordField(const char *record, unsigned index, const char *&field, uint32_t &len)
+{
+    RecordLength n;
+    memcpy(&n, record, sizeof(RecordLength));
+    const char *recordNullIndicator = record + sizeof(RecordLength);
+    if (n & RBFM_FIXED_RECORD)
+    {
+        n &= ~RBFM_FIXED_RECORD;
+        if (index >= n || fieldIsNull((char*) recordNullIndicator, index))
+            return false;
+        field = recordNullIndicator + getNullIndicatorSize(n) + index * INT_SIZE;
+        len = INT_SIZE;
+        return true;
+    }
+    if (index >= n || fieldIsNull((char*) recordNullIndicator, index))
+        return false;
+
+    // The directory holds the end of every field, a field starts where the previous one ends
+    const char *directory = recordNullIndicator + getNullIndicatorSize(n);
+    ColumnOffset attrStart, attrEnd;
+    memcpy(&attrEnd, directory + index * sizeof(ColumnOffset), sizeof(ColumnOffset));
+    if (index > 0)
+        memcpy(&attrStart, directory + (index - 1) * sizeof(ColumnOffset), sizeof(ColumnOffset));
+    else
+        attrStart = directory - record + n * sizeof(ColumnOffset);
+    attrStart &= ~RBFM_FIELD_FLAGS;
+    attrEnd &= ~RBFM_FIELD_FLAGS;
+
+    field = record + attrStart;
+    len = attrEnd - attrStart;
+    return true;
+}
+
+// Whether field index of the record at "record" holds a ToastPointer rather than its value
+bool RecordBasedFileManager::isToastedField(const char *record, unsigned index)
+{
+    RecordLength n;
+    memcpy(&n, record, sizeof(RecordLength));
+    if (index >= n || (n & RBFM_FIXED_RECORD))
+        return false;
+    ColumnOffset attrEnd;
+    memcpy(&attrEnd, record + sizeof(RecordLength) + getNullIndicatorSize(n) + index * sizeof(ColumnOffset), sizeof(ColumnOffset));
+    return attrEnd & RBFM_TOASTED_FIELD;
+}
+
+// Whether field index of the record at "record" holds a code into the dictionary of its page
+bool RecordBasedFileManager::isCodedField(const char *record, unsigned index)
+{
+    RecordLength n;
+    memcpy(&n, record, sizeof(RecordLength));
+    if (index >= n || (n & RBFM_FIXED_RECORD))
+        return false;
+    ColumnOffset attrEnd;
+    memcpy(&attrEnd, record + sizeof(RecordLength) + getNullIndicatorSize(n) + index * sizeof(ColumnOffset), sizeof(ColumnOffset));
+    return attrEnd & RBFM_CODED_FIELD;
+}
+
+// Like getRecordField, for a record on page, with a coded field pointing at its value in the page's dictionary
+bool RecordBasedFileManager::getRecordValue(void *page, const char *record, unsigned index, const char *&field, uint32_t &len)
+{
+    if (isPaxPage(page))
+        return getPaxField(page, record, index, field, len);
+    if (!getRecordField(record, index, field, len))
+        return false;
+    if (isCodedField(record, index))
+        getDictionaryValue(page, (uint8_t) field[0], field, len);
+    return true;
+}
+
+// Put a record in a page that has room for it (and its slot) and return its slot number
+unsigned RecordBasedFileManager::addRecordToPage(void *page, const vector<Attribute> &recordDescriptor, const void *data, unsigned recordSize)
+{
+    SlotDirectoryHeader slotHeader = getSlotDirectoryHeader(page);
+    unsigned slotNum = getOpenSlot(page);
+
+    // Adding the new record reference in the slot directory. On a PAX page the slot's row is where it goes.
+    SlotDirectoryRecordEntry newRecordEntry;
+    if (slotHeader.paxColumns != 0)
+    {
+        unsigned nullIndicatorSize = getNullIndicatorSize(slotHeader.paxColumns);
+        newRecordEntry.length = nullIndicatorSize + slotHeader.paxColumns * INT_SIZE;
+        newRecordEntry.offset = getPaxNullOffset(slotHeader) + slotNum * nullIndicatorSize;
+    }
+    else
+    {
+        newRecordEntry.length = recordSize;
+        newRecordEntry.offset = slotHeader.freeSpaceOffset - recordSize;
+        slotHeader.freeSpaceOffset = newRecordEntry.offset;
+    }
+    setSlotDirectoryRecordEntry(page, slotNum, newRecordEntry);
+
+    // Updating the slot directory header.
+    if (slotNum == slotHeader.recordEntriesNumber)
+        slotHeader.recordEntriesNumber += 1;
+    setSlotDirectoryHeader(page, slotHeader);
+
+    // Adding the record data.
+    setRecordAtOffset (page, newRecordEntry.offset, recordDescriptor, data);
+    return slotNum;
+}
+
+void RecordBasedFileManager::setRecordAtOffset(void *page, unsigned offset, const vector<Attribute> &recordDescriptor, const void *data)
+{
+    if (isPaxPage(page))
+    {
+        setPaxRecord(page, offset, recordDescriptor, data);
+        return;
+    }
+    if (isFixedWidth(recordDescriptor))
+    {
+        setFixedRecord((char*) page + offset, recordDescriptor, data);
+        return;
+    }
+
+    // Read in the null indicator
+    int nullIndicatorSize = getNullIndicatorSize(recordDescriptor.size());
+    char nullIndicator[nullIndicatorSize];
+    memset (nullIndicator, 0, nullIndicatorSize);
+    memcpy(nullIndicator, (char*) data, nullIndicatorSize);
+
+    // Points to start of record
+    char *start = (char*) page + offset;
+
+    // Offset into *data
+    unsigned data_offset = nullIndicatorSize;
+    // Offset into page header
+    unsigned header_offset = 0;
+
+    RecordLength len = recordDescriptor.size();
+    memcpy(start + header_offset, &len, sizeof(len));
+    header_offset += sizeof(len);
+
+    memcpy(start + header_offset, nullIndicator, nullIndicatorSize);
+    header_offset += nullIndicatorSize;
+
+    // Keeps track of the offset of each record
+    // Offset is relative to the start of the record and points to the END of a field
+    ColumnOffset rec_offset = header_offset + (recordDescriptor.size()) * sizeof(ColumnOffset);
+
+    unsigned i = 0;
+    for (i = 0; i < recordDescriptor.size(); i++)
+    {
+        ColumnOffset flags = 0;
+        if (!fieldIsNull(nullIndicator, i))
+        {
+            // Points to current position in *data
+            char *data_start = (char*) data + data_offset;
+
+            // Read in the data for the next column, point rec_offset to end of newly inserted data
+            switch (recordDescriptor[i].type)
+            {
+                case TypeInt:
+                    memcpy (start + rec_offset, data_start, INT_SIZE);
+                    rec_offset += INT_SIZE;
+                    data_offset += INT_SIZE;
+                break;
+                case TypeReal:
+                    memcpy (start + rec_offset, data_start, REAL_SIZE);
+                    rec_offset += REAL_SIZE;
+                    data_offset += REAL_SIZE;
+                break;
+                case TypeVarChar:
+                    unsigned varcharSize;
+                    // We have to get the size of the VarChar field by reading the integer that precedes the string value itself
+                    memcpy(&varcharSize, data_start, VARCHAR_LENGTH_SIZE);
+                    if (varcharSize & RBFM_TOASTED_LENGTH)
+                        flags = RBFM_TOASTED_FIELD;
+                    if (varcharSize & RBFM_CODED_LENGTH)
+                        flags = RBFM_CODED_FIELD;
+                    varcharSize &= ~RBFM_LENGTH_FLAGS;
+                    memcpy(start + rec_offset, data_start + VARCHAR_LENGTH_SIZE, varcharSize);
+                    // We also have to account for the overhead given by that integer.
+                    rec_offset += varcharSize;
+                    data_offset += VARCHAR_LENGTH_SIZE + varcharSize;
+                break;
+            }
+        }
+        // Copy offset into record header
+        // Offset is relative to the start of the record and points to END of field
+        ColumnOffset entry = rec_offset | flags;
+        memcpy(start + header_offset, &entry, sizeof(ColumnOffset));
+        header_offset += sizeof(ColumnOffset);
+    }
+}
+
+// Returns whether any value was stored out of line. Those are given as their ToastPointer, see RBFM_TOASTED_LENGTH.
+bool RecordBasedFileManager::getRecordAtOffset(void *page, int32_t offset, const vector<Attribute> &recordDescriptor, void *data)
+{
+    if (isPaxPage(page))
+    {
+        getPaxRecord(page, offset, recordDescriptor, data);
+        return false;
+    }
+
+    // Pointer to start of record
+    char *start = (char*) page + offset;
+    RecordLength n;
+    memcpy(&n, start, sizeof(RecordLength));
+    if (n & RBFM_FIXED_RECORD)
+    {
+        getFixedRecord(start, recordDescriptor, data);
+        return false;
+    }
+
+    // Allocate space for null indicator. The returned null indicator may be larger than
+    // the null indicator in the table has had fields added to it
     int nullIndicatorSize = getNullIndicatorSize(recordDescriptor.size());
     char nullIndicator[nullIndicatorSize];
-    memset (nullIndicator, 0, nullIndicatorSize);
-    memcpy(nullIndicator, (char*) data, nullIndicatorSize);
+    memset(nullIndicator, 0, nullIndicatorSize);
+
+    // Get number of columns and size of the null indicator for this record
+    RecordLength len = 0;
+    memcpy (&len, (char*)page + offset, sizeof(RecordLength));
+    int recordNullIndicatorSize = getNullIndicatorSize(len);
+
+    // Read in the existing null indicator
+    memcpy (nullIndicator, start + sizeof(RecordLength), nullIndicatorSize);
+
+    // If this new recordDescriptor has had fields added to it, we set all of the new fields to null
+    for (unsigned i = len; i < recordDescriptor.size(); i++)
+    {
+        int indicatorIndex = (i+1) / CHAR_BIT;
+        int indicatorMask  = 1 << (CHAR_BIT - 1 - (i % CHAR_BIT));
+        nullIndicator[indicatorIndex] |= indicatorMask;
+    }
+    // Write out null indicator
+    memcpy(data, nullIndicator, nullIndicatorSize);
+
+    // Initialize some offsets
+    // rec_offset: points to data in the record. We move this forward as we read data from our record
+    unsigned rec_offset = sizeof(RecordLength) + recordNullIndicatorSize + len * sizeof(ColumnOffset);
+    // data_offset: points to our current place in the output data. We move this forward as we write data to data.
+    unsigned data_offset = nullIndicatorSize;
+    // directory_base: points to the start of our directory of indices
+    char *directory_base = start + sizeof(RecordLength) + recordNullIndicatorSize;
+    bool toasted = false;
+    
+    for (unsigned i = 0; i < recordDescriptor.size(); i++)
+    {
+        if (fieldIsNull(nullIndicator, i))
+            continue;
+        
+        // Grab pointer to end of this column
+        ColumnOffset endPointer;
+        memcpy(&endPointer, directory_base + i * sizeof(ColumnOffset), sizeof(ColumnOffset));
+        bool fieldToasted = endPointer & RBFM_TOASTED_FIELD;
+        bool fieldCoded = endPointer & RBFM_CODED_FIELD;
+        endPointer &= ~RBFM_FIELD_FLAGS;
+
+        // rec_offset keeps track of start of column, so end-start = total size
+        uint32_t fieldSize = endPointer - rec_offset;
+
+        // Coded values come from the page's dictionary
+        if (fieldCoded)
+        {
+            const char *value;
+            uint32_t valueSize;
+            getDictionaryValue(page, (uint8_t) start[rec_offset], value, valueSize);
+            memcpy((char*) data + data_offset, &valueSize, VARCHAR_LENGTH_SIZE);
+            memcpy((char*) data + data_offset + VARCHAR_LENGTH_SIZE, value, valueSize);
+            rec_offset += fieldSize;
+            data_offset += VARCHAR_LENGTH_SIZE + valueSize;
+            continue;
+        }
+
+        // Special case for varchar, we must give data the size of varchar first
+        if (recordDescriptor[i].type == TypeVarChar)
+        {
+            uint32_t varcharSize = fieldToasted ? fieldSize | RBFM_TOASTED_LENGTH : fieldSize;
+            memcpy((char*) data + data_offset, &varcharSize, VARCHAR_LENGTH_SIZE);
+            data_offset += VARCHAR_LENGTH_SIZE;
+            toasted |= fieldToasted;
+        }
+        // Next we copy bytes equal to the size of the field and increase our offsets
+        memcpy((char*) data + data_offset, start + rec_offset, fieldSize);
+        rec_offset += fieldSize;
+        data_offset += fieldSize;
+    }
+    return toasted;
+}
+
+// Write a fixed width record at "record". With no NULLs its fields are copied in one go.
+void RecordBasedFileManager::setFixedRecord(char *record, const vector<Attribute> &recordDescriptor, const void *data)
+{
+    RecordLength n = recordDescriptor.size() | RBFM_FIXED_RECORD;
+    memcpy(record, &n, sizeof(RecordLength));
+    unsigned nullIndicatorSize = getNullIndicatorSize(recordDescriptor.size());
+    char *nullIndicator = record + sizeof(RecordLength);
+    memcpy(nullIndicator, data, nullIndicatorSize);
+
+    char *out = nullIndicator + nullIndicatorSize;
+    const char *in = (const char*) data + nullIndicatorSize;
+    if (!hasNullFields(nullIndicator, nullIndicatorSize))
+    {
+        memcpy(out, in, recordDescriptor.size() * INT_SIZE);
+        return;
+    }
+    for (unsigned i = 0; i < recordDescriptor.size(); i++, out += INT_SIZE)
+    {
+        if (fieldIsNull(nullIndicator, i))
+        {
+            memset(out, 0, INT_SIZE);
+            continue;
+        }
+        memcpy(out, in, INT_SIZE);
+        in += INT_SIZE;
+    }
+}
+
+// Read the fixed width record at "record" into data. Fields added to the table after it was written are NULL.
+void RecordBasedFileManager::getFixedRecord(const char *record, const vector<Attribute> &recordDescriptor, void *data)
+{
+    RecordLength n;
+    memcpy(&n, record, sizeof(RecordLength));
+    n &= ~RBFM_FIXED_RECORD;
+    unsigned recordNullIndicatorSize = getNullIndicatorSize(n);
+    unsigned nullIndicatorSize = getNullIndicatorSize(recordDescriptor.size());
+    const char *in = record + sizeof(RecordLength) + recordNullIndicatorSize;
+
+    char *nullIndicator = (char*) data;
+    memset(nullIndicator, 0, nullIndicatorSize);
+    memcpy(nullIndicator, record + sizeof(RecordLength), min(recordNullIndicatorSize, nullIndicatorSize));
+    if (n == recordDescriptor.size() && !hasNullFields(nullIndicator, nullIndicatorSize))
+    {
+        memcpy(nullIndicator + nullIndicatorSize, in, n * INT_SIZE);
+        return;
+    }
+
+    char *out = nullIndicator + nullIndicatorSize;
+    for (unsigned i = 0; i < recordDescriptor.size(); i++, in += INT_SIZE)
+    {
+        if (i >= n)
+            nullIndicator[i / CHAR_BIT] |= 1 << (CHAR_BIT - 1 - (i % CHAR_BIT));
+        if (fieldIsNull(nullIndicator, i))
+            continue;
+        memcpy(out, in, INT_SIZE);
+        out += INT_SIZE;
+    }
+}
+
+SlotStatus RecordBasedFileManager::getSlotStatus(SlotDirectoryRecordEntry slot)
+{
+    if (slot.length == 0 && slot.offset == 0)
+        return DEAD;
+    if (slot.offset <= 0)
+        return MOVED;
+    return VALID;
+}
+
+// Get first unused slot in page. Slot is considered unused if dead
+// If not dead slots returns recordEntriesNumber
+unsigned RecordBasedFileManager::getOpenSlot(void *page)
+{
+    SlotDirectoryHeader header = getSlotDirectoryHeader(page);
+    unsigned i;
+    for (i = 0; i < header.recordEntriesNumber; i++)
+    {
+        SlotDirectoryRecordEntry recordEntry = getSlotDirectoryRecordEntry(page, i);
+        SlotStatus status = getSlotStatus(recordEntry);
+        if (status == DEAD)
+            return i;
+    }
+    return i;
+}
+
+// Mark slot header as dead (all 0s)
+void RecordBasedFileManager::markSlotDeleted(void *page, unsigned i)
+{
+    memset  (
+            ((char*) page + sizeof(SlotDirectoryHeader) + i * sizeof(SlotDirectoryRecordEntry)),
+            0,
+            sizeof(SlotDirectoryRecordEntry)
+            );
+}
+
+// Consolidates free space in center of page
+void RecordBasedFileManager::reorganizePage(void *page)
+{
+    SlotDirectoryHeader header = getSlotDirectoryHeader(page);
+    // The rows of a PAX page never move, there is no free space to consolidate
+    if (header.paxColumns != 0)
+        return;
+
+    // Add all live records to vector, keeping track of slot numbers
+    vector<IndexedRecordEntry> liveRecords;
+    for (unsigned i = 0; i < header.recordEntriesNumber; i++)
+    {
+        IndexedRecordEntry entry;
+        entry.slotNum = i;
+        entry.recordEntry = getSlotDirectoryRecordEntry(page, i);
+        if (getSlotStatus(entry.recordEntry) == VALID)
+            liveRecords.push_back(entry);
+    }
+    // Sort records by offset, descending
+    auto comp = [](IndexedRecordEntry first, IndexedRecordEntry second) 
+        {return first.recordEntry.offset > second.recordEntry.offset;};
+    sort(liveRecords.begin(), liveRecords.end(), comp);
+
+    // Move each record back filling in any gap preceding the record, or the page's dictionary
+    uint16_t pageOffset = header.dictionaryOffset != 0 ? header.dictionaryOffset : PAGE_SIZE;
+    SlotDirectoryRecordEntry current;
+    for (unsigned i = 0; i < liveRecords.size(); i++)
+    {
+        current = liveRecords[i].recordEntry;
+        pageOffset -= current.length;
+
+        // Use memmove rather than memcpy because locations may overlap
+        memmove((char*)page + pageOffset, (char*)page + current.offset, current.length);
+        current.offset = pageOffset;
+        setSlotDirectoryRecordEntry(page, liveRecords[i].slotNum, current);
+    }
+    header.freeSpaceOffset = pageOffset;
+    setSlotDirectoryHeader(page, header);
+}
+
+// Returns whether the attribute was stored out of line, in which case it is given as its ToastPointer
+bool RecordBasedFileManager::getAttributeFromRecord(void *page, unsigned offset, unsigned attrIndex, AttrType type, void *data)
+{
+    char *start = (char*)page + offset;
+    unsigned data_offset = 0;
+
+    if (isPaxPage(page))
+    {
+        const char *field;
+        uint32_t len;
+        char resultNullIndicator = getPaxField(page, start, attrIndex, field, len) ? 0 : 1 << 7;
+        memcpy(data, &resultNullIndicator, 1);
+        if (!resultNullIndicator)
+            memcpy((char*) data + 1, field, len);
+        return false;
+    }
+
+    // Get number of columns
+    RecordLength n;
+    memcpy (&n, start, sizeof(RecordLength));
+    if (n & RBFM_FIXED_RECORD)
+    {
+        const char *field;
+        uint32_t len;
+        char resultNullIndicator = getRecordField(start, attrIndex, field, len) ? 0 : 1 << 7;
+        memcpy(data, &resultNullIndicator, 1);
+        if (!resultNullIndicator)
+            memcpy((char*) data + 1, field, len);
+        return false;
+    }
+
+    // Get null indicator
+    int recordNullIndicatorSize = getNullIndicatorSize(n);
+    char recordNullIndicator[recordNullIndicatorSize];
+    memcpy (recordNullIndicator, start + sizeof(RecordLength), recordNullIndicatorSize);
+
+    // Set null indicator for result
+    char resultNullIndicator = 0;
+    if (fieldIsNull(recordNullIndicator, attrIndex))
+        resultNullIndicator |= (1 << 7);
+    memcpy(data, &resultNullIndicator, 1);
+    data_offset += 1;
+    if (resultNullIndicator) return false;
+
+    // Now we know the result isn't null, so we grab it
+    unsigned header_offset = sizeof(RecordLength) + recordNullIndicatorSize;
+    // attrEnd points to end of attribute, attrStart points to the beginning
+    // Our directory at the beginning of each record contains pointers to the ends of each attribute,
+    // so we can pull attrEnd from that
+    ColumnOffset attrEnd, attrStart;
+    memcpy(&attrEnd, start + header_offset + attrIndex * sizeof(ColumnOffset), sizeof(ColumnOffset));
+    // The start is either the end of the previous attribute, or the start of the data section of the
+    // record if we are after the 0th attribute
+    if (attrIndex > 0)
+        memcpy(&attrStart, start + header_offset + (attrIndex - 1) * sizeof(ColumnOffset), sizeof(ColumnOffset));
+    else
+        attrStart = header_offset + n * sizeof(ColumnOffset);
+    bool toasted = attrEnd & RBFM_TOASTED_FIELD;
+    bool coded = attrEnd & RBFM_CODED_FIELD;
+    attrStart &= ~RBFM_FIELD_FLAGS;
+    attrEnd &= ~RBFM_FIELD_FLAGS;
+    // The length of any attribute is just the difference between its start and end
+    uint32_t len = attrEnd - attrStart;
+    const char *value = start + attrStart;
+    if (coded)
+        getDictionaryValue(page, (uint8_t) *value, value, len);
+    if (type == TypeVarChar)
+    {
+        // For varchars we have to return this length in the result
+        uint32_t varcharSize = toasted ? len | RBFM_TOASTED_LENGTH : len;
+        memcpy((char*)data + data_offset, &varcharSize, VARCHAR_LENGTH_SIZE);
+        data_offset += VARCHAR_LENGTH_SIZE;
+    }
+    // For all types, we then copy the data into the result
+    memcpy((char*)data + data_offset, value, len);
+    return toasted;
+}
+
+// Map pages sit at the start of every run of FSM_PAGE_SPAN data pages
+bool RecordBasedFileManager::isFreeSpaceMapPage(PageNum pageNum)
+{
+    return pageNum % (FSM_PAGE_SPAN + 1) == 0;
+}
+
+// Get the map page that holds the entry for data page pageNum
+PageNum RecordBasedFileManager::getFreeSpaceMapPage(PageNum pageNum)
+{
+    return pageNum - pageNum % (FSM_PAGE_SPAN + 1);
+}
+
+// The page is guaranteed to have at least bucket * FSM_BUCKET_SIZE free bytes
+uint8_t RecordBasedFileManager::getFreeSpaceBucket(void *page)
+{
+    return getPageFreeSpaceSize(page) / FSM_BUCKET_SIZE;
+}
+
+// Record the current free space of a data page in its map page
+RC RecordBasedFileManager::updateFreeSpaceMap(FileHandle &fileHandle, PageNum pageNum, void *page)
+{
+    PageNum mapPageNum = getFreeSpaceMapPage(pageNum);
+    uint8_t bucket = getFreeSpaceBucket(page);
+
+    void *mapPageData;
+    if (_bp_manager->pinPage(fileHandle, mapPageNum, mapPageData))
+        return RBFM_READ_FAILED;
+
+    uint8_t *entry = (uint8_t*) mapPageData + (pageNum - mapPageNum - 1);
+    bool changed = *entry != bucket;
+    *entry = bucket;
+    _bp_manager->unpinPage(fileHandle, mapPageNum, changed);
+    return SUCCESS;
+}
+
+// Search the free space map for a data page with at least size free bytes.
+// The last map page is tried first since that is where new pages go, then the others in order.
+RC RecordBasedFileManager::findPageWithFreeSpace(FileHandle &fileHandle, unsigned size, PageNum &pageNum, bool &found, PageNum before)
+{
+    found = false;
+    unsigned numPages = fileHandle.getNumberOfPages();
+    if (numPages == 0)
+        return SUCCESS;
+
+    // Smallest bucket that guarantees enough space
+    unsigned minBucket = (size + FSM_BUCKET_SIZE - 1) / FSM_BUCKET_SIZE;
+    if (minBucket > UINT8_MAX)
+        return SUCCESS;
+
+    PageNum end = min((PageNum) numPages, before);
+    PageNum lastMapPage = getFreeSpaceMapPage(numPages - 1);
+    for (PageNum i = 0; i <= lastMapPage; i += FSM_PAGE_SPAN + 1)
+    {
+        PageNum mapPageNum = i == 0 ? lastMapPage : i - (FSM_PAGE_SPAN + 1);
+        if ((i != 0 && mapPageNum == lastMapPage) || mapPageNum + 1 >= end)
+            continue;
 
-    // Points to start of record
-    char *start = (char*) page + offset;
+        void *mapPageData;
+        if (_bp_manager->pinPage(fileHandle, mapPageNum, mapPageData))
+            return RBFM_READ_FAILED;
 
-    // Offset into *data
-    unsigned data_offset = nullIndicatorSize;
-    // Offset into page header
-    unsigned header_offset = 0;
+        // Only look at entries for pages that exist and come before the limit
+        unsigned entries = min((unsigned) FSM_PAGE_SPAN, end - mapPageNum - 1);
+        uint8_t *map = (uint8_t*) mapPageData;
+        for (unsigned j = 0; j < entries; j++)
+        {
+            if (map[j] >= minBucket)
+            {
+                pageNum = mapPageNum + 1 + j;
+                found = true;
+                break;
+            }
+        }
+        _bp_manager->unpinPage(fileHandle, mapPageNum, false);
+        if (found)
+            return SUCCESS;
+    }
+    return SUCCESS;
+}
 
-    RecordLength len = recordDescriptor.size();
-    memcpy(start + header_offset, &len, sizeof(len));
-    header_offset += sizeof(len);
+// Append pages filled by insertRecords, then record the free space and zones of the data pages among them
+RC RecordBasedFileManager::appendRecordBasedPages(FileHandle &fileHandle, const vector<Attribute> &recordDescriptor, char *pages, unsigned count)
+{
+    PageNum firstPage = fileHandle.getNumberOfPages();
+    if (fileHandle.appendPages(pages, count))
+        return RBFM_APPEND_FAILED;
 
-    memcpy(start + header_offset, nullIndicator, nullIndicatorSize);
-    header_offset += nullIndicatorSize;
+    for (unsigned i = 0; i < count; i++)
+    {
+        if (isFreeSpaceMapPage(firstPage + i))
+            continue;
+        RC rc = updatePageSummaries(fileHandle, recordDescriptor, firstPage + i, pages + i * PAGE_SIZE);
+        if (rc)
+            return rc;
+    }
+    return SUCCESS;
+}
+
+// Append a new data page to the file (adding a map page first if one is due) and record its free space
+RC RecordBasedFileManager::appendRecordBasedPage(FileHandle &fileHandle, void *page, PageNum &pageNum)
+{
+    pageNum = fileHandle.getNumberOfPages();
+    if (isFreeSpaceMapPage(pageNum))
+    {
+        void *mapPageData = calloc(PAGE_SIZE, 1);
+        if (mapPageData == NULL)
+            return RBFM_MALLOC_FAILED;
+        RC rc = fileHandle.appendPage(mapPageData);
+        free(mapPageData);
+        if (rc)
+            return RBFM_APPEND_FAILED;
+        pageNum++;
+    }
+
+    if (fileHandle.appendPage(page))
+        return RBFM_APPEND_FAILED;
+
+    return updateFreeSpaceMap(fileHandle, pageNum, page);
+}
+
+RecordFile *RecordBasedFileManager::findRecordFile(FileHandle &fileHandle)
+{
+    FileId id = fileHandle.getFileId();
+    for (unsigned i = 0; i < _openFiles.size(); i++)
+    {
+        if (_openFiles[i]->id.device == id.device && _openFiles[i]->id.inode == id.inode)
+            return _openFiles[i];
+    }
+    return NULL;
+}
+
+// Whether a PARALLEL_SCAN is reading the file, see RecordFile
+bool RecordBasedFileManager::isParallelScanned(FileHandle &fileHandle)
+{
+    RecordFile *file = findRecordFile(fileHandle);
+    return file != NULL && file->parallelScans > 0;
+}
+
+// Bring the free space map and zone map up to date after a data page has changed
+RC RecordBasedFileManager::updatePageSummaries(FileHandle &fileHandle, const vector<Attribute> &recordDescriptor, PageNum pageNum, void *page)
+{
+    RC rc = updateFreeSpaceMap(fileHandle, pageNum, page);
+    if (rc)
+        return rc;
+    return rebuildZoneMap(fileHandle, recordDescriptor, pageNum, page);
+}
+
+// Pin the zone file page holding the entry of data page pageNum, growing the zone file if needed.
+// Pages added to the zone file start out as ZONE_UNKNOWN.
+RC RecordBasedFileManager::pinZoneMapEntry(RecordFile *file, PageNum pageNum, PageNum &zonePageNum, ColumnZone *&zones)
+{
+    unsigned entriesPerPage = PAGE_SIZE / (file->zoneColumns * sizeof(ColumnZone));
+    zonePageNum = 1 + pageNum / entriesPerPage;
+    if (zonePageNum >= file->zoneHandle.getNumberOfPages())
+    {
+        void *emptyPage = calloc(PAGE_SIZE, 1);
+        if (emptyPage == NULL)
+            return RBFM_MALLOC_FAILED;
+        RC rc = SUCCESS;
+        while (rc == SUCCESS && zonePageNum >= file->zoneHandle.getNumberOfPages())
+            rc = file->zoneHandle.appendPage(emptyPage);
+        free(emptyPage);
+        if (rc)
+            return RBFM_APPEND_FAILED;
+    }
+
+    void *zonePage;
+    if (_bp_manager->pinPage(file->zoneHandle, zonePageNum, zonePage))
+        return RBFM_READ_FAILED;
+    zones = (ColumnZone*) zonePage + (pageNum % entriesPerPage) * file->zoneColumns;
+    return SUCCESS;
+}
+
+// Widen the zones of a page to take in the record just put in slot slotNum
+RC RecordBasedFileManager::widenZoneMap(FileHandle &fileHandle, const vector<Attribute> &recordDescriptor, PageNum pageNum, void *page, unsigned slotNum)
+{
+    RecordFile *file = findRecordFile(fileHandle);
+    if (file == NULL || !file->hasZoneMap)
+        return SUCCESS;
+
+    PageNum zonePageNum;
+    ColumnZone *zones;
+    RC rc = pinZoneMapEntry(file, pageNum, zonePageNum, zones);
+    if (rc)
+        return rc;
+    SlotDirectoryRecordEntry recordEntry = getSlotDirectoryRecordEntry(page, slotNum);
+    summarizeRecord(zones, file->zoneColumns, recordDescriptor, page, (char*) page + recordEntry.offset);
+    _bp_manager->unpinPage(file->zoneHandle, zonePageNum, true);
+    return SUCCESS;
+}
+
+// Recompute the zones of a page from every record on it, so deletes and updates can narrow them
+RC RecordBasedFileManager::rebuildZoneMap(FileHandle &fileHandle, const vector<Attribute> &recordDescriptor, PageNum pageNum, void *page)
+{
+    RecordFile *file = findRecordFile(fileHandle);
+    if (file == NULL || !file->hasZoneMap)
+        return SUCCESS;
+
+    PageNum zonePageNum;
+    ColumnZone *zones;
+    RC rc = pinZoneMapEntry(file, pageNum, zonePageNum, zones);
+    if (rc)
+        return rc;
+
+    memset(zones, 0, file->zoneColumns * sizeof(ColumnZone));
+    for (unsigned i = 0; i < file->zoneColumns; i++)
+        zones[i].state = ZONE_EMPTY;
+
+    SlotDirectoryHeader header = getSlotDirectoryHeader(page);
+    for (unsigned i = 0; i < header.recordEntriesNumber; i++)
+    {
+        SlotDirectoryRecordEntry recordEntry = getSlotDirectoryRecordEntry(page, i);
+        if (getSlotStatus(recordEntry) == VALID)
+            summarizeRecord(zones, file->zoneColumns, recordDescriptor, page, (char*) page + recordEntry.offset);
+    }
+    _bp_manager->unpinPage(file->zoneHandle, zonePageNum, true);
+    return SUCCESS;
+}
+
+// Zone keys: ints and reals as they are, varchars cut to ZONE_PREFIX_SIZE bytes and padded with zeros
+static void makeZoneKey(AttrType type, const char *field, uint32_t len, char *key)
+{
+    memset(key, 0, ZONE_PREFIX_SIZE);
+    if (type == TypeVarChar)
+        memcpy(key, field, min(len, (uint32_t) ZONE_PREFIX_SIZE));
+    else
+        memcpy(key, field, INT_SIZE);
+}
+
+static int compareZoneKeys(AttrType type, const char *first, const char *second)
+{
+    if (type == TypeInt)
+    {
+        int32_t a, b;
+        memcpy(&a, first, INT_SIZE);
+        memcpy(&b, second, INT_SIZE);
+        return a < b ? -1 : a > b;
+    }
+    if (type == TypeReal)
+    {
+        float a, b;
+        memcpy(&a, first, REAL_SIZE);
+        memcpy(&b, second, REAL_SIZE);
+        return a < b ? -1 : a > b;
+    }
+    return memcmp(first, second, ZONE_PREFIX_SIZE);
+}
+
+void RecordBasedFileManager::summarizeRecord(ColumnZone *zones, unsigned columns, const vector<Attribute> &recordDescriptor, void *page, const char *record)
+{
+    columns = min(columns, (unsigned) recordDescriptor.size());
+    for (unsigned i = 0; i < columns; i++)
+    {
+        // Nulls never match a condition, and unknown zones stay unknown
+        const char *field;
+        uint32_t len;
+        if (zones[i].state == ZONE_UNKNOWN || !getRecordValue(page, record, i, field, len))
+            continue;
+
+        // Values stored out of line are summarized by the prefix kept in their ToastPointer
+        AttrType type = recordDescriptor[i].type;
+        ToastPointer pointer;
+        if (type == TypeVarChar && isToastedField(record, i))
+        {
+            memcpy(&pointer, field, sizeof(ToastPointer));
+            field = pointer.prefix;
+            len = min(pointer.length, (uint32_t) ZONE_PREFIX_SIZE);
+        }
+        char key[ZONE_PREFIX_SIZE];
+        makeZoneKey(type, field, len, key);
+        if (zones[i].state == ZONE_EMPTY)
+        {
+            memcpy(zones[i].min, key, ZONE_PREFIX_SIZE);
+            memcpy(zones[i].max, key, ZONE_PREFIX_SIZE);
+            zones[i].state = ZONE_RANGE;
+            continue;
+        }
+        if (compareZoneKeys(type, key, zones[i].min) < 0)
+            memcpy(zones[i].min, key, ZONE_PREFIX_SIZE);
+        if (compareZoneKeys(type, key, zones[i].max) > 0)
+            memcpy(zones[i].max, key, ZONE_PREFIX_SIZE);
+    }
+}
+
+// Guess the share of records a condition keeps: a textbook fraction for its operator, scaled by
+// the share of a sample of pages the zone map can't rule out
+double RecordBasedFileManager::estimateSelectivity(FileHandle &fileHandle, const ScanCondition &condition)
+{
+    // Nothing compares to NULL
+    if (condition.value == NULL)
+        return 0;
+
+    double selectivity;
+    switch (condition.compOp)
+    {
+        case EQ_OP: selectivity = RBFM_EQ_SELECTIVITY; break;
+        case NE_OP: selectivity = 1 - RBFM_EQ_SELECTIVITY; break;
+        case NO_OP: return 1;
+        default: selectivity = RBFM_RANGE_SELECTIVITY;
+    }
+
+    RecordFile *file = findRecordFile(fileHandle);
+    if (file == NULL || !file->hasZoneMap || condition.attrIndex >= file->zoneColumns)
+        return selectivity;
+    unsigned pages = fileHandle.getNumberOfPages();
+    unsigned step = max(1u, pages / RBFM_SELECTIVITY_SAMPLE);
+    unsigned sampled = 0;
+    unsigned mayMatch = 0;
+    for (PageNum p = 1; p < pages; p += step)
+    {
+        if (isFreeSpaceMapPage(p))
+            continue;
+        sampled++;
+        if (pageMayMatch(fileHandle, p, condition.attrIndex, condition.type, condition.compOp, condition.value))
+            mayMatch++;
+    }
+    if (sampled > 0)
+        selectivity *= (double) mayMatch / sampled;
+    return selectivity;
+}
+
+// Whether data page pageNum may hold a record whose attribute attrIndex satisfies compOp and value
+bool RecordBasedFileManager::pageMayMatch(FileHandle &fileHandle, PageNum pageNum, unsigned attrIndex, AttrType type, CompOp compOp, const void *value)
+{
+    RecordFile *file = findRecordFile(fileHandle);
+    if (file == NULL || !file->hasZoneMap || attrIndex >= file->zoneColumns)
+        return true;
+
+    // Pages past the end of the zone file were never summarized
+    unsigned entriesPerPage = PAGE_SIZE / (file->zoneColumns * sizeof(ColumnZone));
+    PageNum zonePageNum = 1 + pageNum / entriesPerPage;
+    if (zonePageNum >= file->zoneHandle.getNumberOfPages())
+        return true;
+
+    void *zonePage;
+    if (_bp_manager->pinPage(file->zoneHandle, zonePageNum, zonePage))
+        return true;
+    ColumnZone zone = ((ColumnZone*) zonePage)[(pageNum % entriesPerPage) * file->zoneColumns + attrIndex];
+    _bp_manager->unpinPage(file->zoneHandle, zonePageNum, false);
+
+    if (zone.state == ZONE_UNKNOWN)
+        return true;
+    if (zone.state == ZONE_EMPTY)
+        return false;
+
+    // A varchar prefix only bounds the strings, so equal prefixes can't rule anything out
+    char key[ZONE_PREFIX_SIZE];
+    if (type == TypeVarChar)
+    {
+        uint32_t len;
+        memcpy(&len, value, VARCHAR_LENGTH_SIZE);
+        makeZoneKey(type, (const char*) value + VARCHAR_LENGTH_SIZE, len, key);
+    }
+    else
+        makeZoneKey(type, (const char*) value, INT_SIZE, key);
+
+    int vsMin = compareZoneKeys(type, key, zone.min);
+    int vsMax = compareZoneKeys(type, key, zone.max);
+    switch (compOp)
+    {
+        case EQ_OP: return vsMin >= 0 && vsMax <= 0;
+        case LT_OP: return type == TypeVarChar ? vsMin >= 0 : vsMin > 0;
+        case LE_OP: return vsMin >= 0;
+        case GT_OP: return type == TypeVarChar ? vsMax <= 0 : vsMax < 0;
+        case GE_OP: return vsMax <= 0;
+        case NE_OP: return type == TypeVarChar || vsMin != 0 || vsMax != 0;
+        default: return true;
+    }
+}
+
+// Toast file helpers. Page 0 of the toast file holds the first free page, 0 when there is none.
+// Free pages are linked through the nextPage of their ToastPageHeader.
+
+RC RecordBasedFileManager::openToastFile(RecordFile *file, bool create)
+{
+    string toastName = file->fileName + TOAST_FILE_SUFFIX;
+    if (create && _pf_manager->createFile(toastName))
+        return RBFM_CREATE_FAILED;
+    if (_pf_manager->openFile(toastName, file->toastHandle))
+        return RBFM_OPEN_FAILED;
+
+    if (create)
+    {
+        void *header = calloc(PAGE_SIZE, 1);
+        if (header == NULL)
+        {
+            _pf_manager->closeFile(file->toastHandle);
+            return RBFM_MALLOC_FAILED;
+        }
+        RC rc = file->toastHandle.appendPage(header);
+        free(header);
+        if (rc)
+        {
+            _pf_manager->closeFile(file->toastHandle);
+            return RBFM_APPEND_FAILED;
+        }
+    }
+    file->hasToast = true;
+    return SUCCESS;
+}
+
+// Take a page off the free list, or add one to the file. The page comes back pinned.
+RC RecordBasedFileManager::allocateToastPage(RecordFile *file, PageNum &pageNum, void *&pageData)
+{
+    void *header;
+    if (_bp_manager->pinPage(file->toastHandle, 0, header))
+        return RBFM_READ_FAILED;
+    uint32_t freePage;
+    memcpy(&freePage, header, sizeof(uint32_t));
+
+    if (freePage != 0)
+    {
+        if (_bp_manager->pinPage(file->toastHandle, freePage, pageData))
+        {
+            _bp_manager->unpinPage(file->toastHandle, 0, false);
+            return RBFM_READ_FAILED;
+        }
+        ToastPageHeader pageHeader;
+        memcpy(&pageHeader, pageData, sizeof(ToastPageHeader));
+        memcpy(header, &pageHeader.nextPage, sizeof(uint32_t));
+        _bp_manager->unpinPage(file->toastHandle, 0, true);
+        pageNum = freePage;
+        return SUCCESS;
+    }
+    _bp_manager->unpinPage(file->toastHandle, 0, false);
+
+    void *emptyPage = calloc(PAGE_SIZE, 1);
+    if (emptyPage == NULL)
+        return RBFM_MALLOC_FAILED;
+    RC rc = file->toastHandle.appendPage(emptyPage);
+    free(emptyPage);
+    if (rc)
+        return RBFM_APPEND_FAILED;
+    pageNum = file->toastHandle.getNumberOfPages() - 1;
+    if (_bp_manager->pinPage(file->toastHandle, pageNum, pageData))
+        return RBFM_READ_FAILED;
+    return SUCCESS;
+}
+
+// Write a value to a chain of toast pages. The chain is written back to front so every page
+// knows the one after it.
+RC RecordBasedFileManager::writeToastValue(RecordFile *file, const char *value, uint32_t length, ToastPointer &pointer)
+{
+    const unsigned chunkSize = PAGE_SIZE - sizeof(ToastPageHeader);
+    unsigned chunks = (length + chunkSize - 1) / chunkSize;
+
+    ToastPageHeader pageHeader;
+    pageHeader.nextPage = 0;
+    for (unsigned i = chunks; i-- > 0; )
+    {
+        PageNum pageNum;
+        void *pageData;
+        RC rc = allocateToastPage(file, pageNum, pageData);
+        if (rc)
+            return rc;
+        pageHeader.used = min(chunkSize, length - i * chunkSize);
+        memcpy(pageData, &pageHeader, sizeof(ToastPageHeader));
+        memcpy((char*) pageData + sizeof(ToastPageHeader), value + i * chunkSize, pageHeader.used);
+        _bp_manager->unpinPage(file->toastHandle, pageNum, true);
+        pageHeader.nextPage = pageNum;
+    }
+
+    pointer.firstPage = pageHeader.nextPage;
+    pointer.length = length;
+    memset(pointer.prefix, 0, ZONE_PREFIX_SIZE);
+    memcpy(pointer.prefix, value, min(length, (uint32_t) ZONE_PREFIX_SIZE));
+    return SUCCESS;
+}
+
+// Fetch the value whose ToastPointer is at field
+RC RecordBasedFileManager::readToastValue(FileHandle &fileHandle, const char *field, string &value)
+{
+    RecordFile *file = findRecordFile(fileHandle);
+    if (file == NULL || !file->hasToast)
+        return RBFM_READ_FAILED;
+
+    ToastPointer pointer;
+    memcpy(&pointer, field, sizeof(ToastPointer));
+    value.clear();
+    value.reserve(pointer.length);
+    for (PageNum pageNum = pointer.firstPage; pageNum != 0 && value.size() < pointer.length; )
+    {
+        void *pageData;
+        if (_bp_manager->pinPage(file->toastHandle, pageNum, pageData))
+            return RBFM_READ_FAILED;
+        ToastPageHeader pageHeader;
+        memcpy(&pageHeader, pageData, sizeof(ToastPageHeader));
+        value.append((char*) pageData + sizeof(ToastPageHeader), pageHeader.used);
+        _bp_manager->unpinPage(file->toastHandle, pageNum, false);
+        pageNum = pageHeader.nextPage;
+    }
+    return value.size() == pointer.length ? SUCCESS : RBFM_READ_FAILED;
+}
+
+// Put the chain of a value at the head of the free list
+RC RecordBasedFileManager::freeToastValue(RecordFile *file, const ToastPointer &pointer)
+{
+    void *header;
+    if (_bp_manager->pinPage(file->toastHandle, 0, header))
+        return RBFM_READ_FAILED;
+    uint32_t freePage;
+    memcpy(&freePage, header, sizeof(uint32_t));
+
+    // The last page of the chain links to the old head
+    for (PageNum pageNum = pointer.firstPage; pageNum != 0; )
+    {
+        void *pageData;
+        if (_bp_manager->pinPage(file->toastHandle, pageNum, pageData))
+        {
+            _bp_manager->unpinPage(file->toastHandle, 0, false);
+            return RBFM_READ_FAILED;
+        }
+        ToastPageHeader pageHeader;
+        memcpy(&pageHeader, pageData, sizeof(ToastPageHeader));
+        bool last = pageHeader.nextPage == 0;
+        if (last)
+        {
+            pageHeader.nextPage = freePage;
+            memcpy(pageData, &pageHeader, sizeof(ToastPageHeader));
+        }
+        _bp_manager->unpinPage(file->toastHandle, pageNum, last);
+        pageNum = last ? 0 : pageHeader.nextPage;
+    }
+
+    memcpy(header, &pointer.firstPage, sizeof(uint32_t));
+    _bp_manager->unpinPage(file->toastHandle, 0, true);
+    return SUCCESS;
+}
+
+// Add the ToastPointers of the stored record at "record" to pointers
+void RecordBasedFileManager::getRecordToast(const char *record, vector<ToastPointer> &pointers)
+{
+    RecordLength n;
+    memcpy(&n, record, sizeof(RecordLength));
+    n &= ~RBFM_FIXED_RECORD;
+    for (unsigned i = 0; i < n; i++)
+    {
+        const char *field;
+        uint32_t len;
+        if (!isToastedField(record, i) || !getRecordField(record, i, field, len))
+            continue;
+        ToastPointer pointer;
+        memcpy(&pointer, field, sizeof(ToastPointer));
+        pointers.push_back(pointer);
+    }
+}
+
+// Free the values a stored record keeps out of line, for when it is deleted
+RC RecordBasedFileManager::freeRecordToast(FileHandle &fileHandle, const char *record)
+{
+    RecordFile *file = findRecordFile(fileHandle);
+    if (file == NULL || !file->hasToast)
+        return SUCCESS;
+
+    vector<ToastPointer> pointers;
+    getRecordToast(record, pointers);
+    for (unsigned i = 0; i < pointers.size(); i++)
+    {
+        RC rc = freeToastValue(file, pointers[i]);
+        if (rc)
+            return rc;
+    }
+    return SUCCESS;
+}
+
+// Free the values toastRecord moved out of line for data, given the toasted copy it made, for when
+// that copy is never stored. Values data already had out of line are left be.
+RC RecordBasedFileManager::freeRecordToast(FileHandle &fileHandle, const vector<Attribute> &recordDescriptor, const void *data, const void *toasted)
+{
+    RecordFile *file = findRecordFile(fileHandle);
+    if (file == NULL || !file->hasToast)
+        return SUCCESS;
+
+    int nullIndicatorSize = getNullIndicatorSize(recordDescriptor.size());
+    unsigned offset = nullIndicatorSize;
+    unsigned toastedOffset = nullIndicatorSize;
+    for (unsigned i = 0; i < recordDescriptor.size(); i++)
+    {
+        if (fieldIsNull((char*) data, i))
+            continue;
+        if (recordDescriptor[i].type != TypeVarChar)
+        {
+            offset += INT_SIZE;
+            toastedOffset += INT_SIZE;
+            continue;
+        }
+        uint32_t varcharSize, toastedSize;
+        memcpy(&varcharSize, (char*) data + offset, VARCHAR_LENGTH_SIZE);
+        memcpy(&toastedSize, (char*) toasted + toastedOffset, VARCHAR_LENGTH_SIZE);
+        if ((toastedSize & RBFM_TOASTED_LENGTH) && !(varcharSize & RBFM_TOASTED_LENGTH))
+        {
+            ToastPointer pointer;
+            memcpy(&pointer, (char*) toasted + toastedOffset + VARCHAR_LENGTH_SIZE, sizeof(ToastPointer));
+            RC rc = freeToastValue(file, pointer);
+            if (rc)
+                return rc;
+        }
+        offset += VARCHAR_LENGTH_SIZE + (varcharSize & ~RBFM_TOASTED_LENGTH);
+        toastedOffset += VARCHAR_LENGTH_SIZE + (toastedSize & ~RBFM_TOASTED_LENGTH);
+    }
+    return SUCCESS;
+}
+
+// Move the largest varchar values of a record in the insertRecord() format out of line until it comes
+// to RBFM_TOAST_RECORD_SIZE bytes, or nothing is left worth moving. toasted gets a malloc'd copy of the
+// record with ToastPointers in their place and recordSize its new size, or NULL if nothing moved.
+RC RecordBasedFileManager::toastRecord(FileHandle &fileHandle, const vector<Attribute> &recordDescriptor, const void *data, unsigned &recordSize, void *&toasted)
+{
+    toasted = NULL;
+    RecordFile *file = findRecordFile(fileHandle);
+    if (file == NULL)
+        return SUCCESS;
+
+    // Where every field starts in data, and which varchars are worth moving
+    int nullIndicatorSize = getNullIndicatorSize(recordDescriptor.size());
+    vector<unsigned> fieldOffsets(recordDescriptor.size(), 0);
+    vector<pair<uint32_t, unsigned> > candidates;
+    unsigned offset = nullIndicatorSize;
+    for (unsigned i = 0; i < recordDescriptor.size(); i++)
+    {
+        fieldOffsets[i] = offset;
+        if (fieldIsNull((char*) data, i))
+            continue;
+        if (recordDescriptor[i].type != TypeVarChar)
+        {
+            offset += INT_SIZE;
+            continue;
+        }
+        uint32_t varcharSize;
+        memcpy(&varcharSize, (char*) data + offset, VARCHAR_LENGTH_SIZE);
+        offset += VARCHAR_LENGTH_SIZE + (varcharSize & ~RBFM_TOASTED_LENGTH);
+        if (!(varcharSize & RBFM_TOASTED_LENGTH) && varcharSize > sizeof(ToastPointer))
+            candidates.push_back(make_pair(varcharSize, i));
+    }
+    unsigned dataSize = offset;
+
+    // Largest first
+    sort(candidates.rbegin(), candidates.rend());
+    vector<bool> moving(recordDescriptor.size(), false);
+    unsigned newSize = recordSize;
+    unsigned moved = 0;
+    for (; moved < candidates.size() && newSize > RBFM_TOAST_RECORD_SIZE; moved++)
+    {
+        newSize -= candidates[moved].first - sizeof(ToastPointer);
+        moving[candidates[moved].second] = true;
+    }
+    if (moved == 0)
+        return SUCCESS;
+    if (sizeof(SlotDirectoryHeader) + sizeof(SlotDirectoryRecordEntry) + newSize > PAGE_SIZE)
+        return RBFM_RECORD_TOO_BIG;
 
-    // Keeps track of the offset of each record
-    // Offset is relative to the start of the record and points to the END of a field
-    ColumnOffset rec_offset = header_offset + (recordDescriptor.size()) * sizeof(ColumnOffset);
+    if (!file->hasToast)
+    {
+        RC rc = openToastFile(file, true);
+        if (rc)
+            return rc;
+    }
+    char *record = (char*) malloc(dataSize);
+    if (record == NULL)
+        return RBFM_MALLOC_FAILED;
 
-    unsigned i = 0;
-    for (i = 0; i < recordDescriptor.size(); i++)
+    // Copy the record over, writing out the values that move as we go
+    vector<ToastPointer> written;
+    memcpy(record, data, nullIndicatorSize);
+    unsigned out = nullIndicatorSize;
+    for (unsigned i = 0; i < recordDescriptor.size(); i++)
     {
-        if (!fieldIsNull(nullIndicator, i))
+        if (fieldIsNull((char*) data, i))
+            continue;
+        const char *field = (char*) data + fieldOffsets[i];
+        unsigned fieldSize = INT_SIZE;
+        if (recordDescriptor[i].type == TypeVarChar)
         {
-            // Points to current position in *data
-            char *data_start = (char*) data + data_offset;
+            uint32_t varcharSize;
+            memcpy(&varcharSize, field, VARCHAR_LENGTH_SIZE);
+            fieldSize = VARCHAR_LENGTH_SIZE + (varcharSize & ~RBFM_TOASTED_LENGTH);
+        }
+        if (!moving[i])
+        {
+            memcpy(record + out, field, fieldSize);
+            out += fieldSize;
+            continue;
+        }
 
-            // Read in the data for the next column, point rec_offset to end of newly inserted data
-            switch (recordDescriptor[i].type)
-            {
-                case TypeInt:
-                    memcpy (start + rec_offset, data_start, INT_SIZE);
-                    rec_offset += INT_SIZE;
-                    data_offset += INT_SIZE;
-                break;
-                case TypeReal:
-                    memcpy (start + rec_offset, data_start, REAL_SIZE);
-                    rec_offset += REAL_SIZE;
-                    data_offset += REAL_SIZE;
-                break;
-                case TypeVarChar:
-                    unsigned varcharSize;
-                    // We have to get the size of the VarChar field by reading the integer that precedes the string value itself
-                    memcpy(&varcharSize, data_start, VARCHAR_LENGTH_SIZE);
-                    memcpy(start + rec_offset, data_start + VARCHAR_LENGTH_SIZE, varcharSize);
-                    // We also have to account for the overhead given by that integer.
-                    rec_offset += varcharSize;
-                    data_offset += VARCHAR_LENGTH_SIZE + varcharSize;
-                break;
-            }
+        ToastPointer pointer;
+        RC rc = writeToastValue(file, field + VARCHAR_LENGTH_SIZE, fieldSize - VARCHAR_LENGTH_SIZE, pointer);
+        if (rc)
+        {
+            // Let go of the values this record already wrote out
+            for (unsigned j = 0; j < written.size(); j++)
+                freeToastValue(file, written[j]);
+            free(record);
+            return rc;
         }
-        // Copy offset into record header
-        // Offset is relative to the start of the record and points to END of field
-        memcpy(start + header_offset, &rec_offset, sizeof(ColumnOffset));
-        header_offset += sizeof(ColumnOffset);
+        written.push_back(pointer);
+        uint32_t varcharSize = sizeof(ToastPointer) | RBFM_TOASTED_LENGTH;
+        memcpy(record + out, &varcharSize, VARCHAR_LENGTH_SIZE);
+        memcpy(record + out + VARCHAR_LENGTH_SIZE, &pointer, sizeof(ToastPointer));
+        out += VARCHAR_LENGTH_SIZE + sizeof(ToastPointer);
     }
+
+    recordSize = newSize;
+    toasted = record;
+    return SUCCESS;
 }
 
-void RecordBasedFileManager::getRecordAtOffset(void *page, int32_t offset, const vector<Attribute> &recordDescriptor, void *data)
+// Replace the ToastPointers of a record in the insertRecord() format with the values they point at.
+// data must have room for the whole record, size gets its size.
+RC RecordBasedFileManager::detoastRecord(FileHandle &fileHandle, const vector<Attribute> &recordDescriptor, void *data, unsigned &size)
 {
-    // Pointer to start of record
-    char *start = (char*) page + offset;
-
-    // Allocate space for null indicator. The returned null indicator may be larger than
-    // the null indicator in the table has had fields added to it
     int nullIndicatorSize = getNullIndicatorSize(recordDescriptor.size());
-    char nullIndicator[nullIndicatorSize];
-    memset(nullIndicator, 0, nullIndicatorSize);
-
-    // Get number of columns and size of the null indicator for this record
-    RecordLength len = 0;
-    memcpy (&len, (char*)page + offset, sizeof(RecordLength));
-    int recordNullIndicatorSize = getNullIndicatorSize(len);
+    unsigned offset = nullIndicatorSize;
+    for (unsigned i = 0; i < recordDescriptor.size(); i++)
+    {
+        if (fieldIsNull((char*) data, i))
+            continue;
+        if (recordDescriptor[i].type != TypeVarChar)
+        {
+            offset += INT_SIZE;
+            continue;
+        }
+        uint32_t varcharSize;
+        memcpy(&varcharSize, (char*) data + offset, VARCHAR_LENGTH_SIZE);
+        offset += VARCHAR_LENGTH_SIZE + (varcharSize & ~RBFM_TOASTED_LENGTH);
+    }
 
-    // Read in the existing null indicator
-    memcpy (nullIndicator, start + sizeof(RecordLength), nullIndicatorSize);
+    // Values are read from a copy, as the ones that come before them grow in place
+    char *record = (char*) malloc(offset);
+    if (record == NULL)
+        return RBFM_MALLOC_FAILED;
+    memcpy(record, data, offset);
 
-    // If this new recordDescriptor has had fields added to it, we set all of the new fields to null
-    for (unsigned i = len; i < recordDescriptor.size(); i++)
+    RC rc = SUCCESS;
+    unsigned in = nullIndicatorSize;
+    size = nullIndicatorSize;
+    for (unsigned i = 0; i < recordDescriptor.size() && rc == SUCCESS; i++)
     {
-        int indicatorIndex = (i+1) / CHAR_BIT;
-        int indicatorMask  = 1 << (CHAR_BIT - 1 - (i % CHAR_BIT));
-        nullIndicator[indicatorIndex] |= indicatorMask;
+        if (fieldIsNull(record, i))
+            continue;
+        unsigned fieldSize = INT_SIZE;
+        uint32_t varcharSize = 0;
+        if (recordDescriptor[i].type == TypeVarChar)
+        {
+            memcpy(&varcharSize, record + in, VARCHAR_LENGTH_SIZE);
+            fieldSize = VARCHAR_LENGTH_SIZE + (varcharSize & ~RBFM_TOASTED_LENGTH);
+        }
+        if (!(varcharSize & RBFM_TOASTED_LENGTH))
+        {
+            memcpy((char*) data + size, record + in, fieldSize);
+            size += fieldSize;
+            in += fieldSize;
+            continue;
+        }
+
+        string value;
+        rc = readToastValue(fileHandle, record + in + VARCHAR_LENGTH_SIZE, value);
+        uint32_t length = value.size();
+        memcpy((char*) data + size, &length, VARCHAR_LENGTH_SIZE);
+        memcpy((char*) data + size + VARCHAR_LENGTH_SIZE, value.data(), length);
+        size += VARCHAR_LENGTH_SIZE + length;
+        in += fieldSize;
     }
-    // Write out null indicator
-    memcpy(data, nullIndicator, nullIndicatorSize);
+    free(record);
+    return rc;
+}
 
-    // Initialize some offsets
-    // rec_offset: points to data in the record. We move this forward as we read data from our record
-    unsigned rec_offset = sizeof(RecordLength) + recordNullIndicatorSize + len * sizeof(ColumnOffset);
-    // data_offset: points to our current place in the output data. We move this forward as we write data to data.
-    unsigned data_offset = nullIndicatorSize;
-    // directory_base: points to the start of our directory of indices
-    char *directory_base = start + sizeof(RecordLength) + recordNullIndicatorSize;
-    
+// Page dictionary helpers. Codes are entry numbers, an entry is never dropped while a record on the
+// page may hold its code.
+
+// Code the varchars of a record in the insertRecord() format that its file keeps dictionaries for, against
+// the dictionary of page. Values not in the dictionary yet are added to it as long as the record still fits:
+// once the dictionary has grown, the page's free space plus freed must hold the coded record and a slot.
+// coded gets a malloc'd copy of the record with codes in place of those values and recordSize its new
+// size, or NULL if nothing was coded.
+RC RecordBasedFileManager::codeRecord(FileHandle &fileHandle, const vector<Attribute> &recordDescriptor, void *page, const void *data,
+                                      unsigned freed, void *&coded, unsigned &recordSize)
+{
+    coded = NULL;
+    RecordFile *file = findRecordFile(fileHandle);
+    if (file == NULL || file->dictionaryColumns.empty())
+        return SUCCESS;
+
+    // Where every field starts in data
+    int nullIndicatorSize = getNullIndicatorSize(recordDescriptor.size());
+    vector<unsigned> fieldOffsets(recordDescriptor.size() + 1, 0);
+    unsigned offset = nullIndicatorSize;
     for (unsigned i = 0; i < recordDescriptor.size(); i++)
     {
-        if (fieldIsNull(nullIndicator, i))
+        fieldOffsets[i] = offset;
+        if (fieldIsNull((char*) data, i))
+            continue;
+        uint32_t fieldSize = INT_SIZE;
+        if (recordDescriptor[i].type == TypeVarChar)
+        {
+            memcpy(&fieldSize, (char*) data + offset, VARCHAR_LENGTH_SIZE);
+            fieldSize = VARCHAR_LENGTH_SIZE + (fieldSize & ~RBFM_LENGTH_FLAGS);
+        }
+        offset += fieldSize;
+    }
+    fieldOffsets[recordDescriptor.size()] = offset;
+
+    unsigned space = getPageFreeSpaceSize(page) + freed;
+    unsigned growth = 0;
+    unsigned newSize = recordSize;
+    vector<int> codes(recordDescriptor.size(), -1);
+    bool anyCoded = false;
+    for (unsigned c = 0; c < file->dictionaryColumns.size(); c++)
+    {
+        unsigned i = file->dictionaryColumns[c];
+        if (i >= recordDescriptor.size() || recordDescriptor[i].type != TypeVarChar || fieldIsNull((char*) data, i))
+            continue;
+        const char *value = (char*) data + fieldOffsets[i] + VARCHAR_LENGTH_SIZE;
+        uint32_t len;
+        memcpy(&len, value - VARCHAR_LENGTH_SIZE, VARCHAR_LENGTH_SIZE);
+        if ((len & RBFM_LENGTH_FLAGS) || len < 2 || len > RBFM_DICTIONARY_VALUE_SIZE)
             continue;
-        
-        // Grab pointer to end of this column
-        ColumnOffset endPointer;
-        memcpy(&endPointer, directory_base + i * sizeof(ColumnOffset), sizeof(ColumnOffset));
 
-        // rec_offset keeps track of start of column, so end-start = total size
-        uint32_t fieldSize = endPointer - rec_offset;
+        int code = findDictionaryCode(page, value, len);
+        if (code < 0)
+        {
+            // A new entry takes its bytes and its end offset
+            unsigned cost = sizeof(uint16_t) + len;
+            if (getSlotDirectoryHeader(page).dictionaryEntries >= RBFM_DICTIONARY_ENTRIES ||
+                space < growth + cost + sizeof(SlotDirectoryRecordEntry) + newSize - (len - 1))
+                continue;
+            code = addDictionaryEntry(page, value, len);
+            growth += cost;
+        }
+        codes[i] = code;
+        newSize -= len - 1;
+        anyCoded = true;
+    }
+    if (!anyCoded)
+        return SUCCESS;
 
-        // Special case for varchar, we must give data the size of varchar first
-        if (recordDescriptor[i].type == TypeVarChar)
+    char *record = (char*) malloc(offset);
+    if (record == NULL)
+        return RBFM_MALLOC_FAILED;
+    memcpy(record, data, nullIndicatorSize);
+    unsigned out = nullIndicatorSize;
+    for (unsigned i = 0; i < recordDescriptor.size(); i++)
+    {
+        const char *field = (char*) data + fieldOffsets[i];
+        if (codes[i] < 0)
         {
-            memcpy((char*) data + data_offset, &fieldSize, VARCHAR_LENGTH_SIZE);
-            data_offset += VARCHAR_LENGTH_SIZE;
+            unsigned fieldSize = fieldOffsets[i + 1] - fieldOffsets[i];
+            memcpy(record + out, field, fieldSize);
+            out += fieldSize;
+            continue;
         }
-        // Next we copy bytes equal to the size of the field and increase our offsets
-        memcpy((char*) data + data_offset, start + rec_offset, fieldSize);
-        rec_offset += fieldSize;
-        data_offset += fieldSize;
+        uint32_t varcharSize = 1 | RBFM_CODED_LENGTH;
+        memcpy(record + out, &varcharSize, VARCHAR_LENGTH_SIZE);
+        record[out + VARCHAR_LENGTH_SIZE] = (uint8_t) codes[i];
+        out += VARCHAR_LENGTH_SIZE + 1;
     }
+
+    recordSize = newSize;
+    coded = record;
+    return SUCCESS;
 }
 
-SlotStatus RecordBasedFileManager::getSlotStatus(SlotDirectoryRecordEntry slot)
+// Entry number of value in the dictionary of page, -1 if it isn't there
+int RecordBasedFileManager::findDictionaryCode(void *page, const char *value, uint32_t len)
 {
-    if (slot.length == 0 && slot.offset == 0)
-        return DEAD;
-    if (slot.offset <= 0)
-        return MOVED;
-    return VALID;
+    SlotDirectoryHeader header = getSlotDirectoryHeader(page);
+    for (unsigned code = 0; code < header.dictionaryEntries; code++)
+    {
+        const char *entry;
+        uint32_t entryLen;
+        getDictionaryValue(page, code, entry, entryLen);
+        if (entryLen == len && memcmp(entry, value, len) == 0)
+            return code;
+    }
+    return -1;
 }
 
-// Get first unused slot in page. Slot is considered unused if dead
-// If not dead slots returns recordEntriesNumber
-unsigned RecordBasedFileManager::getOpenSlot(void *page)
+// Add value to the dictionary of page, which must have room for it, and return its code.
+// The dictionary grows down into the page, so the records move down to make room.
+unsigned RecordBasedFileManager::addDictionaryEntry(void *page, const char *value, uint32_t len)
 {
     SlotDirectoryHeader header = getSlotDirectoryHeader(page);
-    unsigned i;
-    for (i = 0; i < header.recordEntriesNumber; i++)
+    unsigned start = header.dictionaryOffset != 0 ? header.dictionaryOffset : PAGE_SIZE;
+    unsigned entries = header.dictionaryEntries;
+    unsigned oldSize = PAGE_SIZE - start;
+    unsigned newSize = oldSize + sizeof(uint16_t) + len;
+
+    // Every entry moves up by the new end offset, the new entry goes last
+    char dictionary[newSize];
+    const char *old = (char*) page + start;
+    for (unsigned i = 0; i < entries; i++)
+    {
+        uint16_t end;
+        memcpy(&end, old + i * sizeof(uint16_t), sizeof(uint16_t));
+        end += sizeof(uint16_t);
+        memcpy(dictionary + i * sizeof(uint16_t), &end, sizeof(uint16_t));
+    }
+    uint16_t end = newSize;
+    memcpy(dictionary + entries * sizeof(uint16_t), &end, sizeof(uint16_t));
+    memcpy(dictionary + (entries + 1) * sizeof(uint16_t), old + entries * sizeof(uint16_t), oldSize - entries * sizeof(uint16_t));
+    memcpy(dictionary + newSize - len, value, len);
+
+    unsigned delta = newSize - oldSize;
+    memmove((char*) page + header.freeSpaceOffset - delta, (char*) page + header.freeSpaceOffset, start - header.freeSpaceOffset);
+    for (unsigned i = 0; i < header.recordEntriesNumber; i++)
     {
         SlotDirectoryRecordEntry recordEntry = getSlotDirectoryRecordEntry(page, i);
-        SlotStatus status = getSlotStatus(recordEntry);
-        if (status == DEAD)
-            return i;
+        if (getSlotStatus(recordEntry) != VALID)
+            continue;
+        recordEntry.offset -= delta;
+        setSlotDirectoryRecordEntry(page, i, recordEntry);
     }
-    return i;
+    header.freeSpaceOffset -= delta;
+    header.dictionaryOffset = PAGE_SIZE - newSize;
+    header.dictionaryEntries = entries + 1;
+    setSlotDirectoryHeader(page, header);
+    memcpy((char*) page + header.dictionaryOffset, dictionary, newSize);
+    return entries;
 }
 
-// Mark slot header as dead (all 0s)
-void RecordBasedFileManager::markSlotDeleted(void *page, unsigned i)
+// Point value at the entry code stands for in the dictionary of page
+void RecordBasedFileManager::getDictionaryValue(void *page, unsigned code, const char *&value, uint32_t &len)
 {
-    memset  (
-            ((char*) page + sizeof(SlotDirectoryHeader) + i * sizeof(SlotDirectoryRecordEntry)),
-            0,
-            sizeof(SlotDirectoryRecordEntry)
-            );
+    SlotDirectoryHeader header = getSlotDirectoryHeader(page);
+    const char *dictionary = (char*) page + header.dictionaryOffset;
+    uint16_t start = header.dictionaryEntries * sizeof(uint16_t);
+    uint16_t end;
+    if (code > 0)
+        memcpy(&start, dictionary + (code - 1) * sizeof(uint16_t), sizeof(uint16_t));
+    memcpy(&end, dictionary + code * sizeof(uint16_t), sizeof(uint16_t));
+    value = dictionary + start;
+    len = end - start;
 }
 
-// Consolidates free space in center of page
-void RecordBasedFileManager::reorganizePage(void *page)
+// Once no record is left on a page, nothing holds a code and its dictionary can go
+void RecordBasedFileManager::dropEmptyDictionary(void *page)
 {
     SlotDirectoryHeader header = getSlotDirectoryHeader(page);
-
-    // Add all live records to vector, keeping track of slot numbers
-    vector<IndexedRecordEntry> liveRecords;
+    if (header.dictionaryOffset == 0)
+        return;
     for (unsigned i = 0; i < header.recordEntriesNumber; i++)
     {
-        IndexedRecordEntry entry;
-        entry.slotNum = i;
-        entry.recordEntry = getSlotDirectoryRecordEntry(page, i);
-        if (getSlotStatus(entry.recordEntry) == VALID)
-            liveRecords.push_back(entry);
+        if (getSlotStatus(getSlotDirectoryRecordEntry(page, i)) == VALID)
+            return;
     }
-    // Sort records by offset, descending
-    auto comp = [](IndexedRecordEntry first, IndexedRecordEntry second) 
-        {return first.recordEntry.offset > second.recordEntry.offset;};
-    sort(liveRecords.begin(), liveRecords.end(), comp);
+    header.freeSpaceOffset = PAGE_SIZE;
+    header.dictionaryOffset = 0;
+    header.dictionaryEntries = 0;
+    setSlotDirectoryHeader(page, header);
+}
 
-    // Move each record back filling in any gap preceding the record
-    uint16_t pageOffset = PAGE_SIZE;
-    SlotDirectoryRecordEntry current;
-    for (unsigned i = 0; i < liveRecords.size(); i++)
-    {
-        current = liveRecords[i].recordEntry;
-        pageOffset -= current.length;
+// PAX page helpers, see PAX_LAYOUT
+bool RecordBasedFileManager::isPaxPage(void *page)
+{
+    return getSlotDirectoryHeader(page).paxColumns != 0;
+}
 
-        // Use memmove rather than memcpy because locations may overlap
-        memmove((char*)page + pageOffset, (char*)page + current.offset, current.length);
-        current.offset = pageOffset;
-        setSlotDirectoryRecordEntry(page, liveRecords[i].slotNum, current);
-    }
-    header.freeSpaceOffset = pageOffset;
-    setSlotDirectoryHeader(page, header);
+// Where the null indicators of the rows of a PAX page start, right after its slot directory
+unsigned RecordBasedFileManager::getPaxNullOffset(const SlotDirectoryHeader &header)
+{
+    return sizeof(SlotDirectoryHeader) + header.paxRows * sizeof(SlotDirectoryRecordEntry);
 }
 
-void RecordBasedFileManager::getAttributeFromRecord(void *page, unsigned offset, unsigned attrIndex, AttrType type, void *data)
+// Where the minipage of column index starts. The minipages follow the null indicators, 4 byte aligned.
+unsigned RecordBasedFileManager::getPaxColumnOffset(const SlotDirectoryHeader &header, unsigned index)
 {
-    char *start = (char*)page + offset;
-    unsigned data_offset = 0;
+    unsigned nullsEnd = getPaxNullOffset(header) + header.paxRows * getNullIndicatorSize(header.paxColumns);
+    return (nullsEnd + INT_SIZE - 1) / INT_SIZE * INT_SIZE + index * header.paxRows * INT_SIZE;
+}
 
-    // Get number of columns
-    RecordLength n;
-    memcpy (&n, start, sizeof(RecordLength));
+// Like getRecordField, for the row of a PAX page whose null indicator is at "record"
+bool RecordBasedFileManager::getPaxField(void *page, const char *record, unsigned index, const char *&field, uint32_t &len)
+{
+    SlotDirectoryHeader header = getSlotDirectoryHeader(page);
+    if (index >= header.paxColumns || fieldIsNull((char*) record, index))
+        return false;
+    unsigned row = (record - (char*) page - getPaxNullOffset(header)) / getNullIndicatorSize(header.paxColumns);
+    field = (char*) page + getPaxColumnOffset(header, index) + row * INT_SIZE;
+    len = INT_SIZE;
+    return true;
+}
 
-    // Get null indicator
-    int recordNullIndicatorSize = getNullIndicatorSize(n);
-    char recordNullIndicator[recordNullIndicatorSize];
-    memcpy (recordNullIndicator, start + sizeof(RecordLength), recordNullIndicatorSize);
+// Spread a record in the insertRecord() format over the minipages of the row whose null indicator is at offset.
+// NULL fields are left 0 in their minipage.
+void RecordBasedFileManager::setPaxRecord(void *page, unsigned offset, const vector<Attribute> &recordDescriptor, const void *data)
+{
+    SlotDirectoryHeader header = getSlotDirectoryHeader(page);
+    unsigned row = (offset - getPaxNullOffset(header)) / getNullIndicatorSize(header.paxColumns);
+    unsigned nullIndicatorSize = getNullIndicatorSize(recordDescriptor.size());
+    memcpy((char*) page + offset, data, nullIndicatorSize);
 
-    // Set null indicator for result
-    char resultNullIndicator = 0;
-    if (fieldIsNull(recordNullIndicator, attrIndex))
-        resultNullIndicator |= (1 << 7);
-    memcpy(data, &resultNullIndicator, 1);
-    data_offset += 1;
-    if (resultNullIndicator) return;
+    const char *value = (const char*) data + nullIndicatorSize;
+    for (unsigned i = 0; i < header.paxColumns; i++)
+    {
+        char *field = (char*) page + getPaxColumnOffset(header, i) + row * INT_SIZE;
+        if (fieldIsNull((char*) data, i))
+        {
+            memset(field, 0, INT_SIZE);
+            continue;
+        }
+        memcpy(field, value, INT_SIZE);
+        value += INT_SIZE;
+    }
+}
 
-    // Now we know the result isn't null, so we grab it
-    unsigned header_offset = sizeof(RecordLength) + recordNullIndicatorSize;
-    // attrEnd points to end of attribute, attrStart points to the beginning
-    // Our directory at the beginning of each record contains pointers to the ends of each attribute,
-    // so we can pull attrEnd from that
-    ColumnOffset attrEnd, attrStart;
-    memcpy(&attrEnd, start + header_offset + attrIndex * sizeof(ColumnOffset), sizeof(ColumnOffset));
-    // The start is either the end of the previous attribute, or the start of the data section of the
-    // record if we are after the 0th attribute
-    if (attrIndex > 0)
-        memcpy(&attrStart, start + header_offset + (attrIndex - 1) * sizeof(ColumnOffset), sizeof(ColumnOffset));
-    else
-        attrStart = header_offset + n * sizeof(ColumnOffset);
-    // The length of any attribute is just the difference between its start and end
-    uint32_t len = attrEnd - attrStart;
-    if (type == TypeVarChar)
+// Gather the row of a PAX page whose null indicator is at offset into the readRecord() format
+void RecordBasedFileManager::getPaxRecord(void *page, unsigned offset, const vector<Attribute> &recordDescriptor, void *data)
+{
+    unsigned nullIndicatorSize = getNullIndicatorSize(recordDescriptor.size());
+    char *nullIndicator = (char*) data;
+    memset(nullIndicator, 0, nullIndicatorSize);
+    char *out = (char*) data + nullIndicatorSize;
+
+    const char *record = (char*) page + offset;
+    for (unsigned i = 0; i < recordDescriptor.size(); i++)
     {
-        // For varchars we have to return this length in the result
-        memcpy((char*)data + data_offset, &len, sizeof(VARCHAR_LENGTH_SIZE));
-        data_offset += VARCHAR_LENGTH_SIZE;
+        const char *field;
+        uint32_t len;
+        if (!getPaxField(page, record, i, field, len))
+        {
+            nullIndicator[i / CHAR_BIT] |= 1 << (CHAR_BIT - 1 - (i % CHAR_BIT));
+            continue;
+        }
+        memcpy(out, field, len);
+        out += len;
     }
-    // For all types, we then copy the data into the result
-    memcpy((char*)data + data_offset, start + attrStart, len);
 }
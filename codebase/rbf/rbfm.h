@@ -3,9 +3,11 @@
 
 #include <string>
 #include <vector>
+#include <unordered_map>
 #include <climits>
 
 #include "../rbf/pfm.h"
+#include "../rbf/bpm.h"
 
 #define INT_SIZE                4
 #define REAL_SIZE               4
@@ -22,6 +24,77 @@
 #define RBFM_SLOT_DN_EXIST  7
 #define RBFM_READ_AFTER_DEL 8
 #define RBFM_NO_SUCH_ATTR   9
+#define RBFM_RECORD_TOO_BIG 10
+#define RBFM_ZONE_MAP_EXISTS 11
+#define RBFM_AGGREGATE_TYPE 12
+#define RBFM_DICTIONARY_EXISTS 13
+#define RBFM_DICTIONARY_TYPE 14
+#define RBFM_LAYOUT_TYPE    15
+#define RBFM_FILE_SCANNED   16
+
+// Free space map: every run of FSM_PAGE_SPAN data pages is preceded by a map page,
+// so page 0 of every record based file is a map page. The map page holds one byte per
+// data page: its free space in units of FSM_BUCKET_SIZE bytes, rounded down.
+#define FSM_PAGE_SPAN       PAGE_SIZE
+#define FSM_BUCKET_SIZE     16
+
+// Pages insertRecords fills in memory before appending them to the file in one go
+#define RBFM_BULK_BATCH_PAGES 64
+
+// Most slots a page can have
+#define RBFM_MAX_SLOTS (PAGE_SIZE / sizeof(SlotDirectoryRecordEntry))
+
+// Default number of pages a scan keeps being read ahead of the page it is on
+#define RBFM_SCAN_READAHEAD 32
+
+// Textbook guesses at the share of records a condition keeps, and the number of pages whose
+// zone map entries are sampled to narrow them down
+#define RBFM_EQ_SELECTIVITY     0.1
+#define RBFM_RANGE_SELECTIVITY  (1.0 / 3)
+#define RBFM_SELECTIVITY_SAMPLE 32
+
+// Zone maps: an optional side file, "<fileName>.zone", that holds the smallest and largest value
+// of every column on every data page. Varchars are summarized by their first ZONE_PREFIX_SIZE bytes.
+// Page 0 holds the number of columns summarized, the entries for the data pages follow in order.
+#define ZONE_FILE_SUFFIX    ".zone"
+#define ZONE_PREFIX_SIZE    8
+
+// TOAST: when a record comes to more than RBFM_TOAST_RECORD_SIZE bytes, its largest varchar values
+// move out of line, one at a time, until it doesn't. They go to chains of pages in a side file,
+// "<fileName>.toast", and the record keeps a ToastPointer in their place, with RBFM_TOASTED_FIELD set
+// in the column directory entry of the field. Page 0 of the side file heads a list of free pages.
+#define TOAST_FILE_SUFFIX       ".toast"
+#define RBFM_TOAST_RECORD_SIZE  (PAGE_SIZE / 4)
+#define RBFM_TOASTED_FIELD      0x8000
+// Inside the record manager, records in the insertRecord() format can carry a ToastPointer in place
+// of a varchar value. Its length is then sizeof(ToastPointer) with RBFM_TOASTED_LENGTH set.
+#define RBFM_TOASTED_LENGTH     0x80000000u
+
+// Dictionaries: varchar columns chosen with createDictionary() are stored as one byte codes into a
+// dictionary kept at the end of each page. The columns are listed in a side file, "<fileName>.dict".
+// A coded field has RBFM_CODED_FIELD set in its column directory entry. Values are coded on the page
+// they are written to, values too short to gain or too long to be worth keeping stay in line.
+#define DICTIONARY_FILE_SUFFIX      ".dict"
+#define RBFM_DICTIONARY_ENTRIES     256
+#define RBFM_DICTIONARY_VALUE_SIZE  255
+#define RBFM_CODED_FIELD            0x4000
+// Inside the record manager, a coded varchar in the insertRecord() format is its one byte code,
+// with RBFM_CODED_LENGTH set in its length
+#define RBFM_CODED_LENGTH           0x40000000u
+
+#define RBFM_FIELD_FLAGS    (RBFM_TOASTED_FIELD | RBFM_CODED_FIELD)
+#define RBFM_LENGTH_FLAGS   (RBFM_TOASTED_LENGTH | RBFM_CODED_LENGTH)
+
+// Fixed width records: the records of a descriptor with no varchars have RBFM_FIXED_RECORD set in their
+// RecordLength and no column directory. Their fields follow the null indicator, 4 bytes each and in
+// descriptor order, with NULL fields kept as 4 zero bytes, so every field sits at the same place in every
+// record. One with no NULLs holds its fields exactly as they are in the insertRecord() format.
+#define RBFM_FIXED_RECORD   0x8000
+
+// PAX pages (PAX_LAYOUT): the slot directory has room for paxRows slots, and slot i always holds row i.
+// The null indicators of the rows follow it, then a minipage for every column: an array of paxRows
+// 4 byte values, so a column of the page reads as one array. A live slot points at the null indicator
+// of its row and its length is the bytes the row takes across the minipages. Rows never move.
 
 using namespace std;
 
@@ -58,12 +131,71 @@ typedef enum
     NO_OP       // no condition
 } CompOp;
 
+// How the records of a file are laid out in its pages, picked when the file is created
+typedef enum
+{
+    SLOTTED_LAYOUT = 0, // whole records packed from the end of the page
+    PAX_LAYOUT          // every column in a minipage of its own, for files of ints and reals only
+} PageLayout;
+
+// How a scan gets at the pages of the file
+typedef enum
+{
+    COPY_SCAN = 0,  // copy each page out of the buffer pool
+    MAPPED_SCAN,    // walk a read-only mapping of the file in place, no per-page copy
+    PARALLEL_SCAN   // split the mapped file between worker threads, see ParallelScan
+} ScanMode;
+
+// One condition of a multi-predicate scan. Predicates with orGroup 0 must all hold. Predicates that
+// share a non-zero orGroup are ORed together, and the group as a whole must hold.
+// For example {a < 5, 0}, {b = 1, 1}, {c = 2, 1} means a < 5 AND (b = 1 OR c = 2).
+typedef struct ScanPredicate
+{
+    string attribute;
+    CompOp compOp;
+    const void *value;
+    unsigned orGroup;
+} ScanPredicate;
+
+// Aggregates computed by RecordBasedFileManager::aggregate
+typedef enum { COUNT_AGG = 0, SUM_AGG, MIN_AGG, MAX_AGG, AVG_AGG } AggregateOp;
+
+// The aggregate over one group of records. Records with a NULL aggregated attribute don't count,
+// so a MIN, MAX or AVG with a count of 0 is NULL.
+typedef struct AggregateGroup
+{
+    string groupValue;   // Bytes of the group attribute: 4 for an int, the characters of a varchar
+    bool groupIsNull;    // The group of records whose group attribute is NULL
+    unsigned count;
+    double value;
+} AggregateGroup;
+
+// A scan predicate with its attribute looked up in the record descriptor
+typedef struct ScanCondition
+{
+    unsigned attrIndex;
+    AttrType type;
+    CompOp compOp;
+    const void *value;
+    double selectivity;
+    int code;   // Code of a varchar value in the dictionary of the page being scanned, -1 if it has none
+} ScanCondition;
+
+// Conditions that are ORed together
+typedef vector<ScanCondition> ScanClause;
+
 // Slot directory headers for page organization
 // See chapter 9.6.2 of the cow book or lecture 3 slide 16 for more information
+// The page's dictionary, if it has one, takes up the end of the page from dictionaryOffset on:
+// the end of every entry, relative to dictionaryOffset, then the entries themselves.
 typedef struct SlotDirectoryHeader
 {
     uint16_t freeSpaceOffset;
     uint16_t recordEntriesNumber;
+    uint16_t dictionaryOffset;      // 0 if the page has no dictionary
+    uint16_t dictionaryEntries;
+    uint16_t paxColumns;            // 0 on a slotted page, see PAX_LAYOUT
+    uint16_t paxRows;
 } SlotDirectoryHeader;
 
 // Assignment 2 tip: Make offset negative to represent a forwarding address
@@ -86,6 +218,63 @@ typedef uint16_t ColumnOffset;
 
 typedef uint16_t RecordLength;
 
+// ZONE_UNKNOWN pages were never summarized, so scans can't rule them out
+typedef enum { ZONE_UNKNOWN = 0, ZONE_EMPTY, ZONE_RANGE } ZoneState;
+
+// Summary of one column on one data page, as stored in the zone file
+typedef struct ColumnZone
+{
+    uint8_t state;
+    char min[ZONE_PREFIX_SIZE];
+    char max[ZONE_PREFIX_SIZE];
+} ColumnZone;
+
+// Where a varchar value stored out of line is. prefix holds its first bytes, for the zone map.
+typedef struct ToastPointer
+{
+    uint32_t firstPage;
+    uint32_t length;
+    char prefix[ZONE_PREFIX_SIZE];
+} ToastPointer;
+
+// Start of every page of a chain in the toast file. nextPage is 0 on the last page.
+typedef struct ToastPageHeader
+{
+    uint32_t nextPage;
+    uint32_t used;
+} ToastPageHeader;
+
+// A record based file opened through RecordBasedFileManager::openFile, with its zone map and
+// toast file if it has them
+typedef struct RecordFile
+{
+    FileId id;
+    string fileName;
+    unsigned refCount;
+    bool hasZoneMap;
+    unsigned zoneColumns;
+    FileHandle zoneHandle;
+    bool hasToast;
+    FileHandle toastHandle;
+    vector<unsigned> dictionaryColumns;
+    // Where every moved record came from, keyed by the page and slot it is at now. Built by the
+    // first vacuum of the file and kept up to date from then on.
+    bool hasHomes;
+    unordered_map<uint64_t, RID> homes;
+    // PARALLEL_SCANs open on the file. Their workers read its mapping with no locking, so records
+    // can't be inserted, updated, deleted or vacuumed until they are closed.
+    unsigned parallelScans;
+} RecordFile;
+
+// The moved records of a vacuumed file kept by closeFile, so that the first vacuum after opening the
+// file again needn't look at every page. They are dropped if the file has changed size in between.
+typedef struct ClosedHomes
+{
+    FileId id;
+    unsigned numPages;
+    unordered_map<uint64_t, RID> homes;
+} ClosedHomes;
+
 
 /********************************************************************************
 The scan iterator is NOT required to be implemented for the part 1 of the project 
@@ -102,54 +291,120 @@ The scan iterator is NOT required to be implemented for the part 1 of the projec
 //  }
 //  rbfmScanIterator.close();
 class RecordBasedFileManager;
+class ParallelScan;
 
 class RBFM_ScanIterator {
 public:
   RBFM_ScanIterator();
-  ~RBFM_ScanIterator() {};
+  ~RBFM_ScanIterator();
 
   // Never keep the results in the memory. When getNextRecord() is called, 
   // a satisfying record needs to be fetched from the file.
   // "data" follows the same format as RecordBasedFileManager::insertRecord().
   RC getNextRecord(RID &rid, void *data);
+
+  // Up to maxRows records at once. The projected rows are packed back to back in data, each in the
+  // format getNextRecord() uses, and rids gets their RIDs in the same order. data must have room for
+  // maxRows rows. Returns RBFM_EOF once nothing is left.
+  RC getNextBatch(vector<RID> &rids, void *data, unsigned maxRows);
   RC close();
 
   friend class RecordBasedFileManager;
+  friend class ParallelScan;
 
 private:
   RecordBasedFileManager *rbfm;
 
+  // The workers doing a PARALLEL_SCAN, NULL for the other modes
+  ParallelScan *parallel;
+
   uint32_t currPage;
   uint32_t currSlot;
 
   uint32_t totalPage;
   uint16_t totalSlot;
 
+  // The current page: either pageBuffer, or a page of the mapped file in MAPPED_SCAN mode
   void *pageData;
+  void *pageBuffer;
+  void *mappedData;
+  unsigned mappedPages;
+
+  // Pages from nextReadAhead on haven't been asked for yet
+  unsigned readAheadWindow;
+  PageNum nextReadAhead;
+
+  // Whether the file's zone map is consulted to skip pages
+  bool zoneFiltered;
+
+  // Int and real conditions are evaluated for a whole page at once: the condition attribute of every
+  // slot is gathered into conditionValues and run through a predicate kernel (see filter.h)
+  bool vectorFiltered;
+  bool pageFiltered;
+  void *conditionValues;
+  uint8_t *selection;
 
   AttrType type;
   unsigned attrIndex;
+  // Code of the scan condition's value on the current page, see ScanCondition
+  int conditionCode;
+  // Whether the current page is a PAX page
+  bool paxPage;
 
+  // Our own copy of the caller's handle. Its page counters are handed back to the caller's on close.
   FileHandle fileHandle;
+  FileHandle *callerHandle;
   vector<Attribute> recordDescriptor;
   string conditionAttribute;
   CompOp compOp;
   const void* value;
   vector<string> attributeNames;
 
+  // Record descriptor index of each projected attribute, worked out in scanInit
+  vector<unsigned> projection;
+  unsigned projectionNullSize;
+  // Whether every attribute is projected in descriptor order, and they are all ints and reals
+  bool fixedProjection;
+  // Set by projectRecord when it copied a pointer to a value stored out of line
+  bool projectedToast;
+
   vector<RID> skipList;
 
+  // Multi-predicate scans: the clauses other than the scan condition above. Every one of them must
+  // hold, and they are kept most selective first so the others are rarely looked at.
+  vector<ScanClause> clauses;
+  // Clauses the zone map can rule pages out for, the scan condition included
+  vector<ScanClause> zoneClauses;
+
   RC scanInit(FileHandle &fh,
         const vector<Attribute> rd,
         const string &ca, 
         const CompOp compOp, 
         const void *v, 
-        const vector<string> &an);
-
+        const vector<string> &an,
+        ScanMode scanMode);
+  RC scanInit(FileHandle &fh,
+        const vector<Attribute> rd,
+        const vector<ScanPredicate> &predicates,
+        const vector<string> &an,
+        ScanMode scanMode);
+
+  RC getNextRecordInPlace(RID &rid, const char *&record);
+  RC startParallelScan();
+  void stopParallelScan();
+  RC initWorker(const RBFM_ScanIterator &scan);
   RC getNextSlot();
   RC getNextPage();
+  void returnCounters();
+  void filterPage();
+  void codeConditions();
+  unsigned projectRecord(const char *record, void *data);
+  RC detoastProjection(void *data, unsigned &size);
   RC handleMovedRecord(bool &status, const RID rid, void *data);
+  bool pageMayMatch(PageNum pageNum);
   bool checkScanCondition();
+  bool checkClauses(const char *record);
+  bool checkScanCondition(const char *record, const ScanCondition &condition);
   RC checkScanCondition(bool &result, const RID rid);
   bool checkScanCondition(int, CompOp, const void*);
   bool checkScanCondition(float, CompOp, const void*);
@@ -157,12 +412,49 @@ private:
 };
 
 
+// A record read in place, in its page pinned in the buffer pool, with nothing copied out.
+// The view holds the pin until release() is called or the view is reused or destroyed, so it must
+// be released before the file is closed, and before records on its page are changed.
+// Fields are numbered as in the record descriptor. NULL fields read as 0 or an empty varchar.
+class RecordView
+{
+public:
+  RecordView();
+  ~RecordView();
+
+  bool isValid();                                       // Does the view point at a record
+  unsigned getNumberOfFields();
+  bool isNull(unsigned i);
+  int32_t getInt(unsigned i);
+  float getReal(unsigned i);
+  const char *getVarChar(unsigned i, uint32_t &length); // Points into the page, not NUL terminated
+  string getVarCharString(unsigned i);                  // A copy, for when the view is about to go
+  RC release();
+
+  friend class RecordBasedFileManager;
+
+private:
+  RecordBasedFileManager *rbfm;
+  FileHandle *fileHandle;
+  PageNum pageNum;
+  void *page;
+  const char *record;
+  // The last varchar read that was stored out of line
+  string toastValue;
+
+  bool getField(unsigned i, const char *&field, uint32_t &len);
+};
+
+
 class RecordBasedFileManager
 {
 public:
   static RecordBasedFileManager* instance();
 
   RC createFile(const string &fileName);
+
+  // Create a file whose pages use layout. PAX_LAYOUT takes a record descriptor of ints and reals.
+  RC createFile(const string &fileName, const vector<Attribute> &recordDescriptor, PageLayout layout);
   
   RC destroyFile(const string &fileName);
   
@@ -186,7 +478,18 @@ public:
   // For example, refer to the Q6 of Project 1 Environment document.
   RC insertRecord(FileHandle &fileHandle, const vector<Attribute> &recordDescriptor, const void *data, RID &rid);
 
+  // Bulk load: packs the records into fresh pages in memory and appends them in large batches.
+  // Records use the same format as insertRecord(), rids gets one RID per record, in order.
+  RC insertRecords(FileHandle &fileHandle, const vector<Attribute> &recordDescriptor, const vector<const void*> &data, vector<RID> &rids);
+
   RC readRecord(FileHandle &fileHandle, const vector<Attribute> &recordDescriptor, const RID &rid, void *data);
+
+  // Read many records at once, each page only once however many of the records it holds.
+  // data[i] gets the record at rids[i], in the format readRecord() uses.
+  RC readRecords(FileHandle &fileHandle, const vector<Attribute> &recordDescriptor, const vector<RID> &rids, const vector<void*> &data);
+
+  // Point view at the record in its page instead of copying it out, see RecordView
+  RC readRecordView(FileHandle &fileHandle, const RID &rid, RecordView &view);
   
   // This method will be mainly used for debugging/testing. 
   // The format is as follows:
@@ -212,10 +515,61 @@ IMPORTANT, PLEASE READ: All methods below this comment (other than the construct
       const CompOp compOp,                  // comparision type such as "<" and "="
       const void *value,                    // used in the comparison
       const vector<string> &attributeNames, // a list of projected attributes
-      RBFM_ScanIterator &rbfm_ScanIterator);
+      RBFM_ScanIterator &rbfm_ScanIterator,
+      ScanMode scanMode = COPY_SCAN);       // MAPPED_SCAN or PARALLEL_SCAN for read-only scans of large files
+
+  // Scan with several conditions at once (see ScanPredicate), all checked on the page.
+  // The most selective conditions are checked first, so a record is rarely tested against all of them.
+  RC scan(FileHandle &fileHandle,
+      const vector<Attribute> &recordDescriptor,
+      const vector<ScanPredicate> &predicates,
+      const vector<string> &attributeNames,
+      RBFM_ScanIterator &rbfm_ScanIterator,
+      ScanMode scanMode = COPY_SCAN);
+
+  // Aggregate an int or real attribute over the records that meet every predicate (see ScanPredicate),
+  // straight from the pages. COUNT also takes a varchar, or "" to count records.
+  // groupAttribute, an int or varchar, splits the records into groups; with "" there is a single group.
+  RC aggregate(FileHandle &fileHandle,
+      const vector<Attribute> &recordDescriptor,
+      const string &aggregateAttribute,
+      const AggregateOp op,
+      const vector<ScanPredicate> &predicates,
+      const string &groupAttribute,
+      vector<AggregateGroup> &groups);
+
+  // Number of pages scans read ahead through the buffer pool, 0 turns read ahead off
+  void setScanReadAhead(unsigned pages);
+
+  // Number of worker threads a PARALLEL_SCAN uses, 0 for one per core
+  void setScanThreads(unsigned threads);
+
+  // Summarize every page of the file so scans can skip pages that can't hold a match.
+  // The zone map is kept current by changes made through handles from openFile().
+  RC createZoneMap(const string &fileName, const vector<Attribute> &recordDescriptor);
+  RC destroyZoneMap(const string &fileName);
+
+  // Code the given varchar attributes of records written from now on, against a dictionary kept on
+  // each page. Equality scans on them then compare codes. Records already coded stay readable after
+  // destroyDictionary().
+  RC createDictionary(const string &fileName, const vector<Attribute> &recordDescriptor, const vector<string> &attributeNames);
+  RC destroyDictionary(const string &fileName);
+
+  // How far records are from their RIDs: chainLengths[k] counts the records k forwarding
+  // addresses away. Updates keep every record within one.
+  RC getForwardingChainLengths(FileHandle &fileHandle, vector<unsigned> &chainLengths);
+
+  // Reclaim space left by deletes and moves, working down from the end of the file a few pages per call.
+  // Records moved onto a page go back home or to an earlier page with room, trailing dead slots are
+  // dropped, and empty pages at the end are cut off the file. RIDs stay valid.
+  // Start with cursor 0 and keep calling with the cursor it hands back until it returns RBFM_EOF.
+  // pages is how many pages to go through this call, 0 for the rest of the file.
+  RC vacuum(FileHandle &fileHandle, const vector<Attribute> &recordDescriptor, PageNum &cursor, unsigned pages);
 
 public:
   friend class RBFM_ScanIterator;
+  friend class ParallelScan;
+  friend class RecordView;
 
 protected:
   RecordBasedFileManager();
@@ -224,10 +578,21 @@ protected:
 private:
   static RecordBasedFileManager *_rbf_manager;
   static PagedFileManager *_pf_manager;
+  static BufferPoolManager *_bp_manager;
+
+  unsigned _scanReadAhead;
+  unsigned _scanThreads;
+
+  // Every file currently open through openFile()
+  vector<RecordFile*> _openFiles;
+  // Moved records of files vacuumed and closed since, see ClosedHomes
+  vector<ClosedHomes*> _closedHomes;
 
   // Private helper methods
 
   void newRecordBasedPage(void * page);
+  void newPaxPage(void *page, unsigned columns);
+  RC newDataPage(FileHandle &fileHandle, void *page);
 
   SlotDirectoryHeader getSlotDirectoryHeader(void * page);
   void setSlotDirectoryHeader(void * page, SlotDirectoryHeader slotHeader);
@@ -237,12 +602,48 @@ private:
 
   unsigned getPageFreeSpaceSize(void * page);
   unsigned getRecordSize(const vector<Attribute> &recordDescriptor, const void *data);
+  bool isFixedWidth(const vector<Attribute> &recordDescriptor);
+  bool hasNullFields(const char *nullIndicator, unsigned nullIndicatorSize);
+  void setFixedRecord(char *record, const vector<Attribute> &recordDescriptor, const void *data);
+  void getFixedRecord(const char *record, const vector<Attribute> &recordDescriptor, void *data);
 
   int getNullIndicatorSize(int fieldCount);
   bool fieldIsNull(char *nullIndicator, int i);
 
   void setRecordAtOffset(void *page, unsigned offset, const vector<Attribute> &recordDescriptor, const void *data);
-  void getRecordAtOffset(void *record, int32_t offset, const vector<Attribute> &recordDescriptor, void *data);
+  unsigned addRecordToPage(void *page, const vector<Attribute> &recordDescriptor, const void *data, unsigned recordSize);
+  bool getRecordAtOffset(void *record, int32_t offset, const vector<Attribute> &recordDescriptor, void *data);
+  bool getRecordField(const char *record, unsigned index, const char *&field, uint32_t &len);
+  bool isToastedField(const char *record, unsigned index);
+  bool isCodedField(const char *record, unsigned index);
+  bool getRecordValue(void *page, const char *record, unsigned index, const char *&field, uint32_t &len);
+
+  // PAX pages, see PAX_LAYOUT
+  bool isPaxPage(void *page);
+  unsigned getPaxNullOffset(const SlotDirectoryHeader &header);
+  unsigned getPaxColumnOffset(const SlotDirectoryHeader &header, unsigned index);
+  bool getPaxField(void *page, const char *record, unsigned index, const char *&field, uint32_t &len);
+  void setPaxRecord(void *page, unsigned offset, const vector<Attribute> &recordDescriptor, const void *data);
+  void getPaxRecord(void *page, unsigned offset, const vector<Attribute> &recordDescriptor, void *data);
+
+  // Page dictionaries, see DICTIONARY_FILE_SUFFIX
+  RC codeRecord(FileHandle &fileHandle, const vector<Attribute> &recordDescriptor, void *page, const void *data, unsigned freed, void *&coded, unsigned &recordSize);
+  int findDictionaryCode(void *page, const char *value, uint32_t len);
+  unsigned addDictionaryEntry(void *page, const char *value, uint32_t len);
+  void getDictionaryValue(void *page, unsigned code, const char *&value, uint32_t &len);
+  void dropEmptyDictionary(void *page);
+
+  // Out of line varchar values, see TOAST_FILE_SUFFIX
+  RC toastRecord(FileHandle &fileHandle, const vector<Attribute> &recordDescriptor, const void *data, unsigned &recordSize, void *&toasted);
+  RC detoastRecord(FileHandle &fileHandle, const vector<Attribute> &recordDescriptor, void *data, unsigned &size);
+  RC freeRecordToast(FileHandle &fileHandle, const char *record);
+  RC freeRecordToast(FileHandle &fileHandle, const vector<Attribute> &recordDescriptor, const void *data, const void *toasted);
+  void getRecordToast(const char *record, vector<ToastPointer> &pointers);
+  RC openToastFile(RecordFile *file, bool create);
+  RC writeToastValue(RecordFile *file, const char *value, uint32_t length, ToastPointer &pointer);
+  RC readToastValue(FileHandle &fileHandle, const char *field, string &value);
+  RC freeToastValue(RecordFile *file, const ToastPointer &pointer);
+  RC allocateToastPage(RecordFile *file, PageNum &pageNum, void *&pageData);
 
   SlotStatus getSlotStatus (SlotDirectoryRecordEntry slot);
   unsigned getOpenSlot(void *page);
@@ -250,8 +651,42 @@ private:
   void markSlotDeleted(void *page, unsigned i);
 
   void reorganizePage(void *page);
-
-  void getAttributeFromRecord(void *page, unsigned offset, unsigned attrIndex, AttrType type,void *data);
+  RC dropSlot(FileHandle &fileHandle, const vector<Attribute> &recordDescriptor, const RID &rid);
+  RC findForwardedHomes(FileHandle &fileHandle, PageNum low, PageNum high, unordered_map<uint64_t, RID> &homes);
+  void setForwardedHome(FileHandle &fileHandle, const RID &rid, const RID &home);
+  void clearForwardedHome(FileHandle &fileHandle, const RID &rid);
+  void forgetClosedHomes(const string &fileName);
+  RC vacuumPage(FileHandle &fileHandle, const vector<Attribute> &recordDescriptor, PageNum pageNum, const unordered_map<uint64_t, RID> &homes);
+  RC relocateRecord(FileHandle &fileHandle, const vector<Attribute> &recordDescriptor, const RID &home, const RID &rid, void *pageData);
+  RC relocateRecordData(FileHandle &fileHandle, const vector<Attribute> &recordDescriptor, const RID &home, const RID &rid,
+                        void *pageData, const void *data, unsigned length);
+  RC truncateEmptyPages(FileHandle &fileHandle);
+  bool isParallelScanned(FileHandle &fileHandle);
+  RC updateRecordAt(FileHandle &fileHandle, const vector<Attribute> &recordDescriptor, const void *data, const RID &rid);
+  RC updateRecordOnPage(FileHandle &fileHandle, const vector<Attribute> &recordDescriptor, const void *data,
+                        const void *record, unsigned recordSize, const RID &rid, void *pageData);
+  RC updateForwardedRecord(FileHandle &fileHandle, const vector<Attribute> &recordDescriptor, const void *data,
+                           const RID &rid, void *pageData, SlotDirectoryRecordEntry recordEntry);
+
+  bool getAttributeFromRecord(void *page, unsigned offset, unsigned attrIndex, AttrType type,void *data);
+
+  // Free space map helpers
+  bool isFreeSpaceMapPage(PageNum pageNum);
+  PageNum getFreeSpaceMapPage(PageNum pageNum);
+  uint8_t getFreeSpaceBucket(void *page);
+  RC updateFreeSpaceMap(FileHandle &fileHandle, PageNum pageNum, void *page);
+  RC findPageWithFreeSpace(FileHandle &fileHandle, unsigned size, PageNum &pageNum, bool &found, PageNum before = (PageNum) -1);
+  RC appendRecordBasedPage(FileHandle &fileHandle, void *page, PageNum &pageNum);
+  RC appendRecordBasedPages(FileHandle &fileHandle, const vector<Attribute> &recordDescriptor, char *pages, unsigned count);
+
+  RecordFile *findRecordFile(FileHandle &fileHandle);
+  RC updatePageSummaries(FileHandle &fileHandle, const vector<Attribute> &recordDescriptor, PageNum pageNum, void *page);
+  RC pinZoneMapEntry(RecordFile *file, PageNum pageNum, PageNum &zonePageNum, ColumnZone *&zones);
+  RC widenZoneMap(FileHandle &fileHandle, const vector<Attribute> &recordDescriptor, PageNum pageNum, void *page, unsigned slotNum);
+  RC rebuildZoneMap(FileHandle &fileHandle, const vector<Attribute> &recordDescriptor, PageNum pageNum, void *page);
+  void summarizeRecord(ColumnZone *zones, unsigned columns, const vector<Attribute> &recordDescriptor, void *page, const char *record);
+  bool pageMayMatch(FileHandle &fileHandle, PageNum pageNum, unsigned attrIndex, AttrType type, CompOp compOp, const void *value);
+  double estimateSelectivity(FileHandle &fileHandle, const ScanCondition &condition);
 };
 
 #endif
@@ -0,0 +1,156 @@
+#include <iostream>
+#include <string>
+#include <cassert>
+#include <sys/stat.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdexcept>
+#include <stdio.h>
+
+#include "pfm.h"
+#include "bpm.h"
+#include "rbfm.h"
+#include "test_util.h"
+
+using namespace std;
+
+int RBFTest_13(PagedFileManager *pfm, BufferPoolManager *bpm)
+{
+    // Functions Tested:
+    // 1. Pin / Unpin Page through the buffer pool
+    // 2. Logical vs. physical counter values
+    // 3. Write back of dirty pages on close
+    // 4. Eviction with a small pool
+    cout << endl << "***** In RBF Test Case 13 *****" << endl;
+
+    RC rc;
+    string fileName = "test13";
+
+    unsigned readPageCount = 0;
+    unsigned writePageCount = 0;
+    unsigned appendPageCount = 0;
+    unsigned logicalReadCount = 0;
+    unsigned logicalWriteCount = 0;
+
+    // Create the file named "test13" with 20 pages
+    rc = pfm->createFile(fileName);
+    assert(rc == success && "Creating the file should not fail.");
+
+    FileHandle fileHandle;
+    rc = pfm->openFile(fileName, fileHandle);
+    assert(rc == success && "Opening the file should not fail.");
+
+    void *data = malloc(PAGE_SIZE);
+    for(unsigned j = 0; j < 20; j++)
+    {
+        memset(data, 'a' + j, PAGE_SIZE);
+        rc = fileHandle.appendPage(data);
+        assert(rc == success && "Appending a page should not fail.");
+    }
+
+    // Reading the same page twice through the pool only hits the disk once
+    void *page;
+    rc = bpm->pinPage(fileHandle, 3, page);
+    assert(rc == success && "Pinning a page should not fail.");
+    assert(*((char *)page) == 'a' + 3 && "The pinned page should hold the page data.");
+    rc = bpm->unpinPage(fileHandle, 3, false);
+    assert(rc == success && "Unpinning a page should not fail.");
+
+    rc = bpm->readPage(fileHandle, 3, data);
+    assert(rc == success && "Reading a page through the pool should not fail.");
+
+    rc = fileHandle.collectCounterValues(readPageCount, writePageCount, appendPageCount);
+    assert(rc == success && "collectCounterValues() should not fail.");
+    rc = fileHandle.collectLogicalCounterValues(logicalReadCount, logicalWriteCount);
+    assert(rc == success && "collectLogicalCounterValues() should not fail.");
+    cout << "physical R W A - " << readPageCount << " " << writePageCount << " " << appendPageCount
+         << " logical R W - " << logicalReadCount << " " << logicalWriteCount << endl;
+    assert(readPageCount == 1 && "A cached page should only be read from disk once.");
+    assert(logicalReadCount == 2 && "Both accesses should be counted as logical reads.");
+
+    // Unpinning a page that isn't pinned is an error
+    rc = bpm->unpinPage(fileHandle, 3, false);
+    assert(rc != success && "Unpinning an unpinned page should fail.");
+
+    // Modify a page in place, it is only written back on close
+    rc = bpm->pinPage(fileHandle, 5, page);
+    assert(rc == success && "Pinning a page should not fail.");
+    memset(page, 'z', PAGE_SIZE);
+    rc = bpm->unpinPage(fileHandle, 5, true);
+    assert(rc == success && "Unpinning a page should not fail.");
+
+    rc = fileHandle.collectCounterValues(readPageCount, writePageCount, appendPageCount);
+    assert(rc == success && "collectCounterValues() should not fail.");
+    assert(writePageCount == 0 && "A dirty page should not be written before it is flushed.");
+
+    // A direct read must still see the newest version of the page
+    rc = fileHandle.readPage(5, data);
+    assert(rc == success && "Reading a page should not fail.");
+    assert(*((char *)data + PAGE_SIZE - 1) == 'z' && "A direct read should see the dirty page.");
+
+    rc = pfm->closeFile(fileHandle);
+    assert(rc == success && "Closing the file should not fail.");
+
+    // Shrink the pool so reading every page forces evictions
+    rc = bpm->setPoolSize(4);
+    assert(rc == success && "Resizing the pool should not fail.");
+
+    FileHandle fileHandle2;
+    rc = pfm->openFile(fileName, fileHandle2);
+    assert(rc == success && "Opening the file should not fail.");
+
+    for(unsigned j = 0; j < 20; j++)
+    {
+        rc = bpm->readPage(fileHandle2, j, data);
+        assert(rc == success && "Reading a page through the pool should not fail.");
+        char expected = j == 5 ? 'z' : 'a' + j;
+        assert(*((char *)data) == expected && "Checking the integrity of a page should not fail.");
+    }
+
+    // With every frame pinned there is nothing left to evict
+    void *pages[4];
+    for(unsigned j = 0; j < 4; j++)
+    {
+        rc = bpm->pinPage(fileHandle2, j, pages[j]);
+        assert(rc == success && "Pinning a page should not fail.");
+    }
+    rc = bpm->pinPage(fileHandle2, 10, page);
+    assert(rc == BPM_NO_FREE_FRAME && "Pinning with every frame pinned should fail.");
+    rc = bpm->setPoolSize(8);
+    assert(rc == BPM_FRAMES_PINNED && "Resizing with pinned frames should fail.");
+    for(unsigned j = 0; j < 4; j++)
+    {
+        rc = bpm->unpinPage(fileHandle2, j, false);
+        assert(rc == success && "Unpinning a page should not fail.");
+    }
+
+    rc = pfm->closeFile(fileHandle2);
+    assert(rc == success && "Closing the file should not fail.");
+
+    rc = bpm->setPoolSize(BPM_DEFAULT_POOL_SIZE);
+    assert(rc == success && "Resizing the pool should not fail.");
+
+    rc = pfm->destroyFile(fileName);
+    assert(rc == success && "Destroying the file should not fail.");
+
+    rc = destroyFileShouldSucceed(fileName);
+    assert(rc == success  && "Destroying the file should not fail.");
+
+    free(data);
+
+    cout << "RBF Test Case 13 Finished! The result will be examined." << endl << endl;
+    return 0;
+}
+
+int main()
+{
+    // To test the buffer pool underneath the paged file manager
+    PagedFileManager *pfm = PagedFileManager::instance();
+    BufferPoolManager *bpm = BufferPoolManager::instance();
+
+    // Remove files that might be created by previous test run
+    remove("test13");
+
+    RC rcmain = RBFTest_13(pfm, bpm);
+    return rcmain;
+}
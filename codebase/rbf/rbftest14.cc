@@ -0,0 +1,130 @@
+#include <iostream>
+#include <string>
+#include <cassert>
+#include <sys/stat.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdexcept>
+#include <stdio.h>
+
+#include "pfm.h"
+#include "rbfm.h"
+#include "test_util.h"
+
+using namespace std;
+
+int RBFTest_14(RecordBasedFileManager *rbfm)
+{
+    // Functions Tested:
+    // 1. Insert Records through the free space map
+    // 2. Insert cost does not grow with the number of pages
+    // 3. Space freed by deletes is reused
+    cout << endl << "***** In RBF Test Case 14 *****" << endl;
+
+    RC rc;
+    string fileName = "test14";
+
+    rc = rbfm->createFile(fileName);
+    assert(rc == success && "Creating the file should not fail.");
+
+    FileHandle fileHandle;
+    rc = rbfm->openFile(fileName, fileHandle);
+    assert(rc == success && "Opening the file should not fail.");
+
+    vector<Attribute> recordDescriptor;
+    createLargeRecordDescriptor(recordDescriptor);
+
+    int nullFieldsIndicatorActualSize = getActualByteForNullsIndicator(recordDescriptor.size());
+    unsigned char *nullsIndicator = (unsigned char *) malloc(nullFieldsIndicatorActualSize);
+    memset(nullsIndicator, 0, nullFieldsIndicatorActualSize);
+
+    void *record = malloc(1000);
+    void *returnedData = malloc(1000);
+    vector<RID> rids;
+    RID rid;
+    int size = 0;
+
+    // Fill a few hundred pages
+    int numRecords = 2000;
+    for(int i = 0; i < numRecords; i++)
+    {
+        memset(record, 0, 1000);
+        prepareLargeRecord(recordDescriptor.size(), nullsIndicator, i, record, &size);
+        rc = rbfm->insertRecord(fileHandle, recordDescriptor, record, rid);
+        assert(rc == success && "Inserting a record should not fail.");
+        assert(rid.pageNum != 0 && "Page 0 holds the free space map, not records.");
+        rids.push_back(rid);
+    }
+    cout << "Number of pages: " << fileHandle.getNumberOfPages() << endl;
+
+    // Inserting into a large file should not read every page looking for space
+    unsigned logicalReadBefore, logicalReadAfter, logicalWriteCount;
+    rc = fileHandle.collectLogicalCounterValues(logicalReadBefore, logicalWriteCount);
+    assert(rc == success && "collectLogicalCounterValues() should not fail.");
+    memset(record, 0, 1000);
+    prepareLargeRecord(recordDescriptor.size(), nullsIndicator, numRecords, record, &size);
+    rc = rbfm->insertRecord(fileHandle, recordDescriptor, record, rid);
+    assert(rc == success && "Inserting a record should not fail.");
+    rc = fileHandle.collectLogicalCounterValues(logicalReadAfter, logicalWriteCount);
+    assert(rc == success && "collectLogicalCounterValues() should not fail.");
+    cout << "Pages read by one insert: " << logicalReadAfter - logicalReadBefore << endl;
+    assert(logicalReadAfter - logicalReadBefore <= 4 && "An insert should only touch the map and the target page.");
+
+    // Free up the first page and make sure the next insert goes back there
+    PageNum firstPage = rids[0].pageNum;
+    for(unsigned i = 0; i < rids.size() && rids[i].pageNum == firstPage; i++)
+    {
+        rc = rbfm->deleteRecord(fileHandle, recordDescriptor, rids[i]);
+        assert(rc == success && "Deleting a record should not fail.");
+    }
+
+    memset(record, 0, 1000);
+    prepareLargeRecord(recordDescriptor.size(), nullsIndicator, 0, record, &size);
+    rc = rbfm->insertRecord(fileHandle, recordDescriptor, record, rid);
+    assert(rc == success && "Inserting a record should not fail.");
+    assert(rid.pageNum == firstPage && "The insert should reuse the space freed by the deletes.");
+
+    rc = rbfm->readRecord(fileHandle, recordDescriptor, rid, returnedData);
+    assert(rc == success && "Reading a record should not fail.");
+    assert(memcmp(record, returnedData, size) == 0 && "Returned Data should be the same");
+
+    // RIDs on the map page don't name records
+    RID mapRid;
+    mapRid.pageNum = 0;
+    mapRid.slotNum = 0;
+    rc = rbfm->readRecord(fileHandle, recordDescriptor, mapRid, returnedData);
+    assert(rc == RBFM_SLOT_DN_EXIST && "Reading from the map page should fail.");
+    rc = rbfm->readAttribute(fileHandle, recordDescriptor, mapRid, recordDescriptor[0].name, returnedData);
+    assert(rc == RBFM_SLOT_DN_EXIST && "Reading from the map page should fail.");
+    rc = rbfm->updateRecord(fileHandle, recordDescriptor, record, mapRid);
+    assert(rc == RBFM_SLOT_DN_EXIST && "Updating on the map page should fail.");
+    rc = rbfm->deleteRecord(fileHandle, recordDescriptor, mapRid);
+    assert(rc == RBFM_SLOT_DN_EXIST && "Deleting from the map page should fail.");
+
+    rc = rbfm->closeFile(fileHandle);
+    assert(rc == success && "Closing the file should not fail.");
+
+    rc = rbfm->destroyFile(fileName);
+    assert(rc == success && "Destroying the file should not fail.");
+
+    rc = destroyFileShouldSucceed(fileName);
+    assert(rc == success  && "Destroying the file should not fail.");
+
+    free(record);
+    free(returnedData);
+    free(nullsIndicator);
+
+    cout << "RBF Test Case 14 Finished! The result will be examined." << endl << endl;
+    return 0;
+}
+
+int main()
+{
+    // To test the free space map of the record-based file manager
+    RecordBasedFileManager *rbfm = RecordBasedFileManager::instance();
+
+    remove("test14");
+
+    RC rcmain = RBFTest_14(rbfm);
+    return rcmain;
+}
@@ -0,0 +1,111 @@
+#include <iostream>
+#include <string>
+#include <cassert>
+#include <sys/stat.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdexcept>
+#include <stdio.h>
+#include <unistd.h>
+
+#include "pfm.h"
+#include "bpm.h"
+#include "test_util.h"
+
+using namespace std;
+
+int RBFTest_15(PagedFileManager *pfm, BufferPoolManager *bpm)
+{
+    // Functions Tested:
+    // 1. Page count maintained by Append Page
+    // 2. Truncation behind our back is noticed on Open File
+    cout << endl << "***** In RBF Test Case 15 *****" << endl;
+
+    RC rc;
+    string fileName = "test15";
+
+    rc = pfm->createFile(fileName);
+    assert(rc == success && "Creating the file should not fail.");
+
+    FileHandle fileHandle;
+    rc = pfm->openFile(fileName, fileHandle);
+    assert(rc == success && "Opening the file should not fail.");
+
+    void *data = malloc(PAGE_SIZE);
+    for(unsigned j = 0; j < 5; j++)
+    {
+        memset(data, 'a' + j, PAGE_SIZE);
+        rc = fileHandle.appendPage(data);
+        assert(rc == success && "Appending a page should not fail.");
+        assert(fileHandle.getNumberOfPages() == j + 1 && "Appending a page should grow the page count.");
+    }
+
+    // Another handle on the same file sees the same count
+    FileHandle fileHandle2;
+    rc = pfm->openFile(fileName, fileHandle2);
+    assert(rc == success && "Opening the file should not fail.");
+    assert(fileHandle2.getNumberOfPages() == 5 && "Both handles should see every page.");
+    rc = pfm->closeFile(fileHandle2);
+    assert(rc == success && "Closing the file should not fail.");
+
+    // Get pages 3 and 4 into the buffer pool
+    rc = bpm->readPage(fileHandle, 3, data);
+    assert(rc == success && "Reading a page through the pool should not fail.");
+    rc = bpm->readPage(fileHandle, 4, data);
+    assert(rc == success && "Reading a page through the pool should not fail.");
+
+    rc = pfm->closeFile(fileHandle);
+    assert(rc == success && "Closing the file should not fail.");
+
+    // Cut the file down to 3 pages behind the paged file manager's back
+    rc = truncate(fileName.c_str(), 3 * PAGE_SIZE);
+    assert(rc == success && "Truncating the file should not fail.");
+
+    rc = pfm->openFile(fileName, fileHandle);
+    assert(rc == success && "Opening the file should not fail.");
+    assert(fileHandle.getNumberOfPages() == 3 && "Opening the file should pick up the new size.");
+
+    rc = bpm->readPage(fileHandle, 3, data);
+    assert(rc != success && "Reading a page past the end should fail.");
+
+    // Page 3 gets new contents, the cached copy from before the truncation must be gone
+    memset(data, 'z', PAGE_SIZE);
+    rc = fileHandle.appendPage(data);
+    assert(rc == success && "Appending a page should not fail.");
+    memset(data, 0, PAGE_SIZE);
+    rc = bpm->readPage(fileHandle, 3, data);
+    assert(rc == success && "Reading a page through the pool should not fail.");
+    assert(*((char *)data) == 'z' && "The pool should not return a page from before the truncation.");
+
+    rc = pfm->closeFile(fileHandle);
+    assert(rc == success && "Closing the file should not fail.");
+
+    // A file that isn't a whole number of pages can't be opened
+    rc = truncate(fileName.c_str(), 3 * PAGE_SIZE + 100);
+    assert(rc == success && "Truncating the file should not fail.");
+    rc = pfm->openFile(fileName, fileHandle);
+    assert(rc == PFM_FILE_TRUNCATED && "Opening a partially truncated file should fail.");
+
+    rc = pfm->destroyFile(fileName);
+    assert(rc == success && "Destroying the file should not fail.");
+
+    rc = destroyFileShouldSucceed(fileName);
+    assert(rc == success  && "Destroying the file should not fail.");
+
+    free(data);
+
+    cout << "RBF Test Case 15 Finished! The result will be examined." << endl << endl;
+    return 0;
+}
+
+int main()
+{
+    // To test the page count kept by the paged file manager
+    PagedFileManager *pfm = PagedFileManager::instance();
+    BufferPoolManager *bpm = BufferPoolManager::instance();
+
+    remove("test15");
+
+    RC rcmain = RBFTest_15(pfm, bpm);
+    return rcmain;
+}
@@ -0,0 +1,128 @@
+#include <iostream>
+#include <string>
+#include <cassert>
+#include <sys/stat.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdexcept>
+#include <stdio.h>
+
+#include "pfm.h"
+#include "test_util.h"
+
+using namespace std;
+
+int RBFTest_16(PagedFileManager *pfm)
+{
+    // Functions Tested:
+    // 1. WriteBack durability: writes wait for flush()
+    // 2. GroupFlush durability: writes are flushed every few pages
+    // 3. Strict durability: writes reach the disk right away
+    cout << endl << "***** In RBF Test Case 16 *****" << endl;
+
+    RC rc;
+    string fileName = "test16";
+
+    unsigned readPageCount = 0;
+    unsigned writePageCount = 0;
+    unsigned appendPageCount = 0;
+
+    rc = pfm->createFile(fileName);
+    assert(rc == success && "Creating the file should not fail.");
+
+    // Files opened from now on start in WriteBack
+    pfm->setDurability(WriteBack);
+
+    FileHandle fileHandle;
+    rc = pfm->openFile(fileName, fileHandle);
+    assert(rc == success && "Opening the file should not fail.");
+
+    void *data = malloc(PAGE_SIZE);
+    for(unsigned j = 0; j < 10; j++)
+    {
+        memset(data, 'a' + j, PAGE_SIZE);
+        rc = fileHandle.appendPage(data);
+        assert(rc == success && "Appending a page should not fail.");
+    }
+    memset(data, 'z', PAGE_SIZE);
+    rc = fileHandle.writePage(2, data);
+    assert(rc == success && "Writing a page should not fail.");
+    assert(fileHandle.getNumberOfPages() == 10 && "Appended pages should be counted before they are written back.");
+
+    struct stat sb;
+    stat(fileName.c_str(), &sb);
+    assert(sb.st_size == 0 && "Nothing should reach the file before a flush.");
+
+    // A direct read still sees the newest version
+    rc = fileHandle.readPage(2, data);
+    assert(rc == success && "Reading a page should not fail.");
+    assert(*((char *)data) == 'z' && "A direct read should see the pending write.");
+
+    rc = fileHandle.flush();
+    assert(rc == success && "Flushing the file should not fail.");
+    stat(fileName.c_str(), &sb);
+    assert(sb.st_size == 10 * PAGE_SIZE && "Every page should be in the file after a flush.");
+
+    // GroupFlush: every 4th page written triggers a flush
+    rc = fileHandle.setDurability(GroupFlush, 4, 60000);
+    assert(rc == success && "Changing the durability should not fail.");
+    rc = fileHandle.collectCounterValues(readPageCount, writePageCount, appendPageCount);
+    assert(rc == success && "collectCounterValues() should not fail.");
+    unsigned writesBefore = writePageCount;
+
+    for(unsigned j = 0; j < 3; j++)
+    {
+        rc = fileHandle.writePage(j, data);
+        assert(rc == success && "Writing a page should not fail.");
+    }
+    rc = fileHandle.collectCounterValues(readPageCount, writePageCount, appendPageCount);
+    assert(rc == success && "collectCounterValues() should not fail.");
+    assert(writePageCount == writesBefore && "Writes below the group size should wait.");
+
+    rc = fileHandle.writePage(3, data);
+    assert(rc == success && "Writing a page should not fail.");
+    rc = fileHandle.collectCounterValues(readPageCount, writePageCount, appendPageCount);
+    assert(rc == success && "collectCounterValues() should not fail.");
+    assert(writePageCount == writesBefore + 4 && "The whole group should be written at once.");
+
+    // Strict: the write is on disk as soon as it returns
+    rc = fileHandle.setDurability(Strict);
+    assert(rc == success && "Changing the durability should not fail.");
+    writesBefore = writePageCount;
+    rc = fileHandle.writePage(5, data);
+    assert(rc == success && "Writing a page should not fail.");
+    rc = fileHandle.appendPage(data);
+    assert(rc == success && "Appending a page should not fail.");
+    rc = fileHandle.collectCounterValues(readPageCount, writePageCount, appendPageCount);
+    assert(rc == success && "collectCounterValues() should not fail.");
+    assert(writePageCount == writesBefore + 1 && "A strict write should go to disk right away.");
+    stat(fileName.c_str(), &sb);
+    assert(sb.st_size == 11 * PAGE_SIZE && "A strict append should go to disk right away.");
+
+    rc = pfm->closeFile(fileHandle);
+    assert(rc == success && "Closing the file should not fail.");
+
+    pfm->setDurability(WriteThrough);
+
+    rc = pfm->destroyFile(fileName);
+    assert(rc == success && "Destroying the file should not fail.");
+
+    rc = destroyFileShouldSucceed(fileName);
+    assert(rc == success  && "Destroying the file should not fail.");
+
+    free(data);
+
+    cout << "RBF Test Case 16 Finished! The result will be examined." << endl << endl;
+    return 0;
+}
+
+int main()
+{
+    // To test the durability modes of the paged file manager
+    PagedFileManager *pfm = PagedFileManager::instance();
+
+    remove("test16");
+
+    RC rcmain = RBFTest_16(pfm);
+    return rcmain;
+}
@@ -0,0 +1,155 @@
+#include <iostream>
+#include <string>
+#include <cassert>
+#include <sys/stat.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdexcept>
+#include <stdio.h>
+
+#include "pfm.h"
+#include "rbfm.h"
+#include "test_util.h"
+
+using namespace std;
+
+// Find which inserted record a RID belongs to
+static int findRecord(const vector<RID> &rids, const RID &rid)
+{
+    for (unsigned i = 0; i < rids.size(); i++)
+    {
+        if (rids[i].pageNum == rid.pageNum && rids[i].slotNum == rid.slotNum)
+            return i;
+    }
+    return -1;
+}
+
+int RBFTest_17(RecordBasedFileManager *rbfm)
+{
+    // Functions Tested:
+    // 1. Scan in MAPPED_SCAN mode returns the same records as the default mode
+    // 2. A mapped scan doesn't go through the buffer pool
+    // 3. A mapped scan falls back to copying pages when the file grows under it
+    cout << endl << "***** In RBF Test Case 17 *****" << endl;
+
+    RC rc;
+    string fileName = "test17";
+
+    rc = rbfm->createFile(fileName);
+    assert(rc == success && "Creating the file should not fail.");
+
+    FileHandle fileHandle;
+    rc = rbfm->openFile(fileName, fileHandle);
+    assert(rc == success && "Opening the file should not fail.");
+
+    vector<Attribute> recordDescriptor;
+    createLargeRecordDescriptor(recordDescriptor);
+    vector<string> attributeNames;
+    for (unsigned i = 0; i < recordDescriptor.size(); i++)
+        attributeNames.push_back(recordDescriptor[i].name);
+
+    int nullFieldsIndicatorActualSize = getActualByteForNullsIndicator(recordDescriptor.size());
+    unsigned char *nullsIndicator = (unsigned char *) malloc(nullFieldsIndicatorActualSize);
+    memset(nullsIndicator, 0, nullFieldsIndicatorActualSize);
+
+    void *record = malloc(1000);
+    void *returnedData = malloc(1000);
+    vector<RID> rids;
+    RID rid;
+    int size = 0;
+
+    int numRecords = 1000;
+    for(int i = 0; i < numRecords; i++)
+    {
+        memset(record, 0, 1000);
+        prepareLargeRecord(recordDescriptor.size(), nullsIndicator, i, record, &size);
+        rc = rbfm->insertRecord(fileHandle, recordDescriptor, record, rid);
+        assert(rc == success && "Inserting a record should not fail.");
+        rids.push_back(rid);
+    }
+
+    // Every record comes back once and intact, without a single read through the pool
+    unsigned logicalReadBefore, logicalReadAfter, logicalWriteCount;
+    rc = fileHandle.collectLogicalCounterValues(logicalReadBefore, logicalWriteCount);
+    assert(rc == success && "collectLogicalCounterValues() should not fail.");
+
+    RBFM_ScanIterator rbfm_ScanIterator;
+    rc = rbfm->scan(fileHandle, recordDescriptor, "", NO_OP, NULL, attributeNames, rbfm_ScanIterator, MAPPED_SCAN);
+    assert(rc == success && "Scanning the file should not fail.");
+
+    vector<bool> seen(numRecords, false);
+    int count = 0;
+    while(rbfm_ScanIterator.getNextRecord(rid, returnedData) != RBFM_EOF)
+    {
+        int index = findRecord(rids, rid);
+        assert(index >= 0 && !seen[index] && "Each record should be returned once.");
+        seen[index] = true;
+        prepareLargeRecord(recordDescriptor.size(), nullsIndicator, index, record, &size);
+        assert(memcmp(record, returnedData, size) == 0 && "Returned Data should be the same");
+        count++;
+    }
+    rbfm_ScanIterator.close();
+    assert(count == numRecords && "The scan should return every record.");
+
+    rc = fileHandle.collectLogicalCounterValues(logicalReadAfter, logicalWriteCount);
+    assert(rc == success && "collectLogicalCounterValues() should not fail.");
+    cout << "Pages read through the pool by the mapped scan: " << logicalReadAfter - logicalReadBefore << endl;
+    assert(logicalReadAfter == logicalReadBefore && "A mapped scan should not read pages through the pool.");
+
+    // Grow the file halfway through a mapped scan
+    rc = rbfm->scan(fileHandle, recordDescriptor, "", NO_OP, NULL, attributeNames, rbfm_ScanIterator, MAPPED_SCAN);
+    assert(rc == success && "Scanning the file should not fail.");
+
+    seen.assign(numRecords, false);
+    count = 0;
+    while(rbfm_ScanIterator.getNextRecord(rid, returnedData) != RBFM_EOF)
+    {
+        if (count++ == numRecords / 2)
+        {
+            for(int i = 0; i < 100; i++)
+            {
+                prepareLargeRecord(recordDescriptor.size(), nullsIndicator, numRecords + i, record, &size);
+                RID newRid;
+                rc = rbfm->insertRecord(fileHandle, recordDescriptor, record, newRid);
+                assert(rc == success && "Inserting a record should not fail.");
+            }
+        }
+        int index = findRecord(rids, rid);
+        if (index < 0)
+            continue;
+        assert(!seen[index] && "Each record should be returned once.");
+        seen[index] = true;
+        prepareLargeRecord(recordDescriptor.size(), nullsIndicator, index, record, &size);
+        assert(memcmp(record, returnedData, size) == 0 && "Returned Data should be the same");
+    }
+    rbfm_ScanIterator.close();
+    for(int i = 0; i < numRecords; i++)
+        assert(seen[i] && "Every record in the file before the scan should be returned.");
+
+    rc = rbfm->closeFile(fileHandle);
+    assert(rc == success && "Closing the file should not fail.");
+
+    rc = rbfm->destroyFile(fileName);
+    assert(rc == success && "Destroying the file should not fail.");
+
+    rc = destroyFileShouldSucceed(fileName);
+    assert(rc == success  && "Destroying the file should not fail.");
+
+    free(record);
+    free(returnedData);
+    free(nullsIndicator);
+
+    cout << "RBF Test Case 17 Finished! The result will be examined." << endl << endl;
+    return 0;
+}
+
+int main()
+{
+    // To test memory mapped scans
+    RecordBasedFileManager *rbfm = RecordBasedFileManager::instance();
+
+    remove("test17");
+
+    RC rcmain = RBFTest_17(rbfm);
+    return rcmain;
+}
@@ -0,0 +1,193 @@
+#include <iostream>
+#include <string>
+#include <cassert>
+#include <sys/stat.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdexcept>
+#include <stdio.h>
+
+#include "pfm.h"
+#include "bpm.h"
+#include "aio.h"
+#include "test_util.h"
+
+using namespace std;
+
+#define NUM_PAGES 100
+
+// Counts finished requests for the test
+typedef struct Completion
+{
+    unsigned done;
+    RC rc;
+} Completion;
+
+static void requestDone(RC rc, void *context)
+{
+    Completion *completion = (Completion *) context;
+    completion->done++;
+    if (rc)
+        completion->rc = rc;
+}
+
+// Run reads and writes through whichever engine is in use
+static void testEngine(PagedFileManager *pfm, AsyncIOManager *aio, const string &fileName)
+{
+    RC rc;
+    FileHandle fileHandle;
+    rc = pfm->openFile(fileName, fileHandle);
+    assert(rc == success && "Opening the file should not fail.");
+
+    unsigned readPageCount = 0;
+    unsigned writePageCount = 0;
+    unsigned appendPageCount = 0;
+
+    // Every page read at once
+    char *pages = (char *) malloc(NUM_PAGES * PAGE_SIZE);
+    Completion completion = {0, success};
+    for(unsigned j = 0; j < NUM_PAGES; j++)
+    {
+        rc = fileHandle.submitRead(j, pages + j * PAGE_SIZE, requestDone, &completion);
+        assert(rc == success && "Submitting a read should not fail.");
+    }
+    rc = fileHandle.waitForIO();
+    assert(rc == success && "Waiting for I/O should not fail.");
+    assert(completion.done == NUM_PAGES && completion.rc == success && "Every read should complete.");
+    assert(aio->getInFlight() == 0 && "Nothing should be left in flight.");
+    for(unsigned j = 0; j < NUM_PAGES; j++)
+        assert(pages[j * PAGE_SIZE] == (char) ('a' + j % 26) && pages[(j + 1) * PAGE_SIZE - 1] == (char) ('a' + j % 26) && "Checking the integrity of a page should not fail.");
+
+    rc = fileHandle.collectCounterValues(readPageCount, writePageCount, appendPageCount);
+    assert(rc == success && "collectCounterValues() should not fail.");
+    assert(readPageCount == NUM_PAGES && "Every asynchronous read should be counted.");
+
+    // Rewrite every other page, then read them back synchronously
+    completion.done = 0;
+    for(unsigned j = 0; j < NUM_PAGES; j += 2)
+    {
+        memset(pages + j * PAGE_SIZE, 'A' + j % 26, PAGE_SIZE);
+        rc = fileHandle.submitWrite(j, pages + j * PAGE_SIZE, requestDone, &completion);
+        assert(rc == success && "Submitting a write should not fail.");
+    }
+    rc = fileHandle.waitForIO();
+    assert(rc == success && "Waiting for I/O should not fail.");
+    assert(completion.done == NUM_PAGES / 2 && completion.rc == success && "Every write should complete.");
+
+    void *data = malloc(PAGE_SIZE);
+    for(unsigned j = 0; j < NUM_PAGES; j++)
+    {
+        rc = fileHandle.readPage(j, data);
+        assert(rc == success && "Reading a page should not fail.");
+        char expected = j % 2 == 0 ? 'A' + j % 26 : 'a' + j % 26;
+        assert(*((char *) data + PAGE_SIZE - 1) == expected && "The written pages should be on disk.");
+    }
+
+    // Put the file back the way it was
+    for(unsigned j = 0; j < NUM_PAGES; j += 2)
+    {
+        memset(pages + j * PAGE_SIZE, 'a' + j % 26, PAGE_SIZE);
+        rc = fileHandle.submitWrite(j, pages + j * PAGE_SIZE, NULL, NULL);
+        assert(rc == success && "Submitting a write should not fail.");
+    }
+    rc = fileHandle.waitForIO();
+    assert(rc == success && "Waiting for I/O should not fail.");
+
+    // Reading past the end is refused up front
+    rc = fileHandle.submitRead(NUM_PAGES, data, requestDone, &completion);
+    assert(rc != success && "Reading a page past the end should fail.");
+
+    rc = pfm->closeFile(fileHandle);
+    assert(rc == success && "Closing the file should not fail.");
+
+    free(data);
+    free(pages);
+}
+
+int RBFTest_18(PagedFileManager *pfm, BufferPoolManager *bpm, AsyncIOManager *aio)
+{
+    // Functions Tested:
+    // 1. Submit Read / Submit Write with io_uring, if the kernel allows it
+    // 2. The same with the thread pool engine
+    // 3. Prefetching pages into the buffer pool
+    cout << endl << "***** In RBF Test Case 18 *****" << endl;
+
+    RC rc;
+    string fileName = "test18";
+
+    rc = pfm->createFile(fileName);
+    assert(rc == success && "Creating the file should not fail.");
+
+    FileHandle fileHandle;
+    rc = pfm->openFile(fileName, fileHandle);
+    assert(rc == success && "Opening the file should not fail.");
+    void *data = malloc(PAGE_SIZE);
+    for(unsigned j = 0; j < NUM_PAGES; j++)
+    {
+        memset(data, 'a' + j % 26, PAGE_SIZE);
+        rc = fileHandle.appendPage(data);
+        assert(rc == success && "Appending a page should not fail.");
+    }
+    rc = pfm->closeFile(fileHandle);
+    assert(rc == success && "Closing the file should not fail.");
+
+    if (aio->setEngine(IoUring) == success)
+    {
+        cout << "Testing the io_uring engine" << endl;
+        testEngine(pfm, aio, fileName);
+    }
+    else
+        cout << "io_uring is not available, skipping it" << endl;
+
+    rc = aio->setEngine(ThreadPool);
+    assert(rc == success && "Switching to the thread pool should not fail.");
+    cout << "Testing the thread pool engine" << endl;
+    testEngine(pfm, aio, fileName);
+
+    // Prefetched pages are then served from the pool without going to disk
+    unsigned readPageCount = 0;
+    unsigned writePageCount = 0;
+    unsigned appendPageCount = 0;
+    rc = pfm->openFile(fileName, fileHandle);
+    assert(rc == success && "Opening the file should not fail.");
+    rc = bpm->prefetchPages(fileHandle, 10, 50);
+    assert(rc == success && "Prefetching pages should not fail.");
+    rc = fileHandle.collectCounterValues(readPageCount, writePageCount, appendPageCount);
+    assert(rc == success && "collectCounterValues() should not fail.");
+    assert(readPageCount == 50 && "Every prefetched page should be read once.");
+    for(unsigned j = 10; j < 60; j++)
+    {
+        rc = bpm->readPage(fileHandle, j, data);
+        assert(rc == success && "Reading a page through the pool should not fail.");
+        assert(*((char *) data) == (char) ('a' + j % 26) && "Checking the integrity of a page should not fail.");
+    }
+    rc = fileHandle.collectCounterValues(readPageCount, writePageCount, appendPageCount);
+    assert(rc == success && "collectCounterValues() should not fail.");
+    assert(readPageCount == 50 && "Prefetched pages should not be read again.");
+    rc = pfm->closeFile(fileHandle);
+    assert(rc == success && "Closing the file should not fail.");
+
+    rc = pfm->destroyFile(fileName);
+    assert(rc == success && "Destroying the file should not fail.");
+
+    rc = destroyFileShouldSucceed(fileName);
+    assert(rc == success  && "Destroying the file should not fail.");
+
+    free(data);
+
+    cout << "RBF Test Case 18 Finished! The result will be examined." << endl << endl;
+    return 0;
+}
+
+int main()
+{
+    // To test asynchronous page I/O
+    PagedFileManager *pfm = PagedFileManager::instance();
+    BufferPoolManager *bpm = BufferPoolManager::instance();
+    AsyncIOManager *aio = AsyncIOManager::instance();
+
+    remove("test18");
+
+    RC rcmain = RBFTest_18(pfm, bpm, aio);
+    return rcmain;
+}
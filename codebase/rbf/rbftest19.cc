@@ -0,0 +1,131 @@
+#include <iostream>
+#include <string>
+#include <cassert>
+#include <sys/stat.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdexcept>
+#include <stdio.h>
+
+#include "pfm.h"
+#include "bpm.h"
+#include "aio.h"
+#include "rbfm.h"
+#include "test_util.h"
+
+using namespace std;
+
+// Scan the whole file, checking every record, and return how many there were
+static int scanAll(RecordBasedFileManager *rbfm, FileHandle &fileHandle, const vector<Attribute> &recordDescriptor,
+                   bool checkReadAhead)
+{
+    vector<string> attributeNames;
+    attributeNames.push_back("attr1");
+
+    RBFM_ScanIterator rbfm_ScanIterator;
+    RC rc = rbfm->scan(fileHandle, recordDescriptor, "", NO_OP, NULL, attributeNames, rbfm_ScanIterator);
+    assert(rc == success && "Scanning the file should not fail.");
+
+    RID rid;
+    char returnedData[100];
+    int count = 0;
+    while(rbfm_ScanIterator.getNextRecord(rid, returnedData) != RBFM_EOF)
+    {
+        // The first page is read on its own, the ones after it should already be on their way
+        if (count == 0 && checkReadAhead)
+            assert(AsyncIOManager::instance()->getInFlight() > 0 && "The scan should read ahead.");
+        int value;
+        memcpy(&value, returnedData + 1, sizeof(int));
+        assert(value >= 0 && value < 3000 && "Returned Data should be one of the inserted records.");
+        count++;
+    }
+    rbfm_ScanIterator.close();
+    assert(AsyncIOManager::instance()->getInFlight() == 0 && "Closing the scan should finish its reads.");
+    return count;
+}
+
+int RBFTest_19(RecordBasedFileManager *rbfm, BufferPoolManager *bpm)
+{
+    // Functions Tested:
+    // 1. Scan with read ahead returns every record
+    // 2. Read ahead keeps pages in flight ahead of the scan
+    // 3. Read ahead with a pool smaller than the window
+    cout << endl << "***** In RBF Test Case 19 *****" << endl;
+
+    RC rc;
+    string fileName = "test19";
+
+    rc = rbfm->createFile(fileName);
+    assert(rc == success && "Creating the file should not fail.");
+
+    FileHandle fileHandle;
+    rc = rbfm->openFile(fileName, fileHandle);
+    assert(rc == success && "Opening the file should not fail.");
+
+    vector<Attribute> recordDescriptor;
+    createLargeRecordDescriptor(recordDescriptor);
+
+    int nullFieldsIndicatorActualSize = getActualByteForNullsIndicator(recordDescriptor.size());
+    unsigned char *nullsIndicator = (unsigned char *) malloc(nullFieldsIndicatorActualSize);
+    memset(nullsIndicator, 0, nullFieldsIndicatorActualSize);
+
+    void *record = malloc(1000);
+    RID rid;
+    int size = 0;
+    int numRecords = 3000;
+    for(int i = 0; i < numRecords; i++)
+    {
+        memset(record, 0, 1000);
+        prepareLargeRecord(recordDescriptor.size(), nullsIndicator, i, record, &size);
+        rc = rbfm->insertRecord(fileHandle, recordDescriptor, record, rid);
+        assert(rc == success && "Inserting a record should not fail.");
+    }
+    cout << "Number of pages: " << fileHandle.getNumberOfPages() << endl;
+
+    // Resizing the pool empties it, so the scans below start cold
+    rc = bpm->setPoolSize(BPM_DEFAULT_POOL_SIZE);
+    assert(rc == success && "Resizing the pool should not fail.");
+
+    rbfm->setScanReadAhead(16);
+    assert(scanAll(rbfm, fileHandle, recordDescriptor, true) == numRecords && "The scan should return every record.");
+
+    rbfm->setScanReadAhead(0);
+    rc = bpm->setPoolSize(BPM_DEFAULT_POOL_SIZE);
+    assert(rc == success && "Resizing the pool should not fail.");
+    assert(scanAll(rbfm, fileHandle, recordDescriptor, false) == numRecords && "The scan should return every record.");
+
+    // The window is cut down to what a tiny pool can hold
+    rbfm->setScanReadAhead(RBFM_SCAN_READAHEAD);
+    rc = bpm->setPoolSize(8);
+    assert(rc == success && "Resizing the pool should not fail.");
+    assert(scanAll(rbfm, fileHandle, recordDescriptor, true) == numRecords && "The scan should return every record.");
+    rc = bpm->setPoolSize(BPM_DEFAULT_POOL_SIZE);
+    assert(rc == success && "Resizing the pool should not fail.");
+
+    rc = rbfm->closeFile(fileHandle);
+    assert(rc == success && "Closing the file should not fail.");
+
+    rc = rbfm->destroyFile(fileName);
+    assert(rc == success && "Destroying the file should not fail.");
+
+    rc = destroyFileShouldSucceed(fileName);
+    assert(rc == success  && "Destroying the file should not fail.");
+
+    free(record);
+    free(nullsIndicator);
+
+    cout << "RBF Test Case 19 Finished! The result will be examined." << endl << endl;
+    return 0;
+}
+
+int main()
+{
+    // To test scan read ahead
+    RecordBasedFileManager *rbfm = RecordBasedFileManager::instance();
+    BufferPoolManager *bpm = BufferPoolManager::instance();
+
+    remove("test19");
+
+    RC rcmain = RBFTest_19(rbfm, bpm);
+    return rcmain;
+}
@@ -0,0 +1,173 @@
+#include <iostream>
+#include <string>
+#include <cassert>
+#include <sys/stat.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdexcept>
+#include <stdio.h>
+
+#include "pfm.h"
+#include "rbfm.h"
+#include "test_util.h"
+
+using namespace std;
+
+// Scan with one condition, check the number of matches and return the pages the scan read
+static unsigned scanAndCount(RecordBasedFileManager *rbfm, FileHandle &fileHandle, const vector<Attribute> &recordDescriptor,
+                             const string &attribute, CompOp compOp, const void *value, int expected)
+{
+    unsigned logicalReadBefore, logicalReadAfter, logicalWriteCount;
+    RC rc = fileHandle.collectLogicalCounterValues(logicalReadBefore, logicalWriteCount);
+    assert(rc == success && "collectLogicalCounterValues() should not fail.");
+
+    vector<string> attributeNames;
+    attributeNames.push_back("attr1");
+    RBFM_ScanIterator rbfm_ScanIterator;
+    rc = rbfm->scan(fileHandle, recordDescriptor, attribute, compOp, value, attributeNames, rbfm_ScanIterator);
+    assert(rc == success && "Scanning the file should not fail.");
+
+    RID rid;
+    char returnedData[PAGE_SIZE];
+    int count = 0;
+    while(rbfm_ScanIterator.getNextRecord(rid, returnedData) != RBFM_EOF)
+        count++;
+    rbfm_ScanIterator.close();
+    cout << attribute << " scan: " << count << " matches" << endl;
+    assert(count == expected && "The scan should return every matching record.");
+
+    rc = fileHandle.collectLogicalCounterValues(logicalReadAfter, logicalWriteCount);
+    assert(rc == success && "collectLogicalCounterValues() should not fail.");
+    return logicalReadAfter - logicalReadBefore;
+}
+
+int RBFTest_20(RecordBasedFileManager *rbfm)
+{
+    // Functions Tested:
+    // 1. Create Zone Map over a file with records in it
+    // 2. Scans skip pages the zone map rules out, for int, real and varchar conditions
+    // 3. The zone map follows inserts, updates and deletes, and survives reopening the file
+    // 4. Destroy Zone Map, and destroying the file removes it
+    cout << endl << "***** In RBF Test Case 20 *****" << endl;
+
+    RC rc;
+    string fileName = "test20";
+    string zoneFileName = fileName + ZONE_FILE_SUFFIX;
+
+    rc = rbfm->createFile(fileName);
+    assert(rc == success && "Creating the file should not fail.");
+
+    FileHandle fileHandle;
+    rc = rbfm->openFile(fileName, fileHandle);
+    assert(rc == success && "Opening the file should not fail.");
+
+    vector<Attribute> recordDescriptor;
+    createLargeRecordDescriptor(recordDescriptor);
+
+    int nullFieldsIndicatorActualSize = getActualByteForNullsIndicator(recordDescriptor.size());
+    unsigned char *nullsIndicator = (unsigned char *) malloc(nullFieldsIndicatorActualSize);
+    memset(nullsIndicator, 0, nullFieldsIndicatorActualSize);
+
+    // attr1 grows with the insertion order, like a timestamp
+    void *record = malloc(1000);
+    vector<RID> rids;
+    RID rid;
+    int size = 0;
+    int numRecords = 2000;
+    for(int i = 0; i < numRecords; i++)
+    {
+        prepareLargeRecord(recordDescriptor.size(), nullsIndicator, i, record, &size);
+        rc = rbfm->insertRecord(fileHandle, recordDescriptor, record, rid);
+        assert(rc == success && "Inserting a record should not fail.");
+        rids.push_back(rid);
+    }
+
+    int recent = 1900;
+    unsigned fullScan = scanAndCount(rbfm, fileHandle, recordDescriptor, "attr1", GE_OP, &recent, 100);
+
+    rc = rbfm->createZoneMap(fileName, recordDescriptor);
+    assert(rc == success && "Creating a zone map should not fail.");
+    assert(FileExists(zoneFileName) && "The zone file should exist.");
+    rc = rbfm->createZoneMap(fileName, recordDescriptor);
+    assert(rc == RBFM_ZONE_MAP_EXISTS && "Creating a second zone map should fail.");
+
+    unsigned zoneScan = scanAndCount(rbfm, fileHandle, recordDescriptor, "attr1", GE_OP, &recent, 100);
+    cout << "Pages read without / with the zone map: " << fullScan << " / " << zoneScan << endl;
+    assert(zoneScan * 4 < fullScan && "The zone map should let the scan skip most pages.");
+
+    float height = 50.5;
+    scanAndCount(rbfm, fileHandle, recordDescriptor, "attr2", LT_OP, &height, 50);
+
+    // Only "a" itself is <= "a", longer runs of a's sort after it
+    char varchar[8];
+    int length = 1;
+    memcpy(varchar, &length, sizeof(int));
+    varchar[4] = 'a';
+    scanAndCount(rbfm, fileHandle, recordDescriptor, "attr0", LE_OP, varchar, 4);
+    varchar[4] = 'z' + 1;
+    zoneScan = scanAndCount(rbfm, fileHandle, recordDescriptor, "attr0", GE_OP, varchar, 0);
+    assert(zoneScan == 0 && "No page should be read when the zone map rules them all out.");
+
+    // Deleting the recent records narrows the zones of their pages
+    for(int i = recent; i < numRecords; i++)
+    {
+        rc = rbfm->deleteRecord(fileHandle, recordDescriptor, rids[i]);
+        assert(rc == success && "Deleting a record should not fail.");
+    }
+    zoneScan = scanAndCount(rbfm, fileHandle, recordDescriptor, "attr1", GE_OP, &recent, 0);
+    assert(zoneScan == 0 && "Pages emptied of matches should be skipped.");
+
+    // An update and an insert widen them again
+    prepareLargeRecord(recordDescriptor.size(), nullsIndicator, 5000, record, &size);
+    rc = rbfm->updateRecord(fileHandle, recordDescriptor, record, rids[0]);
+    assert(rc == success && "Updating a record should not fail.");
+    prepareLargeRecord(recordDescriptor.size(), nullsIndicator, 3000, record, &size);
+    rc = rbfm->insertRecord(fileHandle, recordDescriptor, record, rid);
+    assert(rc == success && "Inserting a record should not fail.");
+    scanAndCount(rbfm, fileHandle, recordDescriptor, "attr1", GE_OP, &recent, 2);
+
+    // The zone map is picked up again when the file is reopened
+    rc = rbfm->closeFile(fileHandle);
+    assert(rc == success && "Closing the file should not fail.");
+    rc = rbfm->openFile(fileName, fileHandle);
+    assert(rc == success && "Opening the file should not fail.");
+    zoneScan = scanAndCount(rbfm, fileHandle, recordDescriptor, "attr1", GE_OP, &recent, 2);
+    assert(zoneScan * 4 < fullScan && "The zone map should still let the scan skip most pages.");
+
+    rc = rbfm->destroyZoneMap(fileName);
+    assert(rc == success && "Destroying the zone map should not fail.");
+    assert(!FileExists(zoneFileName) && "The zone file should be gone.");
+    scanAndCount(rbfm, fileHandle, recordDescriptor, "attr1", GE_OP, &recent, 2);
+
+    rc = rbfm->createZoneMap(fileName, recordDescriptor);
+    assert(rc == success && "Creating a zone map should not fail.");
+    scanAndCount(rbfm, fileHandle, recordDescriptor, "attr1", GE_OP, &recent, 2);
+
+    rc = rbfm->closeFile(fileHandle);
+    assert(rc == success && "Closing the file should not fail.");
+
+    rc = rbfm->destroyFile(fileName);
+    assert(rc == success && "Destroying the file should not fail.");
+    assert(!FileExists(zoneFileName) && "Destroying the file should remove its zone map.");
+
+    rc = destroyFileShouldSucceed(fileName);
+    assert(rc == success  && "Destroying the file should not fail.");
+
+    free(record);
+    free(nullsIndicator);
+
+    cout << "RBF Test Case 20 Finished! The result will be examined." << endl << endl;
+    return 0;
+}
+
+int main()
+{
+    // To test zone maps
+    RecordBasedFileManager *rbfm = RecordBasedFileManager::instance();
+
+    remove("test20");
+    remove("test20.zone");
+
+    RC rcmain = RBFTest_20(rbfm);
+    return rcmain;
+}
@@ -0,0 +1,207 @@
+#include <iostream>
+#include <string>
+#include <cassert>
+#include <cmath>
+#include <sys/stat.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdexcept>
+#include <stdio.h>
+
+#include "pfm.h"
+#include "rbfm.h"
+#include "filter.h"
+#include "test_util.h"
+
+using namespace std;
+
+template <typename T>
+static bool reference(T value, CompOp compOp, T constant)
+{
+    switch (compOp)
+    {
+        case EQ_OP: return value == constant;
+        case LT_OP: return value < constant;
+        case GT_OP: return value > constant;
+        case LE_OP: return value <= constant;
+        case GE_OP: return value >= constant;
+        case NE_OP: return value != constant;
+        default: return true;
+    }
+}
+
+template <typename T>
+static void checkSelection(const T *values, unsigned count, CompOp compOp, T constant, const uint8_t *selection)
+{
+    for (unsigned i = 0; i < count; i++)
+    {
+        bool selected = (selection[i / 8] >> (i % 8)) & 1;
+        assert(selected == reference(values[i], compOp, constant) && "The kernel should agree with a plain comparison.");
+    }
+}
+
+// Number of records a scan returns
+static int countMatches(RecordBasedFileManager *rbfm, FileHandle &fileHandle, const vector<Attribute> &recordDescriptor,
+                        const string &attribute, CompOp compOp, const void *value)
+{
+    vector<string> attributeNames;
+    attributeNames.push_back("attr1");
+    RBFM_ScanIterator rbfm_ScanIterator;
+    RC rc = rbfm->scan(fileHandle, recordDescriptor, attribute, compOp, value, attributeNames, rbfm_ScanIterator);
+    assert(rc == success && "Scanning the file should not fail.");
+
+    RID rid;
+    char returnedData[PAGE_SIZE];
+    int count = 0;
+    while(rbfm_ScanIterator.getNextRecord(rid, returnedData) != RBFM_EOF)
+        count++;
+    rbfm_ScanIterator.close();
+    return count;
+}
+
+int RBFTest_21(RecordBasedFileManager *rbfm)
+{
+    // Functions Tested:
+    // 1. Every supported predicate kernel agrees with plain comparisons, for every CompOp
+    // 2. Kernels handle lengths that aren't a multiple of the vector width, extreme ints, NaN and infinities
+    // 3. Scans with int and real conditions return the same records with every kernel
+    cout << endl << "***** In RBF Test Case 21 *****" << endl;
+
+    RC rc;
+    FilterKernel kernels[] = { ScalarKernel, SSEKernel, AVX2Kernel };
+    const char *kernelNames[] = { "scalar", "SSE", "AVX2" };
+    CompOp compOps[] = { EQ_OP, LT_OP, GT_OP, LE_OP, GE_OP, NE_OP, NO_OP };
+    FilterKernel defaultKernel = getFilterKernel();
+    cout << "Default kernel: " << kernelNames[defaultKernel] << endl;
+
+    unsigned maxCount = 1000;
+    int32_t *ints = (int32_t *) malloc(maxCount * sizeof(int32_t));
+    float *reals = (float *) malloc(maxCount * sizeof(float));
+    uint8_t *selection = (uint8_t *) malloc(maxCount / 8 + 1);
+    srand(21);
+    for (unsigned i = 0; i < maxCount; i++)
+    {
+        ints[i] = rand() % 64 - 32;
+        reals[i] = (float) (rand() % 64 - 32) / 4;
+    }
+    ints[3] = INT32_MIN;
+    ints[10] = INT32_MAX;
+    reals[5] = NAN;
+    reals[12] = INFINITY;
+    reals[13] = -INFINITY;
+    reals[17] = -0.0f;
+
+    for (unsigned k = 0; k < 3; k++)
+    {
+        if (!filterKernelSupported(kernels[k]))
+        {
+            cout << kernelNames[k] << " kernel not supported here" << endl;
+            continue;
+        }
+        rc = setFilterKernel(kernels[k]);
+        assert(rc == success && "Choosing a supported kernel should not fail.");
+        cout << "Checking the " << kernelNames[k] << " kernel" << endl;
+
+        for (unsigned op = 0; op < 7; op++)
+        {
+            for (unsigned count = 0; count <= 70; count++)
+            {
+                filterInts(ints, count, compOps[op], 0, selection);
+                checkSelection(ints, count, compOps[op], 0, selection);
+                filterReals(reals, count, compOps[op], 0.0f, selection);
+                checkSelection(reals, count, compOps[op], 0.0f, selection);
+            }
+            filterInts(ints, maxCount, compOps[op], 7, selection);
+            checkSelection(ints, maxCount, compOps[op], 7, selection);
+            filterInts(ints, maxCount, compOps[op], INT32_MIN, selection);
+            checkSelection(ints, maxCount, compOps[op], INT32_MIN, selection);
+            filterReals(reals, maxCount, compOps[op], -2.25f, selection);
+            checkSelection(reals, maxCount, compOps[op], -2.25f, selection);
+            filterReals(reals, maxCount, compOps[op], (float) NAN, selection);
+            checkSelection(reals, maxCount, compOps[op], (float) NAN, selection);
+        }
+    }
+
+    // Scans give the same answers whichever kernel evaluates their condition
+    string fileName = "test21";
+    rc = rbfm->createFile(fileName);
+    assert(rc == success && "Creating the file should not fail.");
+
+    FileHandle fileHandle;
+    rc = rbfm->openFile(fileName, fileHandle);
+    assert(rc == success && "Opening the file should not fail.");
+
+    vector<Attribute> recordDescriptor;
+    createLargeRecordDescriptor(recordDescriptor);
+
+    int nullFieldsIndicatorActualSize = getActualByteForNullsIndicator(recordDescriptor.size());
+    unsigned char *nullsIndicator = (unsigned char *) malloc(nullFieldsIndicatorActualSize);
+    memset(nullsIndicator, 0, nullFieldsIndicatorActualSize);
+
+    void *record = malloc(1000);
+    vector<RID> rids;
+    RID rid;
+    int size = 0;
+    int numRecords = 1000;
+    for(int i = 0; i < numRecords; i++)
+    {
+        prepareLargeRecord(recordDescriptor.size(), nullsIndicator, i, record, &size);
+        rc = rbfm->insertRecord(fileHandle, recordDescriptor, record, rid);
+        assert(rc == success && "Inserting a record should not fail.");
+        rids.push_back(rid);
+    }
+    // Every tenth record is deleted, and their slots must never match
+    for(int i = 0; i < numRecords; i += 10)
+    {
+        rc = rbfm->deleteRecord(fileHandle, recordDescriptor, rids[i]);
+        assert(rc == success && "Deleting a record should not fail.");
+    }
+
+    int intValue = 300;
+    float realValue = 501;
+    for (unsigned k = 0; k < 3; k++)
+    {
+        if (!filterKernelSupported(kernels[k]))
+            continue;
+        rc = setFilterKernel(kernels[k]);
+        assert(rc == success && "Choosing a supported kernel should not fail.");
+
+        // attr1 is the record index, attr2 the index plus one
+        assert(countMatches(rbfm, fileHandle, recordDescriptor, "attr1", LT_OP, &intValue) == 270 && "The int scan should find every match.");
+        assert(countMatches(rbfm, fileHandle, recordDescriptor, "attr1", NE_OP, &intValue) == 900 && "The int scan should find every match.");
+        assert(countMatches(rbfm, fileHandle, recordDescriptor, "attr2", GE_OP, &realValue) == 450 && "The real scan should find every match.");
+        assert(countMatches(rbfm, fileHandle, recordDescriptor, "attr2", EQ_OP, &realValue) == 0 && "Deleted records should never match.");
+    }
+
+    rc = setFilterKernel(defaultKernel);
+    assert(rc == success && "Choosing a supported kernel should not fail.");
+
+    rc = rbfm->closeFile(fileHandle);
+    assert(rc == success && "Closing the file should not fail.");
+
+    rc = rbfm->destroyFile(fileName);
+    assert(rc == success && "Destroying the file should not fail.");
+
+    rc = destroyFileShouldSucceed(fileName);
+    assert(rc == success  && "Destroying the file should not fail.");
+
+    free(ints);
+    free(reals);
+    free(selection);
+    free(record);
+    free(nullsIndicator);
+
+    cout << "RBF Test Case 21 Finished! The result will be examined." << endl << endl;
+    return 0;
+}
+
+int main()
+{
+    // To test the predicate kernels
+    RecordBasedFileManager *rbfm = RecordBasedFileManager::instance();
+
+    remove("test21");
+
+    RC rcmain = RBFTest_21(rbfm);
+    return rcmain;
+}
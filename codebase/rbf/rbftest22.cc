@@ -0,0 +1,248 @@
+#include <iostream>
+#include <string>
+#include <cassert>
+#include <sys/stat.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdexcept>
+#include <stdio.h>
+
+#include "pfm.h"
+#include "rbfm.h"
+#include "test_util.h"
+
+using namespace std;
+
+// Records are made by prepareLargeRecord, so for record i attr1 is i, attr2 is i + 1 and
+// attr0 is i % 50 + 1 copies of the letter i % 26. Every seventh record is deleted.
+#define NUM_RECORDS 2000
+
+static bool deleted(int i)
+{
+    return i % 7 == 0;
+}
+
+static void makeAttr0(int i, char *value)
+{
+    int count = i % 50 + 1;
+    memcpy(value, &count, sizeof(int));
+    memset(value + sizeof(int), i % 26 + 97, count);
+}
+
+// Run the scan, check that every record it returns should match and that it finds all of them.
+// Returns the pages the scan read.
+static unsigned scanAndCheck(RecordBasedFileManager *rbfm, FileHandle &fileHandle, const vector<Attribute> &recordDescriptor,
+                             const vector<ScanPredicate> &predicates, bool (*expected)(int), bool batch)
+{
+    unsigned logicalReadBefore, logicalReadAfter, logicalWriteCount;
+    RC rc = fileHandle.collectLogicalCounterValues(logicalReadBefore, logicalWriteCount);
+    assert(rc == success && "collectLogicalCounterValues() should not fail.");
+
+    // Project attr1 alone, so every row is a null byte and the record's number
+    vector<string> attributeNames;
+    attributeNames.push_back("attr1");
+    RBFM_ScanIterator rbfm_ScanIterator;
+    rc = rbfm->scan(fileHandle, recordDescriptor, predicates, attributeNames, rbfm_ScanIterator);
+    assert(rc == success && "Scanning the file should not fail.");
+
+    int count = 0;
+    if (batch)
+    {
+        vector<RID> rids;
+        char returnedData[64 * (1 + sizeof(int))];
+        while(rbfm_ScanIterator.getNextBatch(rids, returnedData, 64) != RBFM_EOF)
+        {
+            for (unsigned j = 0; j < rids.size(); j++)
+            {
+                int i;
+                memcpy(&i, returnedData + j * (1 + sizeof(int)) + 1, sizeof(int));
+                assert(!deleted(i) && expected(i) && "The scan should only return matching records.");
+                count++;
+            }
+        }
+    }
+    else
+    {
+        RID rid;
+        char returnedData[PAGE_SIZE];
+        while(rbfm_ScanIterator.getNextRecord(rid, returnedData) != RBFM_EOF)
+        {
+            int i;
+            memcpy(&i, returnedData + 1, sizeof(int));
+            assert(!deleted(i) && expected(i) && "The scan should only return matching records.");
+            count++;
+        }
+    }
+    rbfm_ScanIterator.close();
+
+    int expectedCount = 0;
+    for (int i = 0; i < NUM_RECORDS; i++)
+        if (!deleted(i) && expected(i))
+            expectedCount++;
+    cout << "scan with " << predicates.size() << " predicates: " << count << " matches" << endl;
+    assert(count == expectedCount && "The scan should return every matching record.");
+
+    rc = fileHandle.collectLogicalCounterValues(logicalReadAfter, logicalWriteCount);
+    assert(rc == success && "collectLogicalCounterValues() should not fail.");
+    return logicalReadAfter - logicalReadBefore;
+}
+
+static bool inRangeWithLetterC(int i) { return i >= 500 && i < 1500 && i % 26 == 2 && i % 50 == 2; }
+static bool outerWithoutFifty(int i) { return (i < 100 || i > 1900) && i + 1 != 50; }
+static bool twoGroups(int i) { return (i < 300 || i >= 1700) && (i % 650 == 0 || i + 1 <= 150) && i > 0; }
+static bool outerOnly(int i) { return i < 100 || i > 1900; }
+static bool nothing(int) { return false; }
+static bool everything(int) { return true; }
+static bool middle(int i) { return i >= 1000 && i < 1100 && i != 1050; }
+
+int RBFTest_22(RecordBasedFileManager *rbfm)
+{
+    // Functions Tested:
+    // 1. Scans with several ANDed predicates, and with OR groups
+    // 2. Predicates on int, real and varchar attributes, NULL values and NO_OP predicates
+    // 3. The same scans with a zone map, which lets ANDed predicates skip pages
+    cout << endl << "***** In RBF Test Case 22 *****" << endl;
+
+    RC rc;
+    string fileName = "test22";
+
+    rc = rbfm->createFile(fileName);
+    assert(rc == success && "Creating the file should not fail.");
+
+    FileHandle fileHandle;
+    rc = rbfm->openFile(fileName, fileHandle);
+    assert(rc == success && "Opening the file should not fail.");
+
+    vector<Attribute> recordDescriptor;
+    createLargeRecordDescriptor(recordDescriptor);
+
+    int nullFieldsIndicatorActualSize = getActualByteForNullsIndicator(recordDescriptor.size());
+    unsigned char *nullsIndicator = (unsigned char *) malloc(nullFieldsIndicatorActualSize);
+    memset(nullsIndicator, 0, nullFieldsIndicatorActualSize);
+
+    void *record = malloc(1000);
+    vector<RID> rids;
+    RID rid;
+    int size = 0;
+    for(int i = 0; i < NUM_RECORDS; i++)
+    {
+        prepareLargeRecord(recordDescriptor.size(), nullsIndicator, i, record, &size);
+        rc = rbfm->insertRecord(fileHandle, recordDescriptor, record, rid);
+        assert(rc == success && "Inserting a record should not fail.");
+        rids.push_back(rid);
+    }
+    for(int i = 0; i < NUM_RECORDS; i++)
+    {
+        if (!deleted(i))
+            continue;
+        rc = rbfm->deleteRecord(fileHandle, recordDescriptor, rids[i]);
+        assert(rc == success && "Deleting a record should not fail.");
+    }
+
+    int low = 500, high = 1500, outerLow = 100, outerHigh = 1900, groupLow = 300, groupHigh = 1700;
+    int zero = 0, middleLow = 1000, middleHigh = 1100, middleHole = 1050;
+    float fifty = 50, hundredFifty = 150;
+    char letterC[64], letterA[64];
+    makeAttr0(2, letterC);
+    makeAttr0(0, letterA);
+
+    vector<ScanPredicate> rangeWithLetter;
+    rangeWithLetter.push_back(makePredicate("attr0", EQ_OP, letterC, 0));
+    rangeWithLetter.push_back(makePredicate("attr1", GE_OP, &low, 0));
+    rangeWithLetter.push_back(makePredicate("attr1", LT_OP, &high, 0));
+
+    vector<ScanPredicate> outerAndReal;
+    outerAndReal.push_back(makePredicate("attr1", LT_OP, &outerLow, 1));
+    outerAndReal.push_back(makePredicate("attr2", NE_OP, &fifty, 0));
+    outerAndReal.push_back(makePredicate("attr1", GT_OP, &outerHigh, 1));
+
+    // attr0 is "a" for every record i with i % 650 == 0. A NO_OP predicate on its own always holds.
+    vector<ScanPredicate> groups;
+    groups.push_back(makePredicate("attr1", LT_OP, &groupLow, 3));
+    groups.push_back(makePredicate("attr1", GE_OP, &groupHigh, 3));
+    groups.push_back(makePredicate("attr0", EQ_OP, letterA, 5));
+    groups.push_back(makePredicate("attr2", LE_OP, &hundredFifty, 5));
+    groups.push_back(makePredicate("attr1", GT_OP, &zero, 0));
+    groups.push_back(makePredicate("attr1", NO_OP, NULL, 0));
+
+    vector<ScanPredicate> outer;
+    outer.push_back(makePredicate("attr1", LT_OP, &outerLow, 2));
+    outer.push_back(makePredicate("attr1", GT_OP, &outerHigh, 2));
+
+    // A NO_OP predicate makes its group always hold
+    vector<ScanPredicate> alwaysGroup = outer;
+    alwaysGroup.push_back(makePredicate("attr2", NO_OP, NULL, 4));
+    alwaysGroup.push_back(makePredicate("attr2", EQ_OP, &fifty, 4));
+
+    vector<ScanPredicate> withNull = rangeWithLetter;
+    withNull.push_back(makePredicate("attr7", EQ_OP, NULL, 0));
+
+    vector<ScanPredicate> none;
+
+    vector<ScanPredicate> middleRange;
+    middleRange.push_back(makePredicate("attr1", NE_OP, &middleHole, 0));
+    middleRange.push_back(makePredicate("attr4", GE_OP, &middleLow, 0));
+    middleRange.push_back(makePredicate("attr4", LT_OP, &middleHigh, 0));
+
+    vector<ScanPredicate> badAttribute = rangeWithLetter;
+    badAttribute.push_back(makePredicate("attr99", EQ_OP, &zero, 0));
+
+    for (unsigned pass = 0; pass < 2; pass++)
+    {
+        bool batch = pass == 1;
+        scanAndCheck(rbfm, fileHandle, recordDescriptor, rangeWithLetter, inRangeWithLetterC, batch);
+        scanAndCheck(rbfm, fileHandle, recordDescriptor, outerAndReal, outerWithoutFifty, batch);
+        scanAndCheck(rbfm, fileHandle, recordDescriptor, groups, twoGroups, batch);
+        scanAndCheck(rbfm, fileHandle, recordDescriptor, outer, outerOnly, batch);
+        scanAndCheck(rbfm, fileHandle, recordDescriptor, alwaysGroup, outerOnly, batch);
+        scanAndCheck(rbfm, fileHandle, recordDescriptor, withNull, nothing, batch);
+        scanAndCheck(rbfm, fileHandle, recordDescriptor, none, everything, batch);
+        scanAndCheck(rbfm, fileHandle, recordDescriptor, middleRange, middle, batch);
+
+        // With a zone map, pages outside attr4's range are never read
+        unsigned fullPages = scanAndCheck(rbfm, fileHandle, recordDescriptor, none, everything, batch);
+        unsigned middlePages = scanAndCheck(rbfm, fileHandle, recordDescriptor, middleRange, middle, batch);
+        cout << "pages read: full scan " << fullPages << ", middle range " << middlePages << endl;
+        if (pass == 0)
+        {
+            assert(middlePages == fullPages && "Without a zone map every page should be read.");
+            rc = rbfm->createZoneMap(fileName, recordDescriptor);
+            assert(rc == success && "Creating the zone map should not fail.");
+        }
+        else
+            assert(middlePages * 4 < fullPages && "The zone map should let the scan skip most pages.");
+    }
+
+    RBFM_ScanIterator rbfm_ScanIterator;
+    vector<string> attributeNames;
+    rc = rbfm->scan(fileHandle, recordDescriptor, badAttribute, attributeNames, rbfm_ScanIterator);
+    assert(rc == RBFM_NO_SUCH_ATTR && "A predicate on a missing attribute should fail.");
+    rbfm_ScanIterator.close();
+
+    rc = rbfm->closeFile(fileHandle);
+    assert(rc == success && "Closing the file should not fail.");
+
+    rc = rbfm->destroyFile(fileName);
+    assert(rc == success && "Destroying the file should not fail.");
+
+    rc = destroyFileShouldSucceed(fileName);
+    assert(rc == success  && "Destroying the file should not fail.");
+
+    free(record);
+    free(nullsIndicator);
+
+    cout << "RBF Test Case 22 Finished! The result will be examined." << endl << endl;
+    return 0;
+}
+
+int main()
+{
+    // To test scans with several predicates
+    RecordBasedFileManager *rbfm = RecordBasedFileManager::instance();
+
+    remove("test22");
+    remove("test22.zone");
+
+    RC rcmain = RBFTest_22(rbfm);
+    return rcmain;
+}
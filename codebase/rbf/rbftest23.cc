@@ -0,0 +1,246 @@
+#include <iostream>
+#include <string>
+#include <cassert>
+#include <map>
+#include <sys/stat.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdexcept>
+#include <stdio.h>
+
+#include "pfm.h"
+#include "rbfm.h"
+#include "test_util.h"
+
+using namespace std;
+
+typedef map<pair<unsigned, unsigned>, string> ScanResult;
+
+// Size of a projected (attr0, attr1) row
+static unsigned rowSize(const char *row)
+{
+    int length;
+    memcpy(&length, row + 1, sizeof(int));
+    return 1 + sizeof(int) + length + sizeof(int);
+}
+
+// Every record a scan returns, keyed by RID
+static ScanResult collect(RecordBasedFileManager *rbfm, FileHandle &fileHandle, const vector<Attribute> &recordDescriptor,
+                          const vector<ScanPredicate> &predicates, const vector<string> &attributeNames, ScanMode scanMode, bool batch)
+{
+    RBFM_ScanIterator rbfm_ScanIterator;
+    RC rc = rbfm->scan(fileHandle, recordDescriptor, predicates, attributeNames, rbfm_ScanIterator, scanMode);
+    assert(rc == success && "Scanning the file should not fail.");
+
+    ScanResult result;
+    if (batch)
+    {
+        vector<RID> rids;
+        char *rows = (char *) malloc(100 * PAGE_SIZE);
+        while((rc = rbfm_ScanIterator.getNextBatch(rids, rows, 100)) != RBFM_EOF)
+        {
+            assert(rc == success && "getNextBatch() should not fail.");
+            char *row = rows;
+            for (unsigned i = 0; i < rids.size(); i++)
+            {
+                unsigned size = attributeNames.empty() ? 0 : rowSize(row);
+                bool added = result.insert(make_pair(make_pair(rids[i].pageNum, rids[i].slotNum), string(row, size))).second;
+                assert(added && "A record should only be returned once.");
+                row += size;
+            }
+        }
+        free(rows);
+    }
+    else
+    {
+        RID rid;
+        char row[PAGE_SIZE];
+        while(rbfm_ScanIterator.getNextRecord(rid, row) != RBFM_EOF)
+        {
+            unsigned size = attributeNames.empty() ? 0 : rowSize(row);
+            bool added = result.insert(make_pair(make_pair(rid.pageNum, rid.slotNum), string(row, size))).second;
+            assert(added && "A record should only be returned once.");
+        }
+    }
+    rbfm_ScanIterator.close();
+    return result;
+}
+
+// A parallel scan should return exactly what a plain scan does, in whatever order
+static void compareScans(RecordBasedFileManager *rbfm, FileHandle &fileHandle, const vector<Attribute> &recordDescriptor,
+                         const vector<ScanPredicate> &predicates, const vector<string> &attributeNames)
+{
+    ScanResult expected = collect(rbfm, fileHandle, recordDescriptor, predicates, attributeNames, COPY_SCAN, false);
+    ScanResult parallel = collect(rbfm, fileHandle, recordDescriptor, predicates, attributeNames, PARALLEL_SCAN, false);
+    ScanResult parallelBatch = collect(rbfm, fileHandle, recordDescriptor, predicates, attributeNames, PARALLEL_SCAN, true);
+    cout << "scan with " << predicates.size() << " predicates: " << expected.size() << " records" << endl;
+    assert(parallel == expected && "A parallel scan should return the same records as a plain one.");
+    assert(parallelBatch == expected && "A parallel scan in batches should return the same records as a plain one.");
+}
+
+int RBFTest_23(RecordBasedFileManager *rbfm)
+{
+    // Functions Tested:
+    // 1. Scan in PARALLEL_SCAN mode returns the same records as the default mode, for any number of threads
+    // 2. Int, varchar and multi-predicate conditions, projections and no projection, batches
+    // 3. Closing a parallel scan before the end, and parallel scans of files with a zone map
+    // 4. The file can't be modified or vacuumed while a parallel scan is open
+    cout << endl << "***** In RBF Test Case 23 *****" << endl;
+
+    RC rc;
+    string fileName = "test23";
+
+    rc = rbfm->createFile(fileName);
+    assert(rc == success && "Creating the file should not fail.");
+
+    FileHandle fileHandle;
+    rc = rbfm->openFile(fileName, fileHandle);
+    assert(rc == success && "Opening the file should not fail.");
+
+    vector<Attribute> recordDescriptor;
+    createLargeRecordDescriptor(recordDescriptor);
+
+    int nullFieldsIndicatorActualSize = getActualByteForNullsIndicator(recordDescriptor.size());
+    unsigned char *nullsIndicator = (unsigned char *) malloc(nullFieldsIndicatorActualSize);
+    memset(nullsIndicator, 0, nullFieldsIndicatorActualSize);
+
+    void *record = malloc(1000);
+    vector<RID> rids;
+    RID rid;
+    int size = 0;
+    int numRecords = 5000;
+    for(int i = 0; i < numRecords; i++)
+    {
+        prepareLargeRecord(recordDescriptor.size(), nullsIndicator, i, record, &size);
+        rc = rbfm->insertRecord(fileHandle, recordDescriptor, record, rid);
+        assert(rc == success && "Inserting a record should not fail.");
+        rids.push_back(rid);
+    }
+    // Leave holes, and records that grew out of their page
+    for(int i = 0; i < numRecords; i += 5)
+    {
+        rc = rbfm->deleteRecord(fileHandle, recordDescriptor, rids[i]);
+        assert(rc == success && "Deleting a record should not fail.");
+    }
+    for(int i = 1; i < numRecords; i += 50)
+    {
+        prepareLargeRecord(recordDescriptor.size(), nullsIndicator, 49, record, &size);
+        rc = rbfm->updateRecord(fileHandle, recordDescriptor, record, rids[i]);
+        assert(rc == success && "Updating a record should not fail.");
+    }
+
+    vector<string> attributeNames;
+    attributeNames.push_back("attr0");
+    attributeNames.push_back("attr1");
+    vector<string> noAttributes;
+
+    int half = numRecords / 2;
+    int fortyNine = 49;
+    char letterC[64];
+    int count = 3;
+    memcpy(letterC, &count, sizeof(int));
+    memset(letterC + sizeof(int), 'c', count);
+
+    vector<ScanPredicate> all;
+    vector<ScanPredicate> lowerHalf;
+    lowerHalf.push_back(makePredicate("attr1", LT_OP, &half, 0));
+    vector<ScanPredicate> letter;
+    letter.push_back(makePredicate("attr0", EQ_OP, letterC, 0));
+    vector<ScanPredicate> mixed;
+    mixed.push_back(makePredicate("attr4", GE_OP, &half, 1));
+    mixed.push_back(makePredicate("attr7", EQ_OP, &fortyNine, 1));
+    mixed.push_back(makePredicate("attr0", NE_OP, letterC, 0));
+
+    unsigned threads[] = { 1, 3, 8 };
+    for (unsigned t = 0; t < 3; t++)
+    {
+        cout << threads[t] << " threads" << endl;
+        rbfm->setScanThreads(threads[t]);
+        compareScans(rbfm, fileHandle, recordDescriptor, all, attributeNames);
+        compareScans(rbfm, fileHandle, recordDescriptor, all, noAttributes);
+        compareScans(rbfm, fileHandle, recordDescriptor, lowerHalf, attributeNames);
+        compareScans(rbfm, fileHandle, recordDescriptor, letter, attributeNames);
+        compareScans(rbfm, fileHandle, recordDescriptor, mixed, attributeNames);
+    }
+
+    // The single condition scan takes the parallel option too
+    RBFM_ScanIterator rbfm_ScanIterator;
+    rc = rbfm->scan(fileHandle, recordDescriptor, "attr1", LT_OP, &half, attributeNames, rbfm_ScanIterator, PARALLEL_SCAN);
+    assert(rc == success && "Scanning the file should not fail.");
+    char row[PAGE_SIZE];
+    unsigned matches = 0;
+    while(rbfm_ScanIterator.getNextRecord(rid, row) != RBFM_EOF)
+    {
+        int value;
+        memcpy(&value, row + rowSize(row) - sizeof(int), sizeof(int));
+        assert(value < half && "A parallel scan should only return matching records.");
+        matches++;
+    }
+    rbfm_ScanIterator.close();
+    assert(matches == collect(rbfm, fileHandle, recordDescriptor, lowerHalf, attributeNames, COPY_SCAN, false).size() &&
+           "A parallel scan should return every matching record.");
+
+    // Stopping early, while the workers are still going
+    rc = rbfm->scan(fileHandle, recordDescriptor, all, attributeNames, rbfm_ScanIterator, PARALLEL_SCAN);
+    assert(rc == success && "Scanning the file should not fail.");
+    for (unsigned i = 0; i < 10; i++)
+    {
+        rc = rbfm_ScanIterator.getNextRecord(rid, row);
+        assert(rc == success && "getNextRecord() should not fail.");
+    }
+    rc = rbfm_ScanIterator.close();
+    assert(rc == success && "Closing a parallel scan early should not fail.");
+
+    // The workers read the file with no locking, so it stays as it is until the scan is closed
+    rc = rbfm->scan(fileHandle, recordDescriptor, all, attributeNames, rbfm_ScanIterator, PARALLEL_SCAN);
+    assert(rc == success && "Scanning the file should not fail.");
+    prepareLargeRecord(recordDescriptor.size(), nullsIndicator, 2, record, &size);
+    rc = rbfm->insertRecord(fileHandle, recordDescriptor, record, rid);
+    assert(rc == RBFM_FILE_SCANNED && "Inserting during a parallel scan should fail.");
+    rc = rbfm->updateRecord(fileHandle, recordDescriptor, record, rids[2]);
+    assert(rc == RBFM_FILE_SCANNED && "Updating during a parallel scan should fail.");
+    rc = rbfm->deleteRecord(fileHandle, recordDescriptor, rids[2]);
+    assert(rc == RBFM_FILE_SCANNED && "Deleting during a parallel scan should fail.");
+    PageNum cursor = 0;
+    rc = rbfm->vacuum(fileHandle, recordDescriptor, cursor, 0);
+    assert(rc == RBFM_FILE_SCANNED && "Vacuuming during a parallel scan should fail.");
+    rc = rbfm_ScanIterator.close();
+    assert(rc == success && "Closing a parallel scan should not fail.");
+    rc = rbfm->updateRecord(fileHandle, recordDescriptor, record, rids[2]);
+    assert(rc == success && "Updating after a parallel scan should not fail.");
+
+    // With a zone map the workers never see the pages it rules out
+    rc = rbfm->createZoneMap(fileName, recordDescriptor);
+    assert(rc == success && "Creating the zone map should not fail.");
+    compareScans(rbfm, fileHandle, recordDescriptor, lowerHalf, attributeNames);
+    compareScans(rbfm, fileHandle, recordDescriptor, mixed, attributeNames);
+
+    rbfm->setScanThreads(0);
+
+    rc = rbfm->closeFile(fileHandle);
+    assert(rc == success && "Closing the file should not fail.");
+
+    rc = rbfm->destroyFile(fileName);
+    assert(rc == success && "Destroying the file should not fail.");
+
+    rc = destroyFileShouldSucceed(fileName);
+    assert(rc == success  && "Destroying the file should not fail.");
+
+    free(record);
+    free(nullsIndicator);
+
+    cout << "RBF Test Case 23 Finished! The result will be examined." << endl << endl;
+    return 0;
+}
+
+int main()
+{
+    // To test parallel scans
+    RecordBasedFileManager *rbfm = RecordBasedFileManager::instance();
+
+    remove("test23");
+    remove("test23.zone");
+
+    RC rcmain = RBFTest_23(rbfm);
+    return rcmain;
+}
@@ -0,0 +1,162 @@
+#include <iostream>
+#include <string>
+#include <cassert>
+#include <sys/stat.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdexcept>
+#include <stdio.h>
+
+#include "pfm.h"
+#include "bpm.h"
+#include "rbfm.h"
+#include "test_util.h"
+
+using namespace std;
+
+// Check a view of the record prepareLargeRecord made from index, field by field
+static void checkView(RecordView &view, unsigned fieldCount, int index)
+{
+    assert(view.isValid() && "The view should point at a record.");
+    assert(view.getNumberOfFields() == fieldCount && "The view should have every field.");
+    string text(index % 50 + 1, index % 26 + 97);
+    for (unsigned i = 0; i < fieldCount; i += 3)
+    {
+        assert(!view.isNull(i) && "No field should be NULL.");
+        assert(view.getVarCharString(i) == text && "The varchar should read back.");
+        uint32_t length;
+        const char *chars = view.getVarChar(i, length);
+        assert(length == text.size() && memcmp(chars, text.data(), length) == 0 && "The varchar should read back in place.");
+        assert(view.getInt(i + 1) == index && "The int should read back.");
+        assert(view.getReal(i + 2) == (float) (index + 1) && "The real should read back.");
+    }
+}
+
+int RBFTest_24(RecordBasedFileManager *rbfm, BufferPoolManager *bpm)
+{
+    // Functions Tested:
+    // 1. Read Record View of records, including ones moved to another page by an update
+    // 2. NULL fields and fields past the end of the record
+    // 3. The view keeps its page pinned until it is released, reused or destroyed
+    // 4. Views of deleted records and missing slots fail
+    cout << endl << "***** In RBF Test Case 24 *****" << endl;
+
+    RC rc;
+    string fileName = "test24";
+
+    rc = rbfm->createFile(fileName);
+    assert(rc == success && "Creating the file should not fail.");
+
+    FileHandle fileHandle;
+    rc = rbfm->openFile(fileName, fileHandle);
+    assert(rc == success && "Opening the file should not fail.");
+
+    vector<Attribute> recordDescriptor;
+    createLargeRecordDescriptor(recordDescriptor);
+
+    int nullFieldsIndicatorActualSize = getActualByteForNullsIndicator(recordDescriptor.size());
+    unsigned char *nullsIndicator = (unsigned char *) malloc(nullFieldsIndicatorActualSize);
+    memset(nullsIndicator, 0, nullFieldsIndicatorActualSize);
+
+    // Short records fill the first page, then growing some of them moves them elsewhere
+    void *record = malloc(1000);
+    vector<RID> rids;
+    vector<int> indexes;
+    RID rid;
+    int size = 0;
+    for(int i = 0; i < 40; i++)
+    {
+        prepareLargeRecord(recordDescriptor.size(), nullsIndicator, i * 50, record, &size);
+        rc = rbfm->insertRecord(fileHandle, recordDescriptor, record, rid);
+        assert(rc == success && "Inserting a record should not fail.");
+        rids.push_back(rid);
+        indexes.push_back(i * 50);
+    }
+    for(int i = 0; i < 40; i += 4)
+    {
+        indexes[i] = 49 + i * 50;
+        prepareLargeRecord(recordDescriptor.size(), nullsIndicator, indexes[i], record, &size);
+        rc = rbfm->updateRecord(fileHandle, recordDescriptor, record, rids[i]);
+        assert(rc == success && "Updating a record should not fail.");
+    }
+
+    RecordView view;
+    assert(!view.isValid() && "A new view should not point at a record.");
+    for(int i = 0; i < 40; i++)
+    {
+        rc = rbfm->readRecordView(fileHandle, rids[i], view);
+        assert(rc == success && "Reading a record view should not fail.");
+        checkView(view, recordDescriptor.size(), indexes[i]);
+    }
+
+    // The last view still holds its page, so the pool can't be resized
+    rc = bpm->setPoolSize(bpm->getPoolSize());
+    assert(rc == BPM_FRAMES_PINNED && "A view should keep its page pinned.");
+    rc = view.release();
+    assert(rc == success && "Releasing a view should not fail.");
+    assert(!view.isValid() && "A released view should not point at a record.");
+    rc = bpm->setPoolSize(bpm->getPoolSize());
+    assert(rc == success && "Releasing the view should unpin its page.");
+
+    // NULL fields, and fields the record doesn't have
+    // prepareLargeRecord writes every field, so take the first two out by hand
+    prepareLargeRecord(recordDescriptor.size(), nullsIndicator, 7, record, &size);
+    int skipped = sizeof(int) + 8 + sizeof(int);
+    memmove((char *) record + nullFieldsIndicatorActualSize, (char *) record + nullFieldsIndicatorActualSize + skipped,
+            size - nullFieldsIndicatorActualSize - skipped);
+    ((unsigned char *) record)[0] = 0x80 | 0x40;
+    rc = rbfm->insertRecord(fileHandle, recordDescriptor, record, rid);
+    assert(rc == success && "Inserting a record should not fail.");
+    {
+        RecordView nullView;
+        rc = rbfm->readRecordView(fileHandle, rid, nullView);
+        assert(rc == success && "Reading a record view should not fail.");
+        assert(nullView.isNull(0) && nullView.isNull(1) && !nullView.isNull(2) && "NULL fields should read as NULL.");
+        assert(nullView.getInt(1) == 0 && nullView.getVarCharString(0).empty() && "NULL fields should read as empty.");
+        assert(nullView.getReal(2) == 8 && "Fields after NULLs should read back.");
+        assert(nullView.isNull(recordDescriptor.size()) && "Fields past the end should read as NULL.");
+    }
+    // Destroying the view released it
+    rc = bpm->setPoolSize(bpm->getPoolSize());
+    assert(rc == success && "Destroying a view should unpin its page.");
+
+    // Deleted records and missing slots
+    rc = rbfm->deleteRecord(fileHandle, recordDescriptor, rids[4]);
+    assert(rc == success && "Deleting a record should not fail.");
+    rc = rbfm->readRecordView(fileHandle, rids[4], view);
+    assert(rc == RBFM_READ_AFTER_DEL && "Reading a view of a deleted record should fail.");
+    rid = rids[0];
+    rid.slotNum = 1000;
+    rc = rbfm->readRecordView(fileHandle, rid, view);
+    assert(rc == RBFM_SLOT_DN_EXIST && "Reading a view of a missing slot should fail.");
+    assert(!view.isValid() && "A failed read should leave the view empty.");
+    rc = bpm->setPoolSize(bpm->getPoolSize());
+    assert(rc == success && "Failed reads should not leave pages pinned.");
+
+    rc = rbfm->closeFile(fileHandle);
+    assert(rc == success && "Closing the file should not fail.");
+
+    rc = rbfm->destroyFile(fileName);
+    assert(rc == success && "Destroying the file should not fail.");
+
+    rc = destroyFileShouldSucceed(fileName);
+    assert(rc == success  && "Destroying the file should not fail.");
+
+    free(record);
+    free(nullsIndicator);
+
+    cout << "RBF Test Case 24 Finished! The result will be examined." << endl << endl;
+    return 0;
+}
+
+int main()
+{
+    // To test record views
+    RecordBasedFileManager *rbfm = RecordBasedFileManager::instance();
+    BufferPoolManager *bpm = BufferPoolManager::instance();
+
+    remove("test24");
+
+    RC rcmain = RBFTest_24(rbfm, bpm);
+    return rcmain;
+}
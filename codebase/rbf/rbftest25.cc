@@ -0,0 +1,160 @@
+#include <iostream>
+#include <string>
+#include <cassert>
+#include <sys/stat.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdexcept>
+#include <stdio.h>
+#include <set>
+
+#include "pfm.h"
+#include "bpm.h"
+#include "rbfm.h"
+#include "test_util.h"
+
+using namespace std;
+
+int RBFTest_25(RecordBasedFileManager *rbfm)
+{
+    // Functions Tested:
+    // 1. Read Records of many RIDs in no particular order, with repeats
+    // 2. Records moved to another page by an update
+    // 3. Each page is read only once per batch
+    // 4. Deleted records and missing slots fail
+    cout << endl << "***** In RBF Test Case 25 *****" << endl;
+
+    RC rc;
+    string fileName = "test25";
+
+    rc = rbfm->createFile(fileName);
+    assert(rc == success && "Creating the file should not fail.");
+
+    FileHandle fileHandle;
+    rc = rbfm->openFile(fileName, fileHandle);
+    assert(rc == success && "Opening the file should not fail.");
+
+    vector<Attribute> recordDescriptor;
+    createLargeRecordDescriptor(recordDescriptor);
+
+    int nullFieldsIndicatorActualSize = getActualByteForNullsIndicator(recordDescriptor.size());
+    unsigned char *nullsIndicator = (unsigned char *) malloc(nullFieldsIndicatorActualSize);
+    memset(nullsIndicator, 0, nullFieldsIndicatorActualSize);
+
+    // Records spread over several pages, some of them grown until they move
+    int numRecords = 400;
+    void *record = malloc(1000);
+    vector<RID> rids;
+    vector<int> indexes;
+    RID rid;
+    int size = 0;
+    for(int i = 0; i < numRecords; i++)
+    {
+        prepareLargeRecord(recordDescriptor.size(), nullsIndicator, i * 50, record, &size);
+        rc = rbfm->insertRecord(fileHandle, recordDescriptor, record, rid);
+        assert(rc == success && "Inserting a record should not fail.");
+        rids.push_back(rid);
+        indexes.push_back(i * 50);
+    }
+    for(int i = 0; i < numRecords; i += 7)
+    {
+        indexes[i] = 49 + i * 50;
+        prepareLargeRecord(recordDescriptor.size(), nullsIndicator, indexes[i], record, &size);
+        rc = rbfm->updateRecord(fileHandle, recordDescriptor, record, rids[i]);
+        assert(rc == success && "Updating a record should not fail.");
+    }
+
+    // Ask for them scattered and with repeats
+    vector<RID> batch;
+    vector<int> expected;
+    set<PageNum> pages;
+    for(int i = 0; i < numRecords * 2; i++)
+    {
+        int which = (i * 37) % numRecords;
+        batch.push_back(rids[which]);
+        expected.push_back(which);
+        pages.insert(rids[which].pageNum);
+    }
+    vector<void*> data;
+    for(unsigned i = 0; i < batch.size(); i++)
+        data.push_back(malloc(1000));
+
+    unsigned readsBefore, readsAfter, writes;
+    fileHandle.collectLogicalCounterValues(readsBefore, writes);
+    rc = rbfm->readRecords(fileHandle, recordDescriptor, batch, data);
+    assert(rc == success && "Reading records should not fail.");
+    fileHandle.collectLogicalCounterValues(readsAfter, writes);
+
+    // Every record comes back where it was asked for, the same as readRecord() gives it
+    void *returned = malloc(1000);
+    for(unsigned i = 0; i < batch.size(); i++)
+    {
+        prepareLargeRecord(recordDescriptor.size(), nullsIndicator, indexes[expected[i]], record, &size);
+        assert(memcmp(data[i], record, size) == 0 && "Records should read back in the order asked for.");
+        rc = rbfm->readRecord(fileHandle, recordDescriptor, batch[i], returned);
+        assert(rc == success && "Reading a record should not fail.");
+        assert(memcmp(data[i], returned, size) == 0 && "Read records should match readRecord.");
+    }
+
+    // One read per page asked about, plus one per page the moved records went to
+    set<PageNum> movedPages;
+    for(int i = 0; i < numRecords; i += 7)
+    {
+        SlotDirectoryRecordEntry entry;
+        void *page = malloc(PAGE_SIZE);
+        rc = BufferPoolManager::instance()->readPage(fileHandle, rids[i].pageNum, page);
+        assert(rc == success && "Reading a page should not fail.");
+        memcpy(&entry, (char *) page + sizeof(SlotDirectoryHeader) + rids[i].slotNum * sizeof(SlotDirectoryRecordEntry), sizeof(entry));
+        if (entry.offset <= 0)
+            movedPages.insert(entry.length);
+        free(page);
+    }
+    assert(!movedPages.empty() && "Some records should have moved.");
+    assert(readsAfter - readsBefore == pages.size() + movedPages.size() && "Each page should be read once.");
+
+    // An empty batch does nothing
+    rc = rbfm->readRecords(fileHandle, recordDescriptor, vector<RID>(), vector<void*>());
+    assert(rc == success && "Reading no records should not fail.");
+
+    // Deleted records and missing slots
+    rc = rbfm->deleteRecord(fileHandle, recordDescriptor, rids[7]);
+    assert(rc == success && "Deleting a record should not fail.");
+    rc = rbfm->readRecords(fileHandle, recordDescriptor, batch, data);
+    assert(rc == RBFM_READ_AFTER_DEL && "Reading a deleted record should fail.");
+    batch.clear();
+    rid = rids[0];
+    rid.slotNum = 1000;
+    batch.push_back(rids[1]);
+    batch.push_back(rid);
+    rc = rbfm->readRecords(fileHandle, recordDescriptor, batch, data);
+    assert(rc == RBFM_SLOT_DN_EXIST && "Reading a missing slot should fail.");
+
+    rc = rbfm->closeFile(fileHandle);
+    assert(rc == success && "Closing the file should not fail.");
+
+    rc = rbfm->destroyFile(fileName);
+    assert(rc == success && "Destroying the file should not fail.");
+
+    rc = destroyFileShouldSucceed(fileName);
+    assert(rc == success  && "Destroying the file should not fail.");
+
+    for(unsigned i = 0; i < data.size(); i++)
+        free(data[i]);
+    free(returned);
+    free(record);
+    free(nullsIndicator);
+
+    cout << "RBF Test Case 25 Finished! The result will be examined." << endl << endl;
+    return 0;
+}
+
+int main()
+{
+    // To test batched reads
+    RecordBasedFileManager *rbfm = RecordBasedFileManager::instance();
+
+    remove("test25");
+
+    RC rcmain = RBFTest_25(rbfm);
+    return rcmain;
+}
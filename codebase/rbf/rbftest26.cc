@@ -0,0 +1,175 @@
+#include <iostream>
+#include <string>
+#include <cassert>
+#include <sys/stat.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdexcept>
+#include <stdio.h>
+
+#include "pfm.h"
+#include "rbfm.h"
+#include "test_util.h"
+
+using namespace std;
+
+// Read a record and check it, returning how many page reads it took
+static unsigned readAndCheck(RecordBasedFileManager *rbfm, FileHandle &fileHandle, const vector<Attribute> &recordDescriptor,
+                             const RID &rid, unsigned char *nullsIndicator, int index, void *record, void *returned)
+{
+    int size = 0;
+    unsigned before, after, writes;
+    prepareLargeRecord(recordDescriptor.size(), nullsIndicator, index, record, &size);
+    fileHandle.collectLogicalCounterValues(before, writes);
+    RC rc = rbfm->readRecord(fileHandle, recordDescriptor, rid, returned);
+    assert(rc == success && "Reading a record should not fail.");
+    fileHandle.collectLogicalCounterValues(after, writes);
+    assert(memcmp(record, returned, size) == 0 && "The record should read back.");
+    return after - before;
+}
+
+int RBFTest_26(RecordBasedFileManager *rbfm)
+{
+    // Functions Tested:
+    // 1. Update Record moves a record more than once, but it stays one hop from its RID
+    // 2. Get Forwarding Chain Lengths
+    // 3. A moved record that shrinks stays put, and one with room at home goes back
+    // 4. Delete Record of a moved record
+    cout << endl << "***** In RBF Test Case 26 *****" << endl;
+
+    RC rc;
+    string fileName = "test26";
+
+    rc = rbfm->createFile(fileName);
+    assert(rc == success && "Creating the file should not fail.");
+
+    FileHandle fileHandle;
+    rc = rbfm->openFile(fileName, fileHandle);
+    assert(rc == success && "Opening the file should not fail.");
+
+    vector<Attribute> recordDescriptor;
+    createLargeRecordDescriptor(recordDescriptor);
+
+    int nullFieldsIndicatorActualSize = getActualByteForNullsIndicator(recordDescriptor.size());
+    unsigned char *nullsIndicator = (unsigned char *) malloc(nullFieldsIndicatorActualSize);
+    memset(nullsIndicator, 0, nullFieldsIndicatorActualSize);
+
+    void *record = malloc(1000);
+    void *returned = malloc(1000);
+    vector<RID> rids;
+    RID rid;
+    int size = 0;
+
+    // Fill a few pages with short records
+    for(int i = 0; i < 100; i++)
+    {
+        prepareLargeRecord(recordDescriptor.size(), nullsIndicator, i * 50, record, &size);
+        rc = rbfm->insertRecord(fileHandle, recordDescriptor, record, rid);
+        assert(rc == success && "Inserting a record should not fail.");
+        rids.push_back(rid);
+    }
+
+    vector<unsigned> chainLengths;
+    rc = rbfm->getForwardingChainLengths(fileHandle, chainLengths);
+    assert(rc == success && "Getting chain lengths should not fail.");
+    assert(chainLengths.size() == 1 && chainLengths[0] == 100 && "No record should have moved yet.");
+
+    // Grow the first record off its full page, fill the page it went to, then grow it again
+    int index = 25;
+    prepareLargeRecord(recordDescriptor.size(), nullsIndicator, index, record, &size);
+    rc = rbfm->updateRecord(fileHandle, recordDescriptor, record, rids[0]);
+    assert(rc == success && "Updating a record should not fail.");
+    for(int i = 100; i < 200; i++)
+    {
+        prepareLargeRecord(recordDescriptor.size(), nullsIndicator, i * 50, record, &size);
+        rc = rbfm->insertRecord(fileHandle, recordDescriptor, record, rid);
+        assert(rc == success && "Inserting a record should not fail.");
+        rids.push_back(rid);
+    }
+    index = 49;
+    prepareLargeRecord(recordDescriptor.size(), nullsIndicator, index, record, &size);
+    rc = rbfm->updateRecord(fileHandle, recordDescriptor, record, rids[0]);
+    assert(rc == success && "Updating a record should not fail.");
+
+    rc = rbfm->getForwardingChainLengths(fileHandle, chainLengths);
+    assert(rc == success && "Getting chain lengths should not fail.");
+    assert(chainLengths.size() == 2 && chainLengths[0] == 199 && chainLengths[1] == 1 && "The record should be one hop away.");
+    assert(readAndCheck(rbfm, fileHandle, recordDescriptor, rids[0], nullsIndicator, index, record, returned) == 2
+           && "Reading a moved record should take two page reads.");
+
+    // Shrinking it leaves it where it is
+    index = 0;
+    prepareLargeRecord(recordDescriptor.size(), nullsIndicator, index, record, &size);
+    rc = rbfm->updateRecord(fileHandle, recordDescriptor, record, rids[0]);
+    assert(rc == success && "Updating a record should not fail.");
+    rc = rbfm->getForwardingChainLengths(fileHandle, chainLengths);
+    assert(rc == success && "Getting chain lengths should not fail.");
+    assert(chainLengths.size() == 2 && chainLengths[1] == 1 && "A shrunk record should stay where it was moved.");
+    assert(readAndCheck(rbfm, fileHandle, recordDescriptor, rids[0], nullsIndicator, index, record, returned) == 2
+           && "Reading a moved record should take two page reads.");
+
+    // Grow it again once its home page has room, and it goes back
+    for(int i = 1; i < 10; i++)
+    {
+        rc = rbfm->deleteRecord(fileHandle, recordDescriptor, rids[i]);
+        assert(rc == success && "Deleting a record should not fail.");
+    }
+    index = 49;
+    prepareLargeRecord(recordDescriptor.size(), nullsIndicator, index, record, &size);
+    rc = rbfm->updateRecord(fileHandle, recordDescriptor, record, rids[0]);
+    assert(rc == success && "Updating a record should not fail.");
+    rc = rbfm->getForwardingChainLengths(fileHandle, chainLengths);
+    assert(rc == success && "Getting chain lengths should not fail.");
+    assert(chainLengths.size() == 1 && chainLengths[0] == 191 && "The record should be back home.");
+    assert(readAndCheck(rbfm, fileHandle, recordDescriptor, rids[0], nullsIndicator, index, record, returned) == 1
+           && "Reading a record at home should take one page read.");
+
+    // Every record still reads back, and deleting a moved one removes it entirely
+    for(int i = 100; i < 200; i += 10)
+    {
+        prepareLargeRecord(recordDescriptor.size(), nullsIndicator, 49 + i * 50, record, &size);
+        rc = rbfm->updateRecord(fileHandle, recordDescriptor, record, rids[i]);
+        assert(rc == success && "Updating a record should not fail.");
+    }
+    for(int i = 100; i < 200; i++)
+        readAndCheck(rbfm, fileHandle, recordDescriptor, rids[i], nullsIndicator, i % 10 ? i * 50 : 49 + i * 50, record, returned);
+    rc = rbfm->getForwardingChainLengths(fileHandle, chainLengths);
+    assert(rc == success && "Getting chain lengths should not fail.");
+    assert(chainLengths.size() <= 2 && chainLengths[0] + (chainLengths.size() == 2 ? chainLengths[1] : 0) == 191
+           && "No record should be more than one hop away.");
+    for(int i = 100; i < 200; i += 10)
+    {
+        rc = rbfm->deleteRecord(fileHandle, recordDescriptor, rids[i]);
+        assert(rc == success && "Deleting a record should not fail.");
+    }
+    rc = rbfm->getForwardingChainLengths(fileHandle, chainLengths);
+    assert(rc == success && "Getting chain lengths should not fail.");
+    assert(chainLengths.size() == 1 && chainLengths[0] == 181 && "Deleted records should be gone entirely.");
+
+    rc = rbfm->closeFile(fileHandle);
+    assert(rc == success && "Closing the file should not fail.");
+
+    rc = rbfm->destroyFile(fileName);
+    assert(rc == success && "Destroying the file should not fail.");
+
+    rc = destroyFileShouldSucceed(fileName);
+    assert(rc == success  && "Destroying the file should not fail.");
+
+    free(record);
+    free(returned);
+    free(nullsIndicator);
+
+    cout << "RBF Test Case 26 Finished! The result will be examined." << endl << endl;
+    return 0;
+}
+
+int main()
+{
+    // To test forwarding chains
+    RecordBasedFileManager *rbfm = RecordBasedFileManager::instance();
+
+    remove("test26");
+
+    RC rcmain = RBFTest_26(rbfm);
+    return rcmain;
+}
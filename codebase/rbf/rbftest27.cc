@@ -0,0 +1,216 @@
+#include <iostream>
+#include <string>
+#include <cassert>
+#include <sys/stat.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdexcept>
+#include <stdio.h>
+
+#include "pfm.h"
+#include "rbfm.h"
+#include "test_util.h"
+
+using namespace std;
+
+int RBFTest_27(RecordBasedFileManager *rbfm)
+{
+    // Functions Tested:
+    // 1. Vacuum a few pages at a time, closing and reopening the file in between
+    // 2. Moved records go back home, and RIDs still read the same records
+    // 3. Empty pages at the end of the file are cut off
+    // 4. Scans still see every record
+    // 5. A mapped scan ends cleanly when a vacuum cuts off the page it is on
+    cout << endl << "***** In RBF Test Case 27 *****" << endl;
+
+    RC rc;
+    string fileName = "test27";
+
+    rc = rbfm->createFile(fileName);
+    assert(rc == success && "Creating the file should not fail.");
+
+    FileHandle fileHandle;
+    rc = rbfm->openFile(fileName, fileHandle);
+    assert(rc == success && "Opening the file should not fail.");
+
+    vector<Attribute> recordDescriptor;
+    createLargeRecordDescriptor(recordDescriptor);
+
+    int nullFieldsIndicatorActualSize = getActualByteForNullsIndicator(recordDescriptor.size());
+    unsigned char *nullsIndicator = (unsigned char *) malloc(nullFieldsIndicatorActualSize);
+    memset(nullsIndicator, 0, nullFieldsIndicatorActualSize);
+
+    void *record = malloc(1000);
+    void *returned = malloc(1000);
+    int numRecords = 2000;
+    vector<RID> rids;
+    vector<int> indexes;
+    RID rid;
+    int size = 0;
+
+    for(int i = 0; i < numRecords; i++)
+    {
+        prepareLargeRecord(recordDescriptor.size(), nullsIndicator, i * 50, record, &size);
+        rc = rbfm->insertRecord(fileHandle, recordDescriptor, record, rid);
+        assert(rc == success && "Inserting a record should not fail.");
+        rids.push_back(rid);
+        indexes.push_back(i * 50);
+    }
+
+    // Grow records from the first half so they move, then delete most of the rest
+    for(int i = 0; i < numRecords / 2; i += 5)
+    {
+        indexes[i] = 49 + i * 50;
+        prepareLargeRecord(recordDescriptor.size(), nullsIndicator, indexes[i], record, &size);
+        rc = rbfm->updateRecord(fileHandle, recordDescriptor, record, rids[i]);
+        assert(rc == success && "Updating a record should not fail.");
+    }
+    vector<bool> live(numRecords, true);
+    for(int i = 0; i < numRecords; i++)
+    {
+        if (i % 5 == 0 || (i < numRecords / 2 && i % 3 != 0))
+            continue;
+        rc = rbfm->deleteRecord(fileHandle, recordDescriptor, rids[i]);
+        assert(rc == success && "Deleting a record should not fail.");
+        live[i] = false;
+    }
+    unsigned liveCount = 0;
+    for(int i = 0; i < numRecords; i++)
+        liveCount += live[i];
+
+    vector<unsigned> chainLengths;
+    rc = rbfm->getForwardingChainLengths(fileHandle, chainLengths);
+    assert(rc == success && "Getting chain lengths should not fail.");
+    assert(chainLengths.size() == 2 && chainLengths[1] > 0 && "Some records should have moved.");
+    unsigned movedBefore = chainLengths[1];
+    unsigned pagesBefore = fileHandle.getNumberOfPages();
+
+    // A few pages per call, picking up where the last call left off even from another handle
+    PageNum cursor = 0;
+    unsigned calls = 0;
+    do
+    {
+        rc = rbfm->vacuum(fileHandle, recordDescriptor, cursor, 8);
+        assert((rc == success || rc == RBFM_EOF) && "Vacuuming should not fail.");
+        calls++;
+        if (calls == 2)
+        {
+            rc = rbfm->closeFile(fileHandle);
+            assert(rc == success && "Closing the file should not fail.");
+            rc = rbfm->openFile(fileName, fileHandle);
+            assert(rc == success && "Opening the file should not fail.");
+            rc = success;
+        }
+    } while (rc == success);
+    assert(calls > 2 && "Vacuuming should take several calls.");
+
+    // Once the file's moved records are known, a call only reads the pages it was given
+    unsigned logicalReadBefore, logicalReadAfter, logicalWriteCount;
+    rc = fileHandle.collectLogicalCounterValues(logicalReadBefore, logicalWriteCount);
+    assert(rc == success && "collectLogicalCounterValues() should not fail.");
+    cursor = 0;
+    rc = rbfm->vacuum(fileHandle, recordDescriptor, cursor, 8);
+    assert(rc == success && "Vacuuming should not fail.");
+    rc = fileHandle.collectLogicalCounterValues(logicalReadAfter, logicalWriteCount);
+    assert(rc == success && "collectLogicalCounterValues() should not fail.");
+    assert(logicalReadAfter - logicalReadBefore <= 2 * 8 && "A vacuum call should not read the whole file.");
+    assert(fileHandle.getNumberOfPages() < pagesBefore && "Empty pages at the end should be cut off.");
+
+    rc = rbfm->getForwardingChainLengths(fileHandle, chainLengths);
+    assert(rc == success && "Getting chain lengths should not fail.");
+    assert(chainLengths.size() >= 1 && chainLengths.size() <= 2 && "No record should be more than one hop away.");
+    assert(chainLengths[0] + (chainLengths.size() == 2 ? chainLengths[1] : 0) == liveCount && "Every record should still be there.");
+    assert((chainLengths.size() == 1 || chainLengths[1] < movedBefore) && "Moved records should go back home where there is room.");
+
+    for(int i = 0; i < numRecords; i++)
+    {
+        if (!live[i])
+            continue;
+        prepareLargeRecord(recordDescriptor.size(), nullsIndicator, indexes[i], record, &size);
+        rc = rbfm->readRecord(fileHandle, recordDescriptor, rids[i], returned);
+        assert(rc == success && "Reading a record should not fail.");
+        assert(memcmp(record, returned, size) == 0 && "Records should read back after a vacuum.");
+    }
+
+    // Scans see each record once
+    RBFM_ScanIterator scanIterator;
+    vector<string> attributes;
+    attributes.push_back(recordDescriptor[1].name);
+    rc = rbfm->scan(fileHandle, recordDescriptor, "", NO_OP, NULL, attributes, scanIterator);
+    assert(rc == success && "Scanning should not fail.");
+    unsigned scanned = 0;
+    while (scanIterator.getNextRecord(rid, returned) != RBFM_EOF)
+        scanned++;
+    scanIterator.close();
+    assert(scanned == liveCount && "A scan should see every record once.");
+
+    // The file keeps working, pages cut off come back as needed
+    vector<RID> added;
+    for(int i = 0; i < numRecords; i++)
+    {
+        prepareLargeRecord(recordDescriptor.size(), nullsIndicator, i * 50, record, &size);
+        rc = rbfm->insertRecord(fileHandle, recordDescriptor, record, rid);
+        assert(rc == success && "Inserting a record should not fail.");
+        added.push_back(rid);
+        rc = rbfm->readRecord(fileHandle, recordDescriptor, rid, returned);
+        assert(rc == success && "Reading a record should not fail.");
+        assert(memcmp(record, returned, size) == 0 && "Records inserted after a vacuum should read back.");
+    }
+    assert(fileHandle.getNumberOfPages() >= pagesBefore - 1 && "Inserts should grow the file again.");
+
+    // Empty the last page from within a mapped scan that has just got there, and vacuum it away
+    PageNum lastPage = fileHandle.getNumberOfPages() - 1;
+    unsigned onLastPage = 0;
+    for(int i = 0; i < numRecords; i++)
+        onLastPage += added[i].pageNum == lastPage;
+    assert(onLastPage > 0 && "The last page should hold records.");
+    rc = rbfm->scan(fileHandle, recordDescriptor, "", NO_OP, NULL, attributes, scanIterator, MAPPED_SCAN);
+    assert(rc == success && "Scanning should not fail.");
+    scanned = 0;
+    while (scanIterator.getNextRecord(rid, returned) != RBFM_EOF)
+    {
+        scanned++;
+        if (rid.pageNum != lastPage || fileHandle.getNumberOfPages() <= lastPage)
+            continue;
+        for(int i = 0; i < numRecords; i++)
+        {
+            if (added[i].pageNum != lastPage)
+                continue;
+            rc = rbfm->deleteRecord(fileHandle, recordDescriptor, added[i]);
+            assert(rc == success && "Deleting a record should not fail.");
+        }
+        cursor = 0;
+        rc = rbfm->vacuum(fileHandle, recordDescriptor, cursor, 0);
+        assert((rc == success || rc == RBFM_EOF) && "Vacuuming should not fail.");
+        assert(fileHandle.getNumberOfPages() <= lastPage && "The emptied page should be cut off.");
+    }
+    scanIterator.close();
+    assert(scanned == liveCount + numRecords - onLastPage + 1 && "The scan should stop where the file now ends.");
+
+    rc = rbfm->closeFile(fileHandle);
+    assert(rc == success && "Closing the file should not fail.");
+
+    rc = rbfm->destroyFile(fileName);
+    assert(rc == success && "Destroying the file should not fail.");
+
+    rc = destroyFileShouldSucceed(fileName);
+    assert(rc == success  && "Destroying the file should not fail.");
+
+    free(record);
+    free(returned);
+    free(nullsIndicator);
+
+    cout << "RBF Test Case 27 Finished! The result will be examined." << endl << endl;
+    return 0;
+}
+
+int main()
+{
+    // To test vacuum
+    RecordBasedFileManager *rbfm = RecordBasedFileManager::instance();
+
+    remove("test27");
+
+    RC rcmain = RBFTest_27(rbfm);
+    return rcmain;
+}
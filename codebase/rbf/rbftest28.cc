@@ -0,0 +1,238 @@
+#include <iostream>
+#include <string>
+#include <cassert>
+#include <sys/stat.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdexcept>
+#include <stdio.h>
+
+#include "pfm.h"
+#include "rbfm.h"
+#include "test_util.h"
+
+using namespace std;
+
+// Name of record i: long enough to go out of line for even i, most of them over several pages
+string makeName(int i)
+{
+    int length = i % 2 == 0 ? 1000 + i * 300 : 20 + i;
+    string name(length, 'a');
+    for (int j = 0; j < length; j++)
+        name[j] = 'a' + (i + j) % 26;
+    return name;
+}
+
+off_t fileSize(const string &fileName)
+{
+    struct stat info;
+    if (stat(fileName.c_str(), &info) != 0)
+        return -1;
+    return info.st_size;
+}
+
+int RBFTest_28(RecordBasedFileManager *rbfm)
+{
+    // Functions Tested:
+    // 1. Records with large varchars insert and read back, the values going to the toast file
+    // 2. readRecords, readAttribute and RecordView fetch the values out of line
+    // 3. Scans fetch them only for projected or tested attributes
+    // 4. Updates and deletes let go of toast pages, and later inserts reuse them
+    cout << endl << "***** In RBF Test Case 28 *****" << endl;
+
+    RC rc;
+    string fileName = "test28";
+    string toastName = fileName + TOAST_FILE_SUFFIX;
+
+    rc = rbfm->createFile(fileName);
+    assert(rc == success && "Creating the file should not fail.");
+
+    FileHandle fileHandle;
+    rc = rbfm->openFile(fileName, fileHandle);
+    assert(rc == success && "Opening the file should not fail.");
+
+    vector<Attribute> recordDescriptor;
+    createRecordDescriptor(recordDescriptor);
+    recordDescriptor[0].length = 20000;
+
+    int nullFieldsIndicatorActualSize = getActualByteForNullsIndicator(recordDescriptor.size());
+    unsigned char *nullsIndicator = (unsigned char *) malloc(nullFieldsIndicatorActualSize);
+    memset(nullsIndicator, 0, nullFieldsIndicatorActualSize);
+
+    void *record = malloc(25000);
+    void *returned = malloc(25000);
+    int numRecords = 40;
+    vector<RID> rids;
+    RID rid;
+    int size = 0;
+
+    for (int i = 0; i < numRecords; i++)
+    {
+        string name = makeName(i);
+        prepareRecord(recordDescriptor.size(), nullsIndicator, name.size(), name, i, 170.5, i * 100, record, &size);
+        rc = rbfm->insertRecord(fileHandle, recordDescriptor, record, rid);
+        assert(rc == success && "Inserting a record should not fail.");
+        rids.push_back(rid);
+    }
+    assert(fileSize(toastName) > 0 && "Large values should go to the toast file.");
+    assert(fileHandle.getNumberOfPages() < 6 && "Large values should not take up the data pages.");
+
+    for (int i = 0; i < numRecords; i++)
+    {
+        string name = makeName(i);
+        prepareRecord(recordDescriptor.size(), nullsIndicator, name.size(), name, i, 170.5, i * 100, record, &size);
+        rc = rbfm->readRecord(fileHandle, recordDescriptor, rids[i], returned);
+        assert(rc == success && "Reading a record should not fail.");
+        assert(memcmp(record, returned, size) == 0 && "Records should read back with their values in line.");
+    }
+
+    // Batched reads, single attributes and views
+    vector<void*> buffers;
+    for (int i = 0; i < 4; i++)
+        buffers.push_back(malloc(25000));
+    vector<RID> some;
+    for (int i = 0; i < 4; i++)
+        some.push_back(rids[i * 9]);
+    rc = rbfm->readRecords(fileHandle, recordDescriptor, some, buffers);
+    assert(rc == success && "Reading records should not fail.");
+    for (int i = 0; i < 4; i++)
+    {
+        string name = makeName(i * 9);
+        prepareRecord(recordDescriptor.size(), nullsIndicator, name.size(), name, i * 9, 170.5, i * 900, record, &size);
+        assert(memcmp(record, buffers[i], size) == 0 && "Batched reads should fetch values out of line.");
+        free(buffers[i]);
+    }
+
+    string name = makeName(30);
+    rc = rbfm->readAttribute(fileHandle, recordDescriptor, rids[30], "EmpName", returned);
+    assert(rc == success && "Reading an attribute should not fail.");
+    uint32_t length;
+    memcpy(&length, (char*) returned + 1, sizeof(uint32_t));
+    assert(length == name.size() && memcmp((char*) returned + 1 + sizeof(uint32_t), name.data(), length) == 0 &&
+           "readAttribute should fetch values out of line.");
+
+    RecordView view;
+    rc = rbfm->readRecordView(fileHandle, rids[30], view);
+    assert(rc == success && "Reading a record view should not fail.");
+    assert(view.getVarCharString(0) == name && view.getInt(1) == 30 && "Views should fetch values out of line.");
+    view.release();
+
+    // A scan that doesn't need the names, then one that tests them
+    RBFM_ScanIterator scanIterator;
+    vector<string> attributes;
+    attributes.push_back("Age");
+    rc = rbfm->scan(fileHandle, recordDescriptor, "", NO_OP, NULL, attributes, scanIterator);
+    assert(rc == success && "Scanning should not fail.");
+    int scanned = 0;
+    while (scanIterator.getNextRecord(rid, returned) != RBFM_EOF)
+    {
+        int age;
+        memcpy(&age, (char*) returned + 1, sizeof(int));
+        assert(rid.pageNum == rids[age].pageNum && rid.slotNum == rids[age].slotNum && "Scans should return the right ages.");
+        scanned++;
+    }
+    scanIterator.close();
+    assert(scanned == numRecords && "A scan should see every record once.");
+
+    void *value = malloc(sizeof(uint32_t) + name.size());
+    length = name.size();
+    memcpy(value, &length, sizeof(uint32_t));
+    memcpy((char*) value + sizeof(uint32_t), name.data(), length);
+    attributes.clear();
+    attributes.push_back("EmpName");
+    attributes.push_back("Age");
+    rc = rbfm->scan(fileHandle, recordDescriptor, "EmpName", EQ_OP, value, attributes, scanIterator);
+    assert(rc == success && "Scanning should not fail.");
+    scanned = 0;
+    while (scanIterator.getNextRecord(rid, returned) != RBFM_EOF)
+    {
+        memcpy(&length, (char*) returned + 1, sizeof(uint32_t));
+        assert(length == name.size() && memcmp((char*) returned + 1 + sizeof(uint32_t), name.data(), length) == 0 &&
+               "Scans should fetch projected values out of line.");
+        int age;
+        memcpy(&age, (char*) returned + 1 + sizeof(uint32_t) + length, sizeof(int));
+        assert(age == 30 && "Scans should test values out of line.");
+        scanned++;
+    }
+    scanIterator.close();
+    assert(scanned == 1 && "Only one record should match.");
+    free(value);
+
+    // Large values become small ones and the other way around
+    for (int i = 0; i < 4; i++)
+    {
+        string newName = makeName(i + 1);
+        prepareRecord(recordDescriptor.size(), nullsIndicator, newName.size(), newName, i, 170.5, i * 100, record, &size);
+        rc = rbfm->updateRecord(fileHandle, recordDescriptor, record, rids[i]);
+        assert(rc == success && "Updating a record should not fail.");
+        rc = rbfm->readRecord(fileHandle, recordDescriptor, rids[i], returned);
+        assert(rc == success && "Reading a record should not fail.");
+        assert(memcmp(record, returned, size) == 0 && "Updated records should read back.");
+    }
+
+    // Deleting the records frees their toast pages for the next ones
+    for (int i = 0; i < numRecords; i++)
+    {
+        rc = rbfm->deleteRecord(fileHandle, recordDescriptor, rids[i]);
+        assert(rc == success && "Deleting a record should not fail.");
+    }
+    off_t toastSize = fileSize(toastName);
+
+    // An update that fails lets go of the values it wrote out
+    string largeName = makeName(numRecords - 2);
+    prepareRecord(recordDescriptor.size(), nullsIndicator, largeName.size(), largeName, 0, 170.5, 0, record, &size);
+    rc = rbfm->updateRecord(fileHandle, recordDescriptor, record, rids[numRecords - 2]);
+    assert(rc != success && "Updating a deleted record should fail.");
+
+    for (int i = 0; i < numRecords; i++)
+    {
+        string newName = makeName(i);
+        prepareRecord(recordDescriptor.size(), nullsIndicator, newName.size(), newName, i, 170.5, i * 100, record, &size);
+        rc = rbfm->insertRecord(fileHandle, recordDescriptor, record, rids[i]);
+        assert(rc == success && "Inserting a record should not fail.");
+    }
+    assert(fileSize(toastName) == toastSize && "Inserts should reuse freed toast pages.");
+
+    rc = rbfm->closeFile(fileHandle);
+    assert(rc == success && "Closing the file should not fail.");
+
+    // The values are still there after reopening the file
+    rc = rbfm->openFile(fileName, fileHandle);
+    assert(rc == success && "Opening the file should not fail.");
+    for (int i = 0; i < numRecords; i++)
+    {
+        string newName = makeName(i);
+        prepareRecord(recordDescriptor.size(), nullsIndicator, newName.size(), newName, i, 170.5, i * 100, record, &size);
+        rc = rbfm->readRecord(fileHandle, recordDescriptor, rids[i], returned);
+        assert(rc == success && "Reading a record should not fail.");
+        assert(memcmp(record, returned, size) == 0 && "Records should read back after reopening the file.");
+    }
+    rc = rbfm->closeFile(fileHandle);
+    assert(rc == success && "Closing the file should not fail.");
+
+    rc = rbfm->destroyFile(fileName);
+    assert(rc == success && "Destroying the file should not fail.");
+    assert(fileSize(toastName) < 0 && "Destroying the file should remove its toast file.");
+
+    rc = destroyFileShouldSucceed(fileName);
+    assert(rc == success  && "Destroying the file should not fail.");
+
+    free(record);
+    free(returned);
+    free(nullsIndicator);
+
+    cout << "RBF Test Case 28 Finished! The result will be examined." << endl << endl;
+    return 0;
+}
+
+int main()
+{
+    // To test varchars stored out of line
+    RecordBasedFileManager *rbfm = RecordBasedFileManager::instance();
+
+    remove("test28");
+    remove("test28.toast");
+
+    RC rcmain = RBFTest_28(rbfm);
+    return rcmain;
+}
@@ -0,0 +1,287 @@
+#include <iostream>
+#include <string>
+#include <cassert>
+#include <sys/stat.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdexcept>
+#include <stdio.h>
+
+#include "pfm.h"
+#include "rbfm.h"
+#include "test_util.h"
+
+using namespace std;
+
+const string statuses[] = {"Active", "Suspended", "Pending review", "Closed", "Archived"};
+
+// Name of record i: mostly one of a few statuses, sometimes a value of its own or NULL
+string makeName(int i, bool &isNull)
+{
+    isNull = i % 11 == 0;
+    if (i % 7 == 0)
+        return "user_" + to_string(i);
+    return statuses[i % 5];
+}
+
+void prepareStatusRecord(const vector<Attribute> &recordDescriptor, int i, const string &name, bool isNull, void *buffer, int *size)
+{
+    unsigned char nullsIndicator = isNull ? 1 << 7 : 0;
+    prepareRecord(recordDescriptor.size(), &nullsIndicator, name.size(), name, i, 170.5, i * 100, buffer, size);
+}
+
+int countMatches(RecordBasedFileManager *rbfm, FileHandle &fileHandle, const vector<Attribute> &recordDescriptor,
+                 CompOp compOp, const string &name, int &badRows)
+{
+    void *value = malloc(sizeof(uint32_t) + name.size());
+    uint32_t length = name.size();
+    memcpy(value, &length, sizeof(uint32_t));
+    memcpy((char*) value + sizeof(uint32_t), name.data(), length);
+
+    RBFM_ScanIterator scanIterator;
+    vector<string> attributes;
+    attributes.push_back("EmpName");
+    attributes.push_back("Age");
+    RC rc = rbfm->scan(fileHandle, recordDescriptor, "EmpName", compOp, value, attributes, scanIterator);
+    assert(rc == success && "Scanning should not fail.");
+
+    RID rid;
+    char returned[200];
+    int count = 0;
+    while (scanIterator.getNextRecord(rid, returned) != RBFM_EOF)
+    {
+        memcpy(&length, returned + 1, sizeof(uint32_t));
+        int age;
+        memcpy(&age, returned + 1 + sizeof(uint32_t) + length, sizeof(int));
+        bool isNull;
+        string expected = makeName(age, isNull);
+        if (string(returned + 1 + sizeof(uint32_t), length) != expected)
+            badRows++;
+        count++;
+    }
+    scanIterator.close();
+    free(value);
+    return count;
+}
+
+int RBFTest_29(RecordBasedFileManager *rbfm)
+{
+    // Functions Tested:
+    // 1. createDictionary checks its attributes
+    // 2. Records with coded varchars take fewer pages and read back unchanged
+    // 3. Scans with equality, inequality and range conditions on coded values
+    // 4. readAttribute, RecordView, updates, bulk loads and vacuums of coded records
+    // 5. destroyDictionary leaves coded records readable
+    cout << endl << "***** In RBF Test Case 29 *****" << endl;
+
+    RC rc;
+    string fileName = "test29";
+    string plainName = "test29plain";
+
+    rc = rbfm->createFile(fileName);
+    assert(rc == success && "Creating the file should not fail.");
+    rc = rbfm->createFile(plainName);
+    assert(rc == success && "Creating the file should not fail.");
+
+    vector<Attribute> recordDescriptor;
+    createRecordDescriptor(recordDescriptor);
+
+    vector<string> attributes;
+    attributes.push_back("Age");
+    rc = rbfm->createDictionary(fileName, recordDescriptor, attributes);
+    assert(rc == RBFM_DICTIONARY_TYPE && "Only varchars can be coded.");
+    attributes[0] = "EmpName";
+    rc = rbfm->createDictionary(fileName, recordDescriptor, attributes);
+    assert(rc == success && "Creating a dictionary should not fail.");
+    rc = rbfm->createDictionary(fileName, recordDescriptor, attributes);
+    assert(rc == RBFM_DICTIONARY_EXISTS && "A file has one set of dictionary columns.");
+
+    FileHandle fileHandle, plainHandle;
+    rc = rbfm->openFile(fileName, fileHandle);
+    assert(rc == success && "Opening the file should not fail.");
+    rc = rbfm->openFile(plainName, plainHandle);
+    assert(rc == success && "Opening the file should not fail.");
+
+    void *record = malloc(200);
+    void *returned = malloc(200);
+    int numRecords = 3000;
+    vector<RID> rids;
+    RID rid;
+    int size = 0;
+    bool isNull;
+
+    for (int i = 0; i < numRecords; i++)
+    {
+        string name = makeName(i, isNull);
+        prepareStatusRecord(recordDescriptor, i, name, isNull, record, &size);
+        rc = rbfm->insertRecord(fileHandle, recordDescriptor, record, rid);
+        assert(rc == success && "Inserting a record should not fail.");
+        rids.push_back(rid);
+        rc = rbfm->insertRecord(plainHandle, recordDescriptor, record, rid);
+        assert(rc == success && "Inserting a record should not fail.");
+    }
+    assert(fileHandle.getNumberOfPages() < plainHandle.getNumberOfPages() && "Coded records should take fewer pages.");
+
+    for (int i = 0; i < numRecords; i++)
+    {
+        string name = makeName(i, isNull);
+        prepareStatusRecord(recordDescriptor, i, name, isNull, record, &size);
+        rc = rbfm->readRecord(fileHandle, recordDescriptor, rids[i], returned);
+        assert(rc == success && "Reading a record should not fail.");
+        assert(memcmp(record, returned, size) == 0 && "Coded records should read back unchanged.");
+    }
+
+    // Every kind of condition sees the values as they were inserted
+    int expectedEq = 0, expectedNe = 0, expectedLt = 0;
+    for (int i = 0; i < numRecords; i++)
+    {
+        string name = makeName(i, isNull);
+        if (isNull)
+            continue;
+        expectedEq += name == "Pending review";
+        expectedNe += name != "Pending review";
+        expectedLt += name < "Pending review";
+    }
+    int badRows = 0;
+    assert(countMatches(rbfm, fileHandle, recordDescriptor, EQ_OP, "Pending review", badRows) == expectedEq && "Equality scans should compare codes.");
+    assert(countMatches(rbfm, fileHandle, recordDescriptor, NE_OP, "Pending review", badRows) == expectedNe && "Inequality scans should compare codes.");
+    assert(countMatches(rbfm, fileHandle, recordDescriptor, LT_OP, "Pending review", badRows) == expectedLt && "Range scans should see the values.");
+    assert(countMatches(rbfm, fileHandle, recordDescriptor, EQ_OP, "Unknown", badRows) == 0 && "Values no page has should not match.");
+    assert(countMatches(rbfm, fileHandle, recordDescriptor, EQ_OP, "user_7", badRows) == 1 && "Values kept in line should still match.");
+    assert(badRows == 0 && "Scans should project the values.");
+
+    // A multi-predicate scan on the coded attribute
+    vector<ScanPredicate> predicates;
+    uint32_t length;
+    char active[20], closed[20];
+    length = 6;
+    memcpy(active, &length, sizeof(uint32_t));
+    memcpy(active + sizeof(uint32_t), "Active", length);
+    memcpy(closed, &length, sizeof(uint32_t));
+    memcpy(closed + sizeof(uint32_t), "Closed", length);
+    ScanPredicate predicate = {"EmpName", EQ_OP, active, 1};
+    predicates.push_back(predicate);
+    predicate.value = closed;
+    predicates.push_back(predicate);
+    RBFM_ScanIterator scanIterator;
+    attributes.clear();
+    rc = rbfm->scan(fileHandle, recordDescriptor, predicates, attributes, scanIterator);
+    assert(rc == success && "Scanning should not fail.");
+    int scanned = 0;
+    while (scanIterator.getNextRecord(rid, returned) != RBFM_EOF)
+        scanned++;
+    scanIterator.close();
+    int expectedOr = 0;
+    for (int i = 0; i < numRecords; i++)
+    {
+        string name = makeName(i, isNull);
+        expectedOr += !isNull && (name == "Active" || name == "Closed");
+    }
+    assert(scanned == expectedOr && "ORed equality conditions should compare codes.");
+
+    // Single attributes and views
+    rc = rbfm->readAttribute(fileHandle, recordDescriptor, rids[2], "EmpName", returned);
+    assert(rc == success && "Reading an attribute should not fail.");
+    memcpy(&length, (char*) returned + 1, sizeof(uint32_t));
+    assert(string((char*) returned + 1 + sizeof(uint32_t), length) == makeName(2, isNull) && "readAttribute should decode values.");
+    RecordView view;
+    rc = rbfm->readRecordView(fileHandle, rids[3], view);
+    assert(rc == success && "Reading a record view should not fail.");
+    assert(view.getVarCharString(0) == makeName(3, isNull) && "Views should decode values.");
+    view.release();
+
+    // Grow some records so they move off their pages, delete others, then vacuum
+    for (int i = 1; i < numRecords; i += 4)
+    {
+        string name = "Suspended until further notice, pending review by the account team " + to_string(i);
+        prepareStatusRecord(recordDescriptor, i, name, false, record, &size);
+        rc = rbfm->updateRecord(fileHandle, recordDescriptor, record, rids[i]);
+        assert(rc == success && "Updating a record should not fail.");
+    }
+    for (int i = 2; i < numRecords; i += 4)
+    {
+        rc = rbfm->deleteRecord(fileHandle, recordDescriptor, rids[i]);
+        assert(rc == success && "Deleting a record should not fail.");
+    }
+    PageNum cursor = 0;
+    while ((rc = rbfm->vacuum(fileHandle, recordDescriptor, cursor, 16)) == success);
+    assert(rc == RBFM_EOF && "Vacuuming should not fail.");
+    for (int i = 0; i < numRecords; i++)
+    {
+        if (i % 4 == 2)
+            continue;
+        string name = makeName(i, isNull);
+        if (i % 4 == 1)
+        {
+            name = "Suspended until further notice, pending review by the account team " + to_string(i);
+            isNull = false;
+        }
+        prepareStatusRecord(recordDescriptor, i, name, isNull, record, &size);
+        rc = rbfm->readRecord(fileHandle, recordDescriptor, rids[i], returned);
+        assert(rc == success && "Reading a record should not fail.");
+        assert(memcmp(record, returned, size) == 0 && "Records should read back after updates and a vacuum.");
+    }
+
+    // Bulk loads code their records too, and the dictionary can go without losing anything
+    vector<const void*> batch;
+    vector<void*> buffers;
+    for (int i = 0; i < 500; i++)
+    {
+        string name = makeName(i, isNull);
+        void *buffer = malloc(200);
+        prepareStatusRecord(recordDescriptor, i, name, isNull, buffer, &size);
+        batch.push_back(buffer);
+        buffers.push_back(buffer);
+    }
+    vector<RID> bulkRids;
+    rc = rbfm->insertRecords(fileHandle, recordDescriptor, batch, bulkRids);
+    assert(rc == success && "Bulk loading should not fail.");
+
+    rc = rbfm->closeFile(fileHandle);
+    assert(rc == success && "Closing the file should not fail.");
+    rc = rbfm->destroyDictionary(fileName);
+    assert(rc == success && "Destroying a dictionary should not fail.");
+    rc = rbfm->openFile(fileName, fileHandle);
+    assert(rc == success && "Opening the file should not fail.");
+    for (int i = 0; i < 500; i++)
+    {
+        string name = makeName(i, isNull);
+        prepareStatusRecord(recordDescriptor, i, name, isNull, record, &size);
+        rc = rbfm->readRecord(fileHandle, recordDescriptor, bulkRids[i], returned);
+        assert(rc == success && "Reading a record should not fail.");
+        assert(memcmp(record, returned, size) == 0 && "Coded records should read back without the dictionary.");
+        free(buffers[i]);
+    }
+
+    rc = rbfm->closeFile(fileHandle);
+    assert(rc == success && "Closing the file should not fail.");
+    rc = rbfm->closeFile(plainHandle);
+    assert(rc == success && "Closing the file should not fail.");
+
+    rc = rbfm->destroyFile(fileName);
+    assert(rc == success && "Destroying the file should not fail.");
+    rc = rbfm->destroyFile(plainName);
+    assert(rc == success && "Destroying the file should not fail.");
+
+    rc = destroyFileShouldSucceed(fileName);
+    assert(rc == success  && "Destroying the file should not fail.");
+
+    free(record);
+    free(returned);
+
+    cout << "RBF Test Case 29 Finished! The result will be examined." << endl << endl;
+    return 0;
+}
+
+int main()
+{
+    // To test varchar dictionaries
+    RecordBasedFileManager *rbfm = RecordBasedFileManager::instance();
+
+    remove("test29");
+    remove("test29.dict");
+    remove("test29plain");
+
+    RC rcmain = RBFTest_29(rbfm);
+    return rcmain;
+}
@@ -0,0 +1,257 @@
+#include <iostream>
+#include <string>
+#include <cassert>
+#include <sys/stat.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdexcept>
+#include <stdio.h>
+
+#include "pfm.h"
+#include "rbfm.h"
+#include "test_util.h"
+
+using namespace std;
+
+// Scan for Id < limit with the given mode, checking every projected Id and returning how many came back
+static int scanIds(RecordBasedFileManager *rbfm, FileHandle &fileHandle, const vector<Attribute> &recordDescriptor, int limit, ScanMode scanMode)
+{
+    RBFM_ScanIterator scanIterator;
+    vector<string> attributes;
+    attributes.push_back("Id");
+    RC rc = rbfm->scan(fileHandle, recordDescriptor, "Id", LT_OP, &limit, attributes, scanIterator, scanMode);
+    assert(rc == success && "Scanning should not fail.");
+
+    RID rid;
+    char returned[PAGE_SIZE];
+    int count = 0;
+    while (scanIterator.getNextRecord(rid, returned) != RBFM_EOF)
+    {
+        int id;
+        memcpy(&id, returned + 1, sizeof(int));
+        assert(returned[0] == 0 && id < limit && "Scans should return the Ids that match.");
+        count++;
+    }
+    scanIterator.close();
+    return count;
+}
+
+int RBFTest_30(RecordBasedFileManager *rbfm)
+{
+    // Functions Tested:
+    // 1. PAX files take ints and reals only, and fit more records on a page than slotted ones
+    // 2. Records insert, read back and update in place, as whole records, attributes and views
+    // 3. Scans and aggregates with conditions on PAX pages, in every scan mode
+    // 4. Deletes free rows for later inserts, bulk loads and vacuums keep the layout
+    cout << endl << "***** In RBF Test Case 30 *****" << endl;
+
+    RC rc;
+    string fileName = "test30";
+    string slottedName = "test30slotted";
+
+    vector<Attribute> employeeDescriptor;
+    createRecordDescriptor(employeeDescriptor);
+    rc = rbfm->createFile(fileName, employeeDescriptor, PAX_LAYOUT);
+    assert(rc == RBFM_LAYOUT_TYPE && "PAX files should not take varchars.");
+
+    vector<Attribute> recordDescriptor;
+    createMeasureDescriptor(recordDescriptor);
+    rc = rbfm->createFile(fileName, recordDescriptor, PAX_LAYOUT);
+    assert(rc == success && "Creating the file should not fail.");
+    rc = rbfm->createFile(slottedName, recordDescriptor, SLOTTED_LAYOUT);
+    assert(rc == success && "Creating the file should not fail.");
+
+    FileHandle fileHandle, slottedHandle;
+    rc = rbfm->openFile(fileName, fileHandle);
+    assert(rc == success && "Opening the file should not fail.");
+    rc = rbfm->openFile(slottedName, slottedHandle);
+    assert(rc == success && "Opening the file should not fail.");
+
+    char record[PAGE_SIZE], returned[PAGE_SIZE];
+    int size;
+    int numRecords = 4000;
+    vector<RID> rids;
+    RID rid;
+    for (int i = 0; i < numRecords; i++)
+    {
+        prepareMeasure(i, i % 10, record, size);
+        rc = rbfm->insertRecord(fileHandle, recordDescriptor, record, rid);
+        assert(rc == success && "Inserting a record should not fail.");
+        rids.push_back(rid);
+        rc = rbfm->insertRecord(slottedHandle, recordDescriptor, record, rid);
+        assert(rc == success && "Inserting a record should not fail.");
+    }
+    assert(fileHandle.getNumberOfPages() < slottedHandle.getNumberOfPages() && "PAX pages should hold more records.");
+
+    for (int i = 0; i < numRecords; i++)
+    {
+        prepareMeasure(i, i % 10, record, size);
+        rc = rbfm->readRecord(fileHandle, recordDescriptor, rids[i], returned);
+        assert(rc == success && "Reading a record should not fail.");
+        assert(memcmp(record, returned, size) == 0 && "Records should read back from the minipages.");
+    }
+
+    // Single attributes and views
+    rc = rbfm->readAttribute(fileHandle, recordDescriptor, rids[13], "Score", returned);
+    assert(rc == success && "Reading an attribute should not fail.");
+    float score;
+    memcpy(&score, returned + 1, sizeof(float));
+    assert(returned[0] == 0 && score == 13 / 4.0f && "readAttribute should read the minipage.");
+    rc = rbfm->readAttribute(fileHandle, recordDescriptor, rids[14], "Score", returned);
+    assert(rc == success && (returned[0] & (1 << 7)) && "NULLs should read as NULL.");
+
+    RecordView view;
+    rc = rbfm->readRecordView(fileHandle, rids[21], view);
+    assert(rc == success && "Reading a record view should not fail.");
+    assert(view.getNumberOfFields() == 3 && view.getInt(0) == 21 && view.isNull(1) && view.getInt(2) == 1 &&
+           "Views should read the minipages.");
+    view.release();
+
+    // Conditions on every type, in every scan mode
+    assert(scanIds(rbfm, fileHandle, recordDescriptor, 1234, COPY_SCAN) == 1234 && "Int conditions should hold on PAX pages.");
+    assert(scanIds(rbfm, fileHandle, recordDescriptor, 1234, MAPPED_SCAN) == 1234 && "Mapped scans should read PAX pages.");
+    assert(scanIds(rbfm, fileHandle, recordDescriptor, 1234, PARALLEL_SCAN) == 1234 && "Parallel scans should read PAX pages.");
+
+    float half = numRecords / 8.0;
+    int expected = 0;
+    for (int i = 0; i < numRecords; i++)
+        expected += i % 7 != 0 && i / 4.0 >= half;
+    RBFM_ScanIterator scanIterator;
+    vector<string> attributes;
+    attributes.push_back("Score");
+    attributes.push_back("Count");
+    rc = rbfm->scan(fileHandle, recordDescriptor, "Score", GE_OP, &half, attributes, scanIterator);
+    assert(rc == success && "Scanning should not fail.");
+    int scanned = 0;
+    while (scanIterator.getNextRecord(rid, returned) != RBFM_EOF)
+    {
+        memcpy(&score, returned + 1, sizeof(float));
+        assert(returned[0] == 0 && score >= half && "Real conditions should hold on PAX pages.");
+        scanned++;
+    }
+    scanIterator.close();
+    assert(scanned == expected && "NULL scores should not match.");
+
+    // Several predicates, in batches
+    int three = 3;
+    vector<ScanPredicate> predicates;
+    ScanPredicate predicate = {"Count", EQ_OP, &three, 0};
+    predicates.push_back(predicate);
+    predicate.attribute = "Score";
+    predicate.compOp = LT_OP;
+    predicate.value = &half;
+    predicates.push_back(predicate);
+    expected = 0;
+    for (int i = 0; i < numRecords; i++)
+        expected += i % 10 == 3 && i % 7 != 0 && i / 4.0 < half;
+    attributes.clear();
+    attributes.push_back("Id");
+    rc = rbfm->scan(fileHandle, recordDescriptor, predicates, attributes, scanIterator);
+    assert(rc == success && "Scanning should not fail.");
+    vector<RID> batch;
+    scanned = 0;
+    while (scanIterator.getNextBatch(batch, returned, 64) != RBFM_EOF)
+    {
+        for (unsigned i = 0; i < batch.size(); i++)
+        {
+            int id;
+            memcpy(&id, returned + i * (1 + sizeof(int)) + 1, sizeof(int));
+            assert(id % 10 == 3 && "Batches should hold the matching rows.");
+        }
+        scanned += batch.size();
+    }
+    scanIterator.close();
+    assert(scanned == expected && "Multi-predicate scans should hold on PAX pages.");
+
+    vector<AggregateGroup> groups;
+    predicates.clear();
+    rc = rbfm->aggregate(fileHandle, recordDescriptor, "Count", SUM_AGG, predicates, "", groups);
+    assert(rc == success && groups.size() == 1 && groups[0].value == 4.5 * numRecords && "Aggregates should read the minipages.");
+
+    // Update in place, including to and from NULL, then delete and fill the rows again
+    for (int i = 0; i < numRecords; i += 3)
+    {
+        prepareMeasure(i + 1, i % 10 + 100, record, size);
+        rc = rbfm->updateRecord(fileHandle, recordDescriptor, record, rids[i]);
+        assert(rc == success && "Updating a record should not fail.");
+    }
+    PageNum pages = fileHandle.getNumberOfPages();
+    for (int i = 1; i < numRecords; i += 3)
+    {
+        rc = rbfm->deleteRecord(fileHandle, recordDescriptor, rids[i]);
+        assert(rc == success && "Deleting a record should not fail.");
+    }
+    for (int i = 1; i < numRecords; i += 3)
+    {
+        prepareMeasure(i, i % 10, record, size);
+        rc = rbfm->insertRecord(fileHandle, recordDescriptor, record, rids[i]);
+        assert(rc == success && "Inserting a record should not fail.");
+    }
+    assert(fileHandle.getNumberOfPages() == pages && "Inserts should reuse deleted rows.");
+
+    // Bulk loads add PAX pages too, and a vacuum leaves them be
+    vector<const void*> data;
+    vector<void*> buffers;
+    for (int i = numRecords; i < 2 * numRecords; i++)
+    {
+        void *buffer = malloc(PAGE_SIZE);
+        prepareMeasure(i, i % 10, buffer, size);
+        data.push_back(buffer);
+        buffers.push_back(buffer);
+    }
+    vector<RID> bulkRids;
+    rc = rbfm->insertRecords(fileHandle, recordDescriptor, data, bulkRids);
+    assert(rc == success && "Bulk loading should not fail.");
+    rids.insert(rids.end(), bulkRids.begin(), bulkRids.end());
+    for (int i = 3 * numRecords / 2; i < 2 * numRecords; i++)
+    {
+        rc = rbfm->deleteRecord(fileHandle, recordDescriptor, rids[i]);
+        assert(rc == success && "Deleting a record should not fail.");
+    }
+    PageNum cursor = 0;
+    while ((rc = rbfm->vacuum(fileHandle, recordDescriptor, cursor, 0)) == success);
+    assert(rc == RBFM_EOF && "Vacuuming should not fail.");
+
+    for (int i = 0; i < 3 * numRecords / 2; i++)
+    {
+        if (i < numRecords && i % 3 == 0)
+            prepareMeasure(i + 1, i % 10 + 100, record, size);
+        else
+            prepareMeasure(i, i % 10, record, size);
+        rc = rbfm->readRecord(fileHandle, recordDescriptor, rids[i], returned);
+        assert(rc == success && "Reading a record should not fail.");
+        assert(memcmp(record, returned, size) == 0 && "Records should read back after updates, deletes and a vacuum.");
+    }
+    assert(scanIds(rbfm, fileHandle, recordDescriptor, 2 * numRecords, COPY_SCAN) == 3 * numRecords / 2 &&
+           "Scans should see every record left once.");
+    for (unsigned i = 0; i < buffers.size(); i++)
+        free(buffers[i]);
+
+    rc = rbfm->closeFile(fileHandle);
+    assert(rc == success && "Closing the file should not fail.");
+    rc = rbfm->closeFile(slottedHandle);
+    assert(rc == success && "Closing the file should not fail.");
+
+    rc = rbfm->destroyFile(fileName);
+    assert(rc == success && "Destroying the file should not fail.");
+    rc = rbfm->destroyFile(slottedName);
+    assert(rc == success && "Destroying the file should not fail.");
+
+    rc = destroyFileShouldSucceed(fileName);
+    assert(rc == success  && "Destroying the file should not fail.");
+
+    cout << "RBF Test Case 30 Finished! The result will be examined." << endl << endl;
+    return 0;
+}
+
+int main()
+{
+    // To test PAX pages
+    RecordBasedFileManager *rbfm = RecordBasedFileManager::instance();
+
+    remove("test30");
+    remove("test30slotted");
+
+    RC rcmain = RBFTest_30(rbfm);
+    return rcmain;
+}
@@ -0,0 +1,188 @@
+#include <iostream>
+#include <string>
+#include <cassert>
+#include <sys/stat.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdexcept>
+#include <stdio.h>
+
+#include "pfm.h"
+#include "rbfm.h"
+#include "test_util.h"
+
+using namespace std;
+
+// Scan every record whole for Id < limit with the given mode, checking each one against prepareMeasure
+static int scanMeasures(RecordBasedFileManager *rbfm, FileHandle &fileHandle, const vector<Attribute> &recordDescriptor, int limit, ScanMode scanMode)
+{
+    RBFM_ScanIterator scanIterator;
+    vector<string> attributes;
+    for (unsigned i = 0; i < recordDescriptor.size(); i++)
+        attributes.push_back(recordDescriptor[i].name);
+    RC rc = rbfm->scan(fileHandle, recordDescriptor, "Id", LT_OP, &limit, attributes, scanIterator, scanMode);
+    assert(rc == success && "Scanning should not fail.");
+
+    RID rid;
+    char returned[PAGE_SIZE], expected[PAGE_SIZE];
+    int size;
+    int count = 0;
+    while (scanIterator.getNextRecord(rid, returned) != RBFM_EOF)
+    {
+        int id;
+        memcpy(&id, returned + 1, sizeof(int));
+        prepareMeasure(id, id % 10, expected, size);
+        assert(id < limit && memcmp(expected, returned, size) == 0 && "Scans should return whole records as they were inserted.");
+        count++;
+    }
+    scanIterator.close();
+    return count;
+}
+
+int RBFTest_31(RecordBasedFileManager *rbfm)
+{
+    // Functions Tested:
+    // 1. Records with only ints and reals are fixed width, with no column directory
+    // 2. They read back whole, as attributes and as views, with and without NULLs
+    // 3. Scans with whole and partial projections, in every scan mode
+    // 4. Updates to and from NULL, and reads with attributes added since
+    cout << endl << "***** In RBF Test Case 31 *****" << endl;
+
+    RC rc;
+    string fileName = "test31";
+
+    rc = rbfm->createFile(fileName);
+    assert(rc == success && "Creating the file should not fail.");
+
+    FileHandle fileHandle;
+    rc = rbfm->openFile(fileName, fileHandle);
+    assert(rc == success && "Opening the file should not fail.");
+
+    vector<Attribute> recordDescriptor;
+    createMeasureDescriptor(recordDescriptor);
+
+    char record[PAGE_SIZE], returned[PAGE_SIZE];
+    int size;
+    int numRecords = 4000;
+    vector<RID> rids;
+    RID rid;
+    for (int i = 0; i < numRecords; i++)
+    {
+        prepareMeasure(i, i % 10, record, size);
+        rc = rbfm->insertRecord(fileHandle, recordDescriptor, record, rid);
+        assert(rc == success && "Inserting a record should not fail.");
+        rids.push_back(rid);
+    }
+
+    // Every record takes its length, null indicator and values, NULL or not
+    unsigned recordSize = sizeof(RecordLength) + 1 + recordDescriptor.size() * sizeof(int);
+    unsigned perPage = (PAGE_SIZE - sizeof(SlotDirectoryHeader)) / (recordSize + sizeof(SlotDirectoryRecordEntry));
+    assert(fileHandle.getNumberOfPages() <= 1 + (numRecords + perPage - 1) / perPage && "Fixed width records should have no directory.");
+
+    for (int i = 0; i < numRecords; i++)
+    {
+        prepareMeasure(i, i % 10, record, size);
+        rc = rbfm->readRecord(fileHandle, recordDescriptor, rids[i], returned);
+        assert(rc == success && "Reading a record should not fail.");
+        assert(memcmp(record, returned, size) == 0 && "Records should read back unchanged.");
+    }
+
+    // Single attributes and views
+    rc = rbfm->readAttribute(fileHandle, recordDescriptor, rids[13], "Score", returned);
+    assert(rc == success && "Reading an attribute should not fail.");
+    float score;
+    memcpy(&score, returned + 1, sizeof(float));
+    assert(returned[0] == 0 && score == 13 / 4.0f && "readAttribute should find the value at its offset.");
+    rc = rbfm->readAttribute(fileHandle, recordDescriptor, rids[14], "Score", returned);
+    assert(rc == success && (returned[0] & (1 << 7)) && "NULLs should read as NULL.");
+    rc = rbfm->readAttribute(fileHandle, recordDescriptor, rids[14], "Count", returned);
+    int count;
+    memcpy(&count, returned + 1, sizeof(int));
+    assert(rc == success && returned[0] == 0 && count == 4 && "Attributes after a NULL should read back.");
+
+    RecordView view;
+    rc = rbfm->readRecordView(fileHandle, rids[21], view);
+    assert(rc == success && "Reading a record view should not fail.");
+    assert(view.getNumberOfFields() == 3 && view.getInt(0) == 21 && view.isNull(1) && view.getInt(2) == 1 &&
+           "Views should find the values at their offsets.");
+    view.release();
+
+    // Whole records in every scan mode, then conditions on a real with a partial projection
+    assert(scanMeasures(rbfm, fileHandle, recordDescriptor, 1234, COPY_SCAN) == 1234 && "Copy scans should project whole records.");
+    assert(scanMeasures(rbfm, fileHandle, recordDescriptor, 1234, MAPPED_SCAN) == 1234 && "Mapped scans should project whole records.");
+    assert(scanMeasures(rbfm, fileHandle, recordDescriptor, 1234, PARALLEL_SCAN) == 1234 && "Parallel scans should project whole records.");
+
+    float half = numRecords / 8.0;
+    int expected = 0;
+    for (int i = 0; i < numRecords; i++)
+        expected += i % 7 != 0 && i / 4.0 >= half;
+    RBFM_ScanIterator scanIterator;
+    vector<string> attributes;
+    attributes.push_back("Count");
+    attributes.push_back("Score");
+    rc = rbfm->scan(fileHandle, recordDescriptor, "Score", GE_OP, &half, attributes, scanIterator);
+    assert(rc == success && "Scanning should not fail.");
+    int scanned = 0;
+    while (scanIterator.getNextRecord(rid, returned) != RBFM_EOF)
+    {
+        memcpy(&score, returned + 1 + sizeof(int), sizeof(float));
+        assert(returned[0] == 0 && score >= half && "Real conditions should hold on fixed width records.");
+        scanned++;
+    }
+    scanIterator.close();
+    assert(scanned == expected && "NULL scores should not match.");
+
+    // Updates to and from NULL stay in place
+    for (int i = 0; i < numRecords; i += 3)
+    {
+        prepareMeasure(i + 1, i % 10 + 100, record, size);
+        rc = rbfm->updateRecord(fileHandle, recordDescriptor, record, rids[i]);
+        assert(rc == success && "Updating a record should not fail.");
+    }
+    for (int i = 0; i < numRecords; i++)
+    {
+        if (i % 3 == 0)
+            prepareMeasure(i + 1, i % 10 + 100, record, size);
+        else
+            prepareMeasure(i, i % 10, record, size);
+        rc = rbfm->readRecord(fileHandle, recordDescriptor, rids[i], returned);
+        assert(rc == success && "Reading a record should not fail.");
+        assert(memcmp(record, returned, size) == 0 && "Records should read back after updates.");
+    }
+
+    // An attribute added since the records were written reads as NULL
+    vector<Attribute> grownDescriptor = recordDescriptor;
+    Attribute attr;
+    attr.name = "Total";
+    attr.type = TypeInt;
+    attr.length = (AttrLength) 4;
+    grownDescriptor.push_back(attr);
+    prepareMeasure(2, 2, record, size);
+    rc = rbfm->readRecord(fileHandle, grownDescriptor, rids[2], returned);
+    assert(rc == success && "Reading a record should not fail.");
+    assert((unsigned char) returned[0] == (unsigned char) (record[0] | 1 << 4) && memcmp(record + 1, returned + 1, size - 1) == 0 &&
+           "Added attributes should read as NULL.");
+
+    rc = rbfm->closeFile(fileHandle);
+    assert(rc == success && "Closing the file should not fail.");
+
+    rc = rbfm->destroyFile(fileName);
+    assert(rc == success && "Destroying the file should not fail.");
+
+    rc = destroyFileShouldSucceed(fileName);
+    assert(rc == success  && "Destroying the file should not fail.");
+
+    cout << "RBF Test Case 31 Finished! The result will be examined." << endl << endl;
+    return 0;
+}
+
+int main()
+{
+    // To test fixed width records
+    RecordBasedFileManager *rbfm = RecordBasedFileManager::instance();
+
+    remove("test31");
+
+    RC rcmain = RBFTest_31(rbfm);
+    return rcmain;
+}
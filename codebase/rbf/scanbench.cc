@@ -0,0 +1,207 @@
+#include <iostream>
+#include <string>
+#include <cassert>
+#include <chrono>
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+
+#include "pfm.h"
+#include "rbfm.h"
+#include "filter.h"
+#include "test_util.h"
+
+using namespace std;
+
+// Times scans with a 0.1% selective predicate over a large record based file.
+// The "scattered" scan matches one record in every thousand all through the file,
+// the "clustered" one only matches the last 0.1% of the file, so it skips almost
+// every record in the file before returning its first result.
+// The scattered scan is repeated with each predicate kernel the CPU supports.
+// A full scan is then timed one record per call and a batch per call, and the scattered
+// scan again as a parallel scan with 1, 2 and 4 threads.
+// The number of records can be given on the command line.
+
+#define BENCH_RECORDS     10000000
+#define BENCH_LOAD_BATCH  100000
+#define BENCH_SELECTIVITY 1000
+#define BENCH_BATCH_ROWS  256
+
+static double elapsedMillis(chrono::steady_clock::time_point start)
+{
+    return chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+}
+
+static void createBenchRecordDescriptor(vector<Attribute> &recordDescriptor)
+{
+    Attribute attr;
+    attr.name = "key";
+    attr.type = TypeInt;
+    attr.length = (AttrLength)4;
+    recordDescriptor.push_back(attr);
+
+    attr.name = "bucket";
+    attr.type = TypeInt;
+    attr.length = (AttrLength)4;
+    recordDescriptor.push_back(attr);
+
+    attr.name = "name";
+    attr.type = TypeVarChar;
+    attr.length = (AttrLength)16;
+    recordDescriptor.push_back(attr);
+}
+
+// key, bucket = key scrambled into [0, BENCH_SELECTIVITY), an 8 character name
+static void prepareBenchRecord(int key, char *record)
+{
+    int offset = 0;
+    memset(record, 0, 1);
+    offset += 1;
+    memcpy(record + offset, &key, sizeof(int));
+    offset += sizeof(int);
+    int bucket = (int) (((unsigned) key * 2654435761u) % BENCH_SELECTIVITY);
+    memcpy(record + offset, &bucket, sizeof(int));
+    offset += sizeof(int);
+    int nameLength = 8;
+    memcpy(record + offset, &nameLength, sizeof(int));
+    offset += sizeof(int);
+    memcpy(record + offset, "scanbnch", nameLength);
+}
+
+static double timeScan(RecordBasedFileManager *rbfm, FileHandle &fileHandle, const vector<Attribute> &recordDescriptor,
+                       const string &conditionAttribute, CompOp compOp, int value, unsigned &matches,
+                       ScanMode scanMode = COPY_SCAN)
+{
+    vector<string> attributes;
+    attributes.push_back("key");
+    attributes.push_back("name");
+
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
+    RBFM_ScanIterator rbfmsi;
+    RC rc = rbfm->scan(fileHandle, recordDescriptor, conditionAttribute, compOp, &value, attributes, rbfmsi, scanMode);
+    assert(rc == success && "Scanning the file should not fail.");
+
+    RID rid;
+    char returnedData[64];
+    matches = 0;
+    while (rbfmsi.getNextRecord(rid, returnedData) != RBFM_EOF)
+        matches++;
+    rbfmsi.close();
+    return elapsedMillis(start);
+}
+
+// Every record, getNextBatch() rows at a time
+static double timeBatchScan(RecordBasedFileManager *rbfm, FileHandle &fileHandle, const vector<Attribute> &recordDescriptor,
+                            unsigned &matches)
+{
+    vector<string> attributes;
+    attributes.push_back("key");
+    attributes.push_back("name");
+
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
+    RBFM_ScanIterator rbfmsi;
+    RC rc = rbfm->scan(fileHandle, recordDescriptor, "", NO_OP, NULL, attributes, rbfmsi);
+    assert(rc == success && "Scanning the file should not fail.");
+
+    vector<RID> rids;
+    char *returnedData = (char *) malloc(BENCH_BATCH_ROWS * 64);
+    matches = 0;
+    while (rbfmsi.getNextBatch(rids, returnedData, BENCH_BATCH_ROWS) != RBFM_EOF)
+        matches += rids.size();
+    rbfmsi.close();
+    free(returnedData);
+    return elapsedMillis(start);
+}
+
+int ScanBench(RecordBasedFileManager *rbfm, unsigned numRecords)
+{
+    cout << endl << "***** In Scan Benchmark *****" << endl;
+
+    RC rc;
+    string fileName = "scanbench_file";
+
+    rc = rbfm->createFile(fileName);
+    assert(rc == success && "Creating the file should not fail.");
+
+    FileHandle fileHandle;
+    rc = rbfm->openFile(fileName, fileHandle);
+    assert(rc == success && "Opening the file should not fail.");
+
+    vector<Attribute> recordDescriptor;
+    createBenchRecordDescriptor(recordDescriptor);
+
+    // Load the file in batches to keep the prepared records small
+    char *records = (char *) malloc(BENCH_LOAD_BATCH * 32);
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
+    for (unsigned first = 0; first < numRecords; first += BENCH_LOAD_BATCH)
+    {
+        vector<const void*> batch;
+        for (unsigned i = first; i < numRecords && i < first + BENCH_LOAD_BATCH; i++)
+        {
+            char *record = records + (i - first) * 32;
+            prepareBenchRecord(i, record);
+            batch.push_back(record);
+        }
+        vector<RID> rids;
+        rc = rbfm->insertRecords(fileHandle, recordDescriptor, batch, rids);
+        assert(rc == success && "Inserting records should not fail.");
+    }
+    free(records);
+    cout << numRecords << " records on " << fileHandle.getNumberOfPages() << " pages, loaded in "
+         << elapsedMillis(start) << " ms" << endl;
+
+    unsigned matches;
+    double millis = timeScan(rbfm, fileHandle, recordDescriptor, "bucket", EQ_OP, 0, matches);
+    cout << "scattered 0.1% scan: " << matches << " matches in " << millis << " ms" << endl;
+
+    millis = timeScan(rbfm, fileHandle, recordDescriptor, "key", GE_OP, numRecords - numRecords / BENCH_SELECTIVITY, matches);
+    cout << "clustered 0.1% scan: " << matches << " matches in " << millis << " ms" << endl;
+    assert(matches == numRecords / BENCH_SELECTIVITY && "The clustered scan should find every match.");
+
+    FilterKernel defaultKernel = getFilterKernel();
+    FilterKernel kernels[] = { ScalarKernel, SSEKernel, AVX2Kernel };
+    const char *kernelNames[] = { "scalar", "SSE", "AVX2" };
+    for (unsigned k = 0; k < 3; k++)
+    {
+        if (setFilterKernel(kernels[k]) != success)
+            continue;
+        millis = timeScan(rbfm, fileHandle, recordDescriptor, "bucket", EQ_OP, 0, matches);
+        cout << "scattered 0.1% scan, " << kernelNames[k] << " kernel: " << matches << " matches in " << millis << " ms" << endl;
+    }
+    setFilterKernel(defaultKernel);
+
+    millis = timeScan(rbfm, fileHandle, recordDescriptor, "", NO_OP, 0, matches);
+    cout << "full scan, one record per call: " << matches << " records in " << millis << " ms" << endl;
+    millis = timeBatchScan(rbfm, fileHandle, recordDescriptor, matches);
+    cout << "full scan, " << BENCH_BATCH_ROWS << " records per call: " << matches << " records in " << millis << " ms" << endl;
+    assert(matches == numRecords && "The batch scan should return every record.");
+
+    unsigned threads[] = { 1, 2, 4 };
+    for (unsigned t = 0; t < 3; t++)
+    {
+        rbfm->setScanThreads(threads[t]);
+        millis = timeScan(rbfm, fileHandle, recordDescriptor, "bucket", EQ_OP, 0, matches, PARALLEL_SCAN);
+        cout << "scattered 0.1% scan, parallel with " << threads[t] << " threads: " << matches << " matches in " << millis << " ms" << endl;
+    }
+    rbfm->setScanThreads(0);
+
+    rc = rbfm->closeFile(fileHandle);
+    assert(rc == success && "Closing the file should not fail.");
+
+    rc = rbfm->destroyFile(fileName);
+    assert(rc == success && "Destroying the file should not fail.");
+
+    cout << "Scan Benchmark Finished!" << endl << endl;
+    return 0;
+}
+
+int main(int argc, char **argv)
+{
+    RecordBasedFileManager *rbfm = RecordBasedFileManager::instance();
+
+    remove("scanbench_file");
+
+    unsigned numRecords = argc > 1 ? atoi(argv[1]) : BENCH_RECORDS;
+    RC rcmain = ScanBench(rbfm, numRecords);
+    return rcmain;
+}
@@ -287,3 +287,52 @@ void createLargeRecordDescriptor2(vector<Attribute> &recordDescriptor) {
 	}
 	free(suffix);
 }
+
+ScanPredicate makePredicate(const string &attribute, CompOp compOp, const void *value, unsigned orGroup)
+{
+    ScanPredicate predicate;
+    predicate.attribute = attribute;
+    predicate.compOp = compOp;
+    predicate.value = value;
+    predicate.orGroup = orGroup;
+    return predicate;
+}
+
+// Row i of createMeasureDescriptor: Id i, Score i / 4 and the given Count. Every seventh row has a NULL Score.
+void prepareMeasure(int i, int count, void *buffer, int &size)
+{
+    unsigned char nullsIndicator = i % 7 == 0 ? 1 << 6 : 0;
+    char *out = (char*) buffer;
+    memcpy(out, &nullsIndicator, 1);
+    out += 1;
+    memcpy(out, &i, sizeof(int));
+    out += sizeof(int);
+    if (i % 7 != 0)
+    {
+        float score = i / 4.0;
+        memcpy(out, &score, sizeof(float));
+        out += sizeof(float);
+    }
+    memcpy(out, &count, sizeof(int));
+    out += sizeof(int);
+    size = out - (char*) buffer;
+}
+
+void createMeasureDescriptor(vector<Attribute> &recordDescriptor)
+{
+    Attribute attr;
+    attr.name = "Id";
+    attr.type = TypeInt;
+    attr.length = (AttrLength) 4;
+    recordDescriptor.push_back(attr);
+
+    attr.name = "Score";
+    attr.type = TypeReal;
+    attr.length = (AttrLength) 4;
+    recordDescriptor.push_back(attr);
+
+    attr.name = "Count";
+    attr.type = TypeInt;
+    attr.length = (AttrLength) 4;
+    recordDescriptor.push_back(attr);
+}
@@ -73,13 +73,13 @@ RC RelationManager::deleteCatalog()
     return SUCCESS;
 }
 
-RC RelationManager::createTable(const string &tableName, const vector<Attribute> &attrs)
+RC RelationManager::createTable(const string &tableName, const vector<Attribute> &attrs, PageLayout layout)
 {
     RC rc;
     RecordBasedFileManager *rbfm = RecordBasedFileManager::instance();
 
     // Create the rbfm file to store the table
-    if ((rc = rbfm->createFile(getFileName(tableName))))
+    if ((rc = rbfm->createFile(getFileName(tableName), attrs, layout)))
         return rc;
 
     // Get the table's ID
@@ -309,6 +309,38 @@ RC RelationManager::insertTuple(const string &tableName, const void *data, RID &
     return rc;
 }
 
+RC RelationManager::insertTuples(const string &tableName, const vector<const void*> &data, vector<RID> &rids)
+{
+    RecordBasedFileManager *rbfm = RecordBasedFileManager::instance();
+    RC rc;
+
+    // If this is a system table, we cannot modify it
+    bool isSystem;
+    rc = isSystemTable(isSystem, tableName);
+    if (rc)
+        return rc;
+    if (isSystem)
+        return RM_CANNOT_MOD_SYS_TBL;
+
+    // Get recordDescriptor
+    vector<Attribute> recordDescriptor;
+    rc = getAttributes(tableName, recordDescriptor);
+    if (rc)
+        return rc;
+
+    // And get fileHandle
+    FileHandle fileHandle;
+    rc = rbfm->openFile(getFileName(tableName), fileHandle);
+    if (rc)
+        return rc;
+
+    // Let rbfm do all the work
+    rc = rbfm->insertRecords(fileHandle, recordDescriptor, data, rids);
+    rbfm->closeFile(fileHandle);
+
+    return rc;
+}
+
 RC RelationManager::deleteTuple(const string &tableName, const RID &rid)
 {
     RecordBasedFileManager *rbfm = RecordBasedFileManager::instance();
@@ -396,6 +428,26 @@ RC RelationManager::readTuple(const string &tableName, const RID &rid, void *dat
     return rc;
 }
 
+RC RelationManager::readTuples(const string &tableName, const vector<RID> &rids, const vector<void*> &data)
+{
+    RecordBasedFileManager *rbfm = RecordBasedFileManager::instance();
+    RC rc;
+
+    vector<Attribute> recordDescriptor;
+    rc = getAttributes(tableName, recordDescriptor);
+    if (rc)
+        return rc;
+
+    FileHandle fileHandle;
+    rc = rbfm->openFile(getFileName(tableName), fileHandle);
+    if (rc)
+        return rc;
+
+    rc = rbfm->readRecords(fileHandle, recordDescriptor, rids, data);
+    rbfm->closeFile(fileHandle);
+    return rc;
+}
+
 // Let rbfm do all the work
 RC RelationManager::printTuple(const vector<Attribute> &attrs, const void *data)
 {
@@ -423,6 +475,51 @@ RC RelationManager::readAttribute(const string &tableName, const RID &rid, const
     return rc;
 }
 
+RC RelationManager::aggregate(const string &tableName,
+      const string &aggregateAttribute,
+      const AggregateOp op,
+      const vector<ScanPredicate> &predicates,
+      const string &groupAttribute,
+      vector<AggregateGroup> &groups)
+{
+    RecordBasedFileManager *rbfm = RecordBasedFileManager::instance();
+    RC rc;
+
+    vector<Attribute> recordDescriptor;
+    rc = getAttributes(tableName, recordDescriptor);
+    if (rc)
+        return rc;
+
+    FileHandle fileHandle;
+    rc = rbfm->openFile(getFileName(tableName), fileHandle);
+    if (rc)
+        return rc;
+
+    rc = rbfm->aggregate(fileHandle, recordDescriptor, aggregateAttribute, op, predicates, groupAttribute, groups);
+    rbfm->closeFile(fileHandle);
+    return rc;
+}
+
+RC RelationManager::vacuumTable(const string &tableName, PageNum &cursor, unsigned pages)
+{
+    RecordBasedFileManager *rbfm = RecordBasedFileManager::instance();
+    RC rc;
+
+    vector<Attribute> recordDescriptor;
+    rc = getAttributes(tableName, recordDescriptor);
+    if (rc)
+        return rc;
+
+    FileHandle fileHandle;
+    rc = rbfm->openFile(getFileName(tableName), fileHandle);
+    if (rc)
+        return rc;
+
+    rc = rbfm->vacuum(fileHandle, recordDescriptor, cursor, pages);
+    rbfm->closeFile(fileHandle);
+    return rc;
+}
+
 // Extra credit work
 RC RelationManager::dropAttribute(const string &tableName, const string &attributeName)
 {
@@ -833,7 +930,8 @@ RC RelationManager::scan(const string &tableName,
       const CompOp compOp,                  
       const void *value,                    
       const vector<string> &attributeNames,
-      RM_ScanIterator &rm_ScanIterator)
+      RM_ScanIterator &rm_ScanIterator,
+      ScanMode scanMode)
 {
     // Open the file for the given tableName
     RecordBasedFileManager *rbfm = RecordBasedFileManager::instance();
@@ -849,19 +947,44 @@ RC RelationManager::scan(const string &tableName,
 
     // Use the underlying rbfm_scaniterator to do all the work
     rc = rbfm->scan(rm_ScanIterator.fileHandle, recordDescriptor, conditionAttribute,
-                     compOp, value, attributeNames, rm_ScanIterator.rbfm_iter);
+                     compOp, value, attributeNames, rm_ScanIterator.rbfm_iter, scanMode);
     if (rc)
         return rc;
 
     return SUCCESS;
 }
 
+RC RelationManager::scan(const string &tableName,
+      const vector<ScanPredicate> &predicates,
+      const vector<string> &attributeNames,
+      RM_ScanIterator &rm_ScanIterator,
+      ScanMode scanMode)
+{
+    RecordBasedFileManager *rbfm = RecordBasedFileManager::instance();
+    RC rc = rbfm->openFile(getFileName(tableName), rm_ScanIterator.fileHandle);
+    if (rc)
+        return rc;
+
+    vector<Attribute> recordDescriptor;
+    rc = getAttributes(tableName, recordDescriptor);
+    if (rc)
+        return rc;
+
+    return rbfm->scan(rm_ScanIterator.fileHandle, recordDescriptor, predicates, attributeNames,
+                      rm_ScanIterator.rbfm_iter, scanMode);
+}
+
 // Let rbfm do all the work
 RC RM_ScanIterator::getNextTuple(RID &rid, void *data)
 {
     return rbfm_iter.getNextRecord(rid, data);
 }
 
+RC RM_ScanIterator::getNextBatch(vector<RID> &rids, void *data, unsigned maxRows)
+{
+    return rbfm_iter.getNextBatch(rids, data, maxRows);
+}
+
 // Close our file handle, rbfm_scaniterator
 RC RM_ScanIterator::close()
 {
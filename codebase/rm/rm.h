@@ -60,6 +60,8 @@ public:
 
   // "data" follows the same format as RelationManager::insertTuple()
   RC getNextTuple(RID &rid, void *data);
+  // Up to maxRows tuples at once, packed back to back in data (see RBFM_ScanIterator::getNextBatch)
+  RC getNextBatch(vector<RID> &rids, void *data, unsigned maxRows);
   RC close();
 
   friend class RelationManager;
@@ -79,7 +81,8 @@ public:
 
   RC deleteCatalog();
 
-  RC createTable(const string &tableName, const vector<Attribute> &attrs);
+  // PAX_LAYOUT lays the table's pages out column by column, for tables of ints and reals (see PageLayout)
+  RC createTable(const string &tableName, const vector<Attribute> &attrs, PageLayout layout = SLOTTED_LAYOUT);
 
   RC deleteTable(const string &tableName);
 
@@ -87,18 +90,36 @@ public:
 
   RC insertTuple(const string &tableName, const void *data, RID &rid);
 
+  // Bulk load many tuples at once, rids gets one RID per tuple, in order
+  RC insertTuples(const string &tableName, const vector<const void*> &data, vector<RID> &rids);
+
   RC deleteTuple(const string &tableName, const RID &rid);
 
   RC updateTuple(const string &tableName, const void *data, const RID &rid);
 
   RC readTuple(const string &tableName, const RID &rid, void *data);
 
+  // Read many tuples at once, data[i] gets the tuple at rids[i]
+  RC readTuples(const string &tableName, const vector<RID> &rids, const vector<void*> &data);
+
   // Print a tuple that is passed to this utility method.
   // The format is the same as printRecord().
   RC printTuple(const vector<Attribute> &attrs, const void *data);
 
   RC readAttribute(const string &tableName, const RID &rid, const string &attributeName, void *data);
 
+  // Aggregate a column over the tuples that meet the predicates, see RecordBasedFileManager::aggregate
+  RC aggregate(const string &tableName,
+      const string &aggregateAttribute,
+      const AggregateOp op,
+      const vector<ScanPredicate> &predicates,
+      const string &groupAttribute,
+      vector<AggregateGroup> &groups);
+
+  // Reclaim space in the table a few pages per call, see RecordBasedFileManager::vacuum.
+  // Returns RM_EOF once the whole table has been gone through.
+  RC vacuumTable(const string &tableName, PageNum &cursor, unsigned pages = 0);
+
   // Scan returns an iterator to allow the caller to go through the results one by one.
   // Do not store entire results in the scan iterator.
   RC scan(const string &tableName,
@@ -106,7 +127,15 @@ public:
       const CompOp compOp,                  // comparison type such as "<" and "="
       const void *value,                    // used in the comparison
       const vector<string> &attributeNames, // a list of projected attributes
-      RM_ScanIterator &rm_ScanIterator);
+      RM_ScanIterator &rm_ScanIterator,
+      ScanMode scanMode = COPY_SCAN);       // MAPPED_SCAN or PARALLEL_SCAN for read-only scans of large tables
+
+  // Scan with several conditions at once, see RecordBasedFileManager::scan
+  RC scan(const string &tableName,
+      const vector<ScanPredicate> &predicates,
+      const vector<string> &attributeNames,
+      RM_ScanIterator &rm_ScanIterator,
+      ScanMode scanMode = COPY_SCAN);
 
 // Extra credit work (10 points)
 public:
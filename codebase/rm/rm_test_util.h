@@ -281,6 +281,14 @@ RC createTable(const string &tableName)
     return success;
 }
 
+// Size of an employee tuple projected to (EmpName, Age)
+int projectedSize(const char *tuple)
+{
+    int nameLength;
+    memcpy(&nameLength, tuple + 1, sizeof(int));
+    return 1 + sizeof(int) + nameLength + sizeof(int);
+}
+
 void prepareLargeTuple(int attributeCount, unsigned char *nullAttributesIndicator, const int index, void *buffer, int *size)
 {
     int offset = 0;
@@ -0,0 +1,110 @@
+#include "rm_test_util.h"
+
+RC TEST_RM_16(const string &tableName)
+{
+    // Functions Tested:
+    // 1. Create Table
+    // 2. Insert Tuples (bulk load)
+    // 3. Read Tuple
+    // 4. Scan
+    // 5. Delete Table
+    cout << endl << "***** In RM Test Case 16 *****" << endl;
+
+    RC rc = createLargeTable(tableName);
+    assert(rc == success && "Creating a table should not fail.");
+
+    vector<Attribute> attrs;
+    rc = rm->getAttributes(tableName, attrs);
+    assert(rc == success && "RelationManager::getAttributes() should not fail.");
+
+    int nullAttributesIndicatorActualSize = getActualByteForNullsIndicator(attrs.size());
+    unsigned char *nullsIndicator = (unsigned char *) malloc(nullAttributesIndicatorActualSize);
+    memset(nullsIndicator, 0, nullAttributesIndicatorActualSize);
+
+    // Prepare the tuples up front and hand them over in one call
+    int numTuples = 2000;
+    vector<const void*> tuples;
+    vector<int> sizes;
+    for(int i = 0; i < numTuples; i++)
+    {
+        void *tuple = malloc(2000);
+        int size = 0;
+        memset(tuple, 0, 2000);
+        prepareLargeTuple(attrs.size(), nullsIndicator, i, tuple, &size);
+        tuples.push_back(tuple);
+        sizes.push_back(size);
+    }
+
+    vector<RID> rids;
+    rc = rm->insertTuples(tableName, tuples, rids);
+    assert(rc == success && "RelationManager::insertTuples() should not fail.");
+    assert(rids.size() == (unsigned) numTuples && "There should be one RID per tuple.");
+
+    // A second, smaller load goes after the first
+    vector<const void*> more(tuples.begin(), tuples.begin() + 10);
+    vector<RID> moreRids;
+    rc = rm->insertTuples(tableName, more, moreRids);
+    assert(rc == success && "RelationManager::insertTuples() should not fail.");
+    assert(moreRids.size() == 10 && "There should be one RID per tuple.");
+
+    // Read every tuple back through its RID
+    void *returnedData = malloc(2000);
+    for(int i = 0; i < numTuples; i++)
+    {
+        memset(returnedData, 0, 2000);
+        rc = rm->readTuple(tableName, rids[i], returnedData);
+        assert(rc == success && "RelationManager::readTuple() should not fail.");
+
+        if(memcmp(returnedData, tuples[i], sizes[i]) != 0)
+        {
+            cout << "***** [FAIL] Test Case 16 Failed *****" << endl << endl;
+            return -1;
+        }
+    }
+    for(int i = 0; i < 10; i++)
+    {
+        rc = rm->readTuple(tableName, moreRids[i], returnedData);
+        assert(rc == success && "RelationManager::readTuple() should not fail.");
+        assert(memcmp(returnedData, tuples[i], sizes[i]) == 0 && "Bulk loaded tuples should read back intact.");
+    }
+
+    // A scan sees every tuple exactly once
+    vector<string> attributes;
+    attributes.push_back("attr1");
+    RM_ScanIterator rmsi;
+    rc = rm->scan(tableName, "", NO_OP, NULL, attributes, rmsi);
+    assert(rc == success && "RelationManager::scan() should not fail.");
+
+    RID rid;
+    int count = 0;
+    while(rmsi.getNextTuple(rid, returnedData) != RM_EOF)
+        count++;
+    rmsi.close();
+    assert(count == numTuples + 10 && "The scan should return every bulk loaded tuple.");
+
+    // Normal inserts still work on the bulk loaded table
+    rc = rm->insertTuple(tableName, tuples[0], rid);
+    assert(rc == success && "RelationManager::insertTuple() should not fail.");
+
+    rc = rm->deleteTable(tableName);
+    assert(rc == success && "Deleting the table should not fail.");
+
+    for(int i = 0; i < numTuples; i++)
+        free((void *) tuples[i]);
+    free(returnedData);
+    free(nullsIndicator);
+
+    cout << "***** Test Case 16 Finished. The result will be examined. *****" << endl << endl;
+
+    return success;
+}
+
+int main()
+{
+    // Remove the table in case a previous run left it behind
+    rm->deleteTable("tbl_bulk");
+
+    RC rcmain = TEST_RM_16("tbl_bulk");
+
+    return rcmain;
+}
@@ -0,0 +1,111 @@
+#include "rm_test_util.h"
+
+RC TEST_RM_17(const string &tableName)
+{
+    // Functions Tested:
+    // 1. Insert Tuples
+    // 2. Scan with getNextBatch returns the same tuples, in the same order, as getNextTuple
+    // 3. Batches stop at maxRows and the scan ends with RM_EOF
+    cout << endl << "***** In RM Test Case 17 *****" << endl;
+
+    RC rc = createTable(tableName);
+    assert(rc == success && "Creating a table should not fail.");
+
+    vector<Attribute> attrs;
+    rc = rm->getAttributes(tableName, attrs);
+    assert(rc == success && "RelationManager::getAttributes() should not fail.");
+
+    int nullAttributesIndicatorActualSize = getActualByteForNullsIndicator(attrs.size());
+    unsigned char *nullsIndicator = (unsigned char *) malloc(nullAttributesIndicatorActualSize);
+    memset(nullsIndicator, 0, nullAttributesIndicatorActualSize);
+
+    // Names of different lengths so the packed tuples have different sizes
+    int numTuples = 1000;
+    vector<const void*> tuples;
+    for(int i = 0; i < numTuples; i++)
+    {
+        void *tuple = malloc(100);
+        int size = 0;
+        string name(i % 20 + 1, 'a' + i % 26);
+        prepareTuple(attrs.size(), nullsIndicator, name.size(), name, i % 90, 160.5 + i, 1000 + i, tuple, &size);
+        tuples.push_back(tuple);
+    }
+    vector<RID> rids;
+    rc = rm->insertTuples(tableName, tuples, rids);
+    assert(rc == success && "RelationManager::insertTuples() should not fail.");
+
+    vector<string> attributes;
+    attributes.push_back("EmpName");
+    attributes.push_back("Age");
+    int ageVal = 45;
+
+    // The tuples one by one
+    vector<RID> expectedRids;
+    vector<string> expectedTuples;
+    RM_ScanIterator rmsi;
+    rc = rm->scan(tableName, "Age", GE_OP, &ageVal, attributes, rmsi);
+    assert(rc == success && "RelationManager::scan() should not fail.");
+    RID rid;
+    char returnedData[200];
+    while(rmsi.getNextTuple(rid, returnedData) != RM_EOF)
+    {
+        expectedRids.push_back(rid);
+        expectedTuples.push_back(string(returnedData, projectedSize(returnedData)));
+    }
+    rmsi.close();
+    unsigned matching = 0;
+    for(int i = 0; i < numTuples; i++)
+        matching += i % 90 >= ageVal;
+    assert(expectedTuples.size() == matching && "Every matching tuple should be returned.");
+
+    // Then in batches
+    unsigned maxRows = 64;
+    char *batch = (char *) malloc(maxRows * 200);
+    vector<RID> batchRids;
+    unsigned count = 0;
+    rc = rm->scan(tableName, "Age", GE_OP, &ageVal, attributes, rmsi);
+    assert(rc == success && "RelationManager::scan() should not fail.");
+    while((rc = rmsi.getNextBatch(batchRids, batch, maxRows)) != RM_EOF)
+    {
+        assert(rc == success && "RM_ScanIterator::getNextBatch() should not fail.");
+        assert(batchRids.size() > 0 && batchRids.size() <= maxRows && "A batch should hold 1 to maxRows tuples.");
+        assert((batchRids.size() == maxRows || count + batchRids.size() == expectedTuples.size()) && "Only the last batch should be short.");
+
+        char *tuple = batch;
+        for(unsigned i = 0; i < batchRids.size(); i++, count++)
+        {
+            assert(batchRids[i].pageNum == expectedRids[count].pageNum && batchRids[i].slotNum == expectedRids[count].slotNum && "Batches should return the same RIDs.");
+            int size = projectedSize(tuple);
+            if(expectedTuples[count] != string(tuple, size))
+            {
+                cout << "***** [FAIL] Test Case 17 Failed *****" << endl << endl;
+                return -1;
+            }
+            tuple += size;
+        }
+    }
+    rmsi.close();
+    assert(count == expectedTuples.size() && "Batches should return every matching tuple.");
+
+    rc = rm->deleteTable(tableName);
+    assert(rc == success && "Deleting the table should not fail.");
+
+    for(int i = 0; i < numTuples; i++)
+        free((void *) tuples[i]);
+    free(batch);
+    free(nullsIndicator);
+
+    cout << "***** Test Case 17 Finished. The result will be examined. *****" << endl << endl;
+
+    return success;
+}
+
+int main()
+{
+    // Remove the table in case a previous run left it behind
+    rm->deleteTable("tbl_batch");
+
+    RC rcmain = TEST_RM_17("tbl_batch");
+
+    return rcmain;
+}
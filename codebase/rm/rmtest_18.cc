@@ -0,0 +1,95 @@
+#include <map>
+
+#include "rm_test_util.h"
+
+// Every tuple a scan returns, keyed by RID
+static map<pair<unsigned, unsigned>, string> scanTable(const string &tableName, const vector<string> &attributes,
+                                                       int ageVal, ScanMode scanMode)
+{
+    map<pair<unsigned, unsigned>, string> tuples;
+    RM_ScanIterator rmsi;
+    RC rc = rm->scan(tableName, "Age", GE_OP, &ageVal, attributes, rmsi, scanMode);
+    assert(rc == success && "RelationManager::scan() should not fail.");
+    RID rid;
+    char returnedData[200];
+    while(rmsi.getNextTuple(rid, returnedData) != RM_EOF)
+    {
+        bool added = tuples.insert(make_pair(make_pair(rid.pageNum, rid.slotNum),
+                                             string(returnedData, projectedSize(returnedData)))).second;
+        assert(added && "A tuple should only be returned once.");
+    }
+    rmsi.close();
+    return tuples;
+}
+
+RC TEST_RM_18(const string &tableName)
+{
+    // Functions Tested:
+    // 1. Insert Tuples
+    // 2. Scan with the PARALLEL_SCAN option returns the same tuples as a plain scan
+    cout << endl << "***** In RM Test Case 18 *****" << endl;
+
+    RC rc = createTable(tableName);
+    assert(rc == success && "Creating a table should not fail.");
+
+    vector<Attribute> attrs;
+    rc = rm->getAttributes(tableName, attrs);
+    assert(rc == success && "RelationManager::getAttributes() should not fail.");
+
+    int nullAttributesIndicatorActualSize = getActualByteForNullsIndicator(attrs.size());
+    unsigned char *nullsIndicator = (unsigned char *) malloc(nullAttributesIndicatorActualSize);
+    memset(nullsIndicator, 0, nullAttributesIndicatorActualSize);
+
+    int numTuples = 5000;
+    vector<const void*> tuples;
+    for(int i = 0; i < numTuples; i++)
+    {
+        void *tuple = malloc(100);
+        int size = 0;
+        string name(i % 20 + 1, 'a' + i % 26);
+        prepareTuple(attrs.size(), nullsIndicator, name.size(), name, i % 90, 160.5 + i, 1000 + i, tuple, &size);
+        tuples.push_back(tuple);
+    }
+    vector<RID> rids;
+    rc = rm->insertTuples(tableName, tuples, rids);
+    assert(rc == success && "RelationManager::insertTuples() should not fail.");
+
+    vector<string> attributes;
+    attributes.push_back("EmpName");
+    attributes.push_back("Age");
+    int ageVal = 45;
+
+    map<pair<unsigned, unsigned>, string> expected = scanTable(tableName, attributes, ageVal, COPY_SCAN);
+    map<pair<unsigned, unsigned>, string> parallel = scanTable(tableName, attributes, ageVal, PARALLEL_SCAN);
+    cout << expected.size() << " tuples match" << endl;
+    unsigned matching = 0;
+    for(int i = 0; i < numTuples; i++)
+        matching += i % 90 >= ageVal;
+    assert(expected.size() == matching && "Every matching tuple should be returned.");
+    if(parallel != expected)
+    {
+        cout << "***** [FAIL] Test Case 18 Failed *****" << endl << endl;
+        return -1;
+    }
+
+    rc = rm->deleteTable(tableName);
+    assert(rc == success && "Deleting the table should not fail.");
+
+    for(int i = 0; i < numTuples; i++)
+        free((void *) tuples[i]);
+    free(nullsIndicator);
+
+    cout << "***** Test Case 18 Finished. The result will be examined. *****" << endl << endl;
+
+    return success;
+}
+
+int main()
+{
+    // Remove the table in case a previous run left it behind
+    rm->deleteTable("tbl_parallel");
+
+    RC rcmain = TEST_RM_18("tbl_parallel");
+
+    return rcmain;
+}
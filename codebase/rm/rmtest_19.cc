@@ -0,0 +1,157 @@
+#include <cmath>
+#include <map>
+
+#include "rm_test_util.h"
+
+// Tuple i has EmpName of i % 5 + 1 copies of 'a' + i % 5, Age i % 90 (NULL for every tenth tuple),
+// Height 160.5 + i and Salary 1000 + i
+static bool ageIsNull(int i)
+{
+    return i % 10 == 0;
+}
+
+static string empName(int i)
+{
+    return string(i % 5 + 1, 'a' + i % 5);
+}
+
+RC TEST_RM_19(const string &tableName)
+{
+    // Functions Tested:
+    // 1. Insert Tuples
+    // 2. Aggregate COUNT, SUM, MIN, MAX and AVG, with and without a predicate
+    // 3. Aggregate with GROUP BY on a varchar and on an int with NULLs
+    // 4. Aggregates on attributes of the wrong type fail
+    cout << endl << "***** In RM Test Case 19 *****" << endl;
+
+    RC rc = createTable(tableName);
+    assert(rc == success && "Creating a table should not fail.");
+
+    vector<Attribute> attrs;
+    rc = rm->getAttributes(tableName, attrs);
+    assert(rc == success && "RelationManager::getAttributes() should not fail.");
+
+    int nullAttributesIndicatorActualSize = getActualByteForNullsIndicator(attrs.size());
+    unsigned char *nullsIndicator = (unsigned char *) malloc(nullAttributesIndicatorActualSize);
+
+    int numTuples = 3000;
+    vector<const void*> tuples;
+    for(int i = 0; i < numTuples; i++)
+    {
+        memset(nullsIndicator, 0, nullAttributesIndicatorActualSize);
+        if (ageIsNull(i))
+            nullsIndicator[0] = 1 << 6;
+        void *tuple = malloc(100);
+        int size = 0;
+        string name = empName(i);
+        prepareTuple(attrs.size(), nullsIndicator, name.size(), name, i % 90, 160.5 + i, 1000 + i, tuple, &size);
+        tuples.push_back(tuple);
+    }
+    vector<RID> rids;
+    rc = rm->insertTuples(tableName, tuples, rids);
+    assert(rc == success && "RelationManager::insertTuples() should not fail.");
+
+    vector<ScanPredicate> none;
+    vector<AggregateGroup> groups;
+
+    // COUNT(*) and COUNT(Age)
+    rc = rm->aggregate(tableName, "", COUNT_AGG, none, "", groups);
+    assert(rc == success && "RelationManager::aggregate() should not fail.");
+    assert(groups.size() == 1 && groups[0].value == numTuples && "COUNT(*) should count every tuple.");
+    rc = rm->aggregate(tableName, "Age", COUNT_AGG, none, "", groups);
+    assert(rc == success && "RelationManager::aggregate() should not fail.");
+    assert(groups[0].count == (unsigned) numTuples - numTuples / 10 && "COUNT(Age) should leave out NULL ages.");
+
+    // SUM, MIN, MAX and AVG of Salary where Age >= 45
+    ScanPredicate predicate;
+    predicate.attribute = "Age";
+    predicate.compOp = GE_OP;
+    int ageVal = 45;
+    predicate.value = &ageVal;
+    predicate.orGroup = 0;
+    vector<ScanPredicate> older(1, predicate);
+
+    double sum = 0, minSalary = 1e9, maxSalary = -1e9;
+    unsigned count = 0;
+    for(int i = 0; i < numTuples; i++)
+    {
+        if (ageIsNull(i) || i % 90 < ageVal)
+            continue;
+        sum += 1000 + i;
+        minSalary = min(minSalary, 1000.0 + i);
+        maxSalary = max(maxSalary, 1000.0 + i);
+        count++;
+    }
+    AggregateOp ops[] = { SUM_AGG, MIN_AGG, MAX_AGG, AVG_AGG };
+    double expected[] = { sum, minSalary, maxSalary, sum / count };
+    for (unsigned j = 0; j < 4; j++)
+    {
+        rc = rm->aggregate(tableName, "Salary", ops[j], older, "", groups);
+        assert(rc == success && "RelationManager::aggregate() should not fail.");
+        cout << "Salary aggregate " << j << ": " << groups[0].value << endl;
+        assert(groups.size() == 1 && groups[0].count == count && "The aggregate should go over every matching tuple.");
+        assert(fabs(groups[0].value - expected[j]) < 1e-6 && "The aggregate should be right.");
+    }
+
+    // MAX(Height) GROUP BY EmpName
+    rc = rm->aggregate(tableName, "Height", MAX_AGG, none, "EmpName", groups);
+    assert(rc == success && "RelationManager::aggregate() should not fail.");
+    assert(groups.size() == 5 && "There should be one group per name.");
+    for (unsigned j = 0; j < groups.size(); j++)
+    {
+        int last = numTuples - 5;
+        while (empName(last) != groups[j].groupValue)
+            last++;
+        assert(!groups[j].groupIsNull && groups[j].count == (unsigned) numTuples / 5 && "Every name should have its tuples.");
+        assert(groups[j].value == (float) (160.5 + last) && "The group's MAX should be its last height.");
+    }
+
+    // AVG(Salary) GROUP BY Age, with the NULL ages in a group of their own
+    rc = rm->aggregate(tableName, "Salary", AVG_AGG, none, "Age", groups);
+    assert(rc == success && "RelationManager::aggregate() should not fail.");
+    map<int, pair<double, unsigned> > byAge;
+    for(int i = 0; i < numTuples; i++)
+    {
+        int age = ageIsNull(i) ? -1 : i % 90;
+        byAge[age].first += 1000 + i;
+        byAge[age].second++;
+    }
+    assert(groups.size() == byAge.size() && "There should be one group per age, and one for NULL.");
+    for (unsigned j = 0; j < groups.size(); j++)
+    {
+        int age = -1;
+        if (!groups[j].groupIsNull)
+            memcpy(&age, groups[j].groupValue.data(), sizeof(int));
+        assert(groups[j].count == byAge[age].second && "Every age should have its tuples.");
+        assert(fabs(groups[j].value - byAge[age].first / byAge[age].second) < 1e-6 && "The group's AVG should be right.");
+    }
+
+    // Only COUNT works on varchars, and groups can't be reals
+    rc = rm->aggregate(tableName, "EmpName", SUM_AGG, none, "", groups);
+    assert(rc != success && "SUM of a varchar should fail.");
+    rc = rm->aggregate(tableName, "Salary", SUM_AGG, none, "Height", groups);
+    assert(rc != success && "Grouping on a real should fail.");
+    rc = rm->aggregate(tableName, "EmpName", COUNT_AGG, none, "", groups);
+    assert(rc == success && groups[0].count == (unsigned) numTuples && "COUNT of a varchar should work.");
+
+    rc = rm->deleteTable(tableName);
+    assert(rc == success && "Deleting the table should not fail.");
+
+    for(int i = 0; i < numTuples; i++)
+        free((void *) tuples[i]);
+    free(nullsIndicator);
+
+    cout << "***** Test Case 19 Finished. The result will be examined. *****" << endl << endl;
+
+    return success;
+}
+
+int main()
+{
+    // Remove the table in case a previous run left it behind
+    rm->deleteTable("tbl_aggregate");
+
+    RC rcmain = TEST_RM_19("tbl_aggregate");
+
+    return rcmain;
+}
@@ -0,0 +1,136 @@
+#include "rm_test_util.h"
+
+RC TEST_RM_20(const string &tableName)
+{
+    // Functions Tested:
+    // 1. Insert Tuples
+    // 2. Update Tuple so tuples move, and Delete Tuple
+    // 3. Vacuum Table a few pages at a time, then all at once
+    // 4. Vacuum calls after the first don't read the whole table
+    // 5. Read Tuple and Scan after the vacuum
+    cout << endl << "***** In RM Test Case 20 *****" << endl;
+
+    RC rc = createTable(tableName);
+    assert(rc == success && "Creating a table should not fail.");
+
+    vector<Attribute> attrs;
+    rc = rm->getAttributes(tableName, attrs);
+    assert(rc == success && "RelationManager::getAttributes() should not fail.");
+
+    int nullAttributesIndicatorActualSize = getActualByteForNullsIndicator(attrs.size());
+    unsigned char *nullsIndicator = (unsigned char *) malloc(nullAttributesIndicatorActualSize);
+    memset(nullsIndicator, 0, nullAttributesIndicatorActualSize);
+
+    int numTuples = 3000;
+    vector<const void*> tuples;
+    int size = 0;
+    for(int i = 0; i < numTuples; i++)
+    {
+        void *tuple = malloc(100);
+        prepareTuple(attrs.size(), nullsIndicator, 1, "a", i, 160.5 + i, 1000 + i, tuple, &size);
+        tuples.push_back(tuple);
+    }
+    vector<RID> rids;
+    rc = rm->insertTuples(tableName, tuples, rids);
+    assert(rc == success && "RelationManager::insertTuples() should not fail.");
+
+    // Every tenth tuple grows out of its page, most of the rest go
+    void *tuple = malloc(100);
+    string longName(50, 'z');
+    unsigned liveCount = 0;
+    for(int i = 0; i < numTuples; i++)
+    {
+        if (i % 10 == 0)
+        {
+            prepareTuple(attrs.size(), nullsIndicator, longName.size(), longName, i, 160.5 + i, 1000 + i, tuple, &size);
+            rc = rm->updateTuple(tableName, tuple, rids[i]);
+            assert(rc == success && "RelationManager::updateTuple() should not fail.");
+            liveCount++;
+        }
+        else if (i % 4 != 0)
+        {
+            rc = rm->deleteTuple(tableName, rids[i]);
+            assert(rc == success && "RelationManager::deleteTuple() should not fail.");
+        }
+        else
+            liveCount++;
+    }
+
+    // Each call opens the table afresh, but only the first one looks at every page for moved tuples.
+    // After that a call reads the catalog and little more than the pages it was given.
+    BufferPoolManager *bpm = BufferPoolManager::instance();
+    unsigned readsBefore, readsAfter, writeCount;
+    bpm->collectLogicalCounterValues(readsBefore, writeCount);
+    rc = rm->getAttributes(tableName, attrs);
+    assert(rc == success && "RelationManager::getAttributes() should not fail.");
+    bpm->collectLogicalCounterValues(readsAfter, writeCount);
+    unsigned catalogReads = readsAfter - readsBefore;
+
+    PageNum cursor = 0;
+    unsigned callReads[2];
+    for(int i = 0; i < 2; i++)
+    {
+        bpm->collectLogicalCounterValues(readsBefore, writeCount);
+        rc = rm->vacuumTable(tableName, cursor, 2);
+        assert(rc == success && cursor != 0 && "Vacuuming part of the table should leave more to do.");
+        bpm->collectLogicalCounterValues(readsAfter, writeCount);
+        callReads[i] = readsAfter - readsBefore - catalogReads;
+    }
+    cout << "Pages read by the first two vacuum calls: " << callReads[0] << ", " << callReads[1] << endl;
+    assert(callReads[1] <= 4 * 2 && callReads[1] < callReads[0] && "A later vacuum call should not read the whole table.");
+    rc = rm->vacuumTable(tableName, cursor);
+    assert(rc == RM_EOF && cursor == 0 && "Vacuuming the rest should finish the table.");
+
+    void *returned = malloc(100);
+    for(int i = 0; i < numTuples; i++)
+    {
+        if (i % 10 != 0 && i % 4 != 0)
+        {
+            rc = rm->readTuple(tableName, rids[i], returned);
+            assert(rc != success && "Reading a deleted tuple should fail.");
+            continue;
+        }
+        if (i % 10 == 0)
+            prepareTuple(attrs.size(), nullsIndicator, longName.size(), longName, i, 160.5 + i, 1000 + i, tuple, &size);
+        else
+            prepareTuple(attrs.size(), nullsIndicator, 1, "a", i, 160.5 + i, 1000 + i, tuple, &size);
+        rc = rm->readTuple(tableName, rids[i], returned);
+        assert(rc == success && "RelationManager::readTuple() should not fail.");
+        assert(memcmp(tuple, returned, size) == 0 && "Tuples should read back after a vacuum.");
+    }
+
+    RM_ScanIterator rmsi;
+    vector<string> attributes;
+    attributes.push_back("Age");
+    rc = rm->scan(tableName, "", NO_OP, NULL, attributes, rmsi);
+    assert(rc == success && "RelationManager::scan() should not fail.");
+    RID rid;
+    unsigned scanned = 0;
+    while(rmsi.getNextTuple(rid, returned) != RM_EOF)
+        scanned++;
+    rmsi.close();
+    assert(scanned == liveCount && "A scan should see every tuple once.");
+
+    rc = rm->deleteTable(tableName);
+    assert(rc == success && "Deleting the table should not fail.");
+
+    for(int i = 0; i < numTuples; i++)
+        free((void *) tuples[i]);
+    free(tuple);
+    free(returned);
+    free(nullsIndicator);
+
+    cout << "***** Test Case 20 Finished. The result will be examined. *****" << endl << endl;
+
+    return success;
+}
+
+int main()
+{
+    // Remove the table in case a previous run left it behind
+    rm->deleteTable("tbl_vacuum");
+
+    RC rcmain = TEST_RM_20("tbl_vacuum");
+
+    return rcmain;
+}